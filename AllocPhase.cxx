@@ -0,0 +1,27 @@
+/****************************************************************************
+ *
+ * class AllocPhase
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include "AllocPhase.h"
+
+ALLOC_PHASE_TLS AllocPhase::Phase AllocPhase::current_ = AllocPhase::Setup;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+const char *
+AllocPhase::name(Phase phase)
+{
+    static const char *Names[NumPhases] = {
+        "setup", "traversal", "dedup", "geometry", "I/O"
+    };
+    return (phase < NumPhases) ? Names[phase] : "";
+}
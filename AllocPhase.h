@@ -0,0 +1,68 @@
+/****************************************************************************
+ *
+ * class AllocPhase
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _ALLOCPHASE_H_
+#define _ALLOCPHASE_H_
+
+#if defined(_WIN32)
+#   define ALLOC_PHASE_TLS  __declspec(thread)
+#else
+#   define ALLOC_PHASE_TLS  __thread
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////
+// The export phase of the calling thread. An AllocPhase sets it for its //
+// lifetime and restores the enclosing phase when it goes out of scope.  //
+//                                                                      //
+// The exporter only marks the phases. A program that replaces the      //
+// global operator new can charge each allocation to the current phase  //
+// of the thread that makes it, as the print3d driver does. A plugin    //
+// cannot replace the operator new of its host, so it counts nothing.   //
+//////////////////////////////////////////////////////////////////////////
+class AllocPhase {
+public:
+    enum Phase {
+        Setup,          // the models, tables and buffers of the export
+        Traversal,      // reading the elements and visiting their edges
+        Dedup,          // finding the unique edges
+        Geometry,       // making the cylinders, elements and lattices
+        Io,             // formatting, capturing and writing the facets
+        NumPhases
+    };
+
+    AllocPhase(Phase phase) :
+        prev_(current_)
+    {
+        current_ = phase;
+    }
+
+    ~AllocPhase()
+    {
+        current_ = prev_;
+    }
+
+    static Phase    current() {
+                        return current_; }
+
+    static const char * name(Phase phase);
+
+private:
+    // not copyable
+    AllocPhase(const AllocPhase &);
+    AllocPhase & operator=(const AllocPhase &);
+
+private:
+    Phase   prev_;
+
+    static ALLOC_PHASE_TLS Phase    current_;
+};
+
+#endif // _ALLOCPHASE_H_
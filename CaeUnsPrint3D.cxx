@@ -8,8 +8,8 @@
  *
  ***************************************************************************/
 
-#include <stdarg.h>
-#include <math.h>
+#include <ctype.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "apiCAEP.h"
@@ -23,25 +23,47 @@
 #include "CaeUnsGridModel.h"
 #include "CaeUnsPrint3D.h"
 
-const char  SolidName[]         = "Pointwise_Print3D";
 const char  AttrEdgeDiameter[]  = "EdgeDiameter";
 const char  AttrMultiSolid[]    = "MultiSolid";
 const char  AttrNumPoints[]     = "NumPoints";
-
-
-static bool
-valZero(double val)
-{
-    const double ZeroTol = 1.0E-10;
-    return ::fabs(val) < ZeroTol;
-}
-
-
-static double
-roundZero(double val)
-{
-    return valZero(val) ? 0 : val;
-}
+const char  AttrCylTolerance[]  = "CylinderTolerance";
+const char  AttrEdgeMode[]      = "EdgeMode";
+const char  AttrBndryLayers[]   = "BoundaryLayers";
+const char  AttrFeatureAngle[]  = "FeatureAngle";
+const char  AttrClipBoxes[]     = "ClipBoxes";
+const char  AttrClipHalfSpaces[] = "ClipHalfSpaces";
+const char  AttrClipTrim[]      = "ClipTrim";
+const char  AttrWeldVerts[]     = "WeldVertices";
+const char  AttrWeldTol[]       = "WeldTolerance";
+const char  AttrMergeChains[]   = "MergeChains";
+const char  AttrChainTol[]      = "ChainTolerance";
+const char  AttrEdgeOrder[]     = "EdgeOrder";
+const char  AttrTessCache[]     = "TessCache";
+const char  AttrCheckpoint[]    = "Checkpoint";
+const char  AttrPartCount[]     = "PartitionCount";
+const char  AttrPartRank[]      = "PartitionRank";
+const char  AttrPartMerge[]     = "PartitionMerge";
+const char  AttrSolidScope[]    = "SolidScope";
+const char  AttrSolidIds[]      = "BinarySolidId";
+const char  AttrClusterTris[]   = "ClusterTriangles";
+const char  AttrBeamLattice[]   = "BeamLattice";
+const char  AttrSdfUnion[]      = "SdfUnion";
+const char  AttrSdfResolution[] = "SdfResolution";
+const char  AttrHubLattice[]    = "HubLattice";
+const char  AttrThreads[]       = "Threads";
+const char  AttrSliceThickness[] = "SliceThickness";
+const char  AttrSnapshot[]      = "Snapshot";
+const char  AttrSweepDiameters[] = "SweepDiameters";
+const char  AttrSweepNumPoints[] = "SweepNumPoints";
+const char  AttrSweepFormats[]  = "SweepFormats";
+
+
+// the Snapshot attribute values
+enum SnapshotMode {
+    SnapshotOff,    // export from the grid
+    SnapshotWrite,  // export from the grid and write <dest>.p3ds
+    SnapshotRead    // export from <dest>.p3ds
+};
 
 
 static bool
@@ -51,49 +73,38 @@ bcIs(const PWGM_CONDDATA &cond, const char bcType[])
 }
 
 
+// true if dest ends with ext, ignoring case
 static bool
-isHidden(const PWGM_CONDDATA &cond)
-{
-    return bcIs(cond, "hidden");
-}
-
-
-static bool
-isSolid(const PWGM_CONDDATA &cond)
+hasExt(const std::string &dest, const char ext[])
 {
-    return bcIs(cond, "solid");
-}
-
-
-static bool
-isHidden(const CaeUnsPatch &patch)
-{
-    PWGM_CONDDATA cond;
-    return patch.condition(cond) && isHidden(cond);
-}
-
-
-static bool
-isSolid(const CaeUnsPatch &patch)
-{
-    PWGM_CONDDATA cond;
-    return patch.condition(cond) && isSolid(cond);
-}
-
-
-static bool
-isHidden(const CaeUnsBlock &block)
-{
-    PWGM_CONDDATA cond;
-    return block.condition(cond) && isHidden(cond);
+    const size_t len = dest.size();
+    const size_t extLen = strlen(ext);
+    if (len <= extLen) {
+        return false;
+    }
+    for (size_t ii = 0; ii < extLen; ++ii) {
+        if (tolower(dest[len - extLen + ii]) != ext[ii]) {
+            return false;
+        }
+    }
+    return true;
 }
 
 
-static bool
-isSolid(const CaeUnsBlock &block)
+static Print3DCond
+toPrint3DCond(bool haveCond, const PWGM_CONDDATA &cond)
 {
-    PWGM_CONDDATA cond;
-    return block.condition(cond) && isSolid(cond);
+    Print3DCond ret = Print3DCondMesh;
+    if (!haveCond) {
+        // use default
+    }
+    else if (bcIs(cond, "hidden")) {
+        ret = Print3DCondHidden;
+    }
+    else if (bcIs(cond, "solid")) {
+        ret = Print3DCondSolid;
+    }
+    return ret;
 }
 
 
@@ -105,619 +116,342 @@ isSolid(const CaeUnsBlock &block)
 CaeUnsPrint3D::CaeUnsPrint3D(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL
         model, const CAEP_WRITEINFO *pWriteInfo) :
     CaeUnsPlugin(pRti, model, pWriteInfo),
-    edges_(),
-    numTris_(0),
-    numSolids_(0),
-    multiSolid_(PWP_TRUE),
-    radius_(DefCylDiam / 2.0),
-    zOffset_(DefCylDiam / 3.0),
-    numBasePts_(DefNumBasePts)
+    settings_(),
+    numPatches_(0),
+    numBlocks_(0),
+    snapshotMode_(SnapshotOff),
+    snapshot_(),
+    sweep_(0)
 {
+    if ((0 != pWriteInfo) && (0 != pWriteInfo->fileDest)) {
+        settings_.destPath = pWriteInfo->fileDest;
+    }
 }
 
 CaeUnsPrint3D::~CaeUnsPrint3D()
 {
+    delete sweep_;
 }
 
 bool
 CaeUnsPrint3D::beginExport()
 {
-    if (isBinaryEncoding()) {
-        // binary does not support multi-solid
-        multiSolid_ = false;
+    settings_.binary = isBinaryEncoding();
+    // the grid model is only read from the export thread
+    settings_.threadSafeModel = false;
+    if (hasExt(settings_.destPath, ".3mf")) {
+        // a zip package, the runtime must open the file as binary
+        if (!isBinaryEncoding()) {
+            sendErrorMsg("3MF export requires binary encoding");
+            return false;
+        }
+        settings_.format = Print3DFormat3mf;
+    }
+    else if (hasExt(settings_.destPath, ".cli")) {
+        settings_.format = Print3DFormatCli;
+    }
+    model_.getAttribute(AttrBeamLattice, settings_.beamLattice, false);
+    model_.getAttribute(AttrMultiSolid, settings_.multiSolid, true);
+    PWP_UINT enumVal;
+    model_.getAttribute(AttrSolidScope, enumVal, Print3DSolidPerCylinder);
+    settings_.solidScope = (Print3DSolidScope)enumVal;
+    model_.getAttribute(AttrClusterTris, settings_.clusterTris,
+        DefClusterTris);
+    model_.getAttribute(AttrSolidIds, enumVal, Print3DSolidIdPlain);
+    settings_.solidIds = (Print3DSolidIds)enumVal;
+
+    model_.getAttribute(AttrEdgeDiameter, settings_.diameter, DefCylDiam);
+    model_.getAttribute(AttrNumPoints, settings_.numPoints, DefNumBasePts);
+    model_.getAttribute(AttrCylTolerance, settings_.cylTolerance, 0.0);
+    model_.getAttribute(AttrEdgeMode, enumVal, Print3DEdgesAll);
+    settings_.edgeMode = (Print3DEdgeMode)enumVal;
+    model_.getAttribute(AttrBndryLayers, settings_.boundaryLayers, 0);
+    model_.getAttribute(AttrFeatureAngle, settings_.featureAngle,
+        DefFeatureAngle);
+    const char *clipList = "";
+    model_.getAttribute(AttrClipBoxes, clipList, "");
+    settings_.clipBoxes = clipList;
+    model_.getAttribute(AttrClipHalfSpaces, clipList, "");
+    settings_.clipHalfSpaces = clipList;
+    model_.getAttribute(AttrClipTrim, settings_.clipTrim, false);
+    model_.getAttribute(AttrWeldVerts, settings_.weldVertices, false);
+    model_.getAttribute(AttrWeldTol, settings_.weldTolerance, 0.0);
+    model_.getAttribute(AttrMergeChains, settings_.mergeChains, false);
+    model_.getAttribute(AttrChainTol, settings_.chainTolerance, 0.0);
+    model_.getAttribute(AttrEdgeOrder, enumVal, Print3DOrderTraversal);
+    settings_.edgeOrder = (Print3DEdgeOrder)enumVal;
+    model_.getAttribute(AttrTessCache, settings_.tessCache, false);
+    model_.getAttribute(AttrCheckpoint, settings_.checkpoint, false);
+    model_.getAttribute(AttrPartCount, settings_.numParts, 1);
+    model_.getAttribute(AttrPartRank, settings_.partRank, 0);
+    model_.getAttribute(AttrPartMerge, settings_.mergeParts, false);
+    model_.getAttribute(AttrSdfUnion, settings_.sdfUnion, false);
+    model_.getAttribute(AttrSdfResolution, settings_.sdfResolution,
+        DefSdfRes);
+    model_.getAttribute(AttrHubLattice, settings_.hubLattice, false);
+    model_.getAttribute(AttrThreads, settings_.numThreads, 0);
+    model_.getAttribute(AttrSliceThickness, settings_.sliceThickness,
+        DefSliceThick);
+
+    numPatches_ = 0;
+    CaeUnsPatch patch(model_);
+    for (; patch.isValid(); ++patch) {
+        ++numPatches_;
     }
-    else {
-        model_.getAttribute(AttrMultiSolid, multiSolid_, true);
+    numBlocks_ = 0;
+    CaeUnsBlock block(model_);
+    for (; block.isValid(); ++block) {
+        ++numBlocks_;
+    }
+
+    model_.getAttribute(AttrSnapshot, snapshotMode_, SnapshotOff);
+    PWP_UINT32 majorSteps = Print3DExporter::majorSteps(settings_);
+    if (SnapshotWrite == snapshotMode_) {
+        // + edge collection and snapshot write
+        majorSteps += 2;
+    }
+    else if (SnapshotRead == snapshotMode_) {
+        const std::string path = settings_.destPath + SnapshotFileExt;
+        std::string err;
+        if (!snapshot_.open(path, err)) {
+            sendWarningMsg(("Exporting the grid, cannot read snapshot " +
+                path + ": " + err).c_str());
+            snapshotMode_ = SnapshotOff;
+        }
+        else if (snapshot_.entityCount() != entityCount()) {
+            sendWarningMsg("Exporting the grid, the snapshot does not match "
+                "its patches and blocks");
+            snapshot_.close();
+            snapshotMode_ = SnapshotOff;
+        }
+        else {
+            // the conditions may have changed since it was written
+            for (PWP_UINT32 ndx = 0; ndx < entityCount(); ++ndx) {
+                snapshot_.setCondition(ndx, condition(ndx));
+            }
+        }
     }
-    
-    PWP_REAL cylDiam;
-    model_.getAttribute(AttrEdgeDiameter, cylDiam, DefCylDiam);
-    radius_ = cylDiam / 2.0;
-    zOffset_ = cylDiam / 3.0;
-
-    model_.getAttribute(AttrNumPoints, numBasePts_, DefNumBasePts);
 
-    // Initialize masterCylBase_ data
-    // polygon is centered at the origin in the z=0 plane
-    // polygon's right-handed normal is +z
-    const double PI = 3.141592653589793;
-    double angle = 0; // radians
-    double deltaR = (2 * PI) / numBasePts_;
-    for (PWP_UINT ii = 0; ii < numBasePts_; ++ii, angle += deltaR) {
-        // load cyl base pts (xyz)
-        masterCylBase_[ii].set(cos(angle) * radius_, sin(angle) * radius_, 0);
+    if (!loadSweep()) {
+        return false;
+    }
+    if (0 != sweep_) {
+        majorSteps = Print3DSweep::majorSteps() +
+            ((SnapshotWrite == snapshotMode_) ? 2 : 0);
     }
 
-    setProgressMajorSteps(2);
-
-    return true;
-}
+    setProgressMajorSteps(majorSteps);
 
-PWP_BOOL
-CaeUnsPrint3D::write()
-{
-    writeHeader();
-    writePatches();
-    writeBlocks();
-    writeFooter();
     return true;
 }
 
 bool
-CaeUnsPrint3D::endExport()
-{
+CaeUnsPrint3D::loadSweep()
+{
+    // a sweep is only used if the lists make more than one variant
+    delete sweep_;
+    sweep_ = 0;
+    const char *diameters = "";
+    const char *numPoints = "";
+    const char *formats = "";
+    model_.getAttribute(AttrSweepDiameters, diameters, "");
+    model_.getAttribute(AttrSweepNumPoints, numPoints, "");
+    model_.getAttribute(AttrSweepFormats, formats, "");
+    Print3DModel &model = (SnapshotRead == snapshotMode_) ?
+        (Print3DModel &)snapshot_ : (Print3DModel &)*this;
+    std::vector<double> diameterVals;
+    std::vector<PWP_UINT> numPointVals;
+    std::vector<Print3DFormat> formatVals;
+    if (!Print3DSweep::parseDiameters(diameters, diameterVals)) {
+        sendErrorMsg("SweepDiameters must list positive diameters");
+        return false;
+    }
+    if (!Print3DSweep::parseNumPoints(numPoints, numPointVals)) {
+        sendErrorMsg("SweepNumPoints must list point counts from 3 to 10");
+        return false;
+    }
+    if (!Print3DSweep::parseFormats(formats, formatVals)) {
+        sendErrorMsg("SweepFormats must list stl, 3mf or cli");
+        return false;
+    }
+    sweep_ = new Print3DSweep(model, *this, settings_);
+    sweep_->setDiameters(diameterVals);
+    sweep_->setNumPoints(numPointVals);
+    sweep_->setFormats(formatVals);
+    if (sweep_->variantCount() < 2) {
+        delete sweep_;
+        sweep_ = 0;
+    }
     return true;
 }
 
-
-void
-CaeUnsPrint3D::writeStr(const char *format, ...)
+PWP_BOOL
+CaeUnsPrint3D::write()
 {
-    if (isAsciiEncoding()) {
-        va_list args;
-        va_start(args, format);
-        vfprintf(fp(), format, args);
-        va_end(args);
+    bool ret = false;
+    if (0 != sweep_) {
+        ret = sweep_->run(fp());
     }
-}
-
-
-void
-CaeUnsPrint3D::writeXyz(const char prefix[], const vector3 &xyz)
-{
-    const int AsciiFloatPrec = 8;
-    if (isAsciiEncoding()) {
-        fprintf(fp(), "%s %.*g %.*g %.*g\n", prefix,
-            AsciiFloatPrec, roundZero(xyz[0]),
-            AsciiFloatPrec, roundZero(xyz[1]),
-            AsciiFloatPrec, roundZero(xyz[2]));
-    }
-    else if (isBinaryEncoding()) {
-        float val;
-        val = (float)roundZero(xyz[0]);
-        pwpFileWrite(&val, sizeof(val), 1, fp());
-        val = (float)roundZero(xyz[1]);
-        pwpFileWrite(&val, sizeof(val), 1, fp());
-        val = (float)roundZero(xyz[2]);
-        pwpFileWrite(&val, sizeof(val), 1, fp());
+    else if (SnapshotRead == snapshotMode_) {
+        Print3DExporter exporter(snapshot_, *this, fp(), settings_);
+        ret = exporter.run();
     }
-}
-
-
-void
-CaeUnsPrint3D::writeAttrByteCount(PWP_UINT16 byteCnt)
-{
-    if (isBinaryEncoding()) {
-        pwpFileWrite(&byteCnt, sizeof(byteCnt), 1, fp());
+    else {
+        Print3DExporter exporter(*this, *this, fp(), settings_);
+        ret = exporter.run();
+    }
+    if (ret && (SnapshotWrite == snapshotMode_) &&
+            !GridSnapshot::write(*this, *this,
+                settings_.destPath + SnapshotFileExt)) {
+        sendWarningMsg("Could not write grid snapshot");
     }
+    return ret;
 }
 
-
-void
-CaeUnsPrint3D::writeTriFacet(const vector3 &p0, const vector3 &p1,
-    const vector3 &p2)
+bool
+CaeUnsPrint3D::endExport()
 {
-    // from: http://en.wikipedia.org/wiki/STL_(file_format)
-    //
-    // In both ASCII and binary versions of STL, the facet normal should be a
-    // unit vector pointing OUTWARDS from the solid object. In most software
-    // this may be set to (0,0,0) and the software will automatically calculate
-    // a normal based on the order of the triangle vertices using the 'right
-    // hand rule'. Some STL loaders (eg the STL plugin for Art of Illusion)
-    // check that the normal in the file agrees with the normal they calculate
-    // using the right hand rule and warn you when it does not. Other software
-    // may ignore the facet normal entirely and use only the right hand rule.
-    // So in order to be entirely portable one should provide both the facet
-    // normal and order the vertices appropriately  even though it is
-    // seemingly redundant to do so. Some other software (e.g. SolidWorks) use
-    // the normal for shading effects, so the "normals" listed in the file are
-    // not the true facets' normals.
-    //
-    // ******* ASCII export:
-    //  facet normal  0.000000e+000  0.000000e+000  1.000000e+000
-    //    outer loop
-    //      vertex    0.000000e+000  0.000000e+000  0.000000e+000
-    //      vertex    5.000000e-001  0.000000e+000  0.000000e+000
-    //      vertex    5.000000e-001  5.000000e-001  0.000000e+000
-    //    endloop
-    //  endfacet
-    //
-    // ******* BINARY export:
-    // foreach triangle
-    //   REAL32[3]           Normal vector
-    //   REAL32[3]           Vertex 1
-    //   REAL32[3]           Vertex 2
-    //   REAL32[3]           Vertex 3
-    //   UINT16              Attribute byte count
-    // end
-    writeXyz("facet normal", cml::cross((p1 - p0), (p2 - p1)).normalize());
-    writeStr(" outer loop\n");
-    writeXyz("  vertex", p0);
-    writeXyz("  vertex", p1);
-    writeXyz("  vertex", p2);
-    writeAttrByteCount();
-    writeStr(" endloop\n");
-    writeStr("endfacet\n");
-    ++numTris_;
+    delete sweep_;
+    sweep_ = 0;
+    snapshot_.close();
+    return true;
 }
 
 
-void
-CaeUnsPrint3D::writeQuadFacet(const vector3 &p0, const vector3 &p1,
-    const vector3 &p2, const vector3 &p3)
-{
-    writeTriFacet(p0, p1, p2);
-    writeTriFacet(p0, p2, p3);
-}
 
+//===========================================================================
+// Print3DModel implementation
+//===========================================================================
 
-void
-CaeUnsPrint3D::beginMultiSolid()
+PWP_UINT32
+CaeUnsPrint3D::entityCount() const
 {
-    // ******* ASCII export:
-    // "solid [name]\n"
-    //
-    if (multiSolid_ && isAsciiEncoding()) {
-        sprintf(curSolidName_, "%s_%06lu", SolidName,
-            (unsigned long)++numSolids_);
-        writeStr("solid %s\n", curSolidName_);
-    }
+    return numPatches_ + numBlocks_;
 }
 
-
-void
-CaeUnsPrint3D::endMultiSolid()
+bool
+CaeUnsPrint3D::isBlock(PWP_UINT32 ndx) const
 {
-    if (multiSolid_ && isAsciiEncoding()) {
-        // ******* ASCII export:
-        // "endsolid [name]\n"
-        //
-        writeStr("endsolid %s\n", curSolidName_);
-    }
+    return ndx >= numPatches_;
 }
 
-
-void
-CaeUnsPrint3D::makeCylinder(const matrix33 &rot, const vector3 &tran0,
-    const vector3 &tran1, Cylinder &cyl)
+Print3DCond
+CaeUnsPrint3D::condition(PWP_UINT32 ndx) const
 {
-    vector3 pt;
-    for (PWP_UINT ii = 0; ii < numBasePts_; ++ii) {
-        pt = masterCylBase_[ii] * rot;
-        cyl[0][ii] = pt + tran0;
-        cyl[1][ii] = pt + tran1;
+    PWGM_CONDDATA cond;
+    bool haveCond = false;
+    if (isBlock(ndx)) {
+        haveCond = CaeUnsBlock(model_, ndx - numPatches_).condition(cond);
+    }
+    else {
+        haveCond = CaeUnsPatch(model_, ndx).condition(cond);
     }
+    return toPrint3DCond(haveCond, cond);
 }
 
-
-void
-CaeUnsPrint3D::writeCylBase(const CylBase &base, bool reverse)
+std::string
+CaeUnsPrint3D::entityName(PWP_UINT32 ndx) const
 {
-    if (!reverse) {
-        for (PWP_UINT ii = 1; ii < numBasePts_ - 1; ++ii) {
-            writeTriFacet(base[0], base[ii + 1], base[ii]);
-        }
+    // the condition name identifies the entity for the user
+    PWGM_CONDDATA cond;
+    bool haveCond = false;
+    if (isBlock(ndx)) {
+        haveCond = CaeUnsBlock(model_, ndx - numPatches_).condition(cond);
     }
     else {
-        for (PWP_UINT ii = 1; ii < numBasePts_ - 1; ++ii) {
-            writeTriFacet(base[0], base[ii], base[ii + 1]);
-        }
+        haveCond = CaeUnsPatch(model_, ndx).condition(cond);
     }
-}
-
-
-void
-CaeUnsPrint3D::writeCylSides(const CylBase &cb0, const CylBase &cb1)
-{
-    PWP_UINT ii;
-    for (ii = 0; ii < numBasePts_ - 1; ++ii) {
-        writeQuadFacet(cb1[ii], cb0[ii], cb0[ii + 1], cb1[ii + 1]);
+    if (haveCond && (0 != cond.name) && ('\0' != cond.name[0])) {
+        return cond.name;
     }
-    // here, ii == numBasePts_ - 1
-    // write last side quad that wraps back to first side quad
-    writeQuadFacet(cb1[ii], cb0[ii], cb0[0], cb1[0]);
-}
-
-
-void
-CaeUnsPrint3D::writeCylinder(const vector3 &p0, const vector3 &p1)
-{
-    vector3 zaxis(0, 0, 1);
-    vector3 cylAxis = (p1 - p0);
-    vector3 dLen = zOffset_ * normalize(cylAxis);
-    matrix33 v2v;
-    cml::matrix_rotation_vec_to_vec(v2v, cylAxis, zaxis);
-    Cylinder cyl;
-    makeCylinder(v2v, p0 - dLen, p1 + dLen, cyl);
-    beginMultiSolid();
-    writeCylBase(cyl[0], false);
-    writeCylBase(cyl[1], true);
-    writeCylSides(cyl[0], cyl[1]);
-    endMultiSolid();
-}
-
-
-void
-CaeUnsPrint3D::writeCylinder(const PWGM_VERTDATA &vd0,
-    const PWGM_VERTDATA &vd1)
-{
-    vector3 p0;
-    vector3 p1;
-    // try to keep vec from p0->p1 in +z direction
-    if (vd0.z <= vd1.z) {
-        p0.set(vd0.x, vd0.y, vd0.z);
-        p1.set(vd1.x, vd1.y, vd1.z);
+    char buf[32];
+    if (isBlock(ndx)) {
+        sprintf(buf, "block-%lu", (unsigned long)(ndx - numPatches_ + 1));
     }
     else {
-        p0.set(vd1.x, vd1.y, vd1.z);
-        p1.set(vd0.x, vd0.y, vd0.z);
+        sprintf(buf, "patch-%lu", (unsigned long)(ndx + 1));
     }
-    writeCylinder(p0, p1);
+    return buf;
 }
 
-
-bool
-CaeUnsPrint3D::isNewEdge(const Edge &e)
+PWP_UINT32
+CaeUnsPrint3D::elementCount(PWP_UINT32 ndx) const
 {
-    return edges_.insert(e).second;
+    return isBlock(ndx) ?
+        CaeUnsBlock(model_, ndx - numPatches_).elementCount() :
+        CaeUnsPatch(model_, ndx).elementCount();
 }
 
-
-void
-CaeUnsPrint3D::writeEdge(const CaeUnsVertex &v0, const CaeUnsVertex &v1)
+bool
+CaeUnsPrint3D::elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+    Print3DElem &elem) const
 {
-    if (v0.index() != v1.index()) {
-        PWGM_VERTDATA vd0;
-        PWGM_VERTDATA vd1;
-        if (v0.dataMod(vd0) && v1.dataMod(vd1)) {
-            Edge e(vd0.i, vd1.i);
-            if (isNewEdge(e)) {
-                writeCylinder(vd0, vd1);
-            }
-        }
+    PWGM_ELEMDATA eData;
+    bool ret = false;
+    if (isBlock(ndx)) {
+        CaeUnsBlock block(model_, ndx - numPatches_);
+        ret = CaeUnsElement(block, elemNdx).data(eData);
     }
-}
-
-
-void
-CaeUnsPrint3D::writePolygon(const CaeUnsVertex &v0, const CaeUnsVertex &v1,
-    const CaeUnsVertex &v2, const CaeUnsVertex &v3)
-{
-    writeEdge(v0, v1);
-    writeEdge(v1, v2);
-    writeEdge(v2, v3);
-    writeEdge(v3, v0);
-}
-
-
-void
-CaeUnsPrint3D::writePolygon(const CaeUnsVertex &v0, const CaeUnsVertex &v1,
-    const CaeUnsVertex &v2)
-{
-    writeEdge(v0, v1);
-    writeEdge(v1, v2);
-    writeEdge(v2, v0);
-}
-
-
-void
-CaeUnsPrint3D::writeThickenedPolygon(const vector3 &tp0, const vector3 &tp1,
-    const vector3 &tp2)
-{
-    double halfThickness = radius_;
-    vector3 norm = cml::cross((tp1 - tp0), (tp2 - tp1)).normalize();
-    vector3 offset = norm * halfThickness;
-    // "thicken" by halfThickness to either side of tri pts
-    vector3 p0 = tp0 - offset;
-    vector3 p1 = tp1 - offset;
-    vector3 p2 = tp2 - offset;
-    vector3 p3 = tp0 + offset;
-    vector3 p4 = tp1 + offset;
-    vector3 p5 = tp2 + offset;
-    // In STL, the facet normal should be a unit vector pointing OUTWARDS from
-    // the solid object.
-    //
-    // we now have the 6 prism points - write out the solid
-    beginMultiSolid();
-    writeTriFacet(p0, p2, p1);
-    writeTriFacet(p3, p4, p5);
-    writeQuadFacet(p0, p1, p4, p3);
-    writeQuadFacet(p1, p2, p5, p4);
-    writeQuadFacet(p2, p0, p3, p5);
-    endMultiSolid();
-}
-
-
-void
-CaeUnsPrint3D::writeThickenedPolygon(const CaeUnsVertex &v0, const CaeUnsVertex &v1,
-    const CaeUnsVertex &v2)
-{
-    PWGM_VERTDATA vd0;
-    PWGM_VERTDATA vd1;
-    PWGM_VERTDATA vd2;
-    if (PwVertDataMod(v0, &vd0) && PwVertDataMod(v1, &vd1) &&
-            PwVertDataMod(v2, &vd2)) {
-        vector3 p0(vd0.x, vd0.y, vd0.z);
-        vector3 p1(vd1.x, vd1.y, vd1.z);
-        vector3 p2(vd2.x, vd2.y, vd2.z);
-        writeThickenedPolygon(p0, p1, p2);
+    else {
+        CaeUnsPatch patch(model_, ndx);
+        ret = CaeUnsElement(patch, elemNdx).data(eData);
+    }
+    if (ret) {
+        elem.type = eData.type;
+        elem.vertCnt = eData.vertCnt;
+        for (PWP_UINT32 ii = 0; ret && (ii < eData.vertCnt); ++ii) {
+            ret = CaeUnsVertex(eData.vert[ii]).dataMod(elem.vert[ii]);
+        }
     }
+    return ret;
 }
 
 
-void
-CaeUnsPrint3D::writeThickenedPolygon(const vector3 &qp0, const vector3 &qp1,
-    const vector3 &qp2, const vector3 &qp3)
-{
-    vector3 norm0 = cml::cross((qp1 - qp0), (qp2 - qp0)).normalize();
-    vector3 norm1 = cml::cross((qp2 - qp0), (qp3 - qp0)).normalize();
-    vector3 normSeam = (norm0 + norm1).normalize(); // diag seam normal
-    // thicken this amount to either side of tri
-    double halfThickness = radius_;
-    // Account for non-planar quad to make thickness uniform
-    // dot(norm0, normSeam) == dot(norm1, normSeam) == cos(angle). Where,
-    // angle (in radians) is between norm0/norm1 and normSeam.
-    // For a right-triangle: cos(angle) = opp / hyp
-    // Hence: hyp = opp / cos(angle)
-    // For this geometry, seamThickness == hyp
-    double seamThickness = halfThickness / dot(norm0, normSeam);
-    vector3 offset0 = norm0 * halfThickness;
-    vector3 offset1 = norm1 * halfThickness;
-    vector3 offsetSeam = normSeam * seamThickness;
-    // hex base pts
-    vector3 p0 = qp0 - offsetSeam;
-    vector3 p1 = qp1 - offset0;
-    vector3 p2 = qp2 - offsetSeam;
-    vector3 p3 = qp3 - offset1;
-    // hex top pts
-    vector3 p4 = qp0 + offsetSeam;
-    vector3 p5 = qp1 + offset0;
-    vector3 p6 = qp2 + offsetSeam;
-    vector3 p7 = qp3 + offset1;
-    // In STL, the facet normal should be a unit vector pointing OUTWARDS from
-    // the solid object.
-    // we now have the 8 hex points - write out the solid
-    beginMultiSolid();
-    writeQuadFacet(p0, p3, p2, p1);
-    writeQuadFacet(p4, p5, p6, p7);
-    writeQuadFacet(p0, p1, p5, p4);
-    writeQuadFacet(p1, p2, p6, p5);
-    writeQuadFacet(p2, p3, p7, p6);
-    writeQuadFacet(p3, p0, p4, p7);
-    endMultiSolid();
-}
-
-
-void
-CaeUnsPrint3D::writeThickenedPolygon(const CaeUnsVertex &v0, const CaeUnsVertex &v1,
-    const CaeUnsVertex &v2, const CaeUnsVertex &v3)
-{
-    PWGM_VERTDATA vd0;
-    PWGM_VERTDATA vd1;
-    PWGM_VERTDATA vd2;
-    PWGM_VERTDATA vd3;
-    if (PwVertDataMod(v0, &vd0) && PwVertDataMod(v1, &vd1) &&
-            PwVertDataMod(v2, &vd2) && PwVertDataMod(v3, &vd3)) {
-        vector3 p0(vd0.x, vd0.y, vd0.z);
-        vector3 p1(vd1.x, vd1.y, vd1.z);
-        vector3 p2(vd2.x, vd2.y, vd2.z);
-        vector3 p3(vd3.x, vd3.y, vd3.z);
-        writeThickenedPolygon(p0, p1, p2, p3);
-    }
-}
 
+//===========================================================================
+// Print3DHost implementation
+//===========================================================================
 
-void
-CaeUnsPrint3D::writeElemData(PWGM_ELEMDATA &ed, bool solid)
+bool
+CaeUnsPrint3D::progressBeginStep(PWP_UINT32 total)
 {
-    switch (ed.type) {
-        case PWGM_ELEMTYPE_POINT:
-            break;
-        case PWGM_ELEMTYPE_BAR:
-            writeEdge(ed.vert[0], ed.vert[1]);
-            break;
-        case PWGM_ELEMTYPE_QUAD:
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2], ed.vert[3]);
-            if (solid) {
-                writeThickenedPolygon(ed.vert[0], ed.vert[1], ed.vert[2],
-                    ed.vert[3]);
-            }
-            break;
-        case PWGM_ELEMTYPE_TRI:
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2]);
-            if (solid) {
-                writeThickenedPolygon(ed.vert[0], ed.vert[1],
-                    ed.vert[2]);
-            }
-            break;
-        case PWGM_ELEMTYPE_HEX:
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2], ed.vert[3]);
-            writePolygon(ed.vert[4], ed.vert[5], ed.vert[6], ed.vert[7]);
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[5], ed.vert[4]);
-            writePolygon(ed.vert[1], ed.vert[2], ed.vert[6], ed.vert[5]);
-            writePolygon(ed.vert[2], ed.vert[3], ed.vert[7], ed.vert[6]);
-            writePolygon(ed.vert[3], ed.vert[0], ed.vert[4], ed.vert[7]);
-            break;
-        case PWGM_ELEMTYPE_TET:
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2]);
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[3]);
-            writePolygon(ed.vert[1], ed.vert[2], ed.vert[3]);
-            writePolygon(ed.vert[2], ed.vert[0], ed.vert[3]);
-            break;
-        case PWGM_ELEMTYPE_WEDGE:
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2]);
-            writePolygon(ed.vert[3], ed.vert[4], ed.vert[5]);
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[4], ed.vert[3]);
-            writePolygon(ed.vert[1], ed.vert[2], ed.vert[5], ed.vert[4]);
-            writePolygon(ed.vert[2], ed.vert[0], ed.vert[3], ed.vert[5]);
-            break;
-        case PWGM_ELEMTYPE_PYRAMID:
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2], ed.vert[3]);
-            writePolygon(ed.vert[0], ed.vert[1], ed.vert[4]);
-            writePolygon(ed.vert[1], ed.vert[2], ed.vert[4]);
-            writePolygon(ed.vert[2], ed.vert[3], ed.vert[4]);
-            writePolygon(ed.vert[3], ed.vert[0], ed.vert[4]);
-            break;
-    }
+    return CaeUnsPlugin::progressBeginStep(total);
 }
 
-
-void
-CaeUnsPrint3D::writeHeader()
+bool
+CaeUnsPrint3D::progressIncrement()
 {
-    if (isBinaryEncoding()) {
-        // fill with zeros
-        memset(curSolidName_, 0, NameBufSize);
-        strcpy(curSolidName_, SolidName);
-        pwpFileWrite(curSolidName_, 1, 80, fp());
-        rtFile_.getPos(numTrisPos_);
-        // write placeholder - writeFooter() will replace with final value
-        numTris_ = 0;
-        rtFile_.write(numTris_);
-    }
-    else if (!multiSolid_) {
-        // ASCII
-        strcpy(curSolidName_, SolidName);
-        writeStr("solid %s\n", curSolidName_);
-    }
+    return CaeUnsPlugin::progressIncrement();
 }
 
-
 void
-CaeUnsPrint3D::writeFooter()
+CaeUnsPrint3D::progressEndStep()
 {
-    if (isBinaryEncoding()) {
-        // update placeholder with actual tri count
-        //if (rtFile_.setPos(numTrisPos_)) {
-        //    rtFile_.write(numTris_);
-        //}
-        // BUG in setPos()!
-        if (0 == pwpFileSetpos(fp(), &numTrisPos_)) {
-            pwpFileWrite(&numTris_, sizeof(numTris_), 1, fp());
-        }
-    }
-    else if (!multiSolid_) {
-        // ASCII
-        writeStr("endsolid %s\n", curSolidName_);
-    }
+    CaeUnsPlugin::progressEndStep();
 }
 
-
 bool
-CaeUnsPrint3D::writePatch(const CaeUnsPatch &patch)
+CaeUnsPrint3D::aborted()
 {
-    bool ret = false;
-    if (!patch.isValid()) {
-        // bad
-        ret = false;
-    }
-    else if (isHidden(patch)) {
-        // silently skip
-        ret = true;
-    }
-    else {
-        PWGM_ELEMDATA eData;
-        CaeUnsElement element(patch);
-        while (element.data(eData) && progressIncrement()) {
-            writeElemData(eData, isSolid(patch));
-            ++element;
-        }
-        ret = !aborted();
-    }
-    return ret;
+    return CaeUnsPlugin::aborted();
 }
 
-
 void
-CaeUnsPrint3D::writePatches()
+CaeUnsPrint3D::sendInfoMsg(const char *msg)
 {
-    if (aborted()) {
-        return;
-    }
-    PWP_UINT32 steps = 0;
-    CaeUnsPatch patch(model_);
-    while (patch.isValid()) {
-        if (!isHidden(patch)) {
-            steps += patch.elementCount();
-        }
-        ++patch;
-    }
-    if (progressBeginStep(steps)) {
-        patch.moveFirst(model_);
-        while (writePatch(patch)) {
-            ++patch;
-        }
-        progressEndStep();
-    }
+    CaeUnsPlugin::sendInfoMsg(msg);
 }
 
-
-bool
-CaeUnsPrint3D::writeBlock(const CaeUnsBlock &block)
+void
+CaeUnsPrint3D::sendWarningMsg(const char *msg)
 {
-    bool ret = false;
-    if (!block.isValid()) {
-        // bad
-        ret = false;
-    }
-    else if (isHidden(block)) {
-        // silently skip
-        ret = true;
-    }
-    else {
-        PWGM_ELEMDATA eData;
-        CaeUnsElement element(block);
-        while (element.data(eData) && progressIncrement()) {
-            writeElemData(eData, isSolid(block));
-            ++element;
-        }
-        ret = !aborted();
-    }
-    return ret;
+    CaeUnsPlugin::sendWarningMsg(msg);
 }
 
-
 void
-CaeUnsPrint3D::writeBlocks()
+CaeUnsPrint3D::sendErrorMsg(const char *msg)
 {
-    if (aborted()) {
-        return;
-    }
-    PWP_UINT32 steps = 0;
-    CaeUnsBlock block(model_);
-    while (block.isValid()) {
-        if (!isHidden(block)) {
-            steps += block.elementCount();
-        }
-        ++block;
-    }
-    if (progressBeginStep(steps)) {
-        block.moveFirst(model_);
-        while (writeBlock(block)) {
-            ++block;
-        }
-        progressEndStep();
-    }
+    CaeUnsPlugin::sendErrorMsg(msg);
 }
 
 
@@ -766,9 +500,88 @@ CaeUnsPrint3D::create(CAEP_RTITEM &rti)
         publishRealValueDef(rti, AttrEdgeDiameter, DefCylDiam,
             "Edge inflation diameter") &&
         publishBoolValueDef(rti, AttrMultiSolid, true,
-            "Export inflated edges as individual solid bodies (ASCII only)") &&
+            "Export inflated edges as individual solid bodies") &&
+        publishEnumValueDef(rti, AttrSolidScope, "Cylinder",
+            "One solid per inflated edge, patch/block, cluster of nearby "
+            "edges or connected piece", "Cylinder|Entity|Cluster|Component") &&
+        publishUIntValueDef(rti, AttrClusterTris, DefClusterTris,
+            "Largest SolidScope Cluster solid, in triangles", 1,
+            100000000) &&
+        publishEnumValueDef(rti, AttrSolidIds, "Plain",
+            "Binary solid id stored in the facet attribute bytes",
+            "Plain|VisCAM|Magics") &&
+        publishBoolValueDef(rti, AttrBeamLattice, false,
+            "Export a .3mf file as a beam lattice of the edges, without "
+            "cylinders") &&
+        publishBoolValueDef(rti, AttrSdfUnion, false,
+            "Export the surface of the union of the inflated edges") &&
+        publishUIntValueDef(rti, AttrSdfResolution, DefSdfRes,
+            "SdfUnion samples per edge diameter", MinSdfRes, MaxSdfRes) &&
+        publishBoolValueDef(rti, AttrHubLattice, false,
+            "Export the edges as struts joined at convex hubs, one closed "
+            "surface") &&
+        publishUIntValueDef(rti, AttrThreads, 0,
+            "Number of worker threads (0 = one per processor). More than "
+            "one pipelines a plain STL export, 1 keeps it sequential", 0,
+            MaxThreads) &&
+        publishRealValueDef(rti, AttrSliceThickness, DefSliceThick,
+            "Layer thickness of a .cli slice export") &&
+        publishStringValueDef(rti, AttrSweepDiameters, "",
+            "Comma-separated EdgeDiameter values to export in one pass") &&
+        publishStringValueDef(rti, AttrSweepNumPoints, "",
+            "Comma-separated NumPoints values to export in one pass") &&
+        publishStringValueDef(rti, AttrSweepFormats, "",
+            "Comma-separated extra formats (stl, 3mf, cli) to export") &&
+        publishEnumValueDef(rti, AttrSnapshot, "Off",
+            "Write or export from a grid snapshot next to the export file",
+            "Off|Write|Read") &&
         publishUIntValueDef(rti, AttrNumPoints, DefNumBasePts,
-            "Number of inflated edge points", MinNumBasePts, MaxNumBasePts);
+            "Number of inflated edge points", MinNumBasePts, MaxNumBasePts) &&
+        publishRealValueDef(rti, AttrCylTolerance, 0.0,
+            "Largest point error when reusing the inflated edge of a nearby "
+            "direction (0 = exact)") &&
+        publishEnumValueDef(rti, AttrEdgeMode, "All",
+            "Inflate all edges, the boundary edges or the feature edges",
+            "All|Boundary|Feature") &&
+        publishUIntValueDef(rti, AttrBndryLayers, 0,
+            "Cell layers next to the boundary kept by EdgeMode Boundary", 0,
+            MaxBndryLayers) &&
+        publishRealValueDef(rti, AttrFeatureAngle, DefFeatureAngle,
+            "Least angle between the faces of an EdgeMode Feature edge",
+            0.0, 90.0) &&
+        publishStringValueDef(rti, AttrClipBoxes, "",
+            "Export only the edges meeting these boxes, "
+            "xmin,ymin,zmin,xmax,ymax,zmax;...") &&
+        publishStringValueDef(rti, AttrClipHalfSpaces, "",
+            "Export only the edges meeting these half-spaces "
+            "a*x + b*y + c*z <= d, a,b,c,d;...") &&
+        publishBoolValueDef(rti, AttrClipTrim, false,
+            "Cut the edges crossing the clip regions at their boundaries") &&
+        publishBoolValueDef(rti, AttrWeldVerts, false,
+            "Merge the coincident vertices of touching patches and "
+            "blocks") &&
+        publishRealValueDef(rti, AttrWeldTol, 0.0,
+            "Largest distance between welded vertices (0 = coincident)") &&
+        publishBoolValueDef(rti, AttrMergeChains, false,
+            "Inflate each run of collinear edges as one cylinder") &&
+        publishRealValueDef(rti, AttrChainTol, 0.0,
+            "Largest distance of a merged vertex from its chain's axis "
+            "(0 = collinear)") &&
+        publishEnumValueDef(rti, AttrEdgeOrder, "Traversal",
+            "Write the STL cylinders in traversal order or along a "
+            "space-filling curve", "Traversal|Morton|Hilbert") &&
+        publishBoolValueDef(rti, AttrTessCache, false,
+            "Reuse the cached facets of unchanged patches and blocks") &&
+        publishBoolValueDef(rti, AttrCheckpoint, false,
+            "Save the progress so that an interrupted export can resume") &&
+        publishUIntValueDef(rti, AttrPartCount, 1,
+            "Number of partitions exported by separate runs", 1,
+            MaxPartitions) &&
+        publishUIntValueDef(rti, AttrPartRank, 0,
+            "Partition exported by this run (0 to PartitionCount-1)", 0,
+            MaxPartitions - 1) &&
+        publishBoolValueDef(rti, AttrPartMerge, false,
+            "Merge the PartitionCount partial files into the export file");
 }
 
 
@@ -0,0 +1,206 @@
+/****************************************************************************
+ *
+ * class Checkpoint
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#if defined(_WIN32)
+#   include <io.h>
+#   include <windows.h>
+#else
+#   include <unistd.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "Checkpoint.h"
+
+static const char       CheckpointMagic[8] =
+                            { 'P','3','D','C','K','P','T','1' };
+static const PWP_UINT32 CheckpointVersion = 1;
+
+
+template<typename T>
+static bool
+readVal(FILE *fp, T &val)
+{
+    return 1 == fread(&val, sizeof(val), 1, fp);
+}
+
+
+template<typename T>
+static bool
+writeVal(FILE *fp, const T &val)
+{
+    return 1 == fwrite(&val, sizeof(val), 1, fp);
+}
+
+
+static long
+bytesLeft(FILE *fp)
+{
+    // the bytes after the current position, or -1 if unknown
+    const long pos = ftell(fp);
+    if ((pos < 0) || (0 != fseek(fp, 0, SEEK_END))) {
+        return -1;
+    }
+    const long end = ftell(fp);
+    if ((end < 0) || (0 != fseek(fp, pos, SEEK_SET))) {
+        return -1;
+    }
+    return end - pos;
+}
+
+
+static bool
+syncFile(FILE *fp)
+{
+    // flushes the file through to the disk
+    if (0 != fflush(fp)) {
+        return false;
+    }
+#if defined(_WIN32)
+    return 0 == _commit(_fileno(fp));
+#else
+    return 0 == fsync(fileno(fp));
+#endif
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+Checkpoint::Checkpoint() :
+    key(0),
+    numDone(0),
+    numTris(0),
+    numSolids(0),
+    manifest(),
+    segments()
+{
+}
+
+
+Checkpoint::~Checkpoint()
+{
+}
+
+
+bool
+Checkpoint::load(const std::string &path, PWP_UINT64 k)
+{
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (0 == fp) {
+        return false;
+    }
+    char magic[sizeof(CheckpointMagic)];
+    PWP_UINT32 version;
+    PWP_UINT64 fileKey;
+    PWP_UINT64 size;
+    PWP_UINT32 numSegs;
+    bool ret = (1 == fread(magic, sizeof(magic), 1, fp)) &&
+        (0 == memcmp(magic, CheckpointMagic, sizeof(magic))) &&
+        readVal(fp, version) && (CheckpointVersion == version) &&
+        readVal(fp, fileKey) && (k == fileKey) && readVal(fp, numDone) &&
+        readVal(fp, numTris) && readVal(fp, numSolids) &&
+        readVal(fp, size) && readVal(fp, numSegs);
+    // The manifest and the segment sizes are the rest of the file, so a
+    // corrupt size is rejected before anything is allocated for it.
+    if (ret) {
+        const long left = bytesLeft(fp);
+        const PWP_UINT64 segBytes = numSegs * (PWP_UINT64)sizeof(PWP_UINT64);
+        ret = (left >= 0) && ((PWP_UINT64)left >= segBytes) &&
+            (size == (PWP_UINT64)left - segBytes);
+    }
+    if (ret) {
+        manifest.resize((size_t)size);
+        segments.resize(numSegs);
+        ret = ((0 == size) || (1 == fread(&manifest[0], (size_t)size, 1, fp)))
+            && ((0 == numSegs) ||
+                (1 == fread(&segments[0], numSegs * sizeof(PWP_UINT64), 1,
+                    fp)));
+    }
+    fclose(fp);
+    // each completed entity has at most one manifest line
+    ret = ret && (manifest.empty() || ('\n' == manifest[manifest.size() - 1]))
+        && ((size_t)std::count(manifest.begin(), manifest.end(), '\n') <=
+            numDone);
+    for (size_t ii = 0; ret && (ii < segments.size()); ++ii) {
+        FILE *seg = fopen(segmentPath(path, ii).c_str(), "rb");
+        ret = (0 != seg);
+        if (ret) {
+            fclose(seg);
+        }
+    }
+    if (ret) {
+        key = k;
+    }
+    else {
+        *this = Checkpoint();
+    }
+    return ret;
+}
+
+
+bool
+Checkpoint::save(const std::string &path) const
+{
+    const std::string tmpPath = path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (0 == fp) {
+        return false;
+    }
+    bool ret = (1 == fwrite(CheckpointMagic, sizeof(CheckpointMagic), 1,
+            fp)) &&
+        writeVal(fp, CheckpointVersion) && writeVal(fp, key) &&
+        writeVal(fp, numDone) && writeVal(fp, numTris) &&
+        writeVal(fp, numSolids) && writeVal(fp, (PWP_UINT64)manifest.size()) &&
+        writeVal(fp, (PWP_UINT32)segments.size()) &&
+        (manifest.empty() ||
+         (1 == fwrite(manifest.data(), manifest.size(), 1, fp))) &&
+        (segments.empty() ||
+         (1 == fwrite(&segments[0], segments.size() * sizeof(PWP_UINT64), 1,
+            fp)));
+    // The new checkpoint is on the disk before it replaces the old one,
+    // and the replacement itself is a single step.
+    ret = ret && syncFile(fp);
+    ret = (0 == fclose(fp)) && ret;
+#if defined(_WIN32)
+    ret = ret && (0 != MoveFileExA(tmpPath.c_str(), path.c_str(),
+        MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH));
+#else
+    ret = ret && (0 == rename(tmpPath.c_str(), path.c_str()));
+#endif
+    if (!ret) {
+        ::remove(tmpPath.c_str());
+    }
+    return ret;
+}
+
+
+void
+Checkpoint::remove(const std::string &path)
+{
+    ::remove(path.c_str());
+    size_t seg = 0;
+    while (0 == ::remove(segmentPath(path, seg).c_str())) {
+        ++seg;
+    }
+}
+
+
+std::string
+Checkpoint::segmentPath(const std::string &path, size_t seg)
+{
+    char ext[32];
+    sprintf(ext, ".%lu", (unsigned long)seg);
+    return path + ext;
+}
@@ -0,0 +1,52 @@
+/****************************************************************************
+ *
+ * class Checkpoint
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include "apiPWP.h"
+
+#include <string>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// The state of an STL export after its last completed patch or block.  //
+// The facets are written to segment files next to the checkpoint, one  //
+// per run. A later run with the same key skips the completed entities, //
+// appends to a new segment, and finally copies the segments into the   //
+// export file.                                                         //
+//////////////////////////////////////////////////////////////////////////
+struct Checkpoint {
+    Checkpoint();
+    ~Checkpoint();
+
+    // Reads the checkpoint at path. Returns false if there is none, if it
+    // is corrupt, if its key differs or if a segment file is missing.
+    bool    load(const std::string &path, PWP_UINT64 key);
+
+    // Replaces the checkpoint at path. A crash leaves either the old or
+    // the new one.
+    bool    save(const std::string &path) const;
+
+    // removes the checkpoint at path and its segment files
+    static void remove(const std::string &path);
+
+    static std::string  segmentPath(const std::string &path, size_t seg);
+
+    PWP_UINT64                  key;        // the settings and grid hash
+    PWP_UINT32                  numDone;    // the completed entity slots
+    PWP_UINT32                  numTris;
+    PWP_UINT32                  numSolids;
+    std::string                 manifest;
+    std::vector<PWP_UINT64>     segments;   // the valid bytes of each
+};
+
+#endif // _CHECKPOINT_H_
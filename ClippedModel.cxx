@@ -0,0 +1,359 @@
+/****************************************************************************
+ *
+ * class ClippedModel
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <stdlib.h>
+
+#include "ClippedModel.h"
+
+
+static const char *
+skipSpaces(const char *p)
+{
+    while ((' ' == *p) || ('\t' == *p)) {
+        ++p;
+    }
+    return p;
+}
+
+
+// Appends the numbers of a list of groups of cnt comma-separated numbers.
+// The groups are separated by semicolons. Returns false if a group is
+// malformed.
+static bool
+parseGroups(const std::string &list, size_t cnt, std::vector<double> &vals)
+{
+    const char *p = skipSpaces(list.c_str());
+    while ('\0' != *p) {
+        for (size_t ii = 0; ii < cnt; ++ii) {
+            char *end = 0;
+            const double val = strtod(p, &end);
+            if ((end == p) || (val != val)) {
+                return false;
+            }
+            vals.push_back(val);
+            p = skipSpaces(end);
+            if (ii + 1 < cnt) {
+                if (',' != *p) {
+                    return false;
+                }
+                ++p;
+            }
+        }
+        if (';' == *p) {
+            p = skipSpaces(p + 1);
+        }
+        else if ('\0' != *p) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static void
+lerp(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1, double t,
+    PWP_UINT32 vert, PWGM_VERTDATA &vd)
+{
+    vd.x = vd0.x + t * (vd1.x - vd0.x);
+    vd.y = vd0.y + t * (vd1.y - vd0.y);
+    vd.z = vd0.z + t * (vd1.z - vd0.z);
+    vd.i = vert;
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+ClippedModel::ClippedModel(Print3DModel &model) :
+    model_(model),
+    boxes_(),
+    halfSpaces_(),
+    culled_()
+{
+}
+
+
+ClippedModel::~ClippedModel()
+{
+}
+
+
+bool
+ClippedModel::addBoxes(const std::string &list)
+{
+    std::vector<double> vals;
+    if (!parseGroups(list, 6, vals)) {
+        return false;
+    }
+    for (size_t ii = 0; ii < vals.size(); ii += 6) {
+        if ((vals[ii] > vals[ii + 3]) || (vals[ii + 1] > vals[ii + 4]) ||
+                (vals[ii + 2] > vals[ii + 5])) {
+            return false;
+        }
+    }
+    boxes_.insert(boxes_.end(), vals.begin(), vals.end());
+    return true;
+}
+
+
+bool
+ClippedModel::addHalfSpaces(const std::string &list)
+{
+    std::vector<double> vals;
+    if (!parseGroups(list, 4, vals)) {
+        return false;
+    }
+    for (size_t ii = 0; ii < vals.size(); ii += 4) {
+        if ((0.0 == vals[ii]) && (0.0 == vals[ii + 1]) &&
+                (0.0 == vals[ii + 2])) {
+            return false;
+        }
+    }
+    halfSpaces_.insert(halfSpaces_.end(), vals.begin(), vals.end());
+    return true;
+}
+
+
+PWP_UINT32
+ClippedModel::cull()
+{
+    const PWP_UINT32 numEntities = model_.entityCount();
+    PWP_UINT32 ret = 0;
+    culled_.assign(numEntities, false);
+    double minXyz[3];
+    double maxXyz[3];
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        if ((Print3DCondHidden != model_.condition(ndx)) &&
+                model_.bounds(ndx, minXyz, maxXyz) && !meets(minXyz, maxXyz)) {
+            culled_[ndx] = true;
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+
+bool
+ClippedModel::meets(const double *minXyz, const double *maxXyz) const
+{
+    if ((minXyz[0] > maxXyz[0]) || (minXyz[1] > maxXyz[1]) ||
+            (minXyz[2] > maxXyz[2])) {
+        // empty
+        return false;
+    }
+    size_t ii;
+    for (ii = 0; ii < boxes_.size(); ii += 6) {
+        const double *box = &boxes_[ii];
+        if ((minXyz[0] <= box[3]) && (maxXyz[0] >= box[0]) &&
+                (minXyz[1] <= box[4]) && (maxXyz[1] >= box[1]) &&
+                (minXyz[2] <= box[5]) && (maxXyz[2] >= box[2])) {
+            return true;
+        }
+    }
+    for (ii = 0; ii < halfSpaces_.size(); ii += 4) {
+        // the corner of the box that is deepest in the half-space
+        const double *hs = &halfSpaces_[ii];
+        double dist = -hs[3];
+        for (int jj = 0; jj < 3; ++jj) {
+            dist += hs[jj] * ((hs[jj] > 0.0) ? minXyz[jj] : maxXyz[jj]);
+        }
+        if (dist <= 0.0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool
+ClippedModel::meets(const Print3DElem &elem) const
+{
+    if (0 == elem.vertCnt) {
+        return false;
+    }
+    double minXyz[3] = { elem.vert[0].x, elem.vert[0].y, elem.vert[0].z };
+    double maxXyz[3] = { elem.vert[0].x, elem.vert[0].y, elem.vert[0].z };
+    for (PWP_UINT32 ii = 1; ii < elem.vertCnt; ++ii) {
+        const double xyz[3] = { elem.vert[ii].x, elem.vert[ii].y,
+            elem.vert[ii].z };
+        for (int jj = 0; jj < 3; ++jj) {
+            if (xyz[jj] < minXyz[jj]) {
+                minXyz[jj] = xyz[jj];
+            }
+            else if (xyz[jj] > maxXyz[jj]) {
+                maxXyz[jj] = xyz[jj];
+            }
+        }
+    }
+    return meets(minXyz, maxXyz);
+}
+
+
+bool
+ClippedModel::meets(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1) const
+{
+    double t0;
+    double t1;
+    return span(vd0, vd1, t0, t1);
+}
+
+
+bool
+ClippedModel::trim(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1,
+    PWGM_VERTDATA *seg) const
+{
+    double t0;
+    double t1;
+    if (!span(vd0, vd1, t0, t1)) {
+        return false;
+    }
+    // the ends inside the regions are kept exactly
+    seg[0] = vd0;
+    seg[1] = vd1;
+    if (t0 > 0.0) {
+        lerp(vd0, vd1, t0, vd0.i, seg[0]);
+    }
+    if (t1 < 1.0) {
+        lerp(vd0, vd1, t1, vd1.i, seg[1]);
+    }
+    return true;
+}
+
+
+PWP_UINT32
+ClippedModel::entityCount() const
+{
+    return model_.entityCount();
+}
+
+
+bool
+ClippedModel::isBlock(PWP_UINT32 ndx) const
+{
+    return model_.isBlock(ndx);
+}
+
+
+Print3DCond
+ClippedModel::condition(PWP_UINT32 ndx) const
+{
+    return ((ndx < culled_.size()) && culled_[ndx]) ? Print3DCondHidden :
+        model_.condition(ndx);
+}
+
+
+std::string
+ClippedModel::entityName(PWP_UINT32 ndx) const
+{
+    return model_.entityName(ndx);
+}
+
+
+PWP_UINT32
+ClippedModel::elementCount(PWP_UINT32 ndx) const
+{
+    return model_.elementCount(ndx);
+}
+
+
+bool
+ClippedModel::elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+    Print3DElem &elem) const
+{
+    return model_.elementData(ndx, elemNdx, elem);
+}
+
+
+bool
+ClippedModel::ownedEdges(PWP_UINT32 ndx, const PWP_UINT32 *&verts,
+    PWP_UINT32 &count) const
+{
+    return model_.ownedEdges(ndx, verts, count);
+}
+
+
+bool
+ClippedModel::vertexData(PWP_UINT32 vert, PWGM_VERTDATA &vd) const
+{
+    return model_.vertexData(vert, vd);
+}
+
+
+bool
+ClippedModel::bounds(PWP_UINT32 ndx, double *minXyz, double *maxXyz) const
+{
+    return model_.bounds(ndx, minXyz, maxXyz);
+}
+
+
+bool
+ClippedModel::span(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1,
+    double &t0, double &t1) const
+{
+    // The hull of the parameter intervals of the segment in each region.
+    // The interval in a box is cut down one slab at a time.
+    const double p0[3] = { vd0.x, vd0.y, vd0.z };
+    const double dir[3] = { vd1.x - vd0.x, vd1.y - vd0.y, vd1.z - vd0.z };
+    t0 = 1.0;
+    t1 = 0.0;
+    size_t ii;
+    for (ii = 0; ii < boxes_.size(); ii += 6) {
+        const double *box = &boxes_[ii];
+        double lo = 0.0;
+        double hi = 1.0;
+        for (int jj = 0; (jj < 3) && (lo < hi); ++jj) {
+            if (0.0 == dir[jj]) {
+                if ((p0[jj] < box[jj]) || (p0[jj] > box[jj + 3])) {
+                    hi = lo;
+                }
+                continue;
+            }
+            double ta = (box[jj] - p0[jj]) / dir[jj];
+            double tb = (box[jj + 3] - p0[jj]) / dir[jj];
+            if (ta > tb) {
+                const double tmp = ta;
+                ta = tb;
+                tb = tmp;
+            }
+            lo = (ta > lo) ? ta : lo;
+            hi = (tb < hi) ? tb : hi;
+        }
+        if (lo < hi) {
+            t0 = (lo < t0) ? lo : t0;
+            t1 = (hi > t1) ? hi : t1;
+        }
+    }
+    for (ii = 0; ii < halfSpaces_.size(); ii += 4) {
+        // the signed distances of the ends from the plane, times |a, b, c|
+        const double *hs = &halfSpaces_[ii];
+        const double f0 = hs[0] * vd0.x + hs[1] * vd0.y + hs[2] * vd0.z -
+            hs[3];
+        const double f1 = hs[0] * vd1.x + hs[1] * vd1.y + hs[2] * vd1.z -
+            hs[3];
+        double lo = 0.0;
+        double hi = 1.0;
+        if ((f0 > 0.0) && (f1 > 0.0)) {
+            continue;
+        }
+        else if (f0 > 0.0) {
+            lo = f0 / (f0 - f1);
+        }
+        else if (f1 > 0.0) {
+            hi = f0 / (f0 - f1);
+        }
+        if (lo < hi) {
+            t0 = (lo < t0) ? lo : t0;
+            t1 = (hi > t1) ? hi : t1;
+        }
+    }
+    return t0 < t1;
+}
@@ -0,0 +1,99 @@
+/****************************************************************************
+ *
+ * class ClippedModel
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _CLIPPEDMODEL_H_
+#define _CLIPPEDMODEL_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include "Print3DModel.h"
+
+#include <string>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// A Print3DModel that limits another one to the union of some clip    //
+// regions, axis-aligned boxes and half-spaces. cull() hides the        //
+// patches and blocks whose bounding box meets no region, so the export //
+// never visits their elements. The entities that the model cannot     //
+// bound stay visible. The exporter then drops the edges and thickened  //
+// elements that miss the regions and may trim the edges that cross    //
+// them.                                                                //
+// An edge owned by a hidden entity lies in its bounding box and misses //
+// the regions too, so the owned edges of the other entities are still //
+// complete.                                                            //
+//////////////////////////////////////////////////////////////////////////
+class ClippedModel : public Print3DModel {
+public:
+    ClippedModel(Print3DModel &model);
+    virtual ~ClippedModel();
+
+    // Adds the boxes of a list "xmin,ymin,zmin,xmax,ymax,zmax;..." or the
+    // half-spaces a * x + b * y + c * z <= d of a list "a,b,c,d;...".
+    // Returns false if the list is malformed, a box is inverted or a
+    // half-space has no normal.
+    bool        addBoxes(const std::string &list);
+    bool        addHalfSpaces(const std::string &list);
+
+    PWP_UINT32  regionCount() const {
+                    return (PWP_UINT32)(boxes_.size() / 6 +
+                        halfSpaces_.size() / 4); }
+
+    // Hides the visible entities whose bounding box meets no region.
+    // Returns the number hidden.
+    PWP_UINT32  cull();
+
+    // true if the box from minXyz to maxXyz meets a region
+    bool        meets(const double *minXyz, const double *maxXyz) const;
+
+    // true if the bounding box of an element meets a region
+    bool        meets(const Print3DElem &elem) const;
+
+    // true if the segment from vd0 to vd1 meets a region in more than a
+    // point
+    bool        meets(const PWGM_VERTDATA &vd0,
+                    const PWGM_VERTDATA &vd1) const;
+
+    // Sets seg to the part of the segment from vd0 to vd1 between its
+    // first entry into the regions and its last exit. A trimmed end keeps
+    // the vertex index of the end it replaces. Returns false if the
+    // segment misses the regions.
+    bool        trim(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1,
+                    PWGM_VERTDATA *seg) const;
+
+    virtual PWP_UINT32  entityCount() const;
+    virtual bool        isBlock(PWP_UINT32 ndx) const;
+    virtual Print3DCond condition(PWP_UINT32 ndx) const;
+    virtual std::string entityName(PWP_UINT32 ndx) const;
+    virtual PWP_UINT32  elementCount(PWP_UINT32 ndx) const;
+
+    // safe to call from several threads if the clipped model's is
+    virtual bool        elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+                            Print3DElem &elem) const;
+    virtual bool        ownedEdges(PWP_UINT32 ndx, const PWP_UINT32 *&verts,
+                            PWP_UINT32 &count) const;
+    virtual bool        vertexData(PWP_UINT32 vert, PWGM_VERTDATA &vd) const;
+    virtual bool        bounds(PWP_UINT32 ndx, double *minXyz,
+                            double *maxXyz) const;
+
+private:
+    bool        span(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1,
+                    double &t0, double &t1) const;
+
+private:
+    Print3DModel &          model_;
+    std::vector<double>     boxes_;         // six per box, min then max
+    std::vector<double>     halfSpaces_;    // a, b, c, d per half-space
+    std::vector<bool>       culled_;
+};
+
+#endif // _CLIPPEDMODEL_H_
@@ -13,8 +13,6 @@
 
 #include "apiPWP.h"
 
-#include <set>
-
 
 class Edge {
 public:
@@ -24,11 +22,23 @@ public:
 
 	bool operator< (const Edge & rhs) const;
 
+	PWP_UINT32 i0() const {
+		return i0_; }
+
+	PWP_UINT32 i1() const {
+		return i1_; }
+
 private:
 	PWP_UINT32 i0_;
 	PWP_UINT32 i1_;
 };
 
-typedef std::set<Edge> Edges;
+
+class EdgeVisitor {
+public:
+	virtual ~EdgeVisitor() {}
+
+	virtual void visit(const Edge &e) = 0;
+};
 
 #endif
@@ -0,0 +1,281 @@
+/****************************************************************************
+ *
+ * class EdgeChains
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <math.h>
+#include <algorithm>
+
+#include "EdgeChains.h"
+
+// the tolerance of a zero tolerance, relative to the run's length
+const double RoundTol = 1e-9;
+
+// an edge end that no edge continues
+const PWP_UINT32 NoEdge = ~(PWP_UINT32)0;
+
+
+//////////////////////////////////////////////////////////////////////////
+// Two edges that continue each other through a vertex, ordered by the  //
+// distance of the vertex from the line joining their other ends        //
+//////////////////////////////////////////////////////////////////////////
+class StraightPair {
+public:
+    StraightPair(double d2, PWP_UINT32 edge0, PWP_UINT32 edge1) :
+        dist2(d2),
+        e0(edge0),
+        e1(edge1)
+    {
+    }
+
+    bool operator<(const StraightPair &rhs) const {
+        return (dist2 < rhs.dist2) || ((dist2 == rhs.dist2) &&
+            ((e0 < rhs.e0) || ((e0 == rhs.e0) && (e1 < rhs.e1))));
+    }
+
+    double      dist2;
+    PWP_UINT32  e0;
+    PWP_UINT32  e1;
+};
+
+
+// The squared distance of p from the line through a and b, or -1 if p is
+// not strictly between a and b. len2 is the squared length of a to b.
+static double
+lineDist2(const double *a, const double *b, const double *p, double &len2)
+{
+    const double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const double ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+    len2 = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+    const double t = ap[0] * ab[0] + ap[1] * ab[1] + ap[2] * ab[2];
+    if ((t <= 0.0) || (t >= len2)) {
+        return -1.0;
+    }
+    // |ap x ab| is the distance times the length
+    const double cx = ap[1] * ab[2] - ap[2] * ab[1];
+    const double cy = ap[2] * ab[0] - ap[0] * ab[2];
+    const double cz = ap[0] * ab[1] - ap[1] * ab[0];
+    return (cx * cx + cy * cy + cz * cz) / len2;
+}
+
+
+// true if p is within tol of the segment from a to b, strictly between its
+// ends
+static bool
+nearSegment(const double *a, const double *b, const double *p, double tol)
+{
+    double len2;
+    const double dist2 = lineDist2(a, b, p, len2);
+    const double roundTol = RoundTol * sqrt(len2);
+    const double lim = (tol > roundTol) ? tol : roundTol;
+    return (dist2 >= 0.0) && (dist2 <= lim * lim);
+}
+
+
+static PWP_UINT32
+otherVert(const EdgeGraph &graph, PWP_UINT32 edge, PWP_UINT32 vert)
+{
+    const PWP_UINT32 v0 = graph.edgeVert(edge, 0);
+    return (v0 == vert) ? graph.edgeVert(edge, 1) : v0;
+}
+
+
+// the slot of cont that continues edge through vert
+static PWP_UINT32
+contSlot(const EdgeGraph &graph, PWP_UINT32 edge, PWP_UINT32 vert)
+{
+    return 2 * edge + ((graph.edgeVert(edge, 0) == vert) ? 0 : 1);
+}
+
+
+static void
+vertData(const EdgeGraph &graph, PWP_UINT32 vert, PWGM_VERTDATA &vd)
+{
+    const double *xyz = graph.xyz(vert);
+    vd.x = xyz[0];
+    vd.y = xyz[1];
+    vd.z = xyz[2];
+    vd.i = graph.gridIndex(vert);
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+EdgeChains::EdgeChains() :
+    chained_(),
+    ends_(),
+    taken_(),
+    tolerance_(0.0)
+{
+}
+
+
+EdgeChains::~EdgeChains()
+{
+}
+
+
+void
+EdgeChains::build(const EdgeGraph &graph, const std::vector<PWP_UINT32> &ends,
+    double tolerance)
+{
+    tolerance_ = tolerance;
+    const PWP_UINT32 numVerts = graph.vertexCount();
+    const PWP_UINT32 numEdges = graph.edgeCount();
+    std::vector<PWP_UINT32> owner(numEdges, 0);
+    PWP_UINT32 ee = 0;
+    for (size_t ndx = 0; ndx < ends.size(); ++ndx) {
+        for (; (ee < ends[ndx]) && (ee < numEdges); ++ee) {
+            owner[ee] = (PWP_UINT32)ndx;
+        }
+    }
+    // the edges at each vertex
+    std::vector<PWP_UINT32> first(numVerts + 1, 0);
+    for (ee = 0; ee < numEdges; ++ee) {
+        ++first[graph.edgeVert(ee, 0) + 1];
+        ++first[graph.edgeVert(ee, 1) + 1];
+    }
+    PWP_UINT32 vert;
+    for (vert = 0; vert < numVerts; ++vert) {
+        first[vert + 1] += first[vert];
+    }
+    std::vector<PWP_UINT32> vertEdges(2 * numEdges);
+    std::vector<PWP_UINT32> fill(first.begin(), first.end() - 1);
+    for (ee = 0; ee < numEdges; ++ee) {
+        vertEdges[fill[graph.edgeVert(ee, 0)]++] = ee;
+        vertEdges[fill[graph.edgeVert(ee, 1)]++] = ee;
+    }
+    // At each vertex, pair the edges of the same entity that continue
+    // each other, straightest first. cont[2 * e + end] is the edge that
+    // continues e through its vertex end.
+    std::vector<PWP_UINT32> cont(2 * numEdges, NoEdge);
+    std::vector<StraightPair> pairs;
+    for (vert = 0; vert < numVerts; ++vert) {
+        pairs.clear();
+        for (PWP_UINT32 ii = first[vert]; ii < first[vert + 1]; ++ii) {
+            const PWP_UINT32 e0 = vertEdges[ii];
+            const double *a = graph.xyz(otherVert(graph, e0, vert));
+            for (PWP_UINT32 jj = ii + 1; jj < first[vert + 1]; ++jj) {
+                const PWP_UINT32 e1 = vertEdges[jj];
+                const double *b = graph.xyz(otherVert(graph, e1, vert));
+                if ((owner[e0] == owner[e1]) &&
+                        nearSegment(a, b, graph.xyz(vert), tolerance_)) {
+                    double len2;
+                    pairs.push_back(StraightPair(lineDist2(a, b,
+                        graph.xyz(vert), len2), e0, e1));
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        for (size_t ii = 0; ii < pairs.size(); ++ii) {
+            PWP_UINT32 &c0 = cont[contSlot(graph, pairs[ii].e0, vert)];
+            PWP_UINT32 &c1 = cont[contSlot(graph, pairs[ii].e1, vert)];
+            if ((NoEdge == c0) && (NoEdge == c1)) {
+                c0 = pairs[ii].e1;
+                c1 = pairs[ii].e0;
+            }
+        }
+    }
+    // Walk each run from one end and split it wherever the vertices
+    // stray from the line between the ends of the current chain.
+    std::vector<bool> visited(numEdges, false);
+    std::vector<PWP_UINT32> verts;
+    for (PWP_UINT32 start = 0; start < numEdges; ++start) {
+        if (visited[start]) {
+            continue;
+        }
+        PWP_UINT32 edge = start;
+        vert = graph.edgeVert(start, 0);
+        PWP_UINT32 next;
+        while (NoEdge != (next = cont[contSlot(graph, edge, vert)])) {
+            if (next == start) {
+                // a closed run
+                break;
+            }
+            edge = next;
+            vert = otherVert(graph, edge, vert);
+        }
+        verts.assign(1, vert);
+        while (true) {
+            visited[edge] = true;
+            vert = otherVert(graph, edge, vert);
+            verts.push_back(vert);
+            edge = cont[contSlot(graph, edge, vert)];
+            if ((NoEdge == edge) || visited[edge]) {
+                break;
+            }
+        }
+        const size_t numRunEdges = verts.size() - 1;
+        size_t begin = 0;
+        for (size_t ii = 1; ii < numRunEdges; ++ii) {
+            if (!isStraight(graph, verts[begin], verts[ii + 1], verts,
+                    begin + 1, ii + 1)) {
+                addChain(graph, verts, begin, ii);
+                begin = ii;
+            }
+        }
+        addChain(graph, verts, begin, numRunEdges);
+    }
+}
+
+
+bool
+EdgeChains::take(const Edge &e, const PWGM_VERTDATA *&ends)
+{
+    const PWP_UINT64 *chain = chained_.find(e);
+    ends = 0;
+    if (0 != chain) {
+        if (taken_[(size_t)*chain]) {
+            return false;
+        }
+        taken_[(size_t)*chain] = true;
+        ends = &ends_[2 * (size_t)*chain];
+    }
+    return true;
+}
+
+
+bool
+EdgeChains::isStraight(const EdgeGraph &graph, PWP_UINT32 first,
+    PWP_UINT32 last, const std::vector<PWP_UINT32> &path, size_t begin,
+    size_t end) const
+{
+    // true if path[begin, end) are near the segment from first to last
+    for (size_t ii = begin; ii < end; ++ii) {
+        if (!nearSegment(graph.xyz(first), graph.xyz(last),
+                graph.xyz(path[ii]), tolerance_)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void
+EdgeChains::addChain(const EdgeGraph &graph,
+    const std::vector<PWP_UINT32> &verts, size_t begin, size_t end)
+{
+    // the edges from verts[begin] to verts[end], one per vertex pair
+    if (end - begin < 2) {
+        return;
+    }
+    const PWP_UINT64 chain = taken_.size();
+    for (size_t ii = begin; ii < end; ++ii) {
+        chained_.insert(Edge(graph.gridIndex(verts[ii]),
+            graph.gridIndex(verts[ii + 1])), chain);
+    }
+    PWGM_VERTDATA vd;
+    vertData(graph, verts[begin], vd);
+    ends_.push_back(vd);
+    vertData(graph, verts[end], vd);
+    ends_.push_back(vd);
+    taken_.push_back(false);
+}
@@ -0,0 +1,73 @@
+/****************************************************************************
+ *
+ * class EdgeChains
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _EDGECHAINS_H_
+#define _EDGECHAINS_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include "Edge.h"
+#include "EdgeGraph.h"
+#include "EdgeTable.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// The runs of collinear edges of an EdgeGraph that can be written as   //
+// one cylinder. At each vertex, the edges of the same patch or block   //
+// that continue each other within the tolerance are paired, the        //
+// straightest first, so a grid line runs through the lines that cross  //
+// it.                                                                  //
+// Each vertex inside a chain is within the tolerance of the line       //
+// between the chain's ends. A long straight grid line becomes one      //
+// cylinder, without the caps and the overlapping extensions at every   //
+// vertex, and the union of the cylinders does not change.              //
+//////////////////////////////////////////////////////////////////////////
+class EdgeChains {
+public:
+    EdgeChains();
+    ~EdgeChains();
+
+    // ends[ndx] is the graph's edge count after entity ndx, as filled by
+    // Print3DExporter::collectEdges(). A tolerance of 0 only merges the
+    // edges that are collinear up to rounding.
+    void        build(const EdgeGraph &graph,
+                    const std::vector<PWP_UINT32> &ends, double tolerance);
+
+    // Returns false if e is in a chain that was taken already. Otherwise
+    // ends is 0 if e is in no chain, or the two end vertices of its chain,
+    // which counts as taken.
+    bool        take(const Edge &e, const PWGM_VERTDATA *&ends);
+
+    PWP_UINT32  chainCount() const {
+                    return (PWP_UINT32)taken_.size(); }
+
+    // the number of edges in the chains
+    PWP_UINT32  edgeCount() const {
+                    return chained_.size(); }
+
+private:
+    bool        isStraight(const EdgeGraph &graph, PWP_UINT32 first,
+                    PWP_UINT32 last, const std::vector<PWP_UINT32> &path,
+                    size_t begin, size_t end) const;
+    void        addChain(const EdgeGraph &graph,
+                    const std::vector<PWP_UINT32> &verts, size_t begin,
+                    size_t end);
+
+private:
+    EdgeTable                   chained_;   // the chain of each edge
+    std::vector<PWGM_VERTDATA>  ends_;      // two per chain
+    std::vector<bool>           taken_;
+    double                      tolerance_;
+};
+
+#endif // _EDGECHAINS_H_
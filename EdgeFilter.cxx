@@ -0,0 +1,374 @@
+/****************************************************************************
+ *
+ * class EdgeFilter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <math.h>
+
+#include "EdgeFilter.h"
+
+// the face value bits: the cells that use the face (at most 2), a 2D
+// element on it and whether addSurface() has seen it
+const PWP_UINT32 FaceCountMask  = 0x3;
+const PWP_UINT32 FaceSurfaceBit = 0x40000000;
+const PWP_UINT32 FaceDoneBit    = 0x80000000;
+
+// the surface edge value bits: the first face's normal, the faces that
+// use the edge (at most 3) and whether two of them meet at a feature
+const PWP_UINT64 EdgeNormalMask = 0xFFFFFFFFULL;
+const PWP_UINT64 EdgeCountOne   = 0x100000000ULL;
+const PWP_UINT64 EdgeCountMask  = 0x300000000ULL;
+const PWP_UINT64 EdgeFeatureBit = 0x8000000000000000ULL;
+
+// the depth of a vertex not yet reached by a layer
+const PWP_UINT8 Unreached = 0xFF;
+
+
+//////////////////////////////////////////////////////////////////////////
+// A face of a cell as indices into its vertices, wound as in           //
+// Print3DExporter::writeElemData()                                      //
+//////////////////////////////////////////////////////////////////////////
+struct CellFace {
+    PWP_UINT32  numVerts;
+    PWP_UINT32  vert[4];
+};
+
+static const CellFace HexFaces[] = {
+    { 4, { 0, 1, 2, 3 } }, { 4, { 4, 5, 6, 7 } }, { 4, { 0, 1, 5, 4 } },
+    { 4, { 1, 2, 6, 5 } }, { 4, { 2, 3, 7, 6 } }, { 4, { 3, 0, 4, 7 } } };
+static const CellFace TetFaces[] = {
+    { 3, { 0, 1, 2 } }, { 3, { 0, 1, 3 } }, { 3, { 1, 2, 3 } },
+    { 3, { 2, 0, 3 } } };
+static const CellFace WedgeFaces[] = {
+    { 3, { 0, 1, 2 } }, { 3, { 3, 4, 5 } }, { 4, { 0, 1, 4, 3 } },
+    { 4, { 1, 2, 5, 4 } }, { 4, { 2, 0, 3, 5 } } };
+static const CellFace PyramidFaces[] = {
+    { 4, { 0, 1, 2, 3 } }, { 3, { 0, 1, 4 } }, { 3, { 1, 2, 4 } },
+    { 3, { 2, 3, 4 } }, { 3, { 3, 0, 4 } } };
+static const CellFace QuadFaces[] = { { 4, { 0, 1, 2, 3 } } };
+static const CellFace TriFaces[] = { { 3, { 0, 1, 2 } } };
+
+
+static const CellFace *
+cellFaces(PWGM_ENUM_ELEMTYPE type, PWP_UINT32 &numFaces)
+{
+    // a 2D element is its own face
+    switch (type) {
+        case PWGM_ELEMTYPE_HEX:
+            numFaces = 6;
+            return HexFaces;
+        case PWGM_ELEMTYPE_TET:
+            numFaces = 4;
+            return TetFaces;
+        case PWGM_ELEMTYPE_WEDGE:
+            numFaces = 5;
+            return WedgeFaces;
+        case PWGM_ELEMTYPE_PYRAMID:
+            numFaces = 5;
+            return PyramidFaces;
+        case PWGM_ELEMTYPE_QUAD:
+            numFaces = 1;
+            return QuadFaces;
+        case PWGM_ELEMTYPE_TRI:
+            numFaces = 1;
+            return TriFaces;
+        default:
+            numFaces = 0;
+            return 0;
+    }
+}
+
+
+static bool
+isSurfaceElem(PWGM_ENUM_ELEMTYPE type)
+{
+    return (PWGM_ELEMTYPE_QUAD == type) || (PWGM_ELEMTYPE_TRI == type);
+}
+
+
+static vector3
+toVector(const PWGM_VERTDATA &vd)
+{
+    return vector3(vd.x, vd.y, vd.z);
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+EdgeFilter::EdgeFilter(Print3DModel &model, Print3DHost &host) :
+    model_(model),
+    host_(host),
+    kept_(),
+    faces_(),
+    surfEdges_(),
+    normals_(),
+    depths_(),
+    mode_(Print3DEdgesAll),
+    layers_(false),
+    cosAngle_(0.0),
+    depth_(0),
+    maxVert_(0)
+{
+}
+
+
+EdgeFilter::~EdgeFilter()
+{
+}
+
+
+PWP_UINT32
+EdgeFilter::stepCount(Print3DEdgeMode mode, PWP_UINT numLayers) const
+{
+    PWP_UINT32 numElems = 0;
+    const PWP_UINT32 numEntities = model_.entityCount();
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        if (Print3DCondHidden != model_.condition(ndx)) {
+            numElems += model_.elementCount(ndx);
+        }
+    }
+    // the face count, the surface and the layers
+    const PWP_UINT32 numPasses = 2 +
+        ((Print3DEdgesBoundary == mode) ? (PWP_UINT32)numLayers : 0);
+    return numPasses * numElems;
+}
+
+
+bool
+EdgeFilter::build(Print3DEdgeMode mode, PWP_UINT numLayers,
+    double featureAngle)
+{
+    const double PI = 3.141592653589793;
+    mode_ = mode;
+    layers_ = (Print3DEdgesBoundary == mode) && (numLayers > 0);
+    cosAngle_ = cos(featureAngle * PI / 180.0);
+    maxVert_ = 0;
+    bool ok = visitElements(&EdgeFilter::countFaces);
+    if (ok && layers_) {
+        depths_.assign((size_t)maxVert_ + 1, Unreached);
+    }
+    ok = ok && visitElements(&EdgeFilter::addSurface);
+    faces_.clear();
+    if (ok && (Print3DEdgesFeature == mode_)) {
+        keepFeatureEdges();
+    }
+    for (PWP_UINT ii = 1; ok && layers_ && (ii <= numLayers); ++ii) {
+        depth_ = (PWP_UINT8)ii;
+        ok = visitElements(&EdgeFilter::addLayer);
+    }
+    std::vector<PWP_UINT8>().swap(depths_);
+    return ok;
+}
+
+
+bool
+EdgeFilter::visitElements(ElemFn fn)
+{
+    Print3DElem ed;
+    const PWP_UINT32 numEntities = model_.entityCount();
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        if (Print3DCondHidden == model_.condition(ndx)) {
+            continue;
+        }
+        const PWP_UINT32 numElems = model_.elementCount(ndx);
+        for (PWP_UINT32 ii = 0; ii < numElems; ++ii) {
+            if (!model_.elementData(ndx, ii, ed) ||
+                    !host_.progressIncrement()) {
+                return false;
+            }
+            (this->*fn)(ed);
+        }
+    }
+    return !host_.aborted();
+}
+
+
+void
+EdgeFilter::countFaces(const Print3DElem &ed)
+{
+    for (PWP_UINT32 ii = 0; ii < ed.vertCnt; ++ii) {
+        if (ed.vert[ii].i > maxVert_) {
+            maxVert_ = ed.vert[ii].i;
+        }
+    }
+    PWP_UINT32 numFaces;
+    const CellFace *faces = cellFaces(ed.type, numFaces);
+    const bool surface = isSurfaceElem(ed.type);
+    for (PWP_UINT32 ii = 0; ii < numFaces; ++ii) {
+        PWP_UINT32 verts[4];
+        for (PWP_UINT32 jj = 0; jj < faces[ii].numVerts; ++jj) {
+            verts[jj] = ed.vert[faces[ii].vert[jj]].i;
+        }
+        PWP_UINT32 &val = faces_.lookup(verts, faces[ii].numVerts);
+        if (surface) {
+            val |= FaceSurfaceBit;
+        }
+        else if ((val & FaceCountMask) < 2) {
+            ++val;
+        }
+    }
+}
+
+
+void
+EdgeFilter::addSurface(const Print3DElem &ed)
+{
+    if (PWGM_ELEMTYPE_BAR == ed.type) {
+        if (ed.vert[0].i != ed.vert[1].i) {
+            kept_.insert(Edge(ed.vert[0].i, ed.vert[1].i));
+        }
+        return;
+    }
+    PWP_UINT32 numFaces;
+    const CellFace *faces = cellFaces(ed.type, numFaces);
+    for (PWP_UINT32 ii = 0; ii < numFaces; ++ii) {
+        PWP_UINT32 verts[4];
+        for (PWP_UINT32 jj = 0; jj < faces[ii].numVerts; ++jj) {
+            verts[jj] = ed.vert[faces[ii].vert[jj]].i;
+        }
+        // each surface face is added once, by the first element using it
+        PWP_UINT32 *val = faces_.find(verts, faces[ii].numVerts);
+        if ((0 != val) && (0 == (*val & FaceDoneBit)) &&
+                ((0 != (*val & FaceSurfaceBit)) ||
+                 (1 == (*val & FaceCountMask)))) {
+            *val |= FaceDoneBit;
+            addSurfaceFace(ed, faces[ii].vert, faces[ii].numVerts);
+        }
+    }
+}
+
+
+void
+EdgeFilter::addSurfaceFace(const Print3DElem &ed, const PWP_UINT32 *corners,
+    PWP_UINT32 numVerts)
+{
+    PWP_UINT32 normNdx = 0;
+    if (Print3DEdgesFeature == mode_) {
+        // a quad's normal is the cross product of its diagonals
+        const vector3 p0 = toVector(ed.vert[corners[0]]);
+        const vector3 p1 = toVector(ed.vert[corners[1]]);
+        const vector3 p2 = toVector(ed.vert[corners[2]]);
+        normNdx = (PWP_UINT32)normals_.size();
+        if (3 == numVerts) {
+            normals_.push_back(cml::cross(p1 - p0, p2 - p0));
+        }
+        else {
+            const vector3 p3 = toVector(ed.vert[corners[3]]);
+            normals_.push_back(cml::cross(p2 - p0, p3 - p1));
+        }
+    }
+    for (PWP_UINT32 ii = 0; ii < numVerts; ++ii) {
+        const PWP_UINT32 v0 = ed.vert[corners[ii]].i;
+        const PWP_UINT32 v1 =
+            ed.vert[corners[(ii + 1 < numVerts) ? (ii + 1) : 0]].i;
+        if (layers_) {
+            depths_[v0] = 0;
+        }
+        if (v0 == v1) {
+            // collapsed
+        }
+        else if (Print3DEdgesFeature == mode_) {
+            addFeatureEdge(v0, v1, normNdx);
+        }
+        else {
+            kept_.insert(Edge(v0, v1));
+        }
+    }
+}
+
+
+void
+EdgeFilter::addFeatureEdge(PWP_UINT32 v0, PWP_UINT32 v1, PWP_UINT32 normNdx)
+{
+    const Edge e(v0, v1);
+    PWP_UINT64 *val = surfEdges_.find(e);
+    if (0 == val) {
+        surfEdges_.insert(e, EdgeCountOne | normNdx);
+        return;
+    }
+    if ((*val & EdgeCountMask) != EdgeCountMask) {
+        *val += EdgeCountOne;
+    }
+    if (0 == (*val & EdgeFeatureBit)) {
+        // the angle between the face planes, without normalizing: a
+        // degenerate face makes no feature
+        const vector3 &n0 = normals_[(size_t)(*val & EdgeNormalMask)];
+        const vector3 &n1 = normals_[normNdx];
+        const double d = cml::dot(n0, n1);
+        if (d * d < cosAngle_ * cosAngle_ * n0.length_squared() *
+                n1.length_squared()) {
+            *val |= EdgeFeatureBit;
+        }
+    }
+}
+
+
+void
+EdgeFilter::keepFeatureEdges()
+{
+    // an edge with one surface face is on an open boundary and one with
+    // more than two is where surfaces meet
+    const PWP_UINT32 numSlots = surfEdges_.slotCount();
+    for (PWP_UINT32 ii = 0; ii < numSlots; ++ii) {
+        if (!surfEdges_.isUsed(ii)) {
+            continue;
+        }
+        const PWP_UINT64 val = surfEdges_.valueAt(ii);
+        if ((0 != (val & EdgeFeatureBit)) ||
+                ((val & EdgeCountMask) != 2 * EdgeCountOne)) {
+            kept_.insert(surfEdges_.edgeAt(ii));
+        }
+    }
+    surfEdges_.clear();
+    std::vector<vector3>().swap(normals_);
+}
+
+
+void
+EdgeFilter::addLayer(const Print3DElem &ed)
+{
+    // Layer n holds the cells that touch layer n-1 but not the surface or
+    // a layer before it. Their edges are kept and their other vertices
+    // reach layer n.
+    if (isSurfaceElem(ed.type) || (PWGM_ELEMTYPE_BAR == ed.type)) {
+        return;
+    }
+    PWP_UINT32 numFaces;
+    const CellFace *faces = cellFaces(ed.type, numFaces);
+    if (0 == faces) {
+        return;
+    }
+    PWP_UINT8 minDepth = Unreached;
+    for (PWP_UINT32 ii = 0; ii < ed.vertCnt; ++ii) {
+        if (depths_[ed.vert[ii].i] < minDepth) {
+            minDepth = depths_[ed.vert[ii].i];
+        }
+    }
+    if (minDepth + 1 != depth_) {
+        return;
+    }
+    for (PWP_UINT32 ii = 0; ii < ed.vertCnt; ++ii) {
+        if (depths_[ed.vert[ii].i] > depth_) {
+            depths_[ed.vert[ii].i] = depth_;
+        }
+    }
+    for (PWP_UINT32 ii = 0; ii < numFaces; ++ii) {
+        const CellFace &face = faces[ii];
+        for (PWP_UINT32 jj = 0; jj < face.numVerts; ++jj) {
+            const PWP_UINT32 v0 = ed.vert[face.vert[jj]].i;
+            const PWP_UINT32 v1 =
+                ed.vert[face.vert[(jj + 1 < face.numVerts) ? (jj + 1) : 0]].i;
+            if (v0 != v1) {
+                kept_.insert(Edge(v0, v1));
+            }
+        }
+    }
+}
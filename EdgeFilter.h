@@ -0,0 +1,86 @@
+/****************************************************************************
+ *
+ * class EdgeFilter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _EDGEFILTER_H_
+#define _EDGEFILTER_H_
+
+#include "apiPWP.h"
+
+#include "Edge.h"
+#include "EdgeTable.h"
+#include "FaceTable.h"
+#include "Print3DExporter.h"
+#include "Print3DModel.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// The edges a boundary or feature export keeps. The surface of a grid   //
+// is made of the faces of the visible blocks' cells that only one cell  //
+// uses, and of the visible 2D elements. Faces are matched by their      //
+// vertices, so a face between two visible blocks is inside the grid.   //
+//                                                                       //
+// Print3DEdgesBoundary keeps the edges of the surface faces and all the //
+// edges of the cells within numLayers cell layers of the surface.       //
+// Print3DEdgesFeature keeps the surface edges whose two faces meet at   //
+// more than featureAngle degrees, and those with one face or more than //
+// two. The angle is measured between the face planes, so a fold of    //
+// nearly 180 degrees looks flat. Bar elements are always kept.          //
+//////////////////////////////////////////////////////////////////////////
+class EdgeFilter {
+public:
+    EdgeFilter(Print3DModel &model, Print3DHost &host);
+    ~EdgeFilter();
+
+    // the progress increments of build(), one per element and pass
+    PWP_UINT32  stepCount(Print3DEdgeMode mode, PWP_UINT numLayers) const;
+
+    // Classifies the edges of the visible patches and blocks. Returns
+    // false if aborted.
+    bool        build(Print3DEdgeMode mode, PWP_UINT numLayers,
+                    double featureAngle);
+
+    // safe to call from several threads once built
+    bool        keeps(const Edge &e) const {
+                    return kept_.contains(e); }
+
+    PWP_UINT32  size() const {
+                    return kept_.size(); }
+
+private:
+    typedef void (EdgeFilter::*ElemFn)(const Print3DElem &ed);
+
+    // calls fn for each element of the visible patches and blocks
+    bool    visitElements(ElemFn fn);
+    void    countFaces(const Print3DElem &ed);
+    void    addSurface(const Print3DElem &ed);
+    void    addSurfaceFace(const Print3DElem &ed, const PWP_UINT32 *corners,
+                PWP_UINT32 numVerts);
+    void    addFeatureEdge(PWP_UINT32 v0, PWP_UINT32 v1, PWP_UINT32 normNdx);
+    void    keepFeatureEdges();
+    void    addLayer(const Print3DElem &ed);
+
+private:
+    Print3DModel &          model_;
+    Print3DHost &           host_;
+    EdgeTable               kept_;
+    FaceTable               faces_;
+    EdgeTable               surfEdges_; // face count and first normal
+    std::vector<vector3>    normals_;
+    std::vector<PWP_UINT8>  depths_;    // cell layers to the surface
+    Print3DEdgeMode         mode_;
+    bool                    layers_;
+    double                  cosAngle_;
+    PWP_UINT8               depth_;     // the layer being added
+    PWP_UINT32              maxVert_;
+};
+
+#endif // _EDGEFILTER_H_
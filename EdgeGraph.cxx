@@ -0,0 +1,101 @@
+/****************************************************************************
+ *
+ * class EdgeGraph
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include "EdgeGraph.h"
+
+// the grid vertices of the lookup's first allocation
+const PWP_UINT32 MinLookup = 64;
+
+const PWP_UINT32 EdgeGraph::NoVertex;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+EdgeGraph::EdgeGraph() :
+    lookup_(),
+    xyz_(),
+    gridNdx_(),
+    edges_()
+{
+}
+
+
+EdgeGraph::~EdgeGraph()
+{
+}
+
+
+void
+EdgeGraph::clear()
+{
+    lookup_.clear();
+    xyz_.clear();
+    gridNdx_.clear();
+    edges_.clear();
+}
+
+
+PWP_UINT32
+EdgeGraph::addVertex(const PWGM_VERTDATA &v)
+{
+    if (v.i >= lookup_.size()) {
+        // doubled, so that the grid vertices cost a few allocations and
+        // not one each
+        size_t size = lookup_.empty() ? MinLookup : 2 * lookup_.size();
+        while (size <= v.i) {
+            size *= 2;
+        }
+        lookup_.resize(size, NoVertex);
+    }
+    PWP_UINT32 &ndx = lookup_[v.i];
+    if (NoVertex == ndx) {
+        ndx = vertexCount();
+        xyz_.push_back(v.x);
+        xyz_.push_back(v.y);
+        xyz_.push_back(v.z);
+        gridNdx_.push_back(v.i);
+    }
+    return ndx;
+}
+
+
+PWP_UINT32
+EdgeGraph::addEdge(const PWGM_VERTDATA &v0, const PWGM_VERTDATA &v1)
+{
+    const PWP_UINT32 ret = edgeCount();
+    edges_.push_back(addVertex(v0));
+    edges_.push_back(addVertex(v1));
+    return ret;
+}
+
+
+bool
+EdgeGraph::bounds(double minXyz[3], double maxXyz[3]) const
+{
+    if (xyz_.empty()) {
+        return false;
+    }
+    for (int kk = 0; kk < 3; ++kk) {
+        minXyz[kk] = maxXyz[kk] = xyz_[kk];
+    }
+    for (size_t ii = 3; ii < xyz_.size(); ii += 3) {
+        for (int kk = 0; kk < 3; ++kk) {
+            if (xyz_[ii + kk] < minXyz[kk]) {
+                minXyz[kk] = xyz_[ii + kk];
+            }
+            else if (xyz_[ii + kk] > maxXyz[kk]) {
+                maxXyz[kk] = xyz_[ii + kk];
+            }
+        }
+    }
+    return true;
+}
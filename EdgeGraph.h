@@ -0,0 +1,64 @@
+/****************************************************************************
+ *
+ * class EdgeGraph
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _EDGEGRAPH_H_
+#define _EDGEGRAPH_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// The unique grid edges collected by an export that does not write     //
+// cylinders as it goes. Vertices are renumbered compactly in the order //
+// they are first seen.                                                 //
+//////////////////////////////////////////////////////////////////////////
+class EdgeGraph {
+public:
+    EdgeGraph();
+    ~EdgeGraph();
+
+    void        clear();
+
+    // returns the graph index of the grid vertex v.i
+    PWP_UINT32  addVertex(const PWGM_VERTDATA &v);
+
+    // adds an edge, the caller makes sure it is unique
+    PWP_UINT32  addEdge(const PWGM_VERTDATA &v0, const PWGM_VERTDATA &v1);
+
+    PWP_UINT32  vertexCount() const {
+                    return (PWP_UINT32)gridNdx_.size(); }
+    PWP_UINT32  edgeCount() const {
+                    return (PWP_UINT32)(edges_.size() / 2); }
+
+    const double *  xyz(PWP_UINT32 vert) const {
+                        return &xyz_[3 * vert]; }
+    PWP_UINT32      gridIndex(PWP_UINT32 vert) const {
+                        return gridNdx_[vert]; }
+    PWP_UINT32      edgeVert(PWP_UINT32 edge, int end) const {
+                        return edges_[2 * edge + end]; }
+
+    // the bounding box of the vertices, false if there are none
+    bool        bounds(double minXyz[3], double maxXyz[3]) const;
+
+private:
+    // the lookup_ entry of a grid vertex that is not in the graph
+    static const PWP_UINT32 NoVertex = ~(PWP_UINT32)0;
+
+    // the graph index of each grid vertex, by grid index
+    std::vector<PWP_UINT32> lookup_;
+    std::vector<double>     xyz_;
+    std::vector<PWP_UINT32> gridNdx_;
+    std::vector<PWP_UINT32> edges_;
+};
+
+#endif // _EDGEGRAPH_H_
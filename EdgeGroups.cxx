@@ -0,0 +1,426 @@
+/****************************************************************************
+ *
+ * class EdgeGroups
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include "EdgeGroups.h"
+
+// a vertex whose component has no group yet
+const PWP_UINT32 NoGroup = ~(PWP_UINT32)0;
+
+// the digits of the radix sort
+const int        RadixBits = 8;
+const PWP_UINT32 RadixSize = 1 << RadixBits;
+
+// the last cell on each axis of the curve keys
+const PWP_UINT32 MaxCell = (1 << EdgeGroups::KeyBits) - 1;
+
+const int EdgeGroups::KeyBits;
+
+
+//////////////////////////////////////////////////////////////////////////
+// Orders edges by the coordinate of their midpoints along one axis,    //
+// and ties by edge index so that the order is total                    //
+//////////////////////////////////////////////////////////////////////////
+class MidpointLess {
+public:
+    MidpointLess(const EdgeGraph &graph, int axis) :
+        graph_(graph),
+        axis_(axis)
+    {
+    }
+
+    bool operator()(PWP_UINT32 e0, PWP_UINT32 e1) const {
+        const double m0 = mid(e0);
+        const double m1 = mid(e1);
+        return (m0 < m1) || ((m0 == m1) && (e0 < e1));
+    }
+
+private:
+    double mid(PWP_UINT32 e) const {
+        return graph_.xyz(graph_.edgeVert(e, 0))[axis_] +
+            graph_.xyz(graph_.edgeVert(e, 1))[axis_];
+    }
+
+private:
+    const EdgeGraph &   graph_;
+    int                 axis_;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// The curve keys and one pass of the radix sort. Each task handles a   //
+// slice of the edges, and the slices keep their order in each digit,   //
+// so the sort does not depend on the thread count.                     //
+//////////////////////////////////////////////////////////////////////////
+struct EdgeGroups::SortJob {
+    EdgeGroups *            groups;
+    const EdgeGraph *       graph;
+    Print3DEdgeOrder        curve;
+    PWP_UINT32              numItems;
+    PWP_UINT32              numSlices;
+    int                     shift;      // the digit of the pass
+    const PWP_UINT64 *      keys;
+    const PWP_UINT32 *      edges;
+    PWP_UINT64 *            outKeys;
+    PWP_UINT32 *            outEdges;
+    std::vector<PWP_UINT32> counts;     // the digits of each slice, then
+                                        // where the slice puts them
+};
+
+
+static PWP_UINT32
+sliceBegin(PWP_UINT32 numItems, PWP_UINT32 numSlices, PWP_UINT32 slice)
+{
+    return (PWP_UINT32)((PWP_UINT64)numItems * slice / numSlices);
+}
+
+
+// spreads the low KeyBits bits of val to every third bit
+static PWP_UINT64
+spreadBits(PWP_UINT64 val)
+{
+    val &= MaxCell;
+    val = (val | (val << 32)) & 0x001F00000000FFFFULL;
+    val = (val | (val << 16)) & 0x001F0000FF0000FFULL;
+    val = (val | (val << 8)) & 0x100F00F00F00F00FULL;
+    val = (val | (val << 4)) & 0x10C30C30C30C30C3ULL;
+    val = (val | (val << 2)) & 0x1249249249249249ULL;
+    return val;
+}
+
+
+static PWP_UINT64
+mortonKey(const PWP_UINT32 *cell)
+{
+    return (spreadBits(cell[2]) << 2) | (spreadBits(cell[1]) << 1) |
+        spreadBits(cell[0]);
+}
+
+
+static PWP_UINT64
+hilbertKey(const PWP_UINT32 *cell)
+{
+    // J. Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707,
+    // 2004: the cell is turned into the transposed Hilbert index, whose
+    // interleaved bits are the key
+    PWP_UINT32 x[3] = { cell[0], cell[1], cell[2] };
+    PWP_UINT32 q;
+    for (q = (PWP_UINT32)1 << (EdgeGroups::KeyBits - 1); q > 1; q >>= 1) {
+        const PWP_UINT32 p = q - 1;
+        for (int ii = 0; ii < 3; ++ii) {
+            if (0 != (x[ii] & q)) {
+                x[0] ^= p;
+            }
+            else {
+                const PWP_UINT32 t = (x[0] ^ x[ii]) & p;
+                x[0] ^= t;
+                x[ii] ^= t;
+            }
+        }
+    }
+    x[1] ^= x[0];
+    x[2] ^= x[1];
+    PWP_UINT32 t = 0;
+    for (q = (PWP_UINT32)1 << (EdgeGroups::KeyBits - 1); q > 1; q >>= 1) {
+        if (0 != (x[2] & q)) {
+            t ^= q - 1;
+        }
+    }
+    return (spreadBits(x[0] ^ t) << 2) | (spreadBits(x[1] ^ t) << 1) |
+        spreadBits(x[2] ^ t);
+}
+
+
+static PWP_UINT32
+findRoot(std::vector<PWP_UINT32> &parent, PWP_UINT32 vert)
+{
+    // halves the path on the way up
+    while (parent[vert] != vert) {
+        parent[vert] = parent[parent[vert]];
+        vert = parent[vert];
+    }
+    return vert;
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+EdgeGroups::EdgeGroups() :
+    edges_(),
+    ends_(),
+    keys_(),
+    origin_(),
+    cell_(1.0)
+{
+}
+
+
+EdgeGroups::~EdgeGroups()
+{
+}
+
+
+void
+EdgeGroups::makeComponents(const EdgeGraph &graph)
+{
+    const PWP_UINT32 numVerts = graph.vertexCount();
+    const PWP_UINT32 numEdges = graph.edgeCount();
+    std::vector<PWP_UINT32> parent(numVerts);
+    for (PWP_UINT32 ii = 0; ii < numVerts; ++ii) {
+        parent[ii] = ii;
+    }
+    for (PWP_UINT32 ii = 0; ii < numEdges; ++ii) {
+        const PWP_UINT32 r0 = findRoot(parent, graph.edgeVert(ii, 0));
+        const PWP_UINT32 r1 = findRoot(parent, graph.edgeVert(ii, 1));
+        if (r0 != r1) {
+            parent[(r0 < r1) ? r1 : r0] = (r0 < r1) ? r0 : r1;
+        }
+    }
+    // number the components by their first edges and sort the edges by
+    // component, keeping their order
+    std::vector<PWP_UINT32> group(numVerts, NoGroup);
+    std::vector<PWP_UINT32> edgeGroup(numEdges);
+    ends_.clear();
+    for (PWP_UINT32 ii = 0; ii < numEdges; ++ii) {
+        const PWP_UINT32 root = findRoot(parent, graph.edgeVert(ii, 0));
+        if (NoGroup == group[root]) {
+            group[root] = (PWP_UINT32)ends_.size();
+            ends_.push_back(0);
+        }
+        edgeGroup[ii] = group[root];
+        ++ends_[group[root]];
+    }
+    PWP_UINT32 sum = 0;
+    for (size_t ii = 0; ii < ends_.size(); ++ii) {
+        sum += ends_[ii];
+        ends_[ii] = sum;
+    }
+    edges_.resize(numEdges);
+    for (PWP_UINT32 ii = numEdges; ii > 0; --ii) {
+        edges_[--ends_[edgeGroup[ii - 1]]] = ii - 1;
+    }
+    // the loop moved each end back to its group's begin
+    for (size_t ii = 0; ii + 1 < ends_.size(); ++ii) {
+        ends_[ii] = ends_[ii + 1];
+    }
+    if (!ends_.empty()) {
+        ends_.back() = numEdges;
+    }
+}
+
+
+void
+EdgeGroups::makeClusters(const EdgeGraph &graph, PWP_UINT32 maxEdges)
+{
+    const PWP_UINT32 numEdges = graph.edgeCount();
+    edges_.resize(numEdges);
+    for (PWP_UINT32 ii = 0; ii < numEdges; ++ii) {
+        edges_[ii] = ii;
+    }
+    ends_.clear();
+    if (numEdges > 0) {
+        split(graph, 0, numEdges, (0 == maxEdges) ? 1 : maxEdges);
+    }
+}
+
+
+void
+EdgeGroups::split(const EdgeGraph &graph, PWP_UINT32 begin, PWP_UINT32 end,
+    PWP_UINT32 maxEdges)
+{
+    if (end - begin <= maxEdges) {
+        std::sort(edges_.begin() + begin, edges_.begin() + end);
+        ends_.push_back(end);
+        return;
+    }
+    double minXyz[3] = { 0.0, 0.0, 0.0 };
+    double maxXyz[3] = { 0.0, 0.0, 0.0 };
+    for (PWP_UINT32 ii = begin; ii < end; ++ii) {
+        for (int side = 0; side < 2; ++side) {
+            const double *xyz = graph.xyz(graph.edgeVert(edges_[ii], side));
+            for (int jj = 0; jj < 3; ++jj) {
+                if ((ii == begin) && (0 == side)) {
+                    minXyz[jj] = maxXyz[jj] = xyz[jj];
+                }
+                else if (xyz[jj] < minXyz[jj]) {
+                    minXyz[jj] = xyz[jj];
+                }
+                else if (xyz[jj] > maxXyz[jj]) {
+                    maxXyz[jj] = xyz[jj];
+                }
+            }
+        }
+    }
+    int axis = 0;
+    for (int jj = 1; jj < 3; ++jj) {
+        if (maxXyz[jj] - minXyz[jj] > maxXyz[axis] - minXyz[axis]) {
+            axis = jj;
+        }
+    }
+    const PWP_UINT32 mid = begin + (end - begin) / 2;
+    std::nth_element(edges_.begin() + begin, edges_.begin() + mid,
+        edges_.begin() + end, MidpointLess(graph, axis));
+    split(graph, begin, mid, maxEdges);
+    split(graph, mid, end, maxEdges);
+}
+
+
+void
+EdgeGroups::makeCurveChunks(const EdgeGraph &graph, Print3DEdgeOrder curve,
+    PWP_UINT32 chunkEdges, WorkerPool &pool)
+{
+    const PWP_UINT32 numEdges = graph.edgeCount();
+    edges_.resize(numEdges);
+    keys_.resize(numEdges);
+    ends_.clear();
+    if (0 == numEdges) {
+        return;
+    }
+    setKeyCells(graph);
+    SortJob job;
+    job.groups = this;
+    job.graph = &graph;
+    job.curve = curve;
+    job.numItems = numEdges;
+    job.numSlices = pool.threadCount();
+    job.shift = 0;
+    job.keys = 0;
+    job.edges = 0;
+    job.outKeys = 0;
+    job.outEdges = 0;
+    job.counts.resize(job.numSlices * RadixSize);
+    pool.run(keyTask, &job, job.numSlices);
+    // least significant digit first, skipping the digits all keys share
+    std::vector<PWP_UINT64> keys(numEdges);
+    std::vector<PWP_UINT32> edges(numEdges);
+    for (int shift = 0; shift < 3 * KeyBits; shift += RadixBits) {
+        job.shift = shift;
+        job.keys = &keys_[0];
+        job.edges = &edges_[0];
+        job.outKeys = &keys[0];
+        job.outEdges = &edges[0];
+        std::fill(job.counts.begin(), job.counts.end(), 0);
+        pool.run(countTask, &job, job.numSlices);
+        PWP_UINT32 pos = 0;
+        bool shared = false;
+        for (PWP_UINT32 digit = 0; digit < RadixSize; ++digit) {
+            PWP_UINT32 total = 0;
+            for (PWP_UINT32 slice = 0; slice < job.numSlices; ++slice) {
+                PWP_UINT32 &cnt = job.counts[slice * RadixSize + digit];
+                const PWP_UINT32 num = cnt;
+                cnt = pos;
+                pos += num;
+                total += num;
+            }
+            shared = shared || (numEdges == total);
+        }
+        if (!shared) {
+            pool.run(scatterTask, &job, job.numSlices);
+            keys_.swap(keys);
+            edges_.swap(edges);
+        }
+    }
+    const PWP_UINT32 step = (0 == chunkEdges) ? 1 : chunkEdges;
+    for (PWP_UINT32 end = step; end < numEdges; end += step) {
+        ends_.push_back(end);
+    }
+    ends_.push_back(numEdges);
+}
+
+
+void
+EdgeGroups::setKeyCells(const EdgeGraph &graph)
+{
+    // cubic cells, so that the curve does not stretch along one axis
+    double maxXyz[3];
+    const PWP_UINT32 numVerts = graph.vertexCount();
+    for (PWP_UINT32 ii = 0; ii < numVerts; ++ii) {
+        const double *xyz = graph.xyz(ii);
+        for (int jj = 0; jj < 3; ++jj) {
+            if (0 == ii) {
+                origin_[jj] = maxXyz[jj] = xyz[jj];
+            }
+            else if (xyz[jj] < origin_[jj]) {
+                origin_[jj] = xyz[jj];
+            }
+            else if (xyz[jj] > maxXyz[jj]) {
+                maxXyz[jj] = xyz[jj];
+            }
+        }
+    }
+    double extent = 0.0;
+    for (int jj = 0; (numVerts > 0) && (jj < 3); ++jj) {
+        if (maxXyz[jj] - origin_[jj] > extent) {
+            extent = maxXyz[jj] - origin_[jj];
+        }
+    }
+    cell_ = (extent > 0.0) ? (extent / (MaxCell + 1.0)) : 1.0;
+}
+
+
+void
+EdgeGroups::keyTask(void *ctx, PWP_UINT32 task)
+{
+    SortJob *job = (SortJob *)ctx;
+    EdgeGroups &groups = *job->groups;
+    const EdgeGraph &graph = *job->graph;
+    const PWP_UINT32 end = sliceBegin(job->numItems, job->numSlices,
+        task + 1);
+    PWP_UINT32 cell[3];
+    for (PWP_UINT32 ee = sliceBegin(job->numItems, job->numSlices, task);
+            ee < end; ++ee) {
+        const double *xyz0 = graph.xyz(graph.edgeVert(ee, 0));
+        const double *xyz1 = graph.xyz(graph.edgeVert(ee, 1));
+        for (int ii = 0; ii < 3; ++ii) {
+            const double pos = (0.5 * (xyz0[ii] + xyz1[ii]) -
+                groups.origin_[ii]) / groups.cell_;
+            cell[ii] = (pos <= 0.0) ? 0 :
+                ((pos >= MaxCell) ? MaxCell : (PWP_UINT32)pos);
+        }
+        groups.keys_[ee] = (Print3DOrderHilbert == job->curve) ?
+            hilbertKey(cell) : mortonKey(cell);
+        groups.edges_[ee] = ee;
+    }
+}
+
+
+void
+EdgeGroups::countTask(void *ctx, PWP_UINT32 task)
+{
+    SortJob *job = (SortJob *)ctx;
+    PWP_UINT32 *counts = &job->counts[task * RadixSize];
+    const PWP_UINT32 end = sliceBegin(job->numItems, job->numSlices,
+        task + 1);
+    for (PWP_UINT32 ii = sliceBegin(job->numItems, job->numSlices, task);
+            ii < end; ++ii) {
+        ++counts[(job->keys[ii] >> job->shift) & (RadixSize - 1)];
+    }
+}
+
+
+void
+EdgeGroups::scatterTask(void *ctx, PWP_UINT32 task)
+{
+    SortJob *job = (SortJob *)ctx;
+    PWP_UINT32 *next = &job->counts[task * RadixSize];
+    const PWP_UINT32 end = sliceBegin(job->numItems, job->numSlices,
+        task + 1);
+    for (PWP_UINT32 ii = sliceBegin(job->numItems, job->numSlices, task);
+            ii < end; ++ii) {
+        const PWP_UINT32 pos =
+            next[(job->keys[ii] >> job->shift) & (RadixSize - 1)]++;
+        job->outKeys[pos] = job->keys[ii];
+        job->outEdges[pos] = job->edges[ii];
+    }
+}
@@ -0,0 +1,91 @@
+/****************************************************************************
+ *
+ * class EdgeGroups
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _EDGEGROUPS_H_
+#define _EDGEGROUPS_H_
+
+#include "apiPWP.h"
+
+#include "EdgeGraph.h"
+#include "Print3DExporter.h"
+#include "WorkerPool.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// The edges of an EdgeGraph split into groups that are each exported   //
+// as one solid or one chunk. The edges of a solid keep their graph     //
+// order, so the groups do not depend on how the graph was collected.   //
+//////////////////////////////////////////////////////////////////////////
+class EdgeGroups {
+public:
+    EdgeGroups();
+    ~EdgeGroups();
+
+    // One group per connected component of the graph, in the order of
+    // their first edges
+    void        makeComponents(const EdgeGraph &graph);
+
+    // Splits the edges at the median of their midpoints, across the
+    // longest side of their bounds, until no group has more than maxEdges.
+    // Neighboring groups are near each other.
+    void        makeClusters(const EdgeGraph &graph, PWP_UINT32 maxEdges);
+
+    // Sorts the edges along a Morton or Hilbert curve through their
+    // midpoints, with a radix sort on the pool's threads, and splits them
+    // into chunks of chunkEdges. Edges with the same key keep their graph
+    // order. The keys quantize the midpoints to KeyBits bits per axis, in
+    // cells of size keyCell() from keyOrigin().
+    void        makeCurveChunks(const EdgeGraph &graph,
+                    Print3DEdgeOrder curve, PWP_UINT32 chunkEdges,
+                    WorkerPool &pool);
+
+    PWP_UINT32  groupCount() const {
+                    return (PWP_UINT32)ends_.size(); }
+
+    // the edges [groupBegin(g), groupEnd(g)) of edge() are in group g
+    PWP_UINT32  groupBegin(PWP_UINT32 group) const {
+                    return (0 == group) ? 0 : ends_[group - 1]; }
+    PWP_UINT32  groupEnd(PWP_UINT32 group) const {
+                    return ends_[group]; }
+    PWP_UINT32  edge(PWP_UINT32 ndx) const {
+                    return edges_[ndx]; }
+
+    // the curve key of edge(ndx), after makeCurveChunks()
+    PWP_UINT64  key(PWP_UINT32 ndx) const {
+                    return keys_[ndx]; }
+    const double *  keyOrigin() const {
+                    return origin_; }
+    double      keyCell() const {
+                    return cell_; }
+
+    static const int KeyBits = 21;
+
+private:
+    struct SortJob;
+
+    void        split(const EdgeGraph &graph, PWP_UINT32 begin,
+                    PWP_UINT32 end, PWP_UINT32 maxEdges);
+    void        setKeyCells(const EdgeGraph &graph);
+
+    static void keyTask(void *ctx, PWP_UINT32 task);
+    static void countTask(void *ctx, PWP_UINT32 task);
+    static void scatterTask(void *ctx, PWP_UINT32 task);
+
+private:
+    std::vector<PWP_UINT32> edges_; // the graph edges, group by group
+    std::vector<PWP_UINT32> ends_;
+    std::vector<PWP_UINT64> keys_;
+    double                  origin_[3];
+    double                  cell_;
+};
+
+#endif // _EDGEGROUPS_H_
@@ -0,0 +1,104 @@
+/****************************************************************************
+ *
+ * class EdgeRegistry
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include "EdgeRegistry.h"
+
+// the owner of an edge that has been written
+static const PWP_UINT64 Taken = ~(PWP_UINT64)0;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+EdgeRegistry::EdgeRegistry()
+{
+}
+
+
+EdgeRegistry::~EdgeRegistry()
+{
+}
+
+
+EdgeRegistry::Shard &
+EdgeRegistry::shard(const Edge &e)
+{
+    // grid vertices are numbered in runs, mix both ends into the shard
+    const PWP_UINT32 h = (e.i0() * 2654435761U) ^ (e.i1() * 40503U);
+    return shards_[(h >> 16) % NumShards];
+}
+
+
+void
+EdgeRegistry::claim(const Edge &e, PWP_UINT64 seq)
+{
+    Shard &s = shard(e);
+    MutexLock lock(s.mutex);
+    PWP_UINT64 *owner = s.owners.find(e);
+    if (0 == owner) {
+        s.owners.insert(e, seq);
+    }
+    else if (seq < *owner) {
+        *owner = seq;
+    }
+}
+
+
+bool
+EdgeRegistry::take(const Edge &e, PWP_UINT64 seq)
+{
+    Shard &s = shard(e);
+    MutexLock lock(s.mutex);
+    PWP_UINT64 *owner = s.owners.find(e);
+    if ((0 == owner) || (seq != *owner)) {
+        return false;
+    }
+    // an element can use the same edge more than once
+    *owner = Taken;
+    return true;
+}
+
+
+void
+EdgeRegistry::countOwners(const std::vector<PWP_UINT64> &ranges,
+    std::vector<PWP_UINT32> &counts) const
+{
+    counts.assign(ranges.size(), 0);
+    for (int ii = 0; ii < NumShards; ++ii) {
+        const EdgeTable &owners = shards_[ii].owners;
+        for (PWP_UINT32 slot = 0; slot < owners.slotCount(); ++slot) {
+            if (!owners.isUsed(slot)) {
+                continue;
+            }
+            // the last range that starts at or before the owner
+            std::vector<PWP_UINT64>::const_iterator r =
+                std::upper_bound(ranges.begin(), ranges.end(),
+                    owners.valueAt(slot));
+            if (r != ranges.begin()) {
+                ++counts[(r - ranges.begin()) - 1];
+            }
+        }
+    }
+}
+
+
+PWP_UINT32
+EdgeRegistry::edgeCount() const
+{
+    size_t ret = 0;
+    for (int ii = 0; ii < NumShards; ++ii) {
+        ret += shards_[ii].owners.size();
+    }
+    return (PWP_UINT32)ret;
+}
@@ -0,0 +1,65 @@
+/****************************************************************************
+ *
+ * class EdgeRegistry
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _EDGEREGISTRY_H_
+#define _EDGEREGISTRY_H_
+
+#include "apiPWP.h"
+
+#include "Edge.h"
+#include "EdgeTable.h"
+#include "WorkerPool.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// Decides which element writes a shared edge when the elements are      //
+// traversed by several threads. Every element has a sequence number in  //
+// serial traversal order. The element with the lowest number that uses  //
+// an edge owns it, so the result does not depend on thread timing.      //
+//                                                                       //
+// The edges are sharded by hash and each shard has its own lock, so     //
+// threads rarely wait for each other.                                   //
+//////////////////////////////////////////////////////////////////////////
+class EdgeRegistry {
+public:
+    enum { NumShards = 64 };
+
+    EdgeRegistry();
+    ~EdgeRegistry();
+
+    // records that element seq uses e
+    void        claim(const Edge &e, PWP_UINT64 seq);
+
+    // true for the first call by the owner of e
+    bool        take(const Edge &e, PWP_UINT64 seq);
+
+    // Counts the edges owned by the elements in each range. ranges holds
+    // the ascending first sequence number of each range. counts[ii] is
+    // incremented for each edge owned by range ii.
+    void        countOwners(const std::vector<PWP_UINT64> &ranges,
+                    std::vector<PWP_UINT32> &counts) const;
+
+    PWP_UINT32  edgeCount() const;
+
+private:
+    struct Shard {
+        Mutex       mutex;
+        EdgeTable   owners;
+    };
+
+    Shard &     shard(const Edge &e);
+
+private:
+    Shard       shards_[NumShards];
+};
+
+#endif // _EDGEREGISTRY_H_
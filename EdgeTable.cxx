@@ -0,0 +1,165 @@
+/****************************************************************************
+ *
+ * class EdgeTable
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include "EdgeTable.h"
+
+// the slots of a table's first allocation
+const PWP_UINT32 MinSlots = 64;
+
+const PWP_UINT64 EdgeTable::EmptyKey;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+EdgeTable::EdgeTable() :
+    keys_(),
+    vals_(),
+    count_(0)
+{
+}
+
+
+EdgeTable::~EdgeTable()
+{
+}
+
+
+bool
+EdgeTable::insert(const Edge &e, PWP_UINT64 val)
+{
+    if (2 * (count_ + 1) > keys_.size()) {
+        rehash(keys_.empty() ? MinSlots : 2 * (PWP_UINT32)keys_.size());
+    }
+    const PWP_UINT64 k = key(e);
+    const PWP_UINT32 slot = findSlot(k);
+    if (EmptyKey != keys_[slot]) {
+        return false;
+    }
+    keys_[slot] = k;
+    vals_[slot] = val;
+    ++count_;
+    return true;
+}
+
+
+bool
+EdgeTable::contains(const Edge &e) const
+{
+    return !keys_.empty() && (EmptyKey != keys_[findSlot(key(e))]);
+}
+
+
+PWP_UINT64 *
+EdgeTable::find(const Edge &e)
+{
+    if (keys_.empty()) {
+        return 0;
+    }
+    const PWP_UINT32 slot = findSlot(key(e));
+    return (EmptyKey == keys_[slot]) ? 0 : &vals_[slot];
+}
+
+
+bool
+EdgeTable::erase(const Edge &e)
+{
+    if (keys_.empty()) {
+        return false;
+    }
+    PWP_UINT32 hole = findSlot(key(e));
+    if (EmptyKey == keys_[hole]) {
+        return false;
+    }
+    // Move back the following edges of the probe run that would no longer
+    // be found past the hole
+    const PWP_UINT32 mask = (PWP_UINT32)keys_.size() - 1;
+    PWP_UINT32 next = hole;
+    while (true) {
+        next = (next + 1) & mask;
+        if (EmptyKey == keys_[next]) {
+            break;
+        }
+        const PWP_UINT32 h = home(keys_[next]);
+        const bool stays = (hole < next) ? ((hole < h) && (h <= next)) :
+            ((hole < h) || (h <= next));
+        if (!stays) {
+            keys_[hole] = keys_[next];
+            vals_[hole] = vals_[next];
+            hole = next;
+        }
+    }
+    keys_[hole] = EmptyKey;
+    --count_;
+    return true;
+}
+
+
+void
+EdgeTable::reserve(PWP_UINT32 count)
+{
+    PWP_UINT32 numSlots = keys_.empty() ? MinSlots :
+        (PWP_UINT32)keys_.size();
+    while (numSlots < 2 * (PWP_UINT64)count) {
+        numSlots *= 2;
+    }
+    if (numSlots != keys_.size()) {
+        rehash(numSlots);
+    }
+}
+
+
+void
+EdgeTable::clear()
+{
+    std::vector<PWP_UINT64>().swap(keys_);
+    std::vector<PWP_UINT64>().swap(vals_);
+    count_ = 0;
+}
+
+
+PWP_UINT32
+EdgeTable::home(PWP_UINT64 k) const
+{
+    // grid vertices are numbered in runs, mix all the bits
+    k *= 0x9E3779B97F4A7C15ULL;
+    return (PWP_UINT32)(k ^ (k >> 32)) & ((PWP_UINT32)keys_.size() - 1);
+}
+
+
+PWP_UINT32
+EdgeTable::findSlot(PWP_UINT64 k) const
+{
+    // the slot of k, or the empty slot where it goes
+    const PWP_UINT32 mask = (PWP_UINT32)keys_.size() - 1;
+    PWP_UINT32 slot = home(k);
+    while ((EmptyKey != keys_[slot]) && (k != keys_[slot])) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+
+void
+EdgeTable::rehash(PWP_UINT32 numSlots)
+{
+    std::vector<PWP_UINT64> keys(numSlots, EmptyKey);
+    std::vector<PWP_UINT64> vals(numSlots, 0);
+    keys_.swap(keys);
+    vals_.swap(vals);
+    for (size_t ii = 0; ii < keys.size(); ++ii) {
+        if (EmptyKey != keys[ii]) {
+            const PWP_UINT32 slot = findSlot(keys[ii]);
+            keys_[slot] = keys[ii];
+            vals_[slot] = vals[ii];
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/****************************************************************************
+ *
+ * class EdgeTable
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _EDGETABLE_H_
+#define _EDGETABLE_H_
+
+#include "apiPWP.h"
+
+#include "Edge.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// A hash table of edges with a PWP_UINT64 value each. The edges and     //
+// values are kept in two flat arrays with linear probing, so adding an  //
+// edge does not allocate. The arrays double when they are half full.    //
+//////////////////////////////////////////////////////////////////////////
+class EdgeTable {
+public:
+    EdgeTable();
+    ~EdgeTable();
+
+    // Adds e with val. Returns false and keeps the old value if e is
+    // already in the table.
+    bool            insert(const Edge &e, PWP_UINT64 val = 0);
+    bool            contains(const Edge &e) const;
+
+    // Returns the value of e, or 0 if e is not in the table
+    PWP_UINT64 *    find(const Edge &e);
+    bool            erase(const Edge &e);
+
+    // makes room for count edges without growing
+    void            reserve(PWP_UINT32 count);
+    void            clear();
+
+    PWP_UINT32      size() const {
+                        return count_; }
+
+    // the slots, to visit every edge
+    PWP_UINT32      slotCount() const {
+                        return (PWP_UINT32)keys_.size(); }
+    bool            isUsed(PWP_UINT32 slot) const {
+                        return EmptyKey != keys_[slot]; }
+    Edge            edgeAt(PWP_UINT32 slot) const {
+                        return Edge((PWP_UINT32)(keys_[slot] >> 32),
+                            (PWP_UINT32)keys_[slot]); }
+    PWP_UINT64      valueAt(PWP_UINT32 slot) const {
+                        return vals_[slot]; }
+
+private:
+    // no edge joins the last vertex to itself
+    static const PWP_UINT64 EmptyKey = ~(PWP_UINT64)0;
+
+    static PWP_UINT64   key(const Edge &e) {
+                            return ((PWP_UINT64)e.i0() << 32) | e.i1(); }
+
+    PWP_UINT32  home(PWP_UINT64 k) const;
+    PWP_UINT32  findSlot(PWP_UINT64 k) const;
+    void        rehash(PWP_UINT32 numSlots);
+
+private:
+    std::vector<PWP_UINT64> keys_;
+    std::vector<PWP_UINT64> vals_;
+    PWP_UINT32              count_;
+};
+
+#endif // _EDGETABLE_H_
@@ -0,0 +1,134 @@
+/****************************************************************************
+ *
+ * class FaceTable
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include "FaceTable.h"
+
+// the slots of a table's first allocation
+const PWP_UINT32 MinSlots = 64;
+
+const PWP_UINT32 FaceTable::NoVert;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+FaceTable::FaceTable() :
+    slots_(),
+    count_(0)
+{
+}
+
+
+FaceTable::~FaceTable()
+{
+}
+
+
+PWP_UINT32 &
+FaceTable::lookup(const PWP_UINT32 *verts, PWP_UINT32 numVerts)
+{
+    if (2 * (count_ + 1) > slots_.size()) {
+        rehash(slots_.empty() ? MinSlots : 2 * (PWP_UINT32)slots_.size());
+    }
+    PWP_UINT32 key[4];
+    makeKey(verts, numVerts, key);
+    Slot &slot = slots_[findSlot(key)];
+    if (isEmpty(slot)) {
+        for (int ii = 0; ii < 4; ++ii) {
+            slot.vert[ii] = key[ii];
+        }
+        slot.val = 0;
+        ++count_;
+    }
+    return slot.val;
+}
+
+
+PWP_UINT32 *
+FaceTable::find(const PWP_UINT32 *verts, PWP_UINT32 numVerts)
+{
+    if (slots_.empty()) {
+        return 0;
+    }
+    PWP_UINT32 key[4];
+    makeKey(verts, numVerts, key);
+    Slot &slot = slots_[findSlot(key)];
+    return isEmpty(slot) ? 0 : &slot.val;
+}
+
+
+void
+FaceTable::clear()
+{
+    std::vector<Slot>().swap(slots_);
+    count_ = 0;
+}
+
+
+void
+FaceTable::makeKey(const PWP_UINT32 *verts, PWP_UINT32 numVerts,
+    PWP_UINT32 key[4])
+{
+    key[3] = NoVert;
+    for (PWP_UINT32 ii = 0; ii < numVerts; ++ii) {
+        // insertion sort
+        PWP_UINT32 jj = ii;
+        for (; (jj > 0) && (key[jj - 1] > verts[ii]); --jj) {
+            key[jj] = key[jj - 1];
+        }
+        key[jj] = verts[ii];
+    }
+}
+
+
+PWP_UINT32
+FaceTable::home(const PWP_UINT32 key[4]) const
+{
+    // grid vertices are numbered in runs, mix all the bits
+    PWP_UINT64 h = ((PWP_UINT64)key[0] << 32) | key[1];
+    h = (h * 0x9E3779B97F4A7C15ULL) ^ (((PWP_UINT64)key[2] << 32) | key[3]);
+    h *= 0x9E3779B97F4A7C15ULL;
+    return (PWP_UINT32)(h ^ (h >> 32)) & ((PWP_UINT32)slots_.size() - 1);
+}
+
+
+PWP_UINT32
+FaceTable::findSlot(const PWP_UINT32 key[4]) const
+{
+    // the slot of key, or the empty slot where it goes
+    const PWP_UINT32 mask = (PWP_UINT32)slots_.size() - 1;
+    PWP_UINT32 slot = home(key);
+    while (!isEmpty(slots_[slot])) {
+        const Slot &s = slots_[slot];
+        if ((s.vert[0] == key[0]) && (s.vert[1] == key[1]) &&
+                (s.vert[2] == key[2]) && (s.vert[3] == key[3])) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+
+void
+FaceTable::rehash(PWP_UINT32 numSlots)
+{
+    Slot empty;
+    empty.vert[0] = empty.vert[1] = empty.vert[2] = empty.vert[3] = NoVert;
+    empty.val = 0;
+    std::vector<Slot> slots(numSlots, empty);
+    slots_.swap(slots);
+    for (size_t ii = 0; ii < slots.size(); ++ii) {
+        if (!isEmpty(slots[ii])) {
+            slots_[findSlot(slots[ii].vert)] = slots[ii];
+        }
+    }
+}
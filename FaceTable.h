@@ -0,0 +1,65 @@
+/****************************************************************************
+ *
+ * class FaceTable
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _FACETABLE_H_
+#define _FACETABLE_H_
+
+#include "apiPWP.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// A hash table of triangle and quad faces with a PWP_UINT32 value each. //
+// A face is keyed by its sorted vertex indices, so every cell sharing  //
+// it finds the same slot. As in EdgeTable, the slots are kept in one    //
+// flat array with linear probing that doubles when it is half full.    //
+//////////////////////////////////////////////////////////////////////////
+class FaceTable {
+public:
+    FaceTable();
+    ~FaceTable();
+
+    // Returns the value of the face with numVerts (3 or 4) vertices,
+    // adding the face with value 0 if it is not in the table
+    PWP_UINT32 &    lookup(const PWP_UINT32 *verts, PWP_UINT32 numVerts);
+
+    // Returns the value of the face, or 0 if it is not in the table
+    PWP_UINT32 *    find(const PWP_UINT32 *verts, PWP_UINT32 numVerts);
+    void            clear();
+
+    PWP_UINT32      size() const {
+                        return count_; }
+
+private:
+    // The sorted vertices. A triangle's last vertex is NoVert, and no
+    // face has NoVert as its first vertex.
+    struct Slot {
+        PWP_UINT32  vert[4];
+        PWP_UINT32  val;
+    };
+
+    static const PWP_UINT32 NoVert = ~(PWP_UINT32)0;
+
+    static void makeKey(const PWP_UINT32 *verts, PWP_UINT32 numVerts,
+                    PWP_UINT32 key[4]);
+    static bool isEmpty(const Slot &slot) {
+                    return NoVert == slot.vert[0]; }
+
+    PWP_UINT32  home(const PWP_UINT32 key[4]) const;
+    PWP_UINT32  findSlot(const PWP_UINT32 key[4]) const;
+    void        rehash(PWP_UINT32 numSlots);
+
+private:
+    std::vector<Slot>   slots_;
+    PWP_UINT32          count_;
+};
+
+#endif // _FACETABLE_H_
@@ -0,0 +1,658 @@
+/****************************************************************************
+ *
+ * class GridSnapshot
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "EdgeGraph.h"
+#include "GridSnapshot.h"
+#include "Print3DExporter.h"
+
+
+const char          SnapshotMagic[8] = { 'P','3','D','S','N','A','P','2' };
+const PWP_UINT32    SnapshotByteOrder = 0x01020304;
+const size_t        ConnChunk = 65536;
+
+
+//***************************************************************************
+// The file starts with the header. The sections follow at 8-byte aligned
+// offsets, the connectivity first so that it can be streamed.
+struct GridSnapshot::Header {
+    char        magic[8];
+    PWP_UINT32  byteOrder;
+    PWP_UINT32  numEntities;
+    PWP_UINT64  numVerts;
+    PWP_UINT64  numRuns;
+    PWP_UINT64  connSize;       // vertex indices
+    PWP_UINT64  numEdges;
+    PWP_UINT64  namesSize;      // bytes
+    PWP_UINT64  offXyz;         // double[3 * numVerts]
+    PWP_UINT64  offEntities;    // EntityRec[numEntities]
+    PWP_UINT64  offRuns;        // RunRec[numRuns]
+    PWP_UINT64  offConn;        // PWP_UINT32[connSize]
+    PWP_UINT64  offEdges;       // PWP_UINT32[2 * numEdges]
+    PWP_UINT64  offNames;       // char[namesSize]
+};
+
+
+//***************************************************************************
+// A patch or block. Its elements are numRuns runs starting at firstRun and
+// its owned edges are numEdges pairs starting at firstEdge. The bounding
+// box of an entity without elements is empty, its minimum above its
+// maximum.
+struct GridSnapshot::EntityRec {
+    PWP_UINT8   isBlock;
+    PWP_UINT8   cond;
+    PWP_UINT16  pad0;
+    PWP_UINT32  numElems;
+    PWP_UINT32  firstRun;
+    PWP_UINT32  numRuns;
+    PWP_UINT64  firstEdge;
+    PWP_UINT32  numEdges;
+    PWP_UINT32  nameOff;
+    PWP_UINT32  nameLen;
+    PWP_UINT32  pad1;
+    double      minXyz[3];
+    double      maxXyz[3];
+};
+
+
+//***************************************************************************
+// Consecutive elements of one type. Their vertex indices start at connOff.
+struct GridSnapshot::RunRec {
+    PWP_UINT32  firstElem;
+    PWP_UINT32  type;
+    PWP_UINT64  connOff;
+};
+
+
+//***************************************************************************
+// Where a snapshot is written. The header is rewritten once the section
+// offsets are known.
+class SnapshotSink {
+public:
+    SnapshotSink() :
+        pos_(0)
+    {
+    }
+
+    virtual ~SnapshotSink() {}
+
+    bool append(const void *buf, size_t size) {
+        pos_ += size;
+        return (0 == size) || doAppend(buf, size);
+    }
+
+    bool pad() {
+        const char zeros[8] = { 0 };
+        return append(zeros, (size_t)((8 - pos_ % 8) % 8));
+    }
+
+    PWP_UINT64 pos() const {
+        return pos_;
+    }
+
+    virtual bool rewrite(const void *hdr, size_t size) = 0;
+
+protected:
+    virtual bool doAppend(const void *buf, size_t size) = 0;
+
+private:
+    PWP_UINT64  pos_;
+};
+
+
+//***************************************************************************
+// Writes a snapshot file
+class SnapshotFileSink : public SnapshotSink {
+public:
+    SnapshotFileSink(FILE *fp) :
+        fp_(fp)
+    {
+    }
+
+    virtual bool rewrite(const void *hdr, size_t size) {
+        return (0 == fseek(fp_, 0, SEEK_SET)) &&
+            (1 == fwrite(hdr, size, 1, fp_));
+    }
+
+protected:
+    virtual bool doAppend(const void *buf, size_t size) {
+        return 1 == fwrite(buf, size, 1, fp_);
+    }
+
+private:
+    FILE *  fp_;
+};
+
+
+//***************************************************************************
+// Writes a snapshot to memory. The buffer is made of 8-byte words so that
+// the sections are aligned.
+class SnapshotMemSink : public SnapshotSink {
+public:
+    SnapshotMemSink(std::vector<PWP_UINT64> &mem) :
+        mem_(mem)
+    {
+        mem_.clear();
+    }
+
+    virtual bool rewrite(const void *hdr, size_t size) {
+        memcpy(&mem_[0], hdr, size);
+        return true;
+    }
+
+protected:
+    virtual bool doAppend(const void *buf, size_t size) {
+        const PWP_UINT64 start = pos() - size;
+        mem_.resize((size_t)((pos() + 7) / 8), 0);
+        memcpy((unsigned char *)&mem_[0] + start, buf, size);
+        return true;
+    }
+
+private:
+    std::vector<PWP_UINT64> &   mem_;
+};
+
+
+// grows a bounding box to hold xyz, or sets it to xyz if first
+static void
+addBounds(double *minXyz, double *maxXyz, const double *xyz, bool first)
+{
+    for (int ii = 0; ii < 3; ++ii) {
+        if (first || (xyz[ii] < minXyz[ii])) {
+            minXyz[ii] = xyz[ii];
+        }
+        if (first || (xyz[ii] > maxXyz[ii])) {
+            maxXyz[ii] = xyz[ii];
+        }
+    }
+}
+
+
+// true if the section [off, off + cnt * size) lies in a file of fileSize
+// bytes and is aligned
+static bool
+inFile(PWP_UINT64 off, PWP_UINT64 cnt, PWP_UINT64 size, PWP_UINT64 fileSize)
+{
+    return (0 == off % 8) && (off <= fileSize) &&
+        (cnt <= (fileSize - off) / size);
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+GridSnapshot::GridSnapshot() :
+    file_(),
+    mem_(),
+    hdr_(0),
+    xyz_(0),
+    entities_(0),
+    runs_(0),
+    conn_(0),
+    edges_(0),
+    names_(0),
+    conds_(),
+    edgesValid_(false)
+{
+}
+
+
+GridSnapshot::~GridSnapshot()
+{
+}
+
+
+bool
+GridSnapshot::write(Print3DModel &model, Print3DHost &host,
+    const std::string &path)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (0 == fp) {
+        return false;
+    }
+    SnapshotFileSink sink(fp);
+    bool ret = build(model, host, sink);
+    if (0 != fclose(fp)) {
+        ret = false;
+    }
+    if (!ret) {
+        remove(path.c_str());
+    }
+    return ret;
+}
+
+
+bool
+GridSnapshot::load(Print3DModel &model, Print3DHost &host, std::string &err)
+{
+    close();
+    SnapshotMemSink sink(mem_);
+    if (!build(model, host, sink)) {
+        err = "cannot build grid snapshot";
+        close();
+        return false;
+    }
+    if (!mapSections((const unsigned char *)&mem_[0],
+            (PWP_UINT64)mem_.size() * sizeof(PWP_UINT64), err)) {
+        close();
+        return false;
+    }
+    initConds();
+    return true;
+}
+
+
+bool
+GridSnapshot::build(Print3DModel &model, Print3DHost &host,
+    SnapshotSink &sink)
+{
+    // the exporter assigns each edge to the first visible entity that
+    // writes it
+    EdgeGraph graph;
+    std::vector<PWP_UINT32> edgeEnds;
+    Print3DExporter exporter(model, host, 0, Print3DSettings());
+    if (!exporter.collectEdges(graph, edgeEnds)) {
+        return false;
+    }
+    // the connectivity is streamed behind a placeholder header, the other
+    // sections are appended and the header is written last
+    Header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    bool ret = sink.append(&hdr, sizeof(hdr));
+    hdr.offConn = sink.pos();
+
+    const PWP_UINT32 numEntities = model.entityCount();
+    PWP_UINT32 numElems = 0;
+    PWP_UINT32 ndx;
+    for (ndx = 0; ndx < numEntities; ++ndx) {
+        numElems += model.elementCount(ndx);
+    }
+    std::vector<EntityRec> entities(numEntities);
+    std::vector<RunRec> runs;
+    std::vector<double> xyz;
+    std::vector<PWP_UINT32> conn;
+    std::string names;
+    conn.reserve(ConnChunk + 8);
+    if (!host.progressBeginStep(numElems)) {
+        ret = false;
+    }
+    for (ndx = 0; ret && (ndx < numEntities); ++ndx) {
+        EntityRec &ent = entities[ndx];
+        memset(&ent, 0, sizeof(ent));
+        ent.isBlock = model.isBlock(ndx) ? 1 : 0;
+        ent.cond = (PWP_UINT8)model.condition(ndx);
+        ent.firstRun = (PWP_UINT32)runs.size();
+        ent.firstEdge = (0 == ndx) ? 0 : edgeEnds[ndx - 1];
+        ent.numEdges = edgeEnds[ndx] - (PWP_UINT32)ent.firstEdge;
+        const std::string name = model.entityName(ndx);
+        ent.nameOff = (PWP_UINT32)names.size();
+        ent.nameLen = (PWP_UINT32)name.size();
+        names += name;
+        for (int jj = 0; jj < 3; ++jj) {
+            ent.minXyz[jj] = 1.0;
+            ent.maxXyz[jj] = -1.0;
+        }
+
+        Print3DElem eData;
+        const PWP_UINT32 cnt = model.elementCount(ndx);
+        for (PWP_UINT32 ii = 0; ret && (ii < cnt); ++ii) {
+            if (!model.elementData(ndx, ii, eData) ||
+                    !host.progressIncrement()) {
+                break;
+            }
+            if ((runs.size() == ent.firstRun) ||
+                    (runs.back().type != (PWP_UINT32)eData.type)) {
+                RunRec run;
+                run.firstElem = ii;
+                run.type = (PWP_UINT32)eData.type;
+                run.connOff = hdr.connSize + conn.size();
+                runs.push_back(run);
+            }
+            for (PWP_UINT32 jj = 0; jj < eData.vertCnt; ++jj) {
+                const PWGM_VERTDATA &v = eData.vert[jj];
+                if (3 * (size_t)v.i >= xyz.size()) {
+                    xyz.resize(3 * ((size_t)v.i + 1), 0.0);
+                }
+                xyz[3 * v.i] = v.x;
+                xyz[3 * v.i + 1] = v.y;
+                xyz[3 * v.i + 2] = v.z;
+                conn.push_back(v.i);
+                addBounds(ent.minXyz, ent.maxXyz, &xyz[3 * v.i],
+                    (0 == ent.numElems) && (0 == jj));
+            }
+            if (conn.size() >= ConnChunk) {
+                hdr.connSize += conn.size();
+                ret = sink.append(&conn[0], conn.size() * sizeof(conn[0]));
+                conn.clear();
+            }
+            ++ent.numElems;
+        }
+        ent.numRuns = (PWP_UINT32)runs.size() - ent.firstRun;
+    }
+    host.progressEndStep();
+    ret = ret && !host.aborted();
+    if (ret && !conn.empty()) {
+        hdr.connSize += conn.size();
+        ret = sink.append(&conn[0], conn.size() * sizeof(conn[0]));
+    }
+
+    std::vector<PWP_UINT32> edges(2 * (size_t)graph.edgeCount());
+    for (PWP_UINT32 ii = 0; ii < graph.edgeCount(); ++ii) {
+        edges[2 * ii] = graph.gridIndex(graph.edgeVert(ii, 0));
+        edges[2 * ii + 1] = graph.gridIndex(graph.edgeVert(ii, 1));
+    }
+    memcpy(hdr.magic, SnapshotMagic, sizeof(hdr.magic));
+    hdr.byteOrder = SnapshotByteOrder;
+    hdr.numEntities = numEntities;
+    hdr.numVerts = xyz.size() / 3;
+    hdr.numRuns = runs.size();
+    hdr.numEdges = graph.edgeCount();
+    hdr.namesSize = names.size();
+    ret = ret && sink.pad();
+    hdr.offXyz = sink.pos();
+    ret = ret && sink.append((xyz.empty() ? 0 : &xyz[0]),
+        xyz.size() * sizeof(double)) && sink.pad();
+    hdr.offEntities = sink.pos();
+    ret = ret && sink.append((entities.empty() ? 0 : &entities[0]),
+        entities.size() * sizeof(EntityRec));
+    hdr.offRuns = sink.pos();
+    ret = ret && sink.append((runs.empty() ? 0 : &runs[0]),
+        runs.size() * sizeof(RunRec));
+    hdr.offEdges = sink.pos();
+    ret = ret && sink.append((edges.empty() ? 0 : &edges[0]),
+        edges.size() * sizeof(PWP_UINT32)) && sink.pad();
+    hdr.offNames = sink.pos();
+    return ret && sink.append(names.data(), names.size()) && sink.pad() &&
+        sink.rewrite(&hdr, sizeof(hdr));
+}
+
+
+bool
+GridSnapshot::open(const std::string &path, std::string &err)
+{
+    close();
+    if (!file_.open(path)) {
+        err = "cannot map file";
+        return false;
+    }
+    if (!mapSections(file_.data(), file_.size(), err)) {
+        close();
+        return false;
+    }
+    initConds();
+    return true;
+}
+
+
+void
+GridSnapshot::close()
+{
+    file_.close();
+    mem_.clear();
+    hdr_ = 0;
+    xyz_ = 0;
+    entities_ = 0;
+    runs_ = 0;
+    conn_ = 0;
+    edges_ = 0;
+    names_ = 0;
+    conds_.clear();
+    edgesValid_ = false;
+}
+
+
+bool
+GridSnapshot::mapSections(const unsigned char *data, PWP_UINT64 size,
+    std::string &err)
+{
+    // Checks the layout. The vertex indices are checked as they are used
+    // so that opening does not touch the bulk of the file.
+    const Header *hdr = (const Header *)data;
+    if ((size < sizeof(Header)) ||
+            (0 != memcmp(hdr->magic, SnapshotMagic, sizeof(hdr->magic) - 1))) {
+        err = "not a Print3D grid snapshot";
+        return false;
+    }
+    if (SnapshotMagic[7] != hdr->magic[7]) {
+        err = "grid snapshot was written by another version";
+        return false;
+    }
+    if (SnapshotByteOrder != hdr->byteOrder) {
+        err = "grid snapshot was written with another byte order";
+        return false;
+    }
+    if (!inFile(hdr->offXyz, 3 * hdr->numVerts, sizeof(double), size) ||
+            !inFile(hdr->offEntities, hdr->numEntities, sizeof(EntityRec),
+                size) ||
+            !inFile(hdr->offRuns, hdr->numRuns, sizeof(RunRec), size) ||
+            !inFile(hdr->offConn, hdr->connSize, sizeof(PWP_UINT32), size) ||
+            !inFile(hdr->offEdges, 2 * hdr->numEdges, sizeof(PWP_UINT32),
+                size) ||
+            !inFile(hdr->offNames, hdr->namesSize, 1, size) ||
+            (hdr->numVerts > 0xffffffffUL) || (hdr->numRuns > 0xffffffffUL)) {
+        err = "bad grid snapshot";
+        return false;
+    }
+    const EntityRec *entities = (const EntityRec *)(data + hdr->offEntities);
+    const RunRec *runs = (const RunRec *)(data + hdr->offRuns);
+    for (PWP_UINT32 ndx = 0; ndx < hdr->numEntities; ++ndx) {
+        const EntityRec &ent = entities[ndx];
+        bool ok = (ent.cond <= Print3DCondSolid) &&
+            (ent.numRuns <= hdr->numRuns - ent.firstRun) &&
+            (ent.firstRun <= hdr->numRuns) &&
+            (ent.firstEdge <= hdr->numEdges) &&
+            (ent.numEdges <= hdr->numEdges - ent.firstEdge) &&
+            (ent.nameOff <= hdr->namesSize) &&
+            (ent.nameLen <= hdr->namesSize - ent.nameOff) &&
+            ((0 == ent.numElems) == (0 == ent.numRuns));
+        // the runs must cover the elements in order
+        for (PWP_UINT32 ii = 0; ok && (ii < ent.numRuns); ++ii) {
+            const RunRec &run = runs[ent.firstRun + ii];
+            const PWP_UINT32 end = (ii + 1 < ent.numRuns) ?
+                runs[ent.firstRun + ii + 1].firstElem : ent.numElems;
+            const PWP_UINT32 vc = vertCount((PWGM_ENUM_ELEMTYPE)run.type);
+            ok = ((0 != ii) || (0 == run.firstElem)) &&
+                (run.firstElem < end) && (vc > 0) &&
+                (run.connOff <= hdr->connSize) &&
+                ((PWP_UINT64)(end - run.firstElem) * vc <=
+                    hdr->connSize - run.connOff);
+        }
+        if (!ok) {
+            err = "bad grid snapshot";
+            return false;
+        }
+    }
+    hdr_ = hdr;
+    xyz_ = (const double *)(data + hdr->offXyz);
+    entities_ = entities;
+    runs_ = runs;
+    conn_ = (const PWP_UINT32 *)(data + hdr->offConn);
+    edges_ = (const PWP_UINT32 *)(data + hdr->offEdges);
+    names_ = (const char *)(data + hdr->offNames);
+    return true;
+}
+
+
+void
+GridSnapshot::setCondition(PWP_UINT32 ndx, Print3DCond cond)
+{
+    if ((Print3DCondHidden == cond) != (Print3DCondHidden == conds_[ndx])) {
+        // the edges were assigned to the entities visible when the
+        // snapshot was written
+        edgesValid_ = false;
+    }
+    conds_[ndx] = cond;
+}
+
+
+void
+GridSnapshot::initConds()
+{
+    conds_.resize(hdr_->numEntities);
+    for (PWP_UINT32 ndx = 0; ndx < hdr_->numEntities; ++ndx) {
+        conds_[ndx] = (Print3DCond)entities_[ndx].cond;
+    }
+    edgesValid_ = true;
+}
+
+
+PWP_UINT32
+GridSnapshot::setCondition(const std::string &name, Print3DCond cond)
+{
+    PWP_UINT32 ret = 0;
+    for (PWP_UINT32 ndx = 0; ndx < entityCount(); ++ndx) {
+        if (name == entityName(ndx)) {
+            setCondition(ndx, cond);
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+
+PWP_UINT32
+GridSnapshot::vertexCount() const
+{
+    return (0 == hdr_) ? 0 : (PWP_UINT32)hdr_->numVerts;
+}
+
+
+PWP_UINT32
+GridSnapshot::entityCount() const
+{
+    return (PWP_UINT32)conds_.size();
+}
+
+
+bool
+GridSnapshot::isBlock(PWP_UINT32 ndx) const
+{
+    return 0 != entities_[ndx].isBlock;
+}
+
+
+Print3DCond
+GridSnapshot::condition(PWP_UINT32 ndx) const
+{
+    return conds_[ndx];
+}
+
+
+std::string
+GridSnapshot::entityName(PWP_UINT32 ndx) const
+{
+    const EntityRec &ent = entities_[ndx];
+    return std::string(names_ + ent.nameOff, ent.nameLen);
+}
+
+
+PWP_UINT32
+GridSnapshot::elementCount(PWP_UINT32 ndx) const
+{
+    return entities_[ndx].numElems;
+}
+
+
+bool
+GridSnapshot::elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+    Print3DElem &elem) const
+{
+    const EntityRec &ent = entities_[ndx];
+    if (elemNdx >= ent.numElems) {
+        return false;
+    }
+    // the last run that starts at or before elemNdx
+    PWP_UINT32 lo = ent.firstRun;
+    PWP_UINT32 hi = ent.firstRun + ent.numRuns;
+    while (hi - lo > 1) {
+        const PWP_UINT32 mid = lo + (hi - lo) / 2;
+        if (runs_[mid].firstElem <= elemNdx) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    const RunRec &run = runs_[lo];
+    elem.type = (PWGM_ENUM_ELEMTYPE)run.type;
+    elem.vertCnt = vertCount(elem.type);
+    const PWP_UINT32 *verts = conn_ + run.connOff +
+        (PWP_UINT64)(elemNdx - run.firstElem) * elem.vertCnt;
+    for (PWP_UINT32 ii = 0; ii < elem.vertCnt; ++ii) {
+        if (!vertexData(verts[ii], elem.vert[ii])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool
+GridSnapshot::ownedEdges(PWP_UINT32 ndx, const PWP_UINT32 *&verts,
+    PWP_UINT32 &count) const
+{
+    if (!edgesValid_) {
+        return false;
+    }
+    const EntityRec &ent = entities_[ndx];
+    verts = edges_ + 2 * ent.firstEdge;
+    count = ent.numEdges;
+    return true;
+}
+
+
+bool
+GridSnapshot::bounds(PWP_UINT32 ndx, double *minXyz, double *maxXyz) const
+{
+    const EntityRec &ent = entities_[ndx];
+    for (int ii = 0; ii < 3; ++ii) {
+        minXyz[ii] = ent.minXyz[ii];
+        maxXyz[ii] = ent.maxXyz[ii];
+    }
+    return true;
+}
+
+
+bool
+GridSnapshot::vertexData(PWP_UINT32 vert, PWGM_VERTDATA &vd) const
+{
+    if (vert >= hdr_->numVerts) {
+        return false;
+    }
+    const double *xyz = xyz_ + 3 * (size_t)vert;
+    vd.x = xyz[0];
+    vd.y = xyz[1];
+    vd.z = xyz[2];
+    vd.i = vert;
+    return true;
+}
+
+
+PWP_UINT32
+GridSnapshot::vertCount(PWGM_ENUM_ELEMTYPE type)
+{
+    PWP_UINT32 ret = 0;
+    switch (type) {
+        case PWGM_ELEMTYPE_POINT:   ret = 1; break;
+        case PWGM_ELEMTYPE_BAR:     ret = 2; break;
+        case PWGM_ELEMTYPE_TRI:     ret = 3; break;
+        case PWGM_ELEMTYPE_QUAD:    ret = 4; break;
+        case PWGM_ELEMTYPE_TET:     ret = 4; break;
+        case PWGM_ELEMTYPE_PYRAMID: ret = 5; break;
+        case PWGM_ELEMTYPE_WEDGE:   ret = 6; break;
+        case PWGM_ELEMTYPE_HEX:     ret = 8; break;
+        default:                    ret = 0; break;
+    }
+    return ret;
+}
@@ -0,0 +1,107 @@
+/****************************************************************************
+ *
+ * class GridSnapshot
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _GRIDSNAPSHOT_H_
+#define _GRIDSNAPSHOT_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include "MappedFile.h"
+#include "Print3DModel.h"
+
+#include <string>
+#include <vector>
+
+
+#define SnapshotFileExt ".p3ds"
+
+class SnapshotSink;
+
+
+//////////////////////////////////////////////////////////////////////////
+// A compact binary copy of a grid model that is read by mapping it into //
+// memory. It holds the float64 vertex coordinates, the element          //
+// connectivity as runs of one element type, the entity names and       //
+// conditions, the bounding box of each entity, and the unique edges    //
+// in the order an export writes them.                                  //
+// Exporting a snapshot needs neither a parse nor an edge lookup.       //
+//                                                                       //
+// The file is written in the byte order of the writing machine and     //
+// only opens on a machine with the same order.                         //
+//////////////////////////////////////////////////////////////////////////
+class GridSnapshot : public Print3DModel {
+public:
+    GridSnapshot();
+    virtual ~GridSnapshot();
+
+    // Writes a snapshot of model to path. The edges are assigned to the
+    // entities that are visible in model.
+    static bool write(Print3DModel &model, Print3DHost &host,
+                    const std::string &path);
+
+    // Maps the snapshot at path. Returns false and sets err on failure.
+    bool    open(const std::string &path, std::string &err);
+
+    // Builds the snapshot of model in memory. The result does not depend
+    // on model, which is no longer needed.
+    bool    load(Print3DModel &model, Print3DHost &host, std::string &err);
+    void    close();
+
+    // Applies a condition to entity ndx or to the entities with the given
+    // name. Hiding or showing an entity drops the stored edges.
+    void        setCondition(PWP_UINT32 ndx, Print3DCond cond);
+    PWP_UINT32  setCondition(const std::string &name, Print3DCond cond);
+
+    PWP_UINT32  vertexCount() const;
+
+    // Print3DModel implementation
+    virtual PWP_UINT32  entityCount() const;
+    virtual bool        isBlock(PWP_UINT32 ndx) const;
+    virtual Print3DCond condition(PWP_UINT32 ndx) const;
+    virtual std::string entityName(PWP_UINT32 ndx) const;
+    virtual PWP_UINT32  elementCount(PWP_UINT32 ndx) const;
+    virtual bool        elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+                            Print3DElem &elem) const;
+    virtual bool        ownedEdges(PWP_UINT32 ndx, const PWP_UINT32 *&verts,
+                            PWP_UINT32 &count) const;
+    virtual bool        vertexData(PWP_UINT32 vert, PWGM_VERTDATA &vd) const;
+    virtual bool        bounds(PWP_UINT32 ndx, double *minXyz,
+                            double *maxXyz) const;
+
+    static PWP_UINT32   vertCount(PWGM_ENUM_ELEMTYPE type);
+
+private:
+    struct Header;
+    struct EntityRec;
+    struct RunRec;
+
+    static bool build(Print3DModel &model, Print3DHost &host,
+                    SnapshotSink &sink);
+
+    bool    mapSections(const unsigned char *data, PWP_UINT64 size,
+                std::string &err);
+    void    initConds();
+
+private:
+    MappedFile                  file_;
+    std::vector<PWP_UINT64>     mem_;
+    const Header *              hdr_;
+    const double *              xyz_;
+    const EntityRec *           entities_;
+    const RunRec *              runs_;
+    const PWP_UINT32 *          conn_;
+    const PWP_UINT32 *          edges_;
+    const char *                names_;
+    std::vector<Print3DCond>    conds_;
+    bool                        edgesValid_;
+};
+
+#endif // _GRIDSNAPSHOT_H_
@@ -0,0 +1,597 @@
+/****************************************************************************
+ *
+ * class HubMesher
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <math.h>
+
+#include "HubMesher.h"
+
+// The depth of a hub is HubMargin times the least depth at which the end
+// polygons are faces of their hull, and at least MinDepth radii
+const double HubMargin = 1.05;
+const double MinDepth = 0.25;
+
+// the hub depth, in radii, of edges that leave a vertex in one direction
+const double MaxDepth = 1e3;
+
+// the most of an edge's length that the hubs at its ends may take
+const double MaxReach = 0.9;
+
+// the hull tolerance, relative to the size of the hub
+const double HullTol = 1e-9;
+
+
+static double
+dot(const double *a, const double *b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+
+static void
+cross(const double *a, const double *b, double *c)
+{
+    c[0] = a[1] * b[2] - a[2] * b[1];
+    c[1] = a[2] * b[0] - a[0] * b[2];
+    c[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+
+static void
+normalize(double *v)
+{
+    const double len = sqrt(dot(v, v));
+    if (len > 0.0) {
+        v[0] /= len;
+        v[1] /= len;
+        v[2] /= len;
+    }
+}
+
+
+static void
+addTri(const double *p0, const double *p1, const double *p2,
+    std::vector<double> &tris)
+{
+    tris.insert(tris.end(), p0, p0 + 3);
+    tris.insert(tris.end(), p1, p1 + 3);
+    tris.insert(tris.end(), p2, p2 + 3);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// The convex hull of a few points, built by adding one point at a time //
+// to a tetrahedron. A point that is not farther than the tolerance     //
+// outside every face is dropped. Coplanar points make coplanar         //
+// triangles.                                                           //
+//////////////////////////////////////////////////////////////////////////
+class HubHull {
+public:
+    HubHull() :
+        pts_(),
+        faces_(),
+        visible_(),
+        horizon_(),
+        used_()
+    {
+    }
+
+    // Builds the hull of the points, relative to origin. Returns false if
+    // they are flat.
+    bool build(const std::vector<double> &pts, const double *origin,
+            double tol) {
+        const PWP_UINT32 num = (PWP_UINT32)(pts.size() / 3);
+        pts_.resize(pts.size());
+        for (size_t ii = 0; ii < pts.size(); ++ii) {
+            pts_[ii] = pts[ii] - origin[ii % 3];
+        }
+        faces_.clear();
+        used_.assign(num, false);
+        PWP_UINT32 tet[4];
+        if (!findTet(num, tol, tet)) {
+            return false;
+        }
+        double center[3] = { 0.0, 0.0, 0.0 };
+        for (int ii = 0; ii < 4; ++ii) {
+            for (int jj = 0; jj < 3; ++jj) {
+                center[jj] += pt(tet[ii])[jj] / 4.0;
+            }
+            used_[tet[ii]] = true;
+        }
+        addFace(tet[0], tet[1], tet[2], center);
+        addFace(tet[0], tet[1], tet[3], center);
+        addFace(tet[0], tet[2], tet[3], center);
+        addFace(tet[1], tet[2], tet[3], center);
+        for (PWP_UINT32 ii = 0; ii < num; ++ii) {
+            if (!used_[ii]) {
+                addPoint(ii, tol);
+            }
+        }
+        return true;
+    }
+
+    size_t triCount() const {
+        return faces_.size();
+    }
+
+    const PWP_UINT32 *tri(size_t ndx) const {
+        return faces_[ndx].v;
+    }
+
+    // true if each point is a vertex of the hull
+    bool usesAll() const {
+        for (size_t ii = 0; ii < used_.size(); ++ii) {
+            if (!used_[ii]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Face {
+        PWP_UINT32  v[3];
+        double      norm[3];
+    };
+
+    const double *pt(PWP_UINT32 ndx) const {
+        return &pts_[3 * (size_t)ndx];
+    }
+
+    double dist(const Face &face, PWP_UINT32 ndx) const {
+        const double *p = pt(ndx);
+        const double *a = pt(face.v[0]);
+        const double d[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+        return dot(face.norm, d);
+    }
+
+    void setFace(Face &face, PWP_UINT32 a, PWP_UINT32 b,
+            PWP_UINT32 c) const {
+        face.v[0] = a;
+        face.v[1] = b;
+        face.v[2] = c;
+        const double ab[3] = { pt(b)[0] - pt(a)[0], pt(b)[1] - pt(a)[1],
+            pt(b)[2] - pt(a)[2] };
+        const double ac[3] = { pt(c)[0] - pt(a)[0], pt(c)[1] - pt(a)[1],
+            pt(c)[2] - pt(a)[2] };
+        cross(ab, ac, face.norm);
+        normalize(face.norm);
+    }
+
+    // adds a face of the first tetrahedron, facing away from its center
+    void addFace(PWP_UINT32 a, PWP_UINT32 b, PWP_UINT32 c,
+            const double *center) {
+        Face face;
+        setFace(face, a, b, c);
+        const double d[3] = { center[0] - pt(a)[0], center[1] - pt(a)[1],
+            center[2] - pt(a)[2] };
+        if (dot(face.norm, d) > 0.0) {
+            setFace(face, a, c, b);
+        }
+        faces_.push_back(face);
+    }
+
+    bool findTet(PWP_UINT32 num, double tol, PWP_UINT32 *tet) const {
+        // the first point, the farthest from it, the farthest from their
+        // line and the farthest from their plane
+        if (num < 4) {
+            return false;
+        }
+        tet[0] = 0;
+        double best = 0.0;
+        PWP_UINT32 ii;
+        for (ii = 1; ii < num; ++ii) {
+            const double d[3] = { pt(ii)[0] - pt(0)[0], pt(ii)[1] - pt(0)[1],
+                pt(ii)[2] - pt(0)[2] };
+            if (dot(d, d) > best) {
+                best = dot(d, d);
+                tet[1] = ii;
+            }
+        }
+        if (best <= tol * tol) {
+            return false;
+        }
+        const double *a = pt(tet[0]);
+        double axis[3] = { pt(tet[1])[0] - a[0], pt(tet[1])[1] - a[1],
+            pt(tet[1])[2] - a[2] };
+        normalize(axis);
+        best = 0.0;
+        for (ii = 1; ii < num; ++ii) {
+            const double d[3] = { pt(ii)[0] - a[0], pt(ii)[1] - a[1],
+                pt(ii)[2] - a[2] };
+            double c[3];
+            cross(axis, d, c);
+            if (dot(c, c) > best) {
+                best = dot(c, c);
+                tet[2] = ii;
+            }
+        }
+        if (best <= tol * tol) {
+            return false;
+        }
+        Face base;
+        setFace(base, tet[0], tet[1], tet[2]);
+        best = 0.0;
+        for (ii = 1; ii < num; ++ii) {
+            const double d = fabs(dist(base, ii));
+            if (d > best) {
+                best = d;
+                tet[3] = ii;
+            }
+        }
+        return best > tol;
+    }
+
+    void addPoint(PWP_UINT32 ndx, double tol) {
+        // replace the faces that see the point by a cone from the point to
+        // their boundary
+        visible_.clear();
+        size_t ii;
+        for (ii = 0; ii < faces_.size(); ++ii) {
+            if (dist(faces_[ii], ndx) > tol) {
+                visible_.push_back(ii);
+            }
+        }
+        if (visible_.empty()) {
+            return;
+        }
+        horizon_.clear();
+        for (ii = 0; ii < visible_.size(); ++ii) {
+            const Face &face = faces_[visible_[ii]];
+            for (int jj = 0; jj < 3; ++jj) {
+                const PWP_UINT32 a = face.v[jj];
+                const PWP_UINT32 b = face.v[(jj + 1) % 3];
+                if (!hasEdge(b, a)) {
+                    horizon_.push_back(a);
+                    horizon_.push_back(b);
+                }
+            }
+        }
+        // the visible faces are in increasing order
+        for (ii = visible_.size(); ii > 0; --ii) {
+            faces_[visible_[ii - 1]] = faces_.back();
+            faces_.pop_back();
+        }
+        for (ii = 0; ii < horizon_.size(); ii += 2) {
+            Face face;
+            setFace(face, horizon_[ii], horizon_[ii + 1], ndx);
+            faces_.push_back(face);
+        }
+        used_[ndx] = true;
+    }
+
+    // true if a visible face has the edge from a to b
+    bool hasEdge(PWP_UINT32 a, PWP_UINT32 b) const {
+        for (size_t ii = 0; ii < visible_.size(); ++ii) {
+            const PWP_UINT32 *v = faces_[visible_[ii]].v;
+            if (((a == v[0]) && (b == v[1])) || ((a == v[1]) && (b == v[2])) ||
+                    ((a == v[2]) && (b == v[0]))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::vector<double>     pts_;
+    std::vector<Face>       faces_;
+    std::vector<size_t>     visible_;
+    std::vector<PWP_UINT32> horizon_;   // two vertices per edge
+    std::vector<bool>       used_;
+};
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+HubMesher::HubMesher(const EdgeGraph &graph, double radius,
+        PWP_UINT numPoints) :
+    graph_(graph),
+    radius_(radius),
+    numPoints_(numPoints),
+    cos_(numPoints),
+    sin_(numPoints),
+    first_(),
+    vertEdges_(),
+    depth_(),
+    radii_(),
+    numBadHubs_(0),
+    numShort_(0),
+    numNarrow_(0)
+{
+    const double PI = 3.141592653589793;
+    for (PWP_UINT ii = 0; ii < numPoints_; ++ii) {
+        const double angle = (2 * PI * ii) / numPoints_;
+        cos_[ii] = cos(angle);
+        sin_[ii] = sin(angle);
+    }
+}
+
+
+HubMesher::~HubMesher()
+{
+}
+
+
+PWP_UINT32
+HubMesher::build()
+{
+    // the edges at each vertex, less those of no length, which have no
+    // direction for a strut
+    const PWP_UINT32 numVerts = graph_.vertexCount();
+    const PWP_UINT32 numEdges = graph_.edgeCount();
+    first_.assign(numVerts + 1, 0);
+    numShort_ = 0;
+    PWP_UINT32 ee;
+    for (ee = 0; ee < numEdges; ++ee) {
+        if (0.0 == length(ee)) {
+            ++numShort_;
+            continue;
+        }
+        ++first_[graph_.edgeVert(ee, 0) + 1];
+        ++first_[graph_.edgeVert(ee, 1) + 1];
+    }
+    PWP_UINT32 vert;
+    for (vert = 0; vert < numVerts; ++vert) {
+        first_[vert + 1] += first_[vert];
+    }
+    vertEdges_.resize(first_[numVerts]);
+    std::vector<PWP_UINT32> fill(first_.begin(), first_.end() - 1);
+    for (ee = 0; ee < numEdges; ++ee) {
+        if (0.0 == length(ee)) {
+            continue;
+        }
+        vertEdges_[fill[graph_.edgeVert(ee, 0)]++] = ee;
+        vertEdges_[fill[graph_.edgeVert(ee, 1)]++] = ee;
+    }
+    // An end polygon at depth h along d is a face of the hull if the
+    // polygons of the other edges stay behind its plane. The polygon of an
+    // edge at angle a to d reaches h cos(a) + r sin(a), which is less than
+    // h if h > r cot(a / 2). The depths are in radii until the radii are
+    // known.
+    depth_.assign(numVerts, 0.0);
+    std::vector<double> dirs;
+    for (vert = 0; vert < numVerts; ++vert) {
+        const PWP_UINT32 numVertEdges = first_[vert + 1] - first_[vert];
+        if (numVertEdges < 2) {
+            continue;
+        }
+        dirs.resize(3 * (size_t)numVertEdges);
+        for (PWP_UINT32 ii = 0; ii < numVertEdges; ++ii) {
+            const PWP_UINT32 edge = vertEdges_[first_[vert] + ii];
+            double *dir = &dirs[3 * ii];
+            direction(edge, dir);
+            if (graph_.edgeVert(edge, 0) != vert) {
+                dir[0] = -dir[0];
+                dir[1] = -dir[1];
+                dir[2] = -dir[2];
+            }
+        }
+        double maxCos = -1.0;
+        for (PWP_UINT32 ii = 0; ii < numVertEdges; ++ii) {
+            for (PWP_UINT32 jj = ii + 1; jj < numVertEdges; ++jj) {
+                const double c = dot(&dirs[3 * ii], &dirs[3 * jj]);
+                maxCos = (c > maxCos) ? c : maxCos;
+            }
+        }
+        double depth = (maxCos < 1.0) ?
+            HubMargin * sqrt((1.0 + maxCos) / (1.0 - maxCos)) : MaxDepth;
+        depth_[vert] = (depth < MinDepth) ? MinDepth :
+            ((depth > MaxDepth) ? MaxDepth : depth);
+    }
+    // Both ends of an edge whose hubs would take more than MaxReach of it
+    // get the radius at which they take MaxReach. The depth at a vertex is
+    // proportional to its radius, so the least radius over its edges keeps
+    // every strut there and its hub convex.
+    radii_.assign(numVerts, radius_);
+    for (ee = 0; ee < numEdges; ++ee) {
+        const PWP_UINT32 v0 = graph_.edgeVert(ee, 0);
+        const PWP_UINT32 v1 = graph_.edgeVert(ee, 1);
+        const double len = length(ee);
+        const double reach = (depth_[v0] + depth_[v1]) * radius_;
+        if ((0.0 != len) && (reach > MaxReach * len)) {
+            const double radius = radius_ * MaxReach * len / reach;
+            radii_[v0] = (radius < radii_[v0]) ? radius : radii_[v0];
+            radii_[v1] = (radius < radii_[v1]) ? radius : radii_[v1];
+        }
+    }
+    numNarrow_ = 0;
+    for (vert = 0; vert < numVerts; ++vert) {
+        depth_[vert] *= radii_[vert];
+        if (radii_[vert] < radius_) {
+            ++numNarrow_;
+        }
+    }
+    numBadHubs_ = 0;
+    return chunkCount();
+}
+
+
+void
+HubMesher::mesh(WorkerPool &pool, PWP_UINT32 first, PWP_UINT32 count,
+    std::vector< std::vector<double> > &tris)
+{
+    tris.resize(count);
+    MeshJob job;
+    job.mesher = this;
+    job.first = first;
+    job.tris = &tris;
+    job.numBad.assign(count, 0);
+    pool.run(meshTask, &job, count);
+    for (PWP_UINT32 ii = 0; ii < count; ++ii) {
+        numBadHubs_ += job.numBad[ii];
+    }
+}
+
+
+void
+HubMesher::meshTask(void *ctx, PWP_UINT32 task)
+{
+    MeshJob *job = (MeshJob *)ctx;
+    const HubMesher &mesher = *job->mesher;
+    std::vector<double> &tris = (*job->tris)[task];
+    tris.clear();
+    const PWP_UINT32 numVerts = mesher.graph_.vertexCount();
+    const PWP_UINT32 begin = (job->first + task) * ChunkVerts;
+    const PWP_UINT32 end = (numVerts - begin < ChunkVerts) ? numVerts :
+        (begin + ChunkVerts);
+    std::vector<double> pts;
+    for (PWP_UINT32 vert = begin; vert < end; ++vert) {
+        if (mesher.first_[vert] == mesher.first_[vert + 1]) {
+            // only on edges of no length
+            continue;
+        }
+        if (!mesher.meshHub(vert, pts, tris)) {
+            ++job->numBad[task];
+        }
+        // each strut is meshed with the hub at its first vertex
+        for (PWP_UINT32 ii = mesher.first_[vert]; ii < mesher.first_[vert + 1];
+                ++ii) {
+            const PWP_UINT32 edge = mesher.vertEdges_[ii];
+            if (mesher.graph_.edgeVert(edge, 0) == vert) {
+                mesher.meshStrut(edge, tris);
+            }
+        }
+    }
+}
+
+
+bool
+HubMesher::meshHub(PWP_UINT32 vert, std::vector<double> &pts,
+    std::vector<double> &tris) const
+{
+    // The hull of the end polygons less the polygons themselves. Each
+    // polygon is a face of the hull, which splits it into numPoints_ - 2
+    // triangles of its own vertices.
+    const PWP_UINT32 first = first_[vert];
+    const PWP_UINT32 numVertEdges = first_[vert + 1] - first;
+    pts.resize(3 * (size_t)numVertEdges * numPoints_);
+    for (PWP_UINT32 ii = 0; ii < numVertEdges; ++ii) {
+        const PWP_UINT32 edge = vertEdges_[first + ii];
+        const int end = (graph_.edgeVert(edge, 0) == vert) ? 0 : 1;
+        for (PWP_UINT jj = 0; jj < numPoints_; ++jj) {
+            endPoint(edge, end, jj, &pts[3 * ((size_t)ii * numPoints_ + jj)]);
+        }
+    }
+    const double *xyz = graph_.xyz(vert);
+    if (1 == numVertEdges) {
+        // the cap's point, a radius beyond the vertex
+        const PWP_UINT32 edge = vertEdges_[first];
+        const double sign = (graph_.edgeVert(edge, 0) == vert) ? -1.0 : 1.0;
+        double dir[3];
+        direction(edge, dir);
+        for (int kk = 0; kk < 3; ++kk) {
+            pts.push_back(xyz[kk] + sign * radii_[vert] * dir[kk]);
+        }
+    }
+    HubHull hull;
+    if (!hull.build(pts, xyz, HullTol * (depth_[vert] + radii_[vert]))) {
+        return false;
+    }
+    const PWP_UINT32 numEnds = numVertEdges * numPoints_;
+    std::vector<PWP_UINT32> numEndTris(numVertEdges, 0);
+    for (size_t ii = 0; ii < hull.triCount(); ++ii) {
+        const PWP_UINT32 *v = hull.tri(ii);
+        const PWP_UINT32 poly = v[0] / numPoints_;
+        if ((v[0] < numEnds) && (v[1] / numPoints_ == poly) &&
+                (v[2] / numPoints_ == poly)) {
+            ++numEndTris[poly];
+        }
+        else {
+            addTri(&pts[3 * v[0]], &pts[3 * v[1]], &pts[3 * v[2]], tris);
+        }
+    }
+    bool ret = hull.usesAll();
+    for (PWP_UINT32 ii = 0; ii < numVertEdges; ++ii) {
+        ret = ret && (numPoints_ - 2 == numEndTris[ii]);
+    }
+    return ret;
+}
+
+
+void
+HubMesher::meshStrut(PWP_UINT32 edge, std::vector<double> &tris) const
+{
+    // a quad per side, from the polygon at the first vertex to the one at
+    // the second, wound outwards. The polygons are parallel, so each quad
+    // is flat even if their radii differ.
+    double p0[3];
+    double p1[3];
+    double q0[3];
+    double q1[3];
+    endPoint(edge, 0, 0, p0);
+    endPoint(edge, 1, 0, q0);
+    for (PWP_UINT ii = 0; ii < numPoints_; ++ii) {
+        const PWP_UINT next = (ii + 1) % numPoints_;
+        endPoint(edge, 0, next, p1);
+        endPoint(edge, 1, next, q1);
+        addTri(p0, p1, q1, tris);
+        addTri(p0, q1, q0, tris);
+        for (int kk = 0; kk < 3; ++kk) {
+            p0[kk] = p1[kk];
+            q0[kk] = q1[kk];
+        }
+    }
+}
+
+
+double
+HubMesher::length(PWP_UINT32 edge) const
+{
+    const double *a = graph_.xyz(graph_.edgeVert(edge, 0));
+    const double *b = graph_.xyz(graph_.edgeVert(edge, 1));
+    const double d[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    return sqrt(dot(d, d));
+}
+
+
+void
+HubMesher::direction(PWP_UINT32 edge, double dir[3]) const
+{
+    const double *a = graph_.xyz(graph_.edgeVert(edge, 0));
+    const double *b = graph_.xyz(graph_.edgeVert(edge, 1));
+    dir[0] = b[0] - a[0];
+    dir[1] = b[1] - a[1];
+    dir[2] = b[2] - a[2];
+    if (0.0 == dot(dir, dir)) {
+        dir[2] = 1.0;
+    }
+    normalize(dir);
+}
+
+
+void
+HubMesher::endPoint(PWP_UINT32 edge, int end, PWP_UINT ndx, double p[3]) const
+{
+    // Corner ndx of the polygon at an end of the edge. The frame depends
+    // only on the edge, so both ends and the hubs get the same corners.
+    double dir[3];
+    direction(edge, dir);
+    // the axis least aligned with the edge
+    double axis[3] = { 0.0, 0.0, 0.0 };
+    const double ax = fabs(dir[0]);
+    const double ay = fabs(dir[1]);
+    const double az = fabs(dir[2]);
+    axis[((ax <= ay) && (ax <= az)) ? 0 : ((ay <= az) ? 1 : 2)] = 1.0;
+    double u[3];
+    double v[3];
+    cross(dir, axis, u);
+    normalize(u);
+    cross(dir, u, v);
+    const PWP_UINT32 vert = graph_.edgeVert(edge, end);
+    const double *xyz = graph_.xyz(vert);
+    const double depth = (0 == end) ? depth_[vert] : -depth_[vert];
+    const double radius = radii_[vert];
+    for (int kk = 0; kk < 3; ++kk) {
+        p[kk] = xyz[kk] + depth * dir[kk] +
+            radius * (cos_[ndx] * u[kk] + sin_[ndx] * v[kk]);
+    }
+}
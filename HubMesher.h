@@ -0,0 +1,110 @@
+/****************************************************************************
+ *
+ * class HubMesher
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _HUBMESHER_H_
+#define _HUBMESHER_H_
+
+#include "apiPWP.h"
+
+#include "EdgeGraph.h"
+#include "WorkerPool.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// Meshes the edges of a graph as one closed surface of hubs and struts //
+// without sampling a field.                                            //
+//                                                                      //
+// Each strut is a prism of numPoints sides around its edge. Its end    //
+// polygons are set back from the vertices by the depth of the hub at   //
+// each end, which is just enough for every end polygon to be a face of //
+// the convex hull of all the end polygons at the vertex. The hull less //
+// those faces is the hub. The struts and hubs compute the end polygons //
+// with the same code and share their vertices bit for bit, so the      //
+// surface is closed and every edge joins two triangles. A vertex with  //
+// a single edge gets a pointed cap.                                    //
+//                                                                      //
+// A hub is deeper where its edges meet at sharper angles. Where the    //
+// hubs at the ends of an edge would reach too far along it, the radius //
+// of the strut ends at those vertices is reduced until the strut keeps //
+// a positive length, so a strut may taper from one end to the other.   //
+// An edge of no length has no direction and is skipped. If a hub is    //
+// not convex around its struts, it leaves a gap. The struts of edges   //
+// that do not share a vertex may still overlap.                        //
+//////////////////////////////////////////////////////////////////////////
+class HubMesher {
+public:
+    enum { ChunkVerts = 256 };
+
+    HubMesher(const EdgeGraph &graph, double radius, PWP_UINT numPoints);
+    ~HubMesher();
+
+    // sets the hub depths and strut radii and returns the number of chunks
+    // of ChunkVerts vertices
+    PWP_UINT32  build();
+
+    PWP_UINT32  chunkCount() const {
+                    return (graph_.vertexCount() + ChunkVerts - 1) /
+                        ChunkVerts; }
+
+    // Meshes chunks [first, first + count) on the pool. On return, tris[ii]
+    // holds the triangles of the hubs of chunk first + ii and of the struts
+    // that start there, as 9 coordinates each, wound counter-clockwise
+    // seen from outside.
+    void    mesh(WorkerPool &pool, PWP_UINT32 first, PWP_UINT32 count,
+                std::vector< std::vector<double> > &tris);
+
+    // the hubs meshed so far that are not convex around their struts
+    PWP_UINT32  badHubCount() const {
+                    return numBadHubs_; }
+
+    // the edges of no length, which are not meshed
+    PWP_UINT32  shortStrutCount() const {
+                    return numShort_; }
+
+    // the vertices whose strut ends are narrower than the radius
+    PWP_UINT32  narrowHubCount() const {
+                    return numNarrow_; }
+
+private:
+    struct MeshJob {
+        HubMesher *                             mesher;
+        PWP_UINT32                              first;
+        std::vector< std::vector<double> > *    tris;
+        std::vector<PWP_UINT32>                 numBad;     // per task
+    };
+
+    static void meshTask(void *ctx, PWP_UINT32 task);
+
+    bool    meshHub(PWP_UINT32 vert, std::vector<double> &pts,
+                std::vector<double> &tris) const;
+    void    meshStrut(PWP_UINT32 edge, std::vector<double> &tris) const;
+    double  length(PWP_UINT32 edge) const;
+    void    direction(PWP_UINT32 edge, double dir[3]) const;
+    void    endPoint(PWP_UINT32 edge, int end, PWP_UINT ndx,
+                double p[3]) const;
+
+private:
+    const EdgeGraph &       graph_;
+    double                  radius_;
+    PWP_UINT                numPoints_;
+    std::vector<double>     cos_;       // of the polygon angles
+    std::vector<double>     sin_;
+    std::vector<PWP_UINT32> first_;     // the first of each vertex's edges
+    std::vector<PWP_UINT32> vertEdges_;
+    std::vector<double>     depth_;     // of each vertex's hub
+    std::vector<double>     radii_;     // of each vertex's strut ends
+    PWP_UINT32              numBadHubs_;
+    PWP_UINT32              numShort_;
+    PWP_UINT32              numNarrow_;
+};
+
+#endif // _HUBMESHER_H_
@@ -0,0 +1,479 @@
+/****************************************************************************
+ *
+ * class LayerSlicer
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <math.h>
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "LayerSlicer.h"
+
+static const double Pi = 3.14159265358979323846;
+
+// outline pieces whose ends are this many clipping tolerances apart meet
+static const double MatchScale = 1e4;
+
+typedef std::pair<PWP_INT64, PWP_INT64>                 CellKey;
+typedef std::map<CellKey, std::vector<PWP_UINT32> >     CellMap;
+
+
+static double
+cross2(double ux, double uy, double vx, double vy)
+{
+    return ux * vy - uy * vx;
+}
+
+
+static bool
+pointLess(const std::pair<double, double> &a,
+    const std::pair<double, double> &b)
+{
+    return (a.first < b.first) ||
+        ((a.first == b.first) && (a.second < b.second));
+}
+
+
+// replaces pts (x,y pairs) by their convex hull, counter-clockwise and
+// without collinear points
+static void
+convexHull(std::vector<double> &pts)
+{
+    typedef std::pair<double, double> Pt;
+    std::vector<Pt> p;
+    for (size_t ii = 0; ii + 1 < pts.size(); ii += 2) {
+        p.push_back(Pt(pts[ii], pts[ii + 1]));
+    }
+    pts.clear();
+    if (p.size() < 3) {
+        return;
+    }
+    std::sort(p.begin(), p.end(), pointLess);
+    std::vector<Pt> h(2 * p.size());
+    size_t k = 0;
+    size_t ii;
+    for (ii = 0; ii < p.size(); ++ii) {
+        while ((k >= 2) && (cross2(h[k - 1].first - h[k - 2].first,
+                h[k - 1].second - h[k - 2].second,
+                p[ii].first - h[k - 2].first,
+                p[ii].second - h[k - 2].second) <= 0)) {
+            --k;
+        }
+        h[k++] = p[ii];
+    }
+    const size_t lower = k + 1;
+    for (ii = p.size() - 1; ii > 0; --ii) {
+        const Pt &q = p[ii - 1];
+        while ((k >= lower) && (cross2(h[k - 1].first - h[k - 2].first,
+                h[k - 1].second - h[k - 2].second,
+                q.first - h[k - 2].first, q.second - h[k - 2].second) <= 0)) {
+            --k;
+        }
+        h[k++] = q;
+    }
+    // the last point repeats the first
+    if (k - 1 < 3) {
+        return;
+    }
+    for (ii = 0; ii + 1 < k; ++ii) {
+        pts.push_back(h[ii].first);
+        pts.push_back(h[ii].second);
+    }
+}
+
+
+static void
+polyBounds(const std::vector<double> &poly, double box[4])
+{
+    box[0] = box[2] = poly[0];
+    box[1] = box[3] = poly[1];
+    for (size_t ii = 2; ii + 1 < poly.size(); ii += 2) {
+        box[0] = std::min(box[0], poly[ii]);
+        box[1] = std::min(box[1], poly[ii + 1]);
+        box[2] = std::max(box[2], poly[ii]);
+        box[3] = std::max(box[3], poly[ii + 1]);
+    }
+}
+
+
+static CellKey
+cellOf(double x, double y, double size)
+{
+    return CellKey((PWP_INT64)floor(x / size), (PWP_INT64)floor(y / size));
+}
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+LayerSlicer::LayerSlicer(const EdgeGraph &graph, double radius,
+        double thickness) :
+    graph_(graph),
+    radius_(radius),
+    thickness_(thickness),
+    zMin_(0),
+    tol_(0),
+    numLayers_(0),
+    maxSpan_(0),
+    spans_(),
+    mutex_(),
+    numOpen_(0)
+{
+}
+
+
+LayerSlicer::~LayerSlicer()
+{
+}
+
+
+PWP_UINT32
+LayerSlicer::build()
+{
+    spans_.clear();
+    numLayers_ = 0;
+    numOpen_ = 0;
+    double minXyz[3];
+    double maxXyz[3];
+    if (!graph_.bounds(minXyz, maxXyz) || (thickness_ <= 0)) {
+        return 0;
+    }
+    double extent = 0;
+    for (int kk = 0; kk < 3; ++kk) {
+        extent = std::max(extent, fabs(minXyz[kk]));
+        extent = std::max(extent, fabs(maxXyz[kk]));
+    }
+    // far below the spacing of the arc points, far above round off
+    tol_ = 1e-10 * (extent + radius_);
+    zMin_ = minXyz[2] - radius_;
+    numLayers_ = (PWP_UINT32)ceil((maxXyz[2] + radius_ - zMin_) / thickness_ -
+        1e-9);
+
+    const PWP_UINT32 numEdges = graph_.edgeCount();
+    spans_.resize(numEdges);
+    maxSpan_ = 0;
+    for (PWP_UINT32 ee = 0; ee < numEdges; ++ee) {
+        const double z0 = graph_.xyz(graph_.edgeVert(ee, 0))[2];
+        const double z1 = graph_.xyz(graph_.edgeVert(ee, 1))[2];
+        ZSpan &span = spans_[ee];
+        span.lo = std::min(z0, z1) - radius_;
+        span.hi = std::max(z0, z1) + radius_;
+        span.edge = ee;
+        maxSpan_ = std::max(maxSpan_, span.hi - span.lo);
+    }
+    std::sort(spans_.begin(), spans_.end());
+    return numLayers_;
+}
+
+
+void
+LayerSlicer::slice(WorkerPool &pool, PWP_UINT32 first, PWP_UINT32 count,
+    std::vector<Loops> &loops)
+{
+    loops.resize(count);
+    SliceJob job;
+    job.slicer = this;
+    job.first = first;
+    job.loops = &loops;
+    pool.run(sliceTask, &job, count);
+}
+
+
+void
+LayerSlicer::sliceTask(void *ctx, PWP_UINT32 task)
+{
+    SliceJob *job = (SliceJob *)ctx;
+    LayerSlicer *slicer = job->slicer;
+    Loops &loops = (*job->loops)[task];
+    loops.clear();
+    slicer->sliceLayer(slicer->layerTop(job->first + task) -
+        slicer->thickness_ / 2, loops);
+}
+
+
+void
+LayerSlicer::sliceLayer(double z, Loops &loops)
+{
+    // the edges whose Z extent contains z start in [z - maxSpan_, z]
+    ZSpan key;
+    key.lo = z - maxSpan_;
+    std::vector<ZSpan>::const_iterator it =
+        std::lower_bound(spans_.begin(), spans_.end(), key);
+    std::vector<Polygon> polys;
+    Polygon poly;
+    for (; (it != spans_.end()) && (it->lo <= z); ++it) {
+        if (it->hi >= z) {
+            section(it->edge, z, poly);
+            if (!poly.empty()) {
+                polys.push_back(poly);
+            }
+        }
+    }
+
+    // bin the sections so that each only meets the ones nearby
+    const double cellSize = 4 * radius_;
+    std::vector<double> boxes(4 * polys.size());
+    CellMap cells;
+    PWP_UINT32 ii;
+    for (ii = 0; ii < (PWP_UINT32)polys.size(); ++ii) {
+        double *box = &boxes[4 * ii];
+        polyBounds(polys[ii], box);
+        const CellKey lo = cellOf(box[0], box[1], cellSize);
+        const CellKey hi = cellOf(box[2], box[3], cellSize);
+        for (PWP_INT64 cx = lo.first; cx <= hi.first; ++cx) {
+            for (PWP_INT64 cy = lo.second; cy <= hi.second; ++cy) {
+                cells[CellKey(cx, cy)].push_back(ii);
+            }
+        }
+    }
+
+    std::vector<double> segs;
+    std::vector<PWP_UINT32> others;
+    for (ii = 0; ii < (PWP_UINT32)polys.size(); ++ii) {
+        const double *box = &boxes[4 * ii];
+        const CellKey lo = cellOf(box[0], box[1], cellSize);
+        const CellKey hi = cellOf(box[2], box[3], cellSize);
+        others.clear();
+        for (PWP_INT64 cx = lo.first; cx <= hi.first; ++cx) {
+            for (PWP_INT64 cy = lo.second; cy <= hi.second; ++cy) {
+                const std::vector<PWP_UINT32> &cell = cells[CellKey(cx, cy)];
+                for (size_t jj = 0; jj < cell.size(); ++jj) {
+                    const double *other = &boxes[4 * cell[jj]];
+                    if ((cell[jj] != ii) && (other[0] <= box[2]) &&
+                            (other[2] >= box[0]) && (other[1] <= box[3]) &&
+                            (other[3] >= box[1])) {
+                        others.push_back(cell[jj]);
+                    }
+                }
+            }
+        }
+        std::sort(others.begin(), others.end());
+        others.erase(std::unique(others.begin(), others.end()), others.end());
+        clipOutside(polys, ii, others, segs);
+    }
+
+    const PWP_UINT32 numOpen = chain(segs, loops);
+    if (numOpen > 0) {
+        MutexLock lock(mutex_);
+        numOpen_ += numOpen;
+    }
+}
+
+
+void
+LayerSlicer::section(PWP_UINT32 edge, double z, Polygon &poly) const
+{
+    // The section is the convex hull of the section curves of the end
+    // spheres and of the cylinder between them.
+    const double *a = graph_.xyz(graph_.edgeVert(edge, 0));
+    const double *b = graph_.xyz(graph_.edgeVert(edge, 1));
+    const double r2 = radius_ * radius_;
+    const double step = 2 * Pi / ArcPoints;
+    poly.clear();
+    int k;
+    for (int end = 0; end < 2; ++end) {
+        const double *c = (0 == end) ? a : b;
+        const double dz = z - c[2];
+        if (dz * dz < r2) {
+            const double rho = sqrt(r2 - dz * dz);
+            for (k = 0; k < ArcPoints; ++k) {
+                poly.push_back(c[0] + rho * cos(k * step));
+                poly.push_back(c[1] + rho * sin(k * step));
+            }
+        }
+    }
+    double w[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const double len = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    if ((len > 0) && (fabs(w[2]) > 1e-12 * len)) {
+        // An edge parallel to the plane needs nothing more. Its cylinder
+        // section is the rectangle spanned by the two circles.
+        w[0] /= len;
+        w[1] /= len;
+        w[2] /= len;
+        // e1 is horizontal, e2 = w x e1
+        double e1[3] = { w[1], -w[0], 0 };
+        const double e1Len = sqrt(e1[0] * e1[0] + e1[1] * e1[1]);
+        if (e1Len > 1e-12) {
+            e1[0] /= e1Len;
+            e1[1] /= e1Len;
+        }
+        else {
+            e1[0] = 1;
+            e1[1] = 0;
+        }
+        const double e2[3] = {
+            w[1] * e1[2] - w[2] * e1[1],
+            w[2] * e1[0] - w[0] * e1[2],
+            w[0] * e1[1] - w[1] * e1[0]
+        };
+        for (k = 0; k < ArcPoints; ++k) {
+            const double cs = radius_ * cos(k * step);
+            const double sn = radius_ * sin(k * step);
+            // the axis position of the rim point at height z
+            const double t = (z - a[2] - sn * e2[2]) / w[2];
+            if ((t >= 0) && (t <= len)) {
+                poly.push_back(a[0] + t * w[0] + cs * e1[0] + sn * e2[0]);
+                poly.push_back(a[1] + t * w[1] + cs * e1[1] + sn * e2[1]);
+            }
+        }
+    }
+    convexHull(poly);
+}
+
+
+void
+LayerSlicer::clipOutside(const std::vector<Polygon> &polys, PWP_UINT32 poly,
+    const std::vector<PWP_UINT32> &others, std::vector<double> &segs) const
+{
+    // Appends the parts of the boundary of polys[poly] that are outside of
+    // all others. A part on the boundary of another section is kept only
+    // by the section with the lower index.
+    const Polygon &p = polys[poly];
+    const size_t n = p.size() / 2;
+    std::vector<std::pair<double, double> > cuts;
+    for (size_t ii = 0; ii < n; ++ii) {
+        const double x0 = p[2 * ii];
+        const double y0 = p[2 * ii + 1];
+        const double x1 = p[(2 * ii + 2) % p.size()];
+        const double y1 = p[(2 * ii + 3) % p.size()];
+        cuts.clear();
+        for (size_t jj = 0; jj < others.size(); ++jj) {
+            const Polygon &q = polys[others[jj]];
+            const size_t m = q.size() / 2;
+            const double bias = (others[jj] < poly) ? -tol_ : tol_;
+            double t0 = 0;
+            double t1 = 1;
+            for (size_t kk = 0; (kk < m) && (t0 < t1); ++kk) {
+                const double vx = q[2 * kk];
+                const double vy = q[2 * kk + 1];
+                const double ex = q[(2 * kk + 2) % q.size()] - vx;
+                const double ey = q[(2 * kk + 3) % q.size()] - vy;
+                const double eLen = sqrt(ex * ex + ey * ey);
+                if (0 == eLen) {
+                    continue;
+                }
+                // signed distance to the left of the edge at t = 0 and
+                // its change along the segment
+                const double f0 = cross2(ex, ey, x0 - vx, y0 - vy) / eLen;
+                const double df = cross2(ex, ey, x1 - x0, y1 - y0) / eLen;
+                if (0 == df) {
+                    if (f0 < bias) {
+                        t1 = t0;
+                    }
+                }
+                else if (df > 0) {
+                    t0 = std::max(t0, (bias - f0) / df);
+                }
+                else {
+                    t1 = std::min(t1, (bias - f0) / df);
+                }
+            }
+            if (t0 < t1) {
+                cuts.push_back(std::make_pair(t0, t1));
+            }
+        }
+        std::sort(cuts.begin(), cuts.end());
+        // a piece shorter than the chain tolerance is a sliver between two
+        // crossings, chain() bridges the gap
+        const double minLen = MatchScale * tol_;
+        const double segLen = sqrt((x1 - x0) * (x1 - x0) +
+            (y1 - y0) * (y1 - y0));
+        double t = 0;
+        for (size_t jj = 0; jj <= cuts.size(); ++jj) {
+            const double tEnd = (jj < cuts.size()) ? cuts[jj].first : 1;
+            if ((tEnd - t) * segLen > minLen) {
+                segs.push_back(x0 + t * (x1 - x0));
+                segs.push_back(y0 + t * (y1 - y0));
+                segs.push_back(x0 + tEnd * (x1 - x0));
+                segs.push_back(y0 + tEnd * (y1 - y0));
+            }
+            if (jj < cuts.size()) {
+                t = std::max(t, cuts[jj].second);
+            }
+        }
+    }
+}
+
+
+PWP_UINT32
+LayerSlicer::chain(const std::vector<double> &segs, Loops &loops) const
+{
+    // The pieces of the outline meet where one section crosses another.
+    // The two ends are computed from different edges, so they are matched
+    // within a tolerance that allows for the clipping bias.
+    const double matchTol = MatchScale * tol_;
+    const PWP_UINT32 numSegs = (PWP_UINT32)(segs.size() / 4);
+    CellMap starts;
+    PWP_UINT32 ii;
+    for (ii = 0; ii < numSegs; ++ii) {
+        starts[cellOf(segs[4 * ii], segs[4 * ii + 1], matchTol)].push_back(ii);
+    }
+    std::vector<bool> used(numSegs, false);
+    PWP_UINT32 numOpen = 0;
+    Loop loop;
+    for (ii = 0; ii < numSegs; ++ii) {
+        if (used[ii]) {
+            continue;
+        }
+        used[ii] = true;
+        loop.clear();
+        loop.push_back(segs[4 * ii]);
+        loop.push_back(segs[4 * ii + 1]);
+        PWP_UINT32 cur = ii;
+        bool closed = false;
+        for (;;) {
+            const double ex = segs[4 * cur + 2];
+            const double ey = segs[4 * cur + 3];
+            if ((loop.size() >= 4) && (fabs(ex - loop[0]) <= matchTol) &&
+                    (fabs(ey - loop[1]) <= matchTol)) {
+                closed = true;
+                break;
+            }
+            // the nearest unused piece starting at the end of cur
+            const CellKey key = cellOf(ex, ey, matchTol);
+            PWP_UINT32 next = numSegs;
+            double best = matchTol * matchTol;
+            for (PWP_INT64 cx = key.first - 1; cx <= key.first + 1; ++cx) {
+                for (PWP_INT64 cy = key.second - 1; cy <= key.second + 1;
+                        ++cy) {
+                    CellMap::const_iterator cell =
+                        starts.find(CellKey(cx, cy));
+                    if (starts.end() == cell) {
+                        continue;
+                    }
+                    for (size_t jj = 0; jj < cell->second.size(); ++jj) {
+                        const PWP_UINT32 s = cell->second[jj];
+                        const double dx = segs[4 * s] - ex;
+                        const double dy = segs[4 * s + 1] - ey;
+                        if (!used[s] && (dx * dx + dy * dy <= best)) {
+                            best = dx * dx + dy * dy;
+                            next = s;
+                        }
+                    }
+                }
+            }
+            if (numSegs == next) {
+                break;
+            }
+            used[next] = true;
+            loop.push_back(segs[4 * next]);
+            loop.push_back(segs[4 * next + 1]);
+            cur = next;
+        }
+        if (!closed) {
+            ++numOpen;
+        }
+        else if (loop.size() >= 6) {
+            loops.push_back(loop);
+        }
+    }
+    return numOpen;
+}
@@ -0,0 +1,105 @@
+/****************************************************************************
+ *
+ * class LayerSlicer
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _LAYERSLICER_H_
+#define _LAYERSLICER_H_
+
+#include "apiPWP.h"
+
+#include "EdgeGraph.h"
+#include "WorkerPool.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// Cuts the edge capsules (the inflated edges with round ends) with a    //
+// stack of Z planes and returns the outline of their union per layer.   //
+//                                                                       //
+// A capsule is convex, so its section is a convex polygon. It is built  //
+// from points on the exact section curves: the ellipse of the cylinder  //
+// between its end planes and the circles of the end spheres. A point of //
+// a section boundary that lies inside another section is not on the     //
+// union outline. The remaining boundary pieces are chained into loops.  //
+// Outer loops are counter-clockwise and holes are clockwise.            //
+//                                                                       //
+// Layer k spans (zMin + k * thickness, zMin + (k + 1) * thickness] and  //
+// is cut at its middle.                                                 //
+//////////////////////////////////////////////////////////////////////////
+class LayerSlicer {
+public:
+    enum { ArcPoints = 32 };
+
+    typedef std::vector<double>     Loop;   // x,y pairs
+    typedef std::vector<Loop>       Loops;
+
+    LayerSlicer(const EdgeGraph &graph, double radius, double thickness);
+    ~LayerSlicer();
+
+    // sorts the edges by their Z extent and returns the number of layers
+    PWP_UINT32  build();
+
+    PWP_UINT32  layerCount() const {
+                    return numLayers_; }
+
+    // the height of the top of layer
+    double      layerTop(PWP_UINT32 layer) const {
+                    return zMin_ + (layer + 1) * thickness_; }
+
+    // Slices layers [first, first + count) on the pool. On return,
+    // loops[ii] holds the outline of layer first + ii.
+    void    slice(WorkerPool &pool, PWP_UINT32 first, PWP_UINT32 count,
+                std::vector<Loops> &loops);
+
+    // the number of boundary pieces that could not be closed into loops
+    PWP_UINT32  openCount() const {
+                    return numOpen_; }
+
+private:
+    struct ZSpan {
+        double      lo;
+        double      hi;
+        PWP_UINT32  edge;
+
+        bool operator<(const ZSpan &rhs) const {
+            return lo < rhs.lo; }
+    };
+
+    struct SliceJob {
+        LayerSlicer *           slicer;
+        PWP_UINT32              first;
+        std::vector<Loops> *    loops;
+    };
+
+    typedef std::vector<double>     Polygon;    // x,y pairs, convex, CCW
+
+    static void sliceTask(void *ctx, PWP_UINT32 task);
+
+    void    sliceLayer(double z, Loops &loops);
+    void    section(PWP_UINT32 edge, double z, Polygon &poly) const;
+    void    clipOutside(const std::vector<Polygon> &polys, PWP_UINT32 poly,
+                const std::vector<PWP_UINT32> &others,
+                std::vector<double> &segs) const;
+    PWP_UINT32  chain(const std::vector<double> &segs, Loops &loops) const;
+
+private:
+    const EdgeGraph &   graph_;
+    double              radius_;
+    double              thickness_;
+    double              zMin_;
+    double              tol_;
+    PWP_UINT32          numLayers_;
+    double              maxSpan_;
+    std::vector<ZSpan>  spans_;
+    Mutex               mutex_;
+    PWP_UINT32          numOpen_;
+};
+
+#endif // _LAYERSLICER_H_
@@ -0,0 +1,126 @@
+/****************************************************************************
+ *
+ * class MappedFile
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#if !defined(_WIN32)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+MappedFile::MappedFile() :
+    data_(0),
+    size_(0)
+#if defined(_WIN32)
+    , file_(INVALID_HANDLE_VALUE),
+    mapping_(0)
+#endif
+{
+}
+
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+
+#if defined(_WIN32)
+
+bool
+MappedFile::open(const std::string &path)
+{
+    close();
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (INVALID_HANDLE_VALUE == file_) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size) || (0 == size.QuadPart)) {
+        close();
+        return false;
+    }
+    mapping_ = CreateFileMappingA(file_, 0, PAGE_READONLY, 0, 0, 0);
+    if (0 != mapping_) {
+        data_ = (const unsigned char *)MapViewOfFile(mapping_, FILE_MAP_READ,
+            0, 0, 0);
+    }
+    if (0 == data_) {
+        close();
+        return false;
+    }
+    size_ = (PWP_UINT64)size.QuadPart;
+    return true;
+}
+
+
+void
+MappedFile::close()
+{
+    if (0 != data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (0 != mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (INVALID_HANDLE_VALUE != file_) {
+        CloseHandle(file_);
+    }
+    data_ = 0;
+    size_ = 0;
+    mapping_ = 0;
+    file_ = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool
+MappedFile::open(const std::string &path)
+{
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void *p = MAP_FAILED;
+    if ((0 == fstat(fd, &st)) && (st.st_size > 0)) {
+        p = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (MAP_FAILED == p) {
+        return false;
+    }
+    data_ = (const unsigned char *)p;
+    size_ = (PWP_UINT64)st.st_size;
+    return true;
+}
+
+
+void
+MappedFile::close()
+{
+    if (0 != data_) {
+        munmap((void *)data_, (size_t)size_);
+    }
+    data_ = 0;
+    size_ = 0;
+}
+
+#endif
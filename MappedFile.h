@@ -0,0 +1,56 @@
+/****************************************************************************
+ *
+ * class MappedFile
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+#include "apiPWP.h"
+
+#if defined(_WIN32)
+#   include <windows.h>
+#endif
+
+#include <string>
+
+
+//////////////////////////////////////////////////////////////////////////
+// A whole file mapped read-only into memory. The pages are loaded by    //
+// the system as they are touched.                                       //
+//////////////////////////////////////////////////////////////////////////
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool    open(const std::string &path);
+    void    close();
+
+    bool                    isOpen() const {
+                                return 0 != data_; }
+    const unsigned char *   data() const {
+                                return data_; }
+    PWP_UINT64              size() const {
+                                return size_; }
+
+private:
+    // not copyable
+    MappedFile(const MappedFile &);
+    MappedFile & operator=(const MappedFile &);
+
+private:
+    const unsigned char *   data_;
+    PWP_UINT64              size_;
+#if defined(_WIN32)
+    HANDLE                  file_;
+    HANDLE                  mapping_;
+#endif
+};
+
+#endif // _MAPPEDFILE_H_
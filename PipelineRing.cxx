@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ * class PipelineRing
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include "PipelineRing.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+PipelineRing::PipelineRing(PWP_UINT32 numSlots) :
+    mutex_(),
+    changed_(),
+    states_((0 == numSlots) ? 1 : numSlots, Free),
+    nextTake_(0),
+    count_(0),
+    closed_(false),
+    aborted_(false)
+{
+}
+
+
+PipelineRing::~PipelineRing()
+{
+}
+
+
+bool
+PipelineRing::acquire(PWP_UINT64 seq)
+{
+    MutexLock lock(mutex_);
+    while (!aborted_ && (Free != states_[slot(seq)])) {
+        changed_.wait(mutex_);
+    }
+    return !aborted_;
+}
+
+
+void
+PipelineRing::publish(PWP_UINT64 seq)
+{
+    setState(seq, Ready);
+}
+
+
+bool
+PipelineRing::take(PWP_UINT64 &seq)
+{
+    // The batches are published in order, so the next one to take is
+    // ready once its slot is.
+    MutexLock lock(mutex_);
+    while (!aborted_ && (Ready != states_[slot(nextTake_)])) {
+        if (closed_ && (nextTake_ >= count_)) {
+            return false;
+        }
+        changed_.wait(mutex_);
+    }
+    if (aborted_) {
+        return false;
+    }
+    seq = nextTake_++;
+    states_[slot(seq)] = Busy;
+    return true;
+}
+
+
+void
+PipelineRing::complete(PWP_UINT64 seq)
+{
+    setState(seq, Done);
+}
+
+
+bool
+PipelineRing::waitDone(PWP_UINT64 seq)
+{
+    MutexLock lock(mutex_);
+    while (!aborted_ && (Done != states_[slot(seq)])) {
+        if (closed_ && (seq >= count_)) {
+            return false;
+        }
+        changed_.wait(mutex_);
+    }
+    return !aborted_;
+}
+
+
+void
+PipelineRing::release(PWP_UINT64 seq)
+{
+    setState(seq, Free);
+}
+
+
+void
+PipelineRing::close(PWP_UINT64 count)
+{
+    MutexLock lock(mutex_);
+    closed_ = true;
+    count_ = count;
+    changed_.notifyAll();
+}
+
+
+void
+PipelineRing::abort()
+{
+    MutexLock lock(mutex_);
+    aborted_ = true;
+    changed_.notifyAll();
+}
+
+
+void
+PipelineRing::setState(PWP_UINT64 seq, State state)
+{
+    MutexLock lock(mutex_);
+    states_[slot(seq)] = state;
+    changed_.notifyAll();
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+ *
+ * class PipelineRing
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _PIPELINERING_H_
+#define _PIPELINERING_H_
+
+#include "apiPWP.h"
+
+#include "WorkerPool.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// The slot states of a fixed ring of batches passed from one producer,  //
+// through any number of workers, to one consumer. Batch seq uses slot   //
+// seq % slotCount(). The caller owns the batches; the ring only says    //
+// who may touch a slot:                                                //
+//                                                                       //
+//   producer:  acquire(seq), fill the batch, publish(seq)              //
+//   workers:   take(seq), process the batch, complete(seq)             //
+//   consumer:  waitDone(seq), use the batch, release(seq)              //
+//                                                                       //
+// The producer blocks while the ring is full, so the memory does not   //
+// grow with the number of batches. The workers finish out of order;    //
+// the consumer sees the batches in order.                              //
+//////////////////////////////////////////////////////////////////////////
+class PipelineRing {
+public:
+    PipelineRing(PWP_UINT32 numSlots);
+    ~PipelineRing();
+
+    PWP_UINT32  slotCount() const {
+                    return (PWP_UINT32)states_.size(); }
+    PWP_UINT32  slot(PWP_UINT64 seq) const {
+                    return (PWP_UINT32)(seq % states_.size()); }
+
+    // Each waits for its slot state and returns false if the ring was
+    // aborted. take() and waitDone() also return false once all batches
+    // before close() are taken or done.
+    bool    acquire(PWP_UINT64 seq);
+    void    publish(PWP_UINT64 seq);
+    bool    take(PWP_UINT64 &seq);
+    void    complete(PWP_UINT64 seq);
+    bool    waitDone(PWP_UINT64 seq);
+    void    release(PWP_UINT64 seq);
+
+    // no batches follow the first count
+    void    close(PWP_UINT64 count);
+
+    // wakes and stops all stages
+    void    abort();
+
+private:
+    enum State {
+        Free,
+        Ready,
+        Busy,
+        Done
+    };
+
+    void    setState(PWP_UINT64 seq, State state);
+
+    // not copyable
+    PipelineRing(const PipelineRing &);
+    PipelineRing & operator=(const PipelineRing &);
+
+private:
+    Mutex                   mutex_;
+    Condition               changed_;
+    std::vector<State>      states_;
+    PWP_UINT64              nextTake_;
+    PWP_UINT64              count_;
+    bool                    closed_;
+    bool                    aborted_;
+};
+
+#endif // _PIPELINERING_H_
@@ -0,0 +1,3548 @@
+/****************************************************************************
+ *
+ * class Print3DExporter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <stdarg.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+#include "pwpPlatform.h"
+
+#include "Print3DExporter.h"
+#include "ClippedModel.h"
+#include "EdgeChains.h"
+#include "EdgeFilter.h"
+#include "EdgeGroups.h"
+#include "HubMesher.h"
+#include "LayerSlicer.h"
+#include "PipelineRing.h"
+#include "RingCache.h"
+#include "SdfMesher.h"
+#include "StlMerge.h"
+#include "WeldedModel.h"
+#include "WorkerPool.h"
+
+const char  SolidName[]         = "Pointwise_Print3D";
+const char  CacheFileExt[]      = ".p3dcache";
+const char  CheckpointFileExt[] = ".p3dckpt";
+const char  ChunkIndexFileExt[] = ".chunks";
+const char  *SolidIdsName[]     = { "plain", "viscam", "magics" };
+const char  *SolidScopeName[]   = { "cylinder", "entity", "cluster",
+                                    "component" };
+const char  *EdgeModeName[]     = { "all", "boundary", "feature" };
+const char  *EdgeOrderName[]    = { "traversal", "morton", "hilbert" };
+
+// the 3MF package parts
+const char  ContentTypesXml[]   =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/"
+        "content-types\">\n"
+    "<Default Extension=\"rels\" ContentType=\"application/"
+        "vnd.openxmlformats-package.relationships+xml\"/>\n"
+    "<Default Extension=\"model\" ContentType=\"application/"
+        "vnd.ms-package.3dmanufacturing-3dmodel+xml\"/>\n"
+    "</Types>\n";
+const char  RelsXml[]           =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/"
+        "relationships\">\n"
+    "<Relationship Target=\"/3D/3dmodel.model\" Id=\"rel0\" "
+        "Type=\"http://schemas.microsoft.com/3dmanufacturing/2013/01/"
+        "3dmodel\"/>\n"
+    "</Relationships>\n";
+const char  ModelPartName[]     = "3D/3dmodel.model";
+const PWP_UINT32 CylinderObjectId = 1;
+// the shortest beam a beam lattice reader keeps, relative to the radius
+const double BeamMinLength = 1e-6;
+// the cylinders of an ordered export per chunk of the chunk index
+const PWP_UINT32 OrderChunkEdges = 4096;
+
+// the elements per task of a parallel traversal and per pipeline batch
+const PWP_UINT32 RangeElems = 1024;
+
+// the pipeline batches in flight per geometry thread
+const PWP_UINT32 BatchesPerWorker = 4;
+
+// the least time between two checkpoints, in seconds
+const double CheckpointSecs = 2.0;
+
+
+static bool
+valZero(double val)
+{
+    const double ZeroTol = 1.0E-10;
+    return ::fabs(val) < ZeroTol;
+}
+
+
+static double
+roundZero(double val)
+{
+    return valZero(val) ? 0 : val;
+}
+
+
+static PWP_UINT16
+solidIdAttr(Print3DSolidIds ids, PWP_UINT32 solidNum)
+{
+    PWP_UINT16 ret;
+    if (Print3DSolidIdPlain == ids) {
+        // 0 means no solid, so the ids wrap from 65535 back to 1
+        ret = (PWP_UINT16)(((solidNum - 1) % 0xFFFF) + 1);
+    }
+    else {
+        // scatter consecutive ids over the 15-bit color space so that
+        // neighboring solids are easy to tell apart
+        const PWP_UINT32 rgb = ((solidNum * 2654435761u) >> 17) & 0x7FFF;
+        if (Print3DSolidIdVisCAM == ids) {
+            // bit 15 set if valid, red in bits 10-14, blue in bits 0-4
+            ret = (PWP_UINT16)(0x8000 | rgb);
+        }
+        else {
+            // bit 15 clear if valid, blue in bits 10-14, red in bits 0-4
+            ret = (PWP_UINT16)(((rgb & 0x1F) << 10) | (rgb & 0x3E0) |
+                (rgb >> 10));
+        }
+    }
+    return ret;
+}
+
+
+static std::string
+xmlEscape(const std::string &str)
+{
+    std::string ret;
+    for (size_t ii = 0; ii < str.size(); ++ii) {
+        switch (str[ii]) {
+            case '&':  ret += "&amp;";  break;
+            case '<':  ret += "&lt;";   break;
+            case '>':  ret += "&gt;";   break;
+            case '"':  ret += "&quot;"; break;
+            default:   ret += str[ii];  break;
+        }
+    }
+    return ret;
+}
+
+
+//***************************************************************************
+// The attributes of the cylinder solids renumbered by a partition merge
+class PartSolidAttr : public StlSolidAttr {
+public:
+    PartSolidAttr(Print3DSolidIds ids) :
+        ids_(ids)
+    {
+    }
+
+    virtual PWP_UINT16 attribute(PWP_UINT32 solidNum) const {
+        return solidIdAttr(ids_, solidNum);
+    }
+
+private:
+    Print3DSolidIds ids_;
+};
+
+
+//***************************************************************************
+// Registers the edges not yet written and remembers them in owned
+class ClaimNewEdges : public EdgeVisitor {
+public:
+    ClaimNewEdges(EdgeTable &registry, std::vector<Edge> &owned) :
+        registry_(registry),
+        owned_(owned)
+    {
+    }
+
+    virtual void visit(const Edge &e) {
+        if (registry_.insert(e)) {
+            owned_.push_back(e);
+        }
+    }
+
+private:
+    EdgeTable &         registry_;
+    std::vector<Edge> & owned_;
+};
+
+
+//***************************************************************************
+// Claims the visited edges for the element being scanned
+class ClaimEdgeOwner : public EdgeVisitor {
+public:
+    ClaimEdgeOwner(EdgeRegistry &registry) :
+        registry_(registry),
+        seq_(0)
+    {
+    }
+
+    void setSeq(PWP_UINT64 seq) {
+        seq_ = seq;
+    }
+
+    virtual void visit(const Edge &e) {
+        registry_.claim(e, seq_);
+    }
+
+private:
+    EdgeRegistry &  registry_;
+    PWP_UINT64      seq_;
+};
+
+
+//***************************************************************************
+// Collects every visited edge
+class CollectEdges : public EdgeVisitor {
+public:
+    CollectEdges(EdgeTable &edges) :
+        edges_(edges)
+    {
+    }
+
+    virtual void visit(const Edge &e) {
+        edges_.insert(e);
+    }
+
+private:
+    EdgeTable & edges_;
+};
+
+
+//***************************************************************************
+// Registers the visited edges that are also in mine
+class SeedSharedEdges : public EdgeVisitor {
+public:
+    SeedSharedEdges(const EdgeTable &mine, EdgeTable &registry) :
+        mine_(mine),
+        registry_(registry)
+    {
+    }
+
+    virtual void visit(const Edge &e) {
+        if (mine_.contains(e)) {
+            registry_.insert(e);
+        }
+    }
+
+private:
+    const EdgeTable &   mine_;
+    EdgeTable &         registry_;
+};
+
+
+
+//***************************************************************************
+// An element range of a patch or block written by one task of a parallel
+// traversal
+struct Print3DExporter::Range {
+    PWP_UINT32  entity;
+    PWP_UINT32  first;      // the elements [first, end)
+    PWP_UINT32  end;
+    PWP_UINT64  seq;        // the sequence number of element first
+    bool        solid;      // thicken the 2D elements
+    PWP_UINT32  numThick;   // the number of thickened elements
+    PWP_UINT32  solidBase;  // the cylinder solid count before the range
+    PWP_UINT32  numSolids;  // the cylinder solid count after the range
+    PWP_UINT32  numTris;
+    PWP_UINT32  numRings;   // the cylinders and those whose ring was cached
+    PWP_UINT32  numRingHits;
+};
+
+
+//***************************************************************************
+// The worker exporters of the tasks of a job. A task borrows one that no
+// running task uses, so a job makes at most one per thread however many
+// tasks it runs, and a worker's ring cache stays warm.
+struct Print3DExporter::Workers {
+    Workers(const Print3DExporter &owner, PWP_UINT32 numThreads,
+        EdgeRegistry *edgeRegistry = 0);
+    ~Workers();
+
+    Print3DExporter *   take();
+    void                release(Print3DExporter *worker);
+
+    const Print3DExporter &         exporter;
+    EdgeRegistry *                  registry;
+    Mutex                           mutex;
+    std::vector<Print3DExporter *>  all;
+    std::vector<Print3DExporter *>  idle;   // used by no running task
+};
+
+
+//***************************************************************************
+// The ranges and the workers shared by the tasks. The tasks of a batch
+// write the facets of range first + task into bufs[task], which keep
+// their capacity from batch to batch.
+struct Print3DExporter::RangeJob {
+    Print3DExporter *       exporter;
+    std::vector<Range> *    ranges;
+    size_t                  first;
+    std::vector<std::string> bufs;
+    Workers *               workers;
+};
+
+
+//***************************************************************************
+// The solids of up to RangeElems elements of a patch or block, passed from
+// the traversal through a geometry thread to the writer thread. A batch is
+// reused once written, so its buffers keep their capacity.
+struct Print3DExporter::Batch {
+    PWP_UINT32  entity;
+    PWP_UINT32  slot;       // the entity's checkpoint slot
+    bool        first;      // the entity's first batch
+    bool        last;       // the entity's last batch
+    std::string name;       // the entity name, set in its last batch
+    PWP_UINT32  solidBase;  // the cylinder solid count before the batch
+    PWP_UINT32  numSolids;  // the cylinder solid count after the batch
+    PWP_UINT32  numTris;
+    PWP_UINT32  numRings;   // the cylinders and those whose ring was cached
+    PWP_UINT32  numRingHits;
+    std::vector<PWP_UINT8>      ops;    // the vertex count of each solid,
+                                        // 2 for a cylinder, 3 or 4 for a
+                                        // thickened element
+    std::vector<PWGM_VERTDATA>  verts;
+    std::string buf;        // the facets
+};
+
+
+//***************************************************************************
+// The batch ring shared by the pipeline stages
+struct Print3DExporter::PipelineJob {
+    Print3DExporter *       exporter;
+    PipelineRing *          ring;
+    std::vector<Batch> *    batches;
+    PWP_UINT64              seq;        // the next batch to fill
+    PWP_UINT32              numSolids;  // the cylinder solids before seq
+    Workers *               workers;
+};
+
+
+//***************************************************************************
+// A cluster or component solid written by one task
+struct Print3DExporter::Group {
+    PWP_UINT32  ndx;
+    PWP_UINT32  numTris;
+    PWP_UINT32  numSolids;  // the solid count after the group
+    PWP_UINT32  numRings;   // the cylinders and those whose ring was cached
+    PWP_UINT32  numRingHits;
+    std::string buf;        // the facets
+};
+
+
+//***************************************************************************
+// The edge groups or chunks of a batch of tasks
+struct Print3DExporter::GroupJob {
+    Print3DExporter *       exporter;
+    const EdgeGroups *      groups;
+    std::vector<Group> *    solids;
+    PWP_UINT32              first;      // the group of task 0
+    Workers *               workers;
+};
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+Print3DSettings::Print3DSettings() :
+    format(Print3DFormatStl),
+    binary(false),
+    beamLattice(false),
+    multiSolid(true),
+    solidScope(Print3DSolidPerCylinder),
+    solidIds(Print3DSolidIdPlain),
+    clusterTris(DefClusterTris),
+    diameter(DefCylDiam),
+    numPoints(DefNumBasePts),
+    cylTolerance(0.0),
+    edgeMode(Print3DEdgesAll),
+    boundaryLayers(0),
+    featureAngle(DefFeatureAngle),
+    clipBoxes(),
+    clipHalfSpaces(),
+    clipTrim(false),
+    weldVertices(false),
+    weldTolerance(0.0),
+    mergeChains(false),
+    chainTolerance(0.0),
+    edgeOrder(Print3DOrderTraversal),
+    tessCache(false),
+    checkpoint(false),
+    numParts(1),
+    partRank(0),
+    mergeParts(false),
+    sdfUnion(false),
+    sdfResolution(DefSdfRes),
+    hubLattice(false),
+    numThreads(0),
+    sliceThickness(DefSliceThick),
+    threadSafeModel(false),
+    destPath()
+{
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+Print3DExporter::Workers::Workers(const Print3DExporter &owner,
+        PWP_UINT32 numThreads, EdgeRegistry *edgeRegistry) :
+    exporter(owner),
+    registry(edgeRegistry),
+    mutex(),
+    all(),
+    idle()
+{
+    all.reserve(numThreads);
+    idle.reserve(numThreads);
+}
+
+
+Print3DExporter::Workers::~Workers()
+{
+    for (size_t ii = 0; ii < all.size(); ++ii) {
+        // the exporter owns the filter and the clip regions
+        all[ii]->edgeFilter_ = 0;
+        all[ii]->clip_ = 0;
+        delete all[ii];
+    }
+}
+
+
+Print3DExporter *
+Print3DExporter::Workers::take()
+{
+    // an idle worker, or a new one that shares the exporter's filter,
+    // clip regions and registry, with the counts of a new task
+    Print3DExporter *worker = 0;
+    {
+        MutexLock lock(mutex);
+        if (!idle.empty()) {
+            worker = idle.back();
+            idle.pop_back();
+        }
+    }
+    if (0 == worker) {
+        AllocPhase phase(AllocPhase::Setup);
+        worker = new Print3DExporter(*exporter.model_, exporter.host_, 0,
+            exporter.settings_);
+        worker->edgeFilter_ = exporter.edgeFilter_;
+        worker->clip_ = exporter.clip_;
+        worker->registry_ = registry;
+        MutexLock lock(mutex);
+        all.push_back(worker);
+    }
+    worker->numTris_ = 0;
+    worker->numSolids_ = 0;
+    worker->curEntity_ = 0;
+    worker->curAttr_ = 0;
+    worker->seq_ = 0;
+    worker->numRings_ = 0;
+    worker->numRingHits_ = 0;
+    worker->capture_ = 0;
+    worker->edgeVisitor_ = 0;
+    return worker;
+}
+
+
+void
+Print3DExporter::Workers::release(Print3DExporter *worker)
+{
+    MutexLock lock(mutex);
+    idle.push_back(worker);
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+Print3DExporter::Print3DExporter(Print3DModel &model, Print3DHost &host,
+        FILE *fp, const Print3DSettings &settings) :
+    model_(&model),
+    host_(host),
+    fp_(fp),
+    settings_(settings),
+    edges_(),
+    numTris_(0),
+    numSolids_(0),
+    multiSolid_(settings.multiSolid && !isUnion(settings) &&
+        (Print3DFormatStl == settings.format)),
+    curEntity_(0),
+    curAttr_(0),
+    manifest_(),
+    zip_(0),
+    numObjects_(0),
+    objectOpen_(false),
+    buildItems_(),
+    meshVerts_(),
+    graph_(0),
+    registry_(0),
+    seq_(0),
+    entitySolids_(0),
+    radius_(settings.diameter / 2.0),
+    zOffset_(settings.diameter / 3.0),
+    numBasePts_(settings.numPoints),
+    ringStep_((isUnion(settings) || settings.beamLattice ||
+        (Print3DFormatCli == settings.format)) ? 0.0 :
+        RingCache::stepFor(radius_, settings.cylTolerance)),
+    rings_(0),
+    numRings_(0),
+    numRingHits_(0),
+    clip_(0),
+    weld_(0),
+    edgeFilter_(0),
+    chains_(0),
+    useCache_(usesCache(settings)),
+    useOwnedEdges_(false),
+    cachePath_(),
+    cache_(),
+    capture_(0),
+    batch_(0),
+    edgeVisitor_(0),
+    partFirst_(0),
+    partEnd_(0),
+    useCheckpoint_(false),
+    ckptPath_(),
+    ckpt_(),
+    ckptFailed_(false),
+    outFp_(0),
+    numBytes_(0),
+    ckptTime_(0)
+{
+    if (settings_.numParts < 1) {
+        settings_.numParts = 1;
+    }
+    if (!settings_.destPath.empty()) {
+        cachePath_ = settings_.destPath + CacheFileExt;
+    }
+    // Initialize masterCylBase_ data
+    // polygon is centered at the origin in the z=0 plane
+    // polygon's right-handed normal is +z
+    const double PI = 3.141592653589793;
+    double angle = 0; // radians
+    double deltaR = (2 * PI) / numBasePts_;
+    for (PWP_UINT ii = 0; ii < numBasePts_; ++ii, angle += deltaR) {
+        // load cyl base pts (xyz)
+        masterCylBase_[ii].set(cos(angle) * radius_, sin(angle) * radius_, 0);
+    }
+}
+
+
+Print3DExporter::~Print3DExporter()
+{
+    delete zip_;
+    delete rings_;
+    delete clip_;
+    delete weld_;
+    delete edgeFilter_;
+    delete chains_;
+    if (0 != outFp_) {
+        // an export that did not finish keeps its checkpoint
+        fclose(fp_);
+    }
+}
+
+
+PWP_UINT32
+Print3DExporter::majorSteps(const Print3DSettings &settings)
+{
+    PWP_UINT32 ret = 2; // patches + blocks
+    if (settings.mergeParts) {
+        return 1;
+    }
+    else if (isUnion(settings) || (Print3DFormatCli == settings.format) ||
+            hasGroupedSolids(settings) || settings.beamLattice ||
+            usesEdgeOrder(settings)) {
+        // + surface extraction or hubs, slicing, grouped solids, beams or
+        // the ordered cylinders
+        ret = 3;
+    }
+    else if ((settings.numParts > 1) || isParallel(settings)) {
+        // + edge ownership scan
+        ret = 3;
+    }
+    if (settings.weldVertices) {
+        // + vertex welding
+        ++ret;
+    }
+    if (Print3DEdgesAll != settings.edgeMode) {
+        // + edge classification
+        ++ret;
+    }
+    if (usesChains(settings)) {
+        // + chain scan
+        ++ret;
+    }
+    if (usesCheckpoint(settings)) {
+        // + grid hash of the checkpoint key
+        ++ret;
+    }
+    return ret;
+}
+
+
+bool
+Print3DExporter::isUnion(const Print3DSettings &settings)
+{
+    // The exports that replace the edges by one closed surface
+    return settings.sdfUnion || settings.hubLattice;
+}
+
+
+bool
+Print3DExporter::isParallel(const Print3DSettings &settings)
+{
+    // The elements are traversed by several threads only if the model
+    // allows it. Only the plain STL export supports it.
+    const PWP_UINT32 numThreads = (0 == settings.numThreads) ?
+        WorkerPool::processorCount() : settings.numThreads;
+    return settings.threadSafeModel && (numThreads > 1) &&
+        (Print3DFormatStl == settings.format) && !isUnion(settings) &&
+        !settings.tessCache && (settings.numParts <= 1) &&
+        !settings.mergeParts && !hasGroupedSolids(settings) &&
+        !usesChains(settings) && !usesEdgeOrder(settings);
+}
+
+
+bool
+Print3DExporter::isPipelined(const Print3DSettings &settings)
+{
+    // A model that only allows one reading thread is traversed by this
+    // thread while other threads make and write the facets. Only the plain
+    // STL export supports it.
+    const PWP_UINT32 numThreads = (0 == settings.numThreads) ?
+        WorkerPool::processorCount() : settings.numThreads;
+    return !isParallel(settings) && (numThreads > 1) &&
+        (Print3DFormatStl == settings.format) && !isUnion(settings) &&
+        !settings.tessCache && (settings.numParts <= 1) &&
+        !settings.mergeParts && !hasGroupedSolids(settings) &&
+        !usesEdgeOrder(settings);
+}
+
+
+bool
+Print3DExporter::hasGroupedSolids(const Print3DSettings &settings)
+{
+    // The cluster and component solids need all the edges, so they are
+    // collected into a graph like those of an SdfUnion export.
+    return settings.multiSolid && !isUnion(settings) &&
+        (Print3DFormatStl == settings.format) &&
+        ((Print3DSolidPerCluster == settings.solidScope) ||
+        (Print3DSolidPerComponent == settings.solidScope));
+}
+
+
+bool
+Print3DExporter::usesChains(const Print3DSettings &settings)
+{
+    // The exports that collect the edges into a graph do not write
+    // cylinders, the chains are only merged for the others.
+    return settings.mergeChains && !settings.mergeParts &&
+        !isUnion(settings) && !settings.beamLattice &&
+        (Print3DFormatCli != settings.format) && !hasGroupedSolids(settings);
+}
+
+
+bool
+Print3DExporter::usesEdgeOrder(const Print3DSettings &settings)
+{
+    // The cylinders are sorted once all the edges are collected into a
+    // graph. The grouped solids have an order of their own.
+    return (Print3DOrderTraversal != settings.edgeOrder) &&
+        (Print3DFormatStl == settings.format) && !isUnion(settings) &&
+        !settings.mergeParts && !hasGroupedSolids(settings);
+}
+
+
+bool
+Print3DExporter::usesClip(const Print3DSettings &settings)
+{
+    return !settings.mergeParts &&
+        ((std::string::npos != settings.clipBoxes.find_first_not_of(" \t")) ||
+        (std::string::npos !=
+            settings.clipHalfSpaces.find_first_not_of(" \t")));
+}
+
+
+bool
+Print3DExporter::usesCache(const Print3DSettings &settings)
+{
+    return settings.tessCache && !settings.mergeParts &&
+        !isUnion(settings) && (Print3DFormatStl == settings.format) &&
+        !hasGroupedSolids(settings) && !usesChains(settings) &&
+        !usesEdgeOrder(settings) && !usesClip(settings);
+}
+
+
+bool
+Print3DExporter::usesCheckpoint(const Print3DSettings &settings)
+{
+    // A checkpoint splits the file at its patches and blocks, which only
+    // an unpartitioned STL export writes in order
+    return settings.checkpoint && (Print3DFormatStl == settings.format) &&
+        !isUnion(settings) && !usesCache(settings) &&
+        (settings.numParts <= 1) && !settings.mergeParts &&
+        !hasGroupedSolids(settings) && !usesEdgeOrder(settings) &&
+        !settings.destPath.empty();
+}
+
+
+bool
+Print3DExporter::run()
+{
+    if (settings_.partRank >= settings_.numParts) {
+        host_.sendErrorMsg("PartitionRank must be less than PartitionCount");
+        return false;
+    }
+    if (is3mf() && ((settings_.numParts > 1) || settings_.mergeParts)) {
+        host_.sendErrorMsg("3MF export does not support partitions");
+        return false;
+    }
+    if (settings_.sdfUnion && (!isStl() || (settings_.numParts > 1) ||
+            settings_.mergeParts)) {
+        host_.sendErrorMsg("SdfUnion requires an unpartitioned STL export");
+        return false;
+    }
+    if (settings_.hubLattice && (!isStl() || (settings_.numParts > 1) ||
+            settings_.mergeParts)) {
+        host_.sendErrorMsg("HubLattice requires an unpartitioned STL "
+            "export");
+        return false;
+    }
+    if (settings_.sdfUnion && settings_.hubLattice) {
+        host_.sendErrorMsg("SdfUnion and HubLattice are exclusive");
+        return false;
+    }
+    if (hasGroupedSolids(settings_) && ((settings_.numParts > 1) ||
+            settings_.mergeParts)) {
+        host_.sendErrorMsg("Cluster and component solids do not support "
+            "partitions");
+        return false;
+    }
+    if (settings_.mergeChains && (settings_.numParts > 1)) {
+        host_.sendErrorMsg("MergeChains does not support partitions");
+        return false;
+    }
+    if (settings_.weldTolerance < 0.0) {
+        host_.sendErrorMsg("WeldTolerance must not be negative");
+        return false;
+    }
+    if (settings_.chainTolerance < 0.0) {
+        host_.sendErrorMsg("ChainTolerance must not be negative");
+        return false;
+    }
+    if (usesEdgeOrder(settings_) && (settings_.numParts > 1)) {
+        host_.sendErrorMsg("EdgeOrder does not support partitions");
+        return false;
+    }
+    if (usesEdgeOrder(settings_) && multiSolid_ &&
+            (Print3DSolidPerEntity == settings_.solidScope)) {
+        host_.sendErrorMsg("EdgeOrder does not support entity solids");
+        return false;
+    }
+    if (settings_.beamLattice && !is3mf()) {
+        host_.sendErrorMsg("BeamLattice requires a 3MF export");
+        return false;
+    }
+    if (isCli() && ((settings_.numParts > 1) || settings_.mergeParts)) {
+        host_.sendErrorMsg("Slice export does not support partitions");
+        return false;
+    }
+    if (isCli() && (settings_.sliceThickness <= 0)) {
+        host_.sendErrorMsg("SliceThickness must be positive");
+        return false;
+    }
+    if ((settings_.featureAngle < 0.0) || (settings_.featureAngle > 90.0)) {
+        host_.sendErrorMsg("FeatureAngle must be 0 to 90 degrees");
+        return false;
+    }
+    if (settings_.boundaryLayers > MaxBndryLayers) {
+        host_.sendErrorMsg("BoundaryLayers is too large");
+        return false;
+    }
+    if (settings_.numThreads > MaxThreads) {
+        host_.sendErrorMsg("Threads is too large");
+        return false;
+    }
+    if ((settings_.cylTolerance > 0.0) && (0.0 == ringStep_) && !isCli() &&
+            !isUnion(settings_) && !settings_.beamLattice) {
+        host_.sendWarningMsg("CylinderTolerance is too small for the "
+            "direction cache, which is not used");
+    }
+    if (useCache_ && (cachePath_.empty() || !cache_.open(cachePath_))) {
+        host_.sendWarningMsg("Ignoring unreadable tessellation cache");
+    }
+    useCheckpoint_ = usesCheckpoint(settings_);
+    if (settings_.checkpoint && !useCheckpoint_) {
+        host_.sendWarningMsg("Checkpoints are only written by unpartitioned "
+            "STL exports without SdfUnion, HubLattice, TessCache, grouped "
+            "solids or EdgeOrder");
+    }
+
+    if (usesClip(settings_) && !buildClip()) {
+        return false;
+    }
+    if (settings_.weldVertices && !settings_.mergeParts && !buildWeld()) {
+        return false;
+    }
+    useOwnedEdges_ = hasOwnedEdges();
+
+    writeHeader();
+    if (settings_.mergeParts) {
+        if (!mergePartitions()) {
+            return false;
+        }
+    }
+    else {
+        if ((Print3DEdgesAll != settings_.edgeMode) && !buildEdgeFilter()) {
+            return false;
+        }
+        if (usesChains(settings_) && !buildChains()) {
+            return false;
+        }
+        if (settings_.numParts > 1) {
+            initPartition();
+            seedPartitionEdges();
+        }
+        EdgeGraph graph;
+        if (isUnion(settings_) || settings_.beamLattice || isCli() ||
+                hasGroupedSolids(settings_) || usesEdgeOrder(settings_)) {
+            // collect the edges instead of writing cylinders
+            graph_ = &graph;
+        }
+        if (useCheckpoint_ && !beginCheckpoint()) {
+            if (!aborted()) {
+                host_.sendErrorMsg("Could not create the checkpoint files");
+            }
+            return false;
+        }
+        {
+            AllocPhase phase(AllocPhase::Traversal);
+            if (isParallel(settings_) && !useOwnedEdges_) {
+                writeParallel();
+            }
+            else if (isParallel(settings_) || isPipelined(settings_)) {
+                writePipelined();
+            }
+            else {
+                writePatches();
+                writeBlocks();
+            }
+        }
+        AllocPhase phase(AllocPhase::Geometry);
+        if (settings_.sdfUnion) {
+            writeSdfUnion();
+        }
+        else if (settings_.hubLattice) {
+            if (!writeHubLattice()) {
+                return false;
+            }
+        }
+        else if (settings_.beamLattice) {
+            writeBeamLattice();
+        }
+        else if (isCli()) {
+            writeLayerSlices();
+        }
+        else if (hasGroupedSolids(settings_)) {
+            writeGroupedSolids();
+        }
+        else if (usesEdgeOrder(settings_)) {
+            writeOrderedEdges();
+        }
+        graph_ = 0;
+        if (useCheckpoint_ && !endCheckpoint()) {
+            return false;
+        }
+    }
+    if (!writeFooter()) {
+        host_.sendErrorMsg("Could not complete the export file");
+        return false;
+    }
+    if (useCheckpoint_) {
+        Checkpoint::remove(ckptPath_);
+    }
+    reportRings();
+    if (multiSolid_ && isBinaryEncoding() && !settings_.destPath.empty() &&
+            !writeManifest(settings_.destPath + ManifestFileExt)) {
+        host_.sendWarningMsg("Could not write solid id manifest");
+    }
+    if (useCache_ && !aborted()) {
+        char msg[128];
+        sprintf(msg, "Tessellation cache: %lu reused, %lu regenerated",
+            (unsigned long)cache_.hits(), (unsigned long)cache_.misses());
+        host_.sendInfoMsg(msg);
+        if (!cache_.save()) {
+            host_.sendWarningMsg("Could not save tessellation cache");
+        }
+    }
+    return true;
+}
+
+
+void
+Print3DExporter::writeBytes(const void *buf, size_t size)
+{
+    // all facet data passes through here so that it can be captured for
+    // a batch or appended to the tessellation cache
+    AllocPhase phase(AllocPhase::Io);
+    if (0 != zip_) {
+        zip_->write(buf, size);
+    }
+    else if (0 != fp()) {
+        // a worker of a parallel traversal only captures
+        pwpFileWrite(buf, size, 1, fp());
+        numBytes_ += size;
+    }
+    if (0 != capture_) {
+        capture_->append((const char *)buf, size);
+    }
+    if (cache_.recording()) {
+        cache_.append(buf, size);
+    }
+}
+
+
+void
+Print3DExporter::writeStr(const char *format, ...)
+{
+    if (isAsciiEncoding()) {
+        va_list args;
+        va_start(args, format);
+        writeTextV(format, args);
+        va_end(args);
+    }
+}
+
+
+void
+Print3DExporter::writeText(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    writeTextV(format, args);
+    va_end(args);
+}
+
+
+void
+Print3DExporter::writeTextV(const char *format, va_list args)
+{
+    char buf[512];
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    if (len > 0) {
+        writeBytes(buf, ((size_t)len < sizeof(buf)) ? (size_t)len :
+            sizeof(buf) - 1);
+    }
+}
+
+
+void
+Print3DExporter::writeFacet(const vector3 &norm, const vector3 &p0,
+    const vector3 &p1, const vector3 &p2)
+{
+    // The facet is formatted on the stack and written with one call. The
+    // binary attribute is 0 unless a multi-solid export is inside a solid.
+    // Then it holds the solid id.
+    const vector3 *xyz[4] = { &norm, &p0, &p1, &p2 };
+    if (isAsciiEncoding()) {
+        const int AsciiFloatPrec = 8;
+        char buf[512];
+        int len = 0;
+        for (int ii = 0; ii < 4; ++ii) {
+            len += sprintf(buf + len, "%s %.*g %.*g %.*g\n",
+                (0 == ii) ? "facet normal" : "  vertex",
+                AsciiFloatPrec, roundZero((*xyz[ii])[0]),
+                AsciiFloatPrec, roundZero((*xyz[ii])[1]),
+                AsciiFloatPrec, roundZero((*xyz[ii])[2]));
+            if (0 == ii) {
+                len += sprintf(buf + len, " outer loop\n");
+            }
+        }
+        len += sprintf(buf + len, " endloop\nendfacet\n");
+        writeBytes(buf, (size_t)len);
+    }
+    else if (isBinaryEncoding()) {
+        // 12 REAL32 + 1 UINT16
+        unsigned char buf[12 * sizeof(float) + sizeof(curAttr_)];
+        for (int ii = 0; ii < 4; ++ii) {
+            float val[3];
+            val[0] = (float)roundZero((*xyz[ii])[0]);
+            val[1] = (float)roundZero((*xyz[ii])[1]);
+            val[2] = (float)roundZero((*xyz[ii])[2]);
+            memcpy(buf + ii * sizeof(val), val, sizeof(val));
+        }
+        memcpy(buf + 12 * sizeof(float), &curAttr_, sizeof(curAttr_));
+        writeBytes(buf, sizeof(buf));
+    }
+}
+
+
+void
+Print3DExporter::writeTriFacet(const vector3 &p0, const vector3 &p1,
+    const vector3 &p2)
+{
+    // from: http://en.wikipedia.org/wiki/STL_(file_format)
+    //
+    // In both ASCII and binary versions of STL, the facet normal should be a
+    // unit vector pointing OUTWARDS from the solid object. In most software
+    // this may be set to (0,0,0) and the software will automatically calculate
+    // a normal based on the order of the triangle vertices using the 'right
+    // hand rule'. Some STL loaders (eg the STL plugin for Art of Illusion)
+    // check that the normal in the file agrees with the normal they calculate
+    // using the right hand rule and warn you when it does not. Other software
+    // may ignore the facet normal entirely and use only the right hand rule.
+    // So in order to be entirely portable one should provide both the facet
+    // normal and order the vertices appropriately  even though it is
+    // seemingly redundant to do so. Some other software (e.g. SolidWorks) use
+    // the normal for shading effects, so the "normals" listed in the file are
+    // not the true facets' normals.
+    //
+    // ******* ASCII export:
+    //  facet normal  0.000000e+000  0.000000e+000  1.000000e+000
+    //    outer loop
+    //      vertex    0.000000e+000  0.000000e+000  0.000000e+000
+    //      vertex    5.000000e-001  0.000000e+000  0.000000e+000
+    //      vertex    5.000000e-001  5.000000e-001  0.000000e+000
+    //    endloop
+    //  endfacet
+    //
+    // ******* BINARY export:
+    // foreach triangle
+    //   REAL32[3]           Normal vector
+    //   REAL32[3]           Vertex 1
+    //   REAL32[3]           Vertex 2
+    //   REAL32[3]           Vertex 3
+    //   UINT16              Attribute byte count
+    // end
+    if (is3mf()) {
+        // only the thickened elements get here, they are collected into
+        // one mesh object by write3mfFooter()
+        meshVerts_.push_back(p0);
+        meshVerts_.push_back(p1);
+        meshVerts_.push_back(p2);
+        ++numTris_;
+        return;
+    }
+    writeFacet(cml::cross((p1 - p0), (p2 - p1)).normalize(), p0, p1, p2);
+    ++numTris_;
+}
+
+
+void
+Print3DExporter::writeQuadFacet(const vector3 &p0, const vector3 &p1,
+    const vector3 &p2, const vector3 &p3)
+{
+    writeTriFacet(p0, p1, p2);
+    writeTriFacet(p0, p2, p3);
+}
+
+
+PWP_UINT16
+Print3DExporter::solidAttr(PWP_UINT32 solidNum) const
+{
+    return solidIdAttr(settings_.solidIds, solidNum);
+}
+
+
+bool
+Print3DExporter::renumbersParts() const
+{
+    // cylinder solids are numbered by the merge, entity solids by entity
+    return multiSolid_ && (settings_.numParts > 1) &&
+        (Print3DSolidPerCylinder == settings_.solidScope);
+}
+
+
+void
+Print3DExporter::beginMultiSolid(Print3DSolidScope scope)
+{
+    // ******* ASCII export:
+    // "solid [name]\n"
+    //
+    // ******* BINARY export:
+    // The facets written until endMultiSolid() carry the solid's id in
+    // their attribute
+    //
+    if (!multiSolid_ || (scope != settings_.solidScope)) {
+        return;
+    }
+    // entity solids are numbered by entity so that their names and ids are
+    // the same in every partition
+    ++numSolids_;
+    const PWP_UINT32 solidNum = (Print3DSolidPerEntity == scope) ?
+        curEntity_ + 1 : numSolids_;
+    if (isBinaryEncoding() && renumbersParts()) {
+        // a partition numbers its cylinders with plain ids, the merge
+        // renumbers them to follow the earlier partitions
+        curAttr_ = solidIdAttr(Print3DSolidIdPlain, solidNum);
+    }
+    else if (isBinaryEncoding()) {
+        curAttr_ = solidAttr(solidNum);
+    }
+    else {
+        sprintf(curSolidName_, "%s_%06lu", SolidName,
+            (unsigned long)solidNum);
+        writeStr("solid %s\n", curSolidName_);
+    }
+}
+
+
+void
+Print3DExporter::endMultiSolid(Print3DSolidScope scope)
+{
+    if (!multiSolid_ || (scope != settings_.solidScope)) {
+        return;
+    }
+    if (isBinaryEncoding()) {
+        curAttr_ = 0;
+    }
+    else {
+        // ******* ASCII export:
+        // "endsolid [name]\n"
+        //
+        writeStr("endsolid %s\n", curSolidName_);
+    }
+}
+
+
+void
+Print3DExporter::addManifestEntry(PWP_UINT32 ndx, PWP_UINT32 numSolids)
+{
+    if (multiSolid_ && isBinaryEncoding()) {
+        AllocPhase phase(AllocPhase::Io);
+        addManifestEntry(ndx, numSolids, model_->entityName(ndx).c_str());
+    }
+}
+
+
+void
+Print3DExporter::addManifestEntry(PWP_UINT32 ndx, PWP_UINT32 numSolids,
+    const char *name)
+{
+    // numSolids is the solid count before entity ndx was written
+    if (!multiSolid_ || !isBinaryEncoding()) {
+        return;
+    }
+    AllocPhase phase(AllocPhase::Io);
+    PWP_UINT32 first = numSolids + 1;
+    PWP_UINT32 last = numSolids_;
+    if (Print3DSolidPerEntity == settings_.solidScope) {
+        first = last = ndx + 1;
+    }
+    if (first <= last) {
+        char buf[64];
+        sprintf(buf, "%lu %lu 0x%04x ", (unsigned long)first,
+            (unsigned long)last, (unsigned)solidAttr(first));
+        manifest_ += buf;
+        manifest_ += name;
+        manifest_ += '\n';
+    }
+}
+
+
+bool
+Print3DExporter::writeManifest(const std::string &path)
+{
+    // A text file that maps the solid ids to the patches and blocks:
+    //   first-id last-id attribute-of-first-id entity-name
+    FILE *fp = fopen(path.c_str(), "w");
+    if (0 == fp) {
+        return false;
+    }
+    fprintf(fp, "# Print3D solid manifest\n");
+    fprintf(fp, "# ids: %s\n", SolidIdsName[settings_.solidIds]);
+    fprintf(fp, "# scope: %s\n", SolidScopeName[settings_.solidScope]);
+    if (Print3DSolidIdPlain == settings_.solidIds) {
+        fprintf(fp, "# attribute = ((id - 1) %% 65535) + 1\n");
+    }
+    fprintf(fp, "# first last attribute name\n");
+    bool ret = true;
+    if (settings_.mergeParts) {
+        PWP_UINT32 numSolids = 0;
+        for (PWP_UINT32 ii = 0; ret && (ii < settings_.numParts); ++ii) {
+            ret = appendManifest(stlPartPath(settings_.destPath, ii) +
+                ManifestFileExt, fp, numSolids);
+        }
+    }
+    else {
+        ret = (manifest_.size() == fwrite(manifest_.data(), 1,
+            manifest_.size(), fp));
+    }
+    return (0 == fclose(fp)) && ret;
+}
+
+
+bool
+Print3DExporter::appendManifest(const std::string &path, FILE *out,
+    PWP_UINT32 &numSolids)
+{
+    // copies the entries of a partition's manifest, skipping its comments.
+    // Cylinder solids follow the numSolids solids of the earlier partitions.
+    FILE *in = fopen(path.c_str(), "r");
+    if (0 == in) {
+        return false;
+    }
+    const bool renumber = (Print3DSolidPerCylinder == settings_.solidScope);
+    PWP_UINT32 partSolids = 0;
+    char line[1024];
+    while (0 != fgets(line, sizeof(line), in)) {
+        unsigned long first = 0;
+        unsigned long last = 0;
+        unsigned attr = 0;
+        int pos = 0;
+        if ('#' == line[0]) {
+            continue;
+        }
+        else if (renumber && (3 == sscanf(line, "%lu %lu %x %n", &first,
+                &last, &attr, &pos))) {
+            fprintf(out, "%lu %lu 0x%04x %s", first + numSolids,
+                last + numSolids, (unsigned)solidAttr(
+                (PWP_UINT32)first + numSolids), line + pos);
+            if (last > partSolids) {
+                partSolids = (PWP_UINT32)last;
+            }
+        }
+        else {
+            fputs(line, out);
+        }
+    }
+    fclose(in);
+    numSolids += partSolids;
+    return true;
+}
+
+
+void
+Print3DExporter::makeCylinder(const matrix33 &rot, const vector3 &tran0,
+    const vector3 &tran1, Cylinder &cyl)
+{
+    vector3 pt;
+    for (PWP_UINT ii = 0; ii < numBasePts_; ++ii) {
+        pt = masterCylBase_[ii] * rot;
+        cyl[0][ii] = pt + tran0;
+        cyl[1][ii] = pt + tran1;
+    }
+}
+
+
+void
+Print3DExporter::writeCylBase(const CylBase &base, bool reverse)
+{
+    if (!reverse) {
+        for (PWP_UINT ii = 1; ii < numBasePts_ - 1; ++ii) {
+            writeTriFacet(base[0], base[ii + 1], base[ii]);
+        }
+    }
+    else {
+        for (PWP_UINT ii = 1; ii < numBasePts_ - 1; ++ii) {
+            writeTriFacet(base[0], base[ii], base[ii + 1]);
+        }
+    }
+}
+
+
+void
+Print3DExporter::writeCylSides(const CylBase &cb0, const CylBase &cb1)
+{
+    PWP_UINT ii;
+    for (ii = 0; ii < numBasePts_ - 1; ++ii) {
+        writeQuadFacet(cb1[ii], cb0[ii], cb0[ii + 1], cb1[ii + 1]);
+    }
+    // here, ii == numBasePts_ - 1
+    // write last side quad that wraps back to first side quad
+    writeQuadFacet(cb1[ii], cb0[ii], cb0[0], cb1[0]);
+}
+
+
+RingCache *
+Print3DExporter::newRingCache()
+{
+    if (0.0 == ringStep_) {
+        return 0;
+    }
+    return new RingCache(masterCylBase_, numBasePts_, ringStep_);
+}
+
+
+void
+Print3DExporter::writeCylinder(const vector3 &p0, const vector3 &p1)
+{
+    AllocPhase phase(AllocPhase::Geometry);
+    vector3 zaxis(0, 0, 1);
+    vector3 cylAxis = (p1 - p0);
+    vector3 dir = normalize(cylAxis);
+    vector3 dLen = zOffset_ * dir;
+    if ((0.0 != ringStep_) && (fabs(dir[0]) <= 1.0) &&
+            (fabs(dir[1]) <= 1.0) && (dir[2] >= 0.0) && (dir[2] <= 1.0)) {
+        // the ring and facet normals of the direction's cell, translated
+        // to both ends
+        if (0 == rings_) {
+            rings_ = newRingCache();
+        }
+        bool hit;
+        const RingCache::Ring &ring = rings_->lookup(dir, hit);
+        ++numRings_;
+        if (hit) {
+            ++numRingHits_;
+        }
+        if (is3mf()) {
+            write3mfComponent(ring.rot, p0 - dLen,
+                length(cylAxis) + 2 * zOffset_);
+            return;
+        }
+        const vector3 tran0 = p0 - dLen;
+        const vector3 tran1 = p1 + dLen;
+        Cylinder cyl;
+        for (PWP_UINT ii = 0; ii < numBasePts_; ++ii) {
+            cyl[0][ii] = ring.base[ii] + tran0;
+            cyl[1][ii] = ring.base[ii] + tran1;
+        }
+        const vector3 norm0 = -ring.axis;
+        beginMultiSolid();
+        for (PWP_UINT ii = 1; ii < numBasePts_ - 1; ++ii) {
+            writeFacet(norm0, cyl[0][0], cyl[0][ii + 1], cyl[0][ii]);
+        }
+        for (PWP_UINT ii = 1; ii < numBasePts_ - 1; ++ii) {
+            writeFacet(ring.axis, cyl[1][0], cyl[1][ii], cyl[1][ii + 1]);
+        }
+        for (PWP_UINT ii = 0; ii < numBasePts_; ++ii) {
+            const PWP_UINT next = (ii + 1 < numBasePts_) ? (ii + 1) : 0;
+            writeFacet(ring.sideNorms[ii], cyl[1][ii], cyl[0][ii],
+                cyl[0][next]);
+            writeFacet(ring.sideNorms[ii], cyl[1][ii], cyl[0][next],
+                cyl[1][next]);
+        }
+        numTris_ += 4 * numBasePts_ - 4;
+        endMultiSolid();
+        return;
+    }
+    matrix33 v2v;
+    cml::matrix_rotation_vec_to_vec(v2v, cylAxis, zaxis);
+    if (is3mf()) {
+        write3mfComponent(v2v, p0 - dLen, length(cylAxis) + 2 * zOffset_);
+        return;
+    }
+    Cylinder cyl;
+    makeCylinder(v2v, p0 - dLen, p1 + dLen, cyl);
+    beginMultiSolid();
+    writeCylBase(cyl[0], false);
+    writeCylBase(cyl[1], true);
+    writeCylSides(cyl[0], cyl[1]);
+    endMultiSolid();
+}
+
+
+void
+Print3DExporter::writeCylinder(const PWGM_VERTDATA &vd0,
+    const PWGM_VERTDATA &vd1)
+{
+    vector3 p0;
+    vector3 p1;
+    // try to keep vec from p0->p1 in +z direction
+    if (vd0.z <= vd1.z) {
+        p0.set(vd0.x, vd0.y, vd0.z);
+        p1.set(vd1.x, vd1.y, vd1.z);
+    }
+    else {
+        p0.set(vd1.x, vd1.y, vd1.z);
+        p1.set(vd0.x, vd0.y, vd0.z);
+    }
+    writeCylinder(p0, p1);
+}
+
+
+bool
+Print3DExporter::isNewEdge(const Edge &e)
+{
+    AllocPhase phase(AllocPhase::Dedup);
+    if (0 != registry_) {
+        // a worker of a parallel traversal
+        return registry_->take(e, seq_);
+    }
+    return edges_.insert(e);
+}
+
+
+void
+Print3DExporter::writeEdge(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1)
+{
+    if (vd0.i != vd1.i) {
+        Edge e(vd0.i, vd1.i);
+        const PWGM_VERTDATA *ends = 0;
+        if ((0 != edgeFilter_) && !edgeFilter_->keeps(e)) {
+            // not inflated in this edge mode
+        }
+        else if ((0 != clip_) && !clip_->meets(vd0, vd1)) {
+            // outside the clip regions
+        }
+        else if (0 != edgeVisitor_) {
+            // scanning only
+            AllocPhase phase(AllocPhase::Dedup);
+            edgeVisitor_->visit(e);
+        }
+        else if (!isNewEdge(e)) {
+            // already written
+        }
+        else if ((0 != chains_) && !chains_->take(e, ends)) {
+            // written with the first edge of its chain
+        }
+        else if (0 != ends) {
+            // the whole chain
+            writeSegment(ends[0], ends[1]);
+        }
+        else {
+            writeSegment(vd0, vd1);
+        }
+    }
+}
+
+
+void
+Print3DExporter::writeSegment(const PWGM_VERTDATA &vd0,
+    const PWGM_VERTDATA &vd1)
+{
+    // A graph keeps the grid's vertices, so the edges that cross the clip
+    // regions are only trimmed when the cylinders are written directly.
+    PWGM_VERTDATA seg[2] = { vd0, vd1 };
+    if ((0 != clip_) && settings_.clipTrim && (0 == graph_) &&
+            !clip_->trim(vd0, vd1, seg)) {
+        // touches the regions in a point at most
+        return;
+    }
+    if (0 != graph_) {
+        // a chain is collected whole, and merged only by an ordered export
+        AllocPhase phase(AllocPhase::Dedup);
+        graph_->addEdge(vd0, vd1);
+    }
+    else if (0 != batch_) {
+        // made by a pipeline geometry thread
+        batch_->ops.push_back(2);
+        batch_->verts.push_back(seg[0]);
+        batch_->verts.push_back(seg[1]);
+    }
+    else {
+        writeCylinder(seg[0], seg[1]);
+    }
+}
+
+
+void
+Print3DExporter::writeOwnedEdge(const PWGM_VERTDATA &vd0,
+    const PWGM_VERTDATA &vd1)
+{
+    // an owned edge is unique, it only needs clipping
+    if ((0 == clip_) || clip_->meets(vd0, vd1)) {
+        writeSegment(vd0, vd1);
+    }
+}
+
+
+void
+Print3DExporter::writePolygon(const PWGM_VERTDATA &v0,
+    const PWGM_VERTDATA &v1, const PWGM_VERTDATA &v2, const PWGM_VERTDATA &v3)
+{
+    writeEdge(v0, v1);
+    writeEdge(v1, v2);
+    writeEdge(v2, v3);
+    writeEdge(v3, v0);
+}
+
+
+void
+Print3DExporter::writePolygon(const PWGM_VERTDATA &v0,
+    const PWGM_VERTDATA &v1, const PWGM_VERTDATA &v2)
+{
+    writeEdge(v0, v1);
+    writeEdge(v1, v2);
+    writeEdge(v2, v0);
+}
+
+
+void
+Print3DExporter::writeThickenedPolygon(const vector3 &tp0, const vector3 &tp1,
+    const vector3 &tp2)
+{
+    AllocPhase phase(AllocPhase::Geometry);
+    double halfThickness = radius_;
+    vector3 norm = cml::cross((tp1 - tp0), (tp2 - tp1)).normalize();
+    vector3 offset = norm * halfThickness;
+    // "thicken" by halfThickness to either side of tri pts
+    vector3 p0 = tp0 - offset;
+    vector3 p1 = tp1 - offset;
+    vector3 p2 = tp2 - offset;
+    vector3 p3 = tp0 + offset;
+    vector3 p4 = tp1 + offset;
+    vector3 p5 = tp2 + offset;
+    // In STL, the facet normal should be a unit vector pointing OUTWARDS from
+    // the solid object.
+    //
+    // we now have the 6 prism points - write out the solid
+    beginMultiSolid();
+    writeTriFacet(p0, p2, p1);
+    writeTriFacet(p3, p4, p5);
+    writeQuadFacet(p0, p1, p4, p3);
+    writeQuadFacet(p1, p2, p5, p4);
+    writeQuadFacet(p2, p0, p3, p5);
+    endMultiSolid();
+}
+
+
+void
+Print3DExporter::writeThickenedPolygon(const PWGM_VERTDATA &vd0,
+    const PWGM_VERTDATA &vd1, const PWGM_VERTDATA &vd2)
+{
+    if (0 != batch_) {
+        // made by a pipeline geometry thread
+        batch_->ops.push_back(3);
+        batch_->verts.push_back(vd0);
+        batch_->verts.push_back(vd1);
+        batch_->verts.push_back(vd2);
+        return;
+    }
+    vector3 p0(vd0.x, vd0.y, vd0.z);
+    vector3 p1(vd1.x, vd1.y, vd1.z);
+    vector3 p2(vd2.x, vd2.y, vd2.z);
+    writeThickenedPolygon(p0, p1, p2);
+}
+
+
+void
+Print3DExporter::writeThickenedPolygon(const vector3 &qp0, const vector3 &qp1,
+    const vector3 &qp2, const vector3 &qp3)
+{
+    AllocPhase phase(AllocPhase::Geometry);
+    vector3 norm0 = cml::cross((qp1 - qp0), (qp2 - qp0)).normalize();
+    vector3 norm1 = cml::cross((qp2 - qp0), (qp3 - qp0)).normalize();
+    vector3 normSeam = (norm0 + norm1).normalize(); // diag seam normal
+    // thicken this amount to either side of tri
+    double halfThickness = radius_;
+    // Account for non-planar quad to make thickness uniform
+    // dot(norm0, normSeam) == dot(norm1, normSeam) == cos(angle). Where,
+    // angle (in radians) is between norm0/norm1 and normSeam.
+    // For a right-triangle: cos(angle) = opp / hyp
+    // Hence: hyp = opp / cos(angle)
+    // For this geometry, seamThickness == hyp
+    double seamThickness = halfThickness / dot(norm0, normSeam);
+    vector3 offset0 = norm0 * halfThickness;
+    vector3 offset1 = norm1 * halfThickness;
+    vector3 offsetSeam = normSeam * seamThickness;
+    // hex base pts
+    vector3 p0 = qp0 - offsetSeam;
+    vector3 p1 = qp1 - offset0;
+    vector3 p2 = qp2 - offsetSeam;
+    vector3 p3 = qp3 - offset1;
+    // hex top pts
+    vector3 p4 = qp0 + offsetSeam;
+    vector3 p5 = qp1 + offset0;
+    vector3 p6 = qp2 + offsetSeam;
+    vector3 p7 = qp3 + offset1;
+    // In STL, the facet normal should be a unit vector pointing OUTWARDS from
+    // the solid object.
+    // we now have the 8 hex points - write out the solid
+    beginMultiSolid();
+    writeQuadFacet(p0, p3, p2, p1);
+    writeQuadFacet(p4, p5, p6, p7);
+    writeQuadFacet(p0, p1, p5, p4);
+    writeQuadFacet(p1, p2, p6, p5);
+    writeQuadFacet(p2, p3, p7, p6);
+    writeQuadFacet(p3, p0, p4, p7);
+    endMultiSolid();
+}
+
+
+void
+Print3DExporter::writeThickenedPolygon(const PWGM_VERTDATA &vd0,
+    const PWGM_VERTDATA &vd1, const PWGM_VERTDATA &vd2,
+    const PWGM_VERTDATA &vd3)
+{
+    if (0 != batch_) {
+        // made by a pipeline geometry thread
+        batch_->ops.push_back(4);
+        batch_->verts.push_back(vd0);
+        batch_->verts.push_back(vd1);
+        batch_->verts.push_back(vd2);
+        batch_->verts.push_back(vd3);
+        return;
+    }
+    vector3 p0(vd0.x, vd0.y, vd0.z);
+    vector3 p1(vd1.x, vd1.y, vd1.z);
+    vector3 p2(vd2.x, vd2.y, vd2.z);
+    vector3 p3(vd3.x, vd3.y, vd3.z);
+    writeThickenedPolygon(p0, p1, p2, p3);
+}
+
+
+void
+Print3DExporter::writeElemData(const Print3DElem &ed, bool solid)
+{
+    // a collected edge graph has no thickened elements, and those outside
+    // the clip regions are dropped whole
+    solid = solid && (0 == graph_) && ((0 == clip_) || clip_->meets(ed));
+    switch (ed.type) {
+        case PWGM_ELEMTYPE_POINT:
+        default:
+            break;
+        case PWGM_ELEMTYPE_BAR:
+            writeEdge(ed.vert[0], ed.vert[1]);
+            break;
+        case PWGM_ELEMTYPE_QUAD:
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2], ed.vert[3]);
+            if (solid) {
+                writeThickenedPolygon(ed.vert[0], ed.vert[1], ed.vert[2],
+                    ed.vert[3]);
+            }
+            break;
+        case PWGM_ELEMTYPE_TRI:
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2]);
+            if (solid) {
+                writeThickenedPolygon(ed.vert[0], ed.vert[1],
+                    ed.vert[2]);
+            }
+            break;
+        case PWGM_ELEMTYPE_HEX:
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2], ed.vert[3]);
+            writePolygon(ed.vert[4], ed.vert[5], ed.vert[6], ed.vert[7]);
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[5], ed.vert[4]);
+            writePolygon(ed.vert[1], ed.vert[2], ed.vert[6], ed.vert[5]);
+            writePolygon(ed.vert[2], ed.vert[3], ed.vert[7], ed.vert[6]);
+            writePolygon(ed.vert[3], ed.vert[0], ed.vert[4], ed.vert[7]);
+            break;
+        case PWGM_ELEMTYPE_TET:
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2]);
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[3]);
+            writePolygon(ed.vert[1], ed.vert[2], ed.vert[3]);
+            writePolygon(ed.vert[2], ed.vert[0], ed.vert[3]);
+            break;
+        case PWGM_ELEMTYPE_WEDGE:
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2]);
+            writePolygon(ed.vert[3], ed.vert[4], ed.vert[5]);
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[4], ed.vert[3]);
+            writePolygon(ed.vert[1], ed.vert[2], ed.vert[5], ed.vert[4]);
+            writePolygon(ed.vert[2], ed.vert[0], ed.vert[3], ed.vert[5]);
+            break;
+        case PWGM_ELEMTYPE_PYRAMID:
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[2], ed.vert[3]);
+            writePolygon(ed.vert[0], ed.vert[1], ed.vert[4]);
+            writePolygon(ed.vert[1], ed.vert[2], ed.vert[4]);
+            writePolygon(ed.vert[2], ed.vert[3], ed.vert[4]);
+            writePolygon(ed.vert[3], ed.vert[0], ed.vert[4]);
+            break;
+    }
+}
+
+
+void
+Print3DExporter::hashElemData(TessHash &hash, const Print3DElem &ed) const
+{
+    hash.add((PWP_UINT32)ed.type);
+    for (PWP_UINT32 ii = 0; ii < ed.vertCnt; ++ii) {
+        hash.add(ed.vert[ii].i);
+        hash.add(ed.vert[ii].x);
+        hash.add(ed.vert[ii].y);
+        hash.add(ed.vert[ii].z);
+    }
+}
+
+
+bool
+Print3DExporter::scanEntity(PWP_UINT32 ndx, EdgeVisitor &visitor,
+    TessHash *hash)
+{
+    // visit the entity's edges without writing anything
+    Print3DElem eData;
+    const PWP_UINT32 numElems = model_->elementCount(ndx);
+    edgeVisitor_ = &visitor;
+    for (PWP_UINT32 ii = 0; ii < numElems; ++ii) {
+        if (!model_->elementData(ndx, ii, eData) || !progressIncrement()) {
+            break;
+        }
+        if (0 != hash) {
+            hashElemData(*hash, eData);
+        }
+        writeElemData(eData);
+    }
+    edgeVisitor_ = 0;
+    return !aborted();
+}
+
+
+bool
+Print3DExporter::scanEntities(PWP_UINT32 first, PWP_UINT32 end,
+    EdgeVisitor &visitor)
+{
+    for (PWP_UINT32 ndx = first; ndx < end; ++ndx) {
+        if ((Print3DCondHidden != model_->condition(ndx)) &&
+                !scanEntity(ndx, visitor)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+PWP_UINT32
+Print3DExporter::countElements(PWP_UINT32 first, PWP_UINT32 end,
+    bool blocks) const
+{
+    // count the elements of the visible patches or blocks in [first, end)
+    PWP_UINT32 ret = 0;
+    for (PWP_UINT32 ndx = first; ndx < end; ++ndx) {
+        if ((blocks == model_->isBlock(ndx)) &&
+                (Print3DCondHidden != model_->condition(ndx))) {
+            ret += model_->elementCount(ndx);
+        }
+    }
+    return ret;
+}
+
+
+bool
+Print3DExporter::writeCachedEntity(PWP_UINT32 ndx)
+{
+    // Pass 1: hash the entity's content and claim the edges it will own.
+    // Ownership depends on the entities written before this one. Hashing
+    // the owned edges makes a cached chunk valid only if it still writes
+    // exactly the same set of cylinders.
+    const bool solid = (Print3DCondSolid == model_->condition(ndx));
+    TessHash hash;
+    hash.add((PWP_UINT32)(model_->isBlock(ndx) ? 1 : 0));
+    hash.add((PWP_UINT32)(solid ? 1 : 0));
+    hash.add((PWP_UINT32)(isBinaryEncoding() ? 1 : 0));
+    hash.add((PWP_UINT32)(multiSolid_ ? 1 : 0));
+    hash.add(radius_);
+    hash.add((PWP_UINT32)numBasePts_);
+    if (0.0 != ringStep_) {
+        // the cylinders are quantized
+        hash.add(ringStep_);
+    }
+    if (multiSolid_) {
+        // solid names and ids are numbered
+        hash.add((PWP_UINT32)settings_.solidScope);
+        hash.add((PWP_UINT32)settings_.solidIds);
+        hash.add((PWP_UINT32)(renumbersParts() ? 1 : 0));
+        hash.add(numSolids_);
+        hash.add(ndx);
+    }
+    std::vector<Edge> owned;
+    ClaimNewEdges claim(edges_, owned);
+    if (!scanEntity(ndx, claim, &hash)) {
+        return false;
+    }
+    std::vector<Edge>::const_iterator it;
+    for (it = owned.begin(); it != owned.end(); ++it) {
+        hash.add(it->i0());
+        hash.add(it->i1());
+    }
+
+    const PWP_UINT64 key = hash.value();
+    const TessEntry *entry = cache_.find(key);
+    if (0 != entry) {
+        // Pass 2: splice the cached facets, a block at a time. The owned
+        // edges were registered by pass 1.
+        char buf[16 * 1024];
+        PWP_UINT64 left = entry->size;
+        bool ok = cache_.beginRead(*entry);
+        while (ok && (left > 0)) {
+            const size_t size = (left < sizeof(buf)) ? (size_t)left :
+                sizeof(buf);
+            ok = cache_.read(buf, size);
+            if (ok) {
+                writeBytes(buf, size);
+            }
+            left -= size;
+        }
+        if (!ok) {
+            host_.sendErrorMsg("Could not read the tessellation cache");
+            return false;
+        }
+        numTris_ += entry->numTris;
+        numSolids_ += entry->numSolids;
+    }
+    else {
+        // Pass 2: release the claimed edges and regenerate while capturing
+        // the facet stream
+        for (it = owned.begin(); it != owned.end(); ++it) {
+            edges_.erase(*it);
+        }
+        cache_.beginChunk(key);
+        const PWP_UINT32 numTris = numTris_;
+        const PWP_UINT32 numSolids = numSolids_;
+        Print3DElem eData;
+        const PWP_UINT32 numElems = model_->elementCount(ndx);
+        for (PWP_UINT32 ii = 0; ii < numElems; ++ii) {
+            if (aborted() || !model_->elementData(ndx, ii, eData)) {
+                break;
+            }
+            writeElemData(eData, solid);
+        }
+        cache_.endChunk(numTris_ - numTris, numSolids_ - numSolids);
+    }
+    return !aborted();
+}
+
+
+bool
+Print3DExporter::hasOwnedEdges() const
+{
+    // The model's edges replace the element traversal only if nothing
+    // else depends on the elements. A solid entity interleaves the
+    // thickened elements with the cylinders, and an edge mode filters the
+    // elements' edges. A chain is written at the first of its edges met
+    // by the element traversal.
+    if (useCache_ || (settings_.numParts > 1) || settings_.mergeParts ||
+            (Print3DEdgesAll != settings_.edgeMode) || usesChains(settings_)) {
+        return false;
+    }
+    const PWP_UINT32 numEntities = model_->entityCount();
+    const PWP_UINT32 *verts;
+    PWP_UINT32 count;
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        const Print3DCond cond = model_->condition(ndx);
+        if ((Print3DCondSolid == cond) || ((Print3DCondHidden != cond) &&
+                !model_->ownedEdges(ndx, verts, count))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool
+Print3DExporter::writeOwnedEdges(PWP_UINT32 ndx)
+{
+    // The elements are only counted for the progress. It advances in
+    // proportion to the edges written.
+    const PWP_UINT32 *verts = 0;
+    PWP_UINT32 numEdges = 0;
+    if (!model_->ownedEdges(ndx, verts, numEdges)) {
+        return false;
+    }
+    const PWP_UINT64 numElems = model_->elementCount(ndx);
+    PWP_UINT64 done = 0;
+    PWGM_VERTDATA vd0;
+    PWGM_VERTDATA vd1;
+    bool ok = true;
+    for (PWP_UINT32 ii = 0; ok && (ii < numEdges); ++ii) {
+        if (!model_->vertexData(verts[2 * ii], vd0) ||
+                !model_->vertexData(verts[2 * ii + 1], vd1)) {
+            host_.sendErrorMsg("Bad edge vertex in the grid model");
+            return false;
+        }
+        writeOwnedEdge(vd0, vd1);
+        const PWP_UINT64 target = (ii + 1) * numElems / numEdges;
+        for (; ok && (done < target); ++done) {
+            ok = progressIncrement();
+        }
+    }
+    for (; ok && (done < numElems); ++done) {
+        ok = progressIncrement();
+    }
+    return !aborted();
+}
+
+
+bool
+Print3DExporter::inPartition(PWP_UINT32 entityNdx) const
+{
+    return (settings_.numParts < 2) ||
+        ((entityNdx >= partFirst_) && (entityNdx < partEnd_));
+}
+
+
+void
+Print3DExporter::initPartition()
+{
+    // Split the patches and blocks into settings_.numParts contiguous runs
+    // of about the same element count. Entity i goes to the rank containing
+    // its first element. Every rank computes the same split.
+    std::vector<PWP_UINT32> counts;
+    PWP_UINT64 total = 0;
+    const PWP_UINT32 numEntities = model_->entityCount();
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        counts.push_back((Print3DCondHidden == model_->condition(ndx)) ? 0 :
+            model_->elementCount(ndx));
+        total += counts.back();
+    }
+    partFirst_ = (PWP_UINT32)counts.size();
+    partEnd_ = partFirst_;
+    PWP_UINT64 cum = 0;
+    for (PWP_UINT32 ii = 0; ii < (PWP_UINT32)counts.size(); ++ii) {
+        PWP_UINT64 rank = (0 == total) ? 0 : (cum * settings_.numParts) / total;
+        if (rank == settings_.partRank) {
+            if (partFirst_ == partEnd_) {
+                partFirst_ = ii;
+            }
+            partEnd_ = ii + 1;
+        }
+        cum += counts[ii];
+    }
+}
+
+
+void
+Print3DExporter::seedPartitionEdges()
+{
+    // An edge on a partition boundary is owned by the lowest rank that
+    // contains it, just as the first entity containing an edge writes it in
+    // a serial export. Collect this partition's edges, then register the
+    // ones that also appear in the lower ranks' entities as already written.
+    // Memory stays proportional to the size of this partition.
+    if (aborted()) {
+        return;
+    }
+    const PWP_UINT32 steps = countElements(0, partEnd_, false) +
+        countElements(0, partEnd_, true);
+    if (progressBeginStep(steps)) {
+        EdgeTable mine;
+        CollectEdges collect(mine);
+        SeedSharedEdges seed(mine, edges_);
+        if (scanEntities(partFirst_, partEnd_, collect)) {
+            scanEntities(0, partFirst_, seed);
+        }
+        progressEndStep();
+    }
+}
+
+
+bool
+Print3DExporter::mergePartitions()
+{
+    // Append the parts written by ranks 0..settings_.numParts-1 to the
+    // final file. writeFooter() patches the binary triangle count.
+    bool ret = progressBeginStep(settings_.numParts);
+    const bool stripSolid = !multiSolid_;
+    const PartSolidAttr attr(settings_.solidIds);
+    const StlSolidAttr *renumber = renumbersParts() ? &attr : 0;
+    PWP_UINT32 numSolids = 0;
+    for (PWP_UINT32 ii = 0; ret && (ii < settings_.numParts); ++ii) {
+        const std::string path = stlPartPath(settings_.destPath, ii);
+        if (!stlAppendPart(path, fp(), isBinaryEncoding(), stripSolid,
+                numTris_, renumber, numSolids)) {
+            std::string msg("Could not merge partition file ");
+            host_.sendErrorMsg((msg + path).c_str());
+            ret = false;
+        }
+        else {
+            ret = progressIncrement();
+        }
+    }
+    progressEndStep();
+    return ret;
+}
+
+
+void
+Print3DExporter::write3mfHeader()
+{
+    // A 3MF file is a zip package. The model part defines the cylinder mesh
+    // once as object 1. Each patch and block becomes an object whose
+    // components place object 1 along the entity's edges. A beam lattice
+    // has no cylinder mesh, writeBeamLattice() writes its only object.
+    zip_ = new ZipWriter(fp());
+    zip_->addFile("[Content_Types].xml", ContentTypesXml,
+        sizeof(ContentTypesXml) - 1);
+    zip_->addFile("_rels/.rels", RelsXml, sizeof(RelsXml) - 1);
+    zip_->beginFile(ModelPartName);
+    writeText("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    if (settings_.beamLattice) {
+        writeText("<model unit=\"millimeter\" xml:lang=\"en-US\" "
+            "xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/"
+            "2015/02\" xmlns:b=\"http://schemas.microsoft.com/"
+            "3dmanufacturing/beamlattice/2017/02\" "
+            "requiredextensions=\"b\">\n");
+        writeText("<resources>\n");
+        return;
+    }
+    writeText("<model unit=\"millimeter\" xml:lang=\"en-US\" "
+        "xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/"
+        "2015/02\">\n");
+    writeText("<resources>\n");
+
+    // The unit cylinder has its base at z=0 and its top at z=1. The
+    // triangles follow writeCylBase() and writeCylSides().
+    const int Prec = 9;
+    const PWP_UINT n = numBasePts_;
+    PWP_UINT ii;
+    writeText("<object id=\"%lu\" type=\"model\" name=\"edge\">\n",
+        (unsigned long)CylinderObjectId);
+    writeText("<mesh>\n<vertices>\n");
+    for (int z = 0; z < 2; ++z) {
+        for (ii = 0; ii < n; ++ii) {
+            writeText("<vertex x=\"%.*g\" y=\"%.*g\" z=\"%d\"/>\n",
+                Prec, roundZero(masterCylBase_[ii][0]),
+                Prec, roundZero(masterCylBase_[ii][1]), z);
+        }
+    }
+    writeText("</vertices>\n<triangles>\n");
+    const char *TriFmt = "<triangle v1=\"%u\" v2=\"%u\" v3=\"%u\"/>\n";
+    for (ii = 1; ii < n - 1; ++ii) {
+        writeText(TriFmt, 0, ii + 1, ii);
+        writeText(TriFmt, n, n + ii, n + ii + 1);
+    }
+    for (ii = 0; ii < n; ++ii) {
+        const PWP_UINT jj = (ii + 1) % n;
+        writeText(TriFmt, n + ii, ii, jj);
+        writeText(TriFmt, n + ii, jj, n + jj);
+    }
+    writeText("</triangles>\n</mesh>\n</object>\n");
+    numObjects_ = CylinderObjectId;
+}
+
+
+bool
+Print3DExporter::write3mfFooter()
+{
+    end3mfObject();
+    if (!meshVerts_.empty()) {
+        // the thickened elements of all solid entities
+        const int Prec = 9;
+        const unsigned long id = ++numObjects_;
+        writeText("<object id=\"%lu\" type=\"model\" name=\"solid\">\n", id);
+        writeText("<mesh>\n<vertices>\n");
+        size_t ii;
+        for (ii = 0; ii < meshVerts_.size(); ++ii) {
+            const vector3 &v = meshVerts_[ii];
+            writeText("<vertex x=\"%.*g\" y=\"%.*g\" z=\"%.*g\"/>\n",
+                Prec, roundZero(v[0]), Prec, roundZero(v[1]),
+                Prec, roundZero(v[2]));
+        }
+        writeText("</vertices>\n<triangles>\n");
+        for (ii = 0; ii < meshVerts_.size(); ii += 3) {
+            writeText("<triangle v1=\"%lu\" v2=\"%lu\" v3=\"%lu\"/>\n",
+                (unsigned long)ii, (unsigned long)ii + 1,
+                (unsigned long)ii + 2);
+        }
+        writeText("</triangles>\n</mesh>\n</object>\n");
+        char buf[64];
+        sprintf(buf, "<item objectid=\"%lu\"/>\n", id);
+        buildItems_ += buf;
+    }
+    writeText("</resources>\n<build>\n");
+    writeBytes(buildItems_.data(), buildItems_.size());
+    writeText("</build>\n</model>\n");
+    bool ret = zip_->endFile() && zip_->finish();
+    delete zip_;
+    zip_ = 0;
+    return ret;
+}
+
+
+void
+Print3DExporter::begin3mfObject()
+{
+    // opened on the entity's first edge so that no object is empty
+    if (!objectOpen_) {
+        const unsigned long id = ++numObjects_;
+        writeText("<object id=\"%lu\" type=\"model\" name=\"%s\">\n", id,
+            xmlEscape(model_->entityName(curEntity_)).c_str());
+        writeText("<components>\n");
+        char buf[64];
+        sprintf(buf, "<item objectid=\"%lu\"/>\n", id);
+        buildItems_ += buf;
+        objectOpen_ = true;
+    }
+}
+
+
+void
+Print3DExporter::end3mfObject()
+{
+    if (objectOpen_) {
+        writeText("</components>\n</object>\n");
+        objectOpen_ = false;
+    }
+}
+
+
+void
+Print3DExporter::write3mfComponent(const matrix33 &rot, const vector3 &tran,
+    double len)
+{
+    // 3MF transforms row vectors like CML's v * m. Row 2 maps the unit
+    // cylinder's z axis, scale it to the length of the edge.
+    const int Prec = 9;
+    begin3mfObject();
+    writeText("<component objectid=\"%lu\" transform=\""
+        "%.*g %.*g %.*g %.*g %.*g %.*g %.*g %.*g %.*g %.*g %.*g %.*g\"/>\n",
+        (unsigned long)CylinderObjectId,
+        Prec, roundZero(rot(0, 0)), Prec, roundZero(rot(0, 1)),
+        Prec, roundZero(rot(0, 2)),
+        Prec, roundZero(rot(1, 0)), Prec, roundZero(rot(1, 1)),
+        Prec, roundZero(rot(1, 2)),
+        Prec, roundZero(len * rot(2, 0)), Prec, roundZero(len * rot(2, 1)),
+        Prec, roundZero(len * rot(2, 2)),
+        Prec, roundZero(tran[0]), Prec, roundZero(tran[1]),
+        Prec, roundZero(tran[2]));
+    numTris_ += 4 * numBasePts_ - 4;
+}
+
+
+void
+Print3DExporter::warnSolidCondition(const char *mode)
+{
+    // the edge graph has no thickened elements
+    const PWP_UINT32 numEntities = model_->entityCount();
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        if (Print3DCondSolid == model_->condition(ndx)) {
+            char msg[128];
+            sprintf(msg, "%s ignores the solid condition", mode);
+            host_.sendWarningMsg(msg);
+            break;
+        }
+    }
+}
+
+
+void
+Print3DExporter::writeSdfUnion()
+{
+    // Replace the collected edges by the surface of their union. The
+    // tiles are meshed in parallel, a batch at a time, and written in
+    // tile order so that the output does not depend on the thread count.
+    if (aborted()) {
+        return;
+    }
+    warnSolidCondition("SdfUnion");
+    const double spacing = settings_.diameter / settings_.sdfResolution;
+    SdfMesher mesher(*graph_, radius_, spacing);
+    const PWP_UINT32 numTiles = mesher.build();
+    WorkerPool pool(settings_.numThreads);
+    const PWP_UINT32 numTris = numTris_;
+    if (progressBeginStep(numTiles)) {
+        const PWP_UINT32 batch = 16 * pool.threadCount();
+        std::vector< std::vector<double> > tris;
+        bool ok = true;
+        for (PWP_UINT32 first = 0; ok && (first < numTiles); first += batch) {
+            const PWP_UINT32 cnt = (numTiles - first < batch) ?
+                (numTiles - first) : batch;
+            mesher.mesh(pool, first, cnt, tris);
+            for (PWP_UINT32 ii = 0; ok && (ii < cnt); ++ii) {
+                const std::vector<double> &t = tris[ii];
+                for (size_t jj = 0; jj + 8 < t.size(); jj += 9) {
+                    writeTriFacet(vector3(t[jj], t[jj + 1], t[jj + 2]),
+                        vector3(t[jj + 3], t[jj + 4], t[jj + 5]),
+                        vector3(t[jj + 6], t[jj + 7], t[jj + 8]));
+                }
+                ok = progressIncrement();
+            }
+        }
+        progressEndStep();
+    }
+    char msg[256];
+    sprintf(msg, "SdfUnion: %lu edges, %lu tiles, %lu triangles, "
+        "spacing %g, %lu threads", (unsigned long)graph_->edgeCount(),
+        (unsigned long)numTiles, (unsigned long)(numTris_ - numTris),
+        spacing, (unsigned long)pool.threadCount());
+    host_.sendInfoMsg(msg);
+}
+
+
+bool
+Print3DExporter::writeHubLattice()
+{
+    // Replace the collected edges by struts joined at convex hubs. The
+    // chunks of vertices are meshed in parallel, a batch at a time, and
+    // written in chunk order like the tiles of writeSdfUnion(). Returns
+    // false if aborted.
+    if (aborted()) {
+        return false;
+    }
+    warnSolidCondition("HubLattice");
+    HubMesher mesher(*graph_, radius_, numBasePts_);
+    const PWP_UINT32 numChunks = mesher.build();
+    char msg[256];
+    WorkerPool pool(settings_.numThreads);
+    const PWP_UINT32 numTris = numTris_;
+    if (progressBeginStep(numChunks)) {
+        const PWP_UINT32 batch = 16 * pool.threadCount();
+        std::vector< std::vector<double> > tris;
+        bool ok = true;
+        for (PWP_UINT32 first = 0; ok && (first < numChunks); first += batch) {
+            const PWP_UINT32 cnt = (numChunks - first < batch) ?
+                (numChunks - first) : batch;
+            mesher.mesh(pool, first, cnt, tris);
+            for (PWP_UINT32 ii = 0; ok && (ii < cnt); ++ii) {
+                const std::vector<double> &t = tris[ii];
+                for (size_t jj = 0; jj + 8 < t.size(); jj += 9) {
+                    writeTriFacet(vector3(t[jj], t[jj + 1], t[jj + 2]),
+                        vector3(t[jj + 3], t[jj + 4], t[jj + 5]),
+                        vector3(t[jj + 6], t[jj + 7], t[jj + 8]));
+                }
+                ok = progressIncrement();
+            }
+        }
+        progressEndStep();
+    }
+    sprintf(msg, "HubLattice: %lu nodes, %lu struts, %lu triangles, "
+        "%lu threads", (unsigned long)graph_->vertexCount(),
+        (unsigned long)(graph_->edgeCount() - mesher.shortStrutCount()),
+        (unsigned long)(numTris_ - numTris),
+        (unsigned long)pool.threadCount());
+    host_.sendInfoMsg(msg);
+    if (mesher.shortStrutCount() > 0) {
+        sprintf(msg, "HubLattice: skipped %lu edges of no length between "
+            "coincident vertices. Set WeldVertices to merge them.",
+            (unsigned long)mesher.shortStrutCount());
+        host_.sendWarningMsg(msg);
+    }
+    if (mesher.narrowHubCount() > 0) {
+        sprintf(msg, "HubLattice: the struts are narrower than EdgeDiameter "
+            "at %lu nodes, whose hubs would not fit on their edges",
+            (unsigned long)mesher.narrowHubCount());
+        host_.sendWarningMsg(msg);
+    }
+    if (mesher.badHubCount() > 0) {
+        sprintf(msg, "HubLattice: %lu hubs are not convex around their "
+            "struts, the surface is not a valid solid there. Reduce "
+            "EdgeDiameter.", (unsigned long)mesher.badHubCount());
+        host_.sendWarningMsg(msg);
+    }
+    return !aborted();
+}
+
+
+void
+Print3DExporter::writeBeamLattice()
+{
+    // Replace the collected edges by one mesh object whose beams join the
+    // edges' vertices, all of radius_, with no triangles. The receiving
+    // software tessellates the beams at its own resolution.
+    if (aborted() || (0 == graph_->edgeCount())) {
+        return;
+    }
+    warnSolidCondition("Beam lattice export");
+    const int Prec = 9;
+    const PWP_UINT32 numVerts = graph_->vertexCount();
+    const PWP_UINT32 numEdges = graph_->edgeCount();
+    const unsigned long id = ++numObjects_;
+    writeText("<object id=\"%lu\" type=\"model\" name=\"lattice\">\n", id);
+    writeText("<mesh>\n<vertices>\n");
+    if (progressBeginStep(numVerts + numEdges)) {
+        bool ok = true;
+        PWP_UINT32 ii;
+        for (ii = 0; ok && (ii < numVerts); ++ii) {
+            const double *xyz = graph_->xyz(ii);
+            writeText("<vertex x=\"%.*g\" y=\"%.*g\" z=\"%.*g\"/>\n",
+                Prec, roundZero(xyz[0]), Prec, roundZero(xyz[1]),
+                Prec, roundZero(xyz[2]));
+            ok = progressIncrement();
+        }
+        // the beams' ends are capped with spheres, as the cylinders of a
+        // tessellated export overlap at the vertices
+        writeText("</vertices>\n<triangles>\n</triangles>\n");
+        writeText("<b:beamlattice radius=\"%.*g\" minlength=\"%.*g\" "
+            "cap=\"sphere\">\n<b:beams>\n", Prec, radius_, Prec,
+            BeamMinLength * radius_);
+        for (ii = 0; ok && (ii < numEdges); ++ii) {
+            writeText("<b:beam v1=\"%lu\" v2=\"%lu\"/>\n",
+                (unsigned long)graph_->edgeVert(ii, 0),
+                (unsigned long)graph_->edgeVert(ii, 1));
+            ok = progressIncrement();
+        }
+        progressEndStep();
+    }
+    writeText("</b:beams>\n</b:beamlattice>\n</mesh>\n</object>\n");
+    char buf[64];
+    sprintf(buf, "<item objectid=\"%lu\"/>\n", id);
+    buildItems_ += buf;
+    char msg[128];
+    sprintf(msg, "Beam lattice: %lu vertices, %lu beams, radius %g",
+        (unsigned long)numVerts, (unsigned long)numEdges, radius_);
+    host_.sendInfoMsg(msg);
+}
+
+
+void
+Print3DExporter::writeLayerSlices()
+{
+    // Write the outline of each layer as Common Layer Interface polylines.
+    // The layers are sliced in parallel, a batch at a time, and written in
+    // order. The header needs the layer count, so it is written here.
+    if (aborted()) {
+        return;
+    }
+    warnSolidCondition("Slice export");
+    const int Prec = 8;
+    LayerSlicer slicer(*graph_, radius_, settings_.sliceThickness);
+    const PWP_UINT32 numLayers = slicer.build();
+    writeText("$$HEADERSTART\n$$ASCII\n$$UNITS/1\n$$VERSION/200\n");
+    writeText("$$LABEL/1,%s\n$$LAYERS/%lu\n$$HEADEREND\n", SolidName,
+        (unsigned long)numLayers);
+    writeText("$$GEOMETRYSTART\n");
+    WorkerPool pool(settings_.numThreads);
+    PWP_UINT32 numLoops = 0;
+    if (progressBeginStep(numLayers)) {
+        const PWP_UINT32 batch = 4 * pool.threadCount();
+        std::vector<LayerSlicer::Loops> loops;
+        bool ok = true;
+        for (PWP_UINT32 first = 0; ok && (first < numLayers); first += batch) {
+            const PWP_UINT32 cnt = (numLayers - first < batch) ?
+                (numLayers - first) : batch;
+            slicer.slice(pool, first, cnt, loops);
+            for (PWP_UINT32 ii = 0; ok && (ii < cnt); ++ii) {
+                writeText("$$LAYER/%.*g\n", Prec,
+                    roundZero(slicer.layerTop(first + ii)));
+                for (size_t jj = 0; jj < loops[ii].size(); ++jj) {
+                    writeCliPolyline(loops[ii][jj]);
+                    ++numLoops;
+                }
+                ok = progressIncrement();
+            }
+        }
+        progressEndStep();
+    }
+    if (slicer.openCount() > 0) {
+        host_.sendWarningMsg("Some slice outlines could not be closed");
+    }
+    char msg[256];
+    sprintf(msg, "Slices: %lu edges, %lu layers of %g, %lu outlines, "
+        "%lu threads", (unsigned long)graph_->edgeCount(),
+        (unsigned long)numLayers, settings_.sliceThickness,
+        (unsigned long)numLoops, (unsigned long)pool.threadCount());
+    host_.sendInfoMsg(msg);
+}
+
+
+void
+Print3DExporter::writeCliPolyline(const std::vector<double> &loop)
+{
+    // A closed polyline repeats its first point. Direction 1 is an outer,
+    // counter-clockwise outline and 0 a clockwise hole.
+    const int Prec = 8;
+    const size_t n = loop.size() / 2;
+    double area = 0;
+    size_t ii;
+    for (ii = 0; ii < n; ++ii) {
+        const size_t next = (ii + 1) % n;
+        area += loop[2 * ii] * loop[2 * next + 1] -
+            loop[2 * next] * loop[2 * ii + 1];
+    }
+    writeText("$$POLYLINE/1,%d,%lu", (area > 0) ? 1 : 0,
+        (unsigned long)(n + 1));
+    for (ii = 0; ii <= n; ++ii) {
+        writeText(",%.*g,%.*g", Prec, roundZero(loop[2 * (ii % n)]), Prec,
+            roundZero(loop[2 * (ii % n) + 1]));
+    }
+    writeText("\n");
+}
+
+
+void
+Print3DExporter::writeHeader()
+{
+    if (is3mf()) {
+        write3mfHeader();
+    }
+    else if (isCli()) {
+        // written by writeLayerSlices() once the layer count is known
+    }
+    else if (isBinaryEncoding()) {
+        // fill with zeros
+        memset(curSolidName_, 0, NameBufSize);
+        strcpy(curSolidName_, SolidName);
+        if (multiSolid_ && (Print3DSolidIdMagics == settings_.solidIds)) {
+            // Magics reads the default RGBA color of the facets that have
+            // no color of their own from the header
+            const char MagicsColor[] = "COLOR=\xc0\xc0\xc0\xff";
+            memcpy(curSolidName_ + 40, MagicsColor, sizeof(MagicsColor) - 1);
+        }
+        pwpFileWrite(curSolidName_, 1, 80, fp());
+        pwpFileGetpos(fp(), &numTrisPos_);
+        // write placeholder - writeFooter() will replace with final value
+        numTris_ = 0;
+        pwpFileWrite(&numTris_, sizeof(numTris_), 1, fp());
+    }
+    else if (!multiSolid_) {
+        // ASCII
+        strcpy(curSolidName_, SolidName);
+        writeStr("solid %s\n", curSolidName_);
+    }
+}
+
+
+bool
+Print3DExporter::writeFooter()
+{
+    bool ret = true;
+    if (is3mf()) {
+        ret = write3mfFooter();
+    }
+    else if (isCli()) {
+        writeText("$$GEOMETRYEND\n");
+    }
+    else if (isBinaryEncoding()) {
+        // update placeholder with actual tri count
+        ret = (0 == pwpFileSetpos(fp(), &numTrisPos_)) &&
+            (1 == pwpFileWrite(&numTris_, sizeof(numTris_), 1, fp()));
+    }
+    else if (!multiSolid_) {
+        // ASCII
+        writeStr("endsolid %s\n", curSolidName_);
+    }
+    return ret;
+}
+
+
+void
+Print3DExporter::reportRings()
+{
+    if ((0 == numRings_) || aborted()) {
+        return;
+    }
+    char msg[128];
+    sprintf(msg, "Direction cache: %lu of %lu cylinder rings reused (%.1f%%)",
+        (unsigned long)numRingHits_, (unsigned long)numRings_,
+        100.0 * numRingHits_ / numRings_);
+    host_.sendInfoMsg(msg);
+}
+
+
+bool
+Print3DExporter::collectEdges(EdgeGraph &graph, std::vector<PWP_UINT32> &ends)
+{
+    const PWP_UINT32 numEntities = model_->entityCount();
+    ends.clear();
+    graph_ = &graph;
+    if (progressBeginStep(countElements(0, numEntities, false) +
+            countElements(0, numEntities, true))) {
+        Print3DElem eData;
+        for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+            const PWP_UINT32 numElems =
+                (Print3DCondHidden == model_->condition(ndx)) ? 0 :
+                model_->elementCount(ndx);
+            for (PWP_UINT32 ii = 0; ii < numElems; ++ii) {
+                if (!model_->elementData(ndx, ii, eData) ||
+                        !progressIncrement()) {
+                    break;
+                }
+                writeElemData(eData);
+            }
+            ends.push_back(graph.edgeCount());
+        }
+        progressEndStep();
+    }
+    graph_ = 0;
+    return !aborted() && (numEntities == ends.size());
+}
+
+
+bool
+Print3DExporter::buildClip()
+{
+    // The culled entities are hidden from every later pass, the welding
+    // and the edge ownership included.
+    clip_ = new ClippedModel(*model_);
+    if (!clip_->addBoxes(settings_.clipBoxes)) {
+        host_.sendErrorMsg("ClipBoxes must be lists of six numbers, "
+            "minimum then maximum");
+        return false;
+    }
+    if (!clip_->addHalfSpaces(settings_.clipHalfSpaces)) {
+        host_.sendErrorMsg("ClipHalfSpaces must be lists of four numbers "
+            "with a nonzero normal");
+        return false;
+    }
+    if (0 == clip_->regionCount()) {
+        host_.sendErrorMsg("ClipBoxes and ClipHalfSpaces define no region");
+        return false;
+    }
+    const PWP_UINT32 numCulled = clip_->cull();
+    PWP_UINT32 numVisible = 0;
+    for (PWP_UINT32 ndx = 0; ndx < model_->entityCount(); ++ndx) {
+        if (Print3DCondHidden != model_->condition(ndx)) {
+            ++numVisible;
+        }
+    }
+    model_ = clip_;
+    char msg[128];
+    sprintf(msg, "Clip: %lu regions, %lu of %lu entities culled",
+        (unsigned long)clip_->regionCount(), (unsigned long)numCulled,
+        (unsigned long)numVisible);
+    host_.sendInfoMsg(msg);
+    return true;
+}
+
+
+bool
+Print3DExporter::buildWeld()
+{
+    // Every pass reads the elements through the welded model, which has
+    // no edges of its own, so the owned edges are not used.
+    weld_ = new WeldedModel(*model_, host_);
+    bool ok = false;
+    if (progressBeginStep(weld_->stepCount())) {
+        ok = weld_->build(settings_.weldTolerance);
+        progressEndStep();
+    }
+    if (ok) {
+        model_ = weld_;
+        char msg[128];
+        sprintf(msg, "Weld: %lu of %lu vertices merged",
+            (unsigned long)weld_->weldedCount(),
+            (unsigned long)weld_->vertexCount());
+        host_.sendInfoMsg(msg);
+    }
+    return ok;
+}
+
+
+bool
+Print3DExporter::buildEdgeFilter()
+{
+    // Every pass that reads the elements, serial or parallel, drops the
+    // edges the filter does not keep, so the edge ownership and the solid
+    // numbering only see the kept edges.
+    edgeFilter_ = new EdgeFilter(*model_, host_);
+    bool ok = false;
+    if (progressBeginStep(edgeFilter_->stepCount(settings_.edgeMode,
+            settings_.boundaryLayers))) {
+        ok = edgeFilter_->build(settings_.edgeMode, settings_.boundaryLayers,
+            settings_.featureAngle);
+        progressEndStep();
+    }
+    if (ok) {
+        char msg[128];
+        sprintf(msg, "Edge mode %s: %lu edges kept",
+            EdgeModeName[settings_.edgeMode],
+            (unsigned long)edgeFilter_->size());
+        host_.sendInfoMsg(msg);
+    }
+    return ok;
+}
+
+
+bool
+Print3DExporter::buildChains()
+{
+    // The edges are collected once to find the vertices that join two
+    // edges. A chain is then written by whichever of its edges the export
+    // meets first.
+    EdgeGraph graph;
+    std::vector<PWP_UINT32> ends;
+    const bool ok = collectEdges(graph, ends);
+    edges_.clear();
+    if (!ok) {
+        return false;
+    }
+    chains_ = new EdgeChains;
+    chains_->build(graph, ends, settings_.chainTolerance);
+    char msg[128];
+    sprintf(msg, "Chains: %lu of %lu edges merged into %lu cylinders",
+        (unsigned long)chains_->edgeCount(), (unsigned long)graph.edgeCount(),
+        (unsigned long)chains_->chainCount());
+    host_.sendInfoMsg(msg);
+    return true;
+}
+
+
+bool
+Print3DExporter::writeEntity(PWP_UINT32 ndx)
+{
+    bool ret = false;
+    const Print3DCond cond = (ndx < model_->entityCount()) ?
+        model_->condition(ndx) : Print3DCondHidden;
+    if (ndx >= model_->entityCount()) {
+        // bad
+        ret = false;
+    }
+    else if ((Print3DCondHidden == cond) || !inPartition(ndx)) {
+        // silently skip
+        ret = true;
+    }
+    else {
+        const PWP_UINT32 numSolids = numSolids_;
+        curEntity_ = ndx;
+        beginMultiSolid(Print3DSolidPerEntity);
+        if (useCache_) {
+            ret = writeCachedEntity(ndx);
+        }
+        else if (useOwnedEdges_) {
+            ret = writeOwnedEdges(ndx);
+        }
+        else {
+            Print3DElem eData;
+            const PWP_UINT32 numElems = model_->elementCount(ndx);
+            for (PWP_UINT32 ii = 0; ii < numElems; ++ii) {
+                if (!model_->elementData(ndx, ii, eData) ||
+                        !progressIncrement()) {
+                    break;
+                }
+                writeElemData(eData, (Print3DCondSolid == cond));
+            }
+            ret = !aborted();
+        }
+        endMultiSolid(Print3DSolidPerEntity);
+        end3mfObject();
+        addManifestEntry(ndx, numSolids);
+    }
+    return ret;
+}
+
+
+void
+Print3DExporter::writeEntities(bool blocks)
+{
+    if (aborted()) {
+        return;
+    }
+    const PWP_UINT32 numEntities = model_->entityCount();
+    PWP_UINT32 steps = 0;
+    PWP_UINT32 ndx;
+    for (ndx = 0; ndx < numEntities; ++ndx) {
+        if (inPartition(ndx)) {
+            steps += countElements(ndx, ndx + 1, blocks);
+        }
+    }
+    if (progressBeginStep(steps)) {
+        for (ndx = 0; ndx < numEntities; ++ndx) {
+            if (blocks != model_->isBlock(ndx)) {
+                continue;
+            }
+            if (isCheckpointed(ndx)) {
+                if (!restoreEntity(ndx)) {
+                    break;
+                }
+            }
+            else if (!writeEntity(ndx)) {
+                break;
+            }
+            else if (Print3DCondHidden != model_->condition(ndx)) {
+                saveCheckpoint(entitySlot(ndx));
+            }
+        }
+        progressEndStep();
+    }
+}
+
+
+bool
+Print3DExporter::hashGrid(TessHash &hash)
+{
+    // the connectivity and coordinates of the visible patches and blocks
+    const PWP_UINT32 numEntities = model_->entityCount();
+    if (progressBeginStep(countElements(0, numEntities, false) +
+            countElements(0, numEntities, true))) {
+        Print3DElem eData;
+        for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+            const PWP_UINT32 numElems =
+                (Print3DCondHidden == model_->condition(ndx)) ? 0 :
+                model_->elementCount(ndx);
+            for (PWP_UINT32 ii = 0; ii < numElems; ++ii) {
+                if (!model_->elementData(ndx, ii, eData) ||
+                        !progressIncrement()) {
+                    break;
+                }
+                hashElemData(hash, eData);
+            }
+        }
+        progressEndStep();
+    }
+    return !aborted();
+}
+
+
+bool
+Print3DExporter::checkpointKey(PWP_UINT64 &key)
+{
+    // The settings that change the file and the layout and content of the
+    // grid. A checkpoint of a grid whose points have moved since is
+    // discarded like one of other settings.
+    TessHash hash;
+    hash.add((PWP_UINT32)(isBinaryEncoding() ? 1 : 0));
+    hash.add((PWP_UINT32)(multiSolid_ ? 1 : 0));
+    hash.add((PWP_UINT32)settings_.solidScope);
+    hash.add((PWP_UINT32)settings_.solidIds);
+    hash.add(radius_);
+    hash.add((PWP_UINT32)numBasePts_);
+    hash.add(ringStep_);
+    hash.add((PWP_UINT32)settings_.edgeMode);
+    hash.add((PWP_UINT32)settings_.boundaryLayers);
+    hash.add(settings_.featureAngle);
+    hash.add(settings_.clipBoxes.c_str());
+    hash.add(settings_.clipHalfSpaces.c_str());
+    hash.add((PWP_UINT32)(settings_.clipTrim ? 1 : 0));
+    hash.add((PWP_UINT32)(settings_.weldVertices ? 1 : 0));
+    hash.add(settings_.weldTolerance);
+    hash.add((PWP_UINT32)(usesChains(settings_) ? 1 : 0));
+    hash.add(settings_.chainTolerance);
+    const PWP_UINT32 numEntities = model_->entityCount();
+    hash.add(numEntities);
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        hash.add((PWP_UINT32)(model_->isBlock(ndx) ? 1 : 0));
+        hash.add((PWP_UINT32)model_->condition(ndx));
+        hash.add(model_->elementCount(ndx));
+        hash.add(model_->entityName(ndx).c_str());
+    }
+    if (!hashGrid(hash)) {
+        return false;
+    }
+    key = hash.value();
+    return true;
+}
+
+
+PWP_UINT32
+Print3DExporter::entitySlot(PWP_UINT32 ndx) const
+{
+    // the position of entity ndx in the order of writePatches() and
+    // writeBlocks()
+    return (model_->isBlock(ndx) ? model_->entityCount() : 0) + ndx;
+}
+
+
+bool
+Print3DExporter::isCheckpointed(PWP_UINT32 ndx) const
+{
+    return useCheckpoint_ && (entitySlot(ndx) < ckpt_.numDone);
+}
+
+
+bool
+Print3DExporter::beginCheckpoint()
+{
+    // A checkpoint of an export with the same settings and grid is resumed
+    // and any other one is discarded. The facets go to a new segment file
+    // until endCheckpoint().
+    ckptPath_ = settings_.destPath + CheckpointFileExt;
+    PWP_UINT64 key = 0;
+    if (!checkpointKey(key)) {
+        return false;
+    }
+    if (ckpt_.load(ckptPath_, key)) {
+        numTris_ = ckpt_.numTris;
+        numSolids_ = ckpt_.numSolids;
+        manifest_ = ckpt_.manifest;
+        const PWP_UINT32 numEntities = model_->entityCount();
+        PWP_UINT32 numDone = 0;
+        for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+            if (isCheckpointed(ndx)) {
+                ++numDone;
+            }
+        }
+        char msg[128];
+        sprintf(msg, "Resuming from a checkpoint: %lu of %lu patches and "
+            "blocks done", (unsigned long)numDone,
+            (unsigned long)numEntities);
+        host_.sendInfoMsg(msg);
+    }
+    else {
+        Checkpoint::remove(ckptPath_);
+        ckpt_.key = key;
+    }
+    FILE *fp = fopen(Checkpoint::segmentPath(ckptPath_,
+        ckpt_.segments.size()).c_str(), "wb");
+    if (0 == fp) {
+        return false;
+    }
+    ckpt_.segments.push_back(0);
+    outFp_ = fp_;
+    fp_ = fp;
+    numBytes_ = 0;
+    ckptTime_ = time(0);
+    return true;
+}
+
+
+void
+Print3DExporter::saveCheckpoint(PWP_UINT32 slot)
+{
+    // Called once the entity in slot is in the segment. Its facets are
+    // flushed before the checkpoint that counts them replaces the previous
+    // one. The pipeline's writer thread calls it too, so it must not read
+    // the model.
+    if ((0 == outFp_) || (difftime(time(0), ckptTime_) < CheckpointSecs)) {
+        return;
+    }
+    ckpt_.numDone = slot + 1;
+    ckpt_.numTris = numTris_;
+    ckpt_.numSolids = numSolids_;
+    ckpt_.manifest = manifest_;
+    ckpt_.segments.back() = numBytes_;
+    if ((0 != fflush(fp_)) || !ckpt_.save(ckptPath_)) {
+        ckptFailed_ = true;
+    }
+    ckptTime_ = time(0);
+}
+
+
+bool
+Print3DExporter::endCheckpoint()
+{
+    // Copies the segments into the export file. An aborted export keeps
+    // them and the checkpoint for the next run.
+    bool ret = (0 == fclose(fp_));
+    fp_ = outFp_;
+    outFp_ = 0;
+    ckpt_.segments.back() = numBytes_;
+    if (ckptFailed_) {
+        host_.sendWarningMsg("Could not write a checkpoint");
+    }
+    if (aborted()) {
+        return false;
+    }
+    char buf[65536];
+    for (size_t ii = 0; ret && (ii < ckpt_.segments.size()); ++ii) {
+        FILE *seg = fopen(Checkpoint::segmentPath(ckptPath_, ii).c_str(),
+            "rb");
+        PWP_UINT64 left = ckpt_.segments[ii];
+        ret = (0 != seg);
+        while (ret && (left > 0)) {
+            const size_t cnt = (left > sizeof(buf)) ? sizeof(buf) :
+                (size_t)left;
+            ret = (1 == fread(buf, cnt, 1, seg)) &&
+                (1 == pwpFileWrite(buf, cnt, 1, fp()));
+            left -= cnt;
+        }
+        if (0 != seg) {
+            fclose(seg);
+        }
+    }
+    if (!ret) {
+        host_.sendErrorMsg("Could not copy the checkpoint segments into the "
+            "export file");
+    }
+    return ret;
+}
+
+
+bool
+Print3DExporter::restoreEntity(PWP_UINT32 ndx)
+{
+    // Entity ndx was written before the checkpoint. Its edges are
+    // collected again, so that the entities after it still skip them.
+    if (Print3DCondHidden == model_->condition(ndx)) {
+        return true;
+    }
+    if (!useOwnedEdges_) {
+        CollectEdges collect(edges_);
+        return scanEntity(ndx, collect);
+    }
+    const PWP_UINT32 numElems = model_->elementCount(ndx);
+    for (PWP_UINT32 ii = 0; ii < numElems; ++ii) {
+        if (!progressIncrement()) {
+            return false;
+        }
+    }
+    return !aborted();
+}
+
+
+void
+Print3DExporter::writePatches()
+{
+    writeEntities(false);
+}
+
+
+void
+Print3DExporter::writeBlocks()
+{
+    writeEntities(true);
+}
+
+
+void
+Print3DExporter::addRanges(bool blocks, std::vector<Range> &ranges) const
+{
+    // Splits the visible patches or blocks into ranges of up to RangeElems
+    // elements. The elements are numbered in serial traversal order. An
+    // entity without elements still gets a range for its solid.
+    PWP_UINT64 seq = 0;
+    if (!ranges.empty()) {
+        seq = ranges.back().seq + (ranges.back().end - ranges.back().first);
+    }
+    const PWP_UINT32 numEntities = model_->entityCount();
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        const Print3DCond cond = model_->condition(ndx);
+        if ((blocks != model_->isBlock(ndx)) || (Print3DCondHidden == cond)) {
+            continue;
+        }
+        const PWP_UINT32 numElems = model_->elementCount(ndx);
+        Range range;
+        range.entity = ndx;
+        range.solid = (Print3DCondSolid == cond);
+        range.numThick = 0;
+        range.solidBase = 0;
+        range.numSolids = 0;
+        range.numTris = 0;
+        range.numRings = 0;
+        range.numRingHits = 0;
+        range.first = 0;
+        do {
+            range.end = (numElems - range.first > RangeElems) ?
+                (range.first + RangeElems) : numElems;
+            range.seq = seq;
+            ranges.push_back(range);
+            seq += range.end - range.first;
+            range.first = range.end;
+        } while (range.first < numElems);
+    }
+}
+
+
+bool
+Print3DExporter::skipRanges(const std::vector<Range> &ranges, size_t first,
+    size_t end)
+{
+    // advances the progress over the ranges written before the checkpoint
+    for (size_t ii = first; ii < end; ++ii) {
+        for (PWP_UINT32 jj = ranges[ii].first; jj < ranges[ii].end; ++jj) {
+            if (!progressIncrement()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+bool
+Print3DExporter::runRanges(WorkerPool &pool, RangeJob &job, size_t first,
+    size_t end, bool claim)
+{
+    // Runs the ranges [first, end) on the pool a batch of job.bufs at a
+    // time. The progress and the facets are reported by this thread, in
+    // order.
+    std::vector<Range> &ranges = *job.ranges;
+    const size_t batch = job.bufs.size();
+    for (size_t bb = first; bb < end; bb += batch) {
+        const size_t cnt = (end - bb < batch) ? (end - bb) : batch;
+        job.first = bb;
+        pool.run(claim ? claimTask : writeTask, &job, (PWP_UINT32)cnt);
+        for (size_t ii = bb; ii < bb + cnt; ++ii) {
+            if (!claim) {
+                writeRange(ranges[ii], job.bufs[ii - bb]);
+            }
+            for (PWP_UINT32 jj = ranges[ii].first; jj < ranges[ii].end; ++jj) {
+                if (!progressIncrement()) {
+                    return false;
+                }
+            }
+        }
+    }
+    return !aborted();
+}
+
+
+void
+Print3DExporter::writeRange(const Range &range, const std::string &buf)
+{
+    // the entity's solid and manifest entry are written around its ranges
+    if (0 == range.first) {
+        curEntity_ = range.entity;
+        entitySolids_ = numSolids_;
+        beginMultiSolid(Print3DSolidPerEntity);
+    }
+    if (!buf.empty()) {
+        writeBytes(buf.data(), buf.size());
+    }
+    numTris_ += range.numTris;
+    numRings_ += range.numRings;
+    numRingHits_ += range.numRingHits;
+    if (multiSolid_ && (Print3DSolidPerCylinder == settings_.solidScope)) {
+        numSolids_ = range.numSolids;
+    }
+    if (range.end == model_->elementCount(range.entity)) {
+        endMultiSolid(Print3DSolidPerEntity);
+        addManifestEntry(range.entity, entitySolids_);
+        saveCheckpoint(entitySlot(range.entity));
+    }
+}
+
+
+void
+Print3DExporter::writeParallel()
+{
+    // Pass 1 claims each edge for the first element that uses it. Pass 2
+    // writes each range into its own buffer, with the edges its elements
+    // own. The buffers are written in range order, so the file is the
+    // same as the one written by writePatches() and writeBlocks().
+    if (aborted()) {
+        return;
+    }
+    std::vector<Range> ranges;
+    size_t numPatchRanges = 0;
+    {
+        // planned before either pass
+        AllocPhase phase(AllocPhase::Setup);
+        addRanges(false, ranges);
+        numPatchRanges = ranges.size();
+        addRanges(true, ranges);
+    }
+
+    EdgeRegistry registry;
+    WorkerPool pool(settings_.numThreads);
+    Workers workers(*this, pool.threadCount(), &registry);
+    RangeJob job;
+    job.exporter = this;
+    job.ranges = &ranges;
+    job.first = 0;
+    job.bufs.resize(4 * pool.threadCount());
+    job.workers = &workers;
+
+    // the ranges of the entities written before the checkpoint are
+    // claimed again but not written
+    size_t numDone = 0;
+    while ((numDone < ranges.size()) &&
+            isCheckpointed(ranges[numDone].entity)) {
+        ++numDone;
+    }
+    const size_t firstPatch = (numDone < numPatchRanges) ? numDone :
+        numPatchRanges;
+    const size_t firstBlock = (numDone > numPatchRanges) ? numDone :
+        numPatchRanges;
+
+    const PWP_UINT32 numEntities = model_->entityCount();
+    bool ok = false;
+    if (progressBeginStep(countElements(0, numEntities, false) +
+            countElements(0, numEntities, true))) {
+        ok = runRanges(pool, job, 0, ranges.size(), true);
+        progressEndStep();
+    }
+    if (ok && multiSolid_ &&
+            (Print3DSolidPerCylinder == settings_.solidScope)) {
+        // the cylinder solids are numbered in serial order
+        std::vector<PWP_UINT64> seqs(ranges.size());
+        for (size_t ii = 0; ii < ranges.size(); ++ii) {
+            seqs[ii] = ranges[ii].seq;
+        }
+        std::vector<PWP_UINT32> counts;
+        registry.countOwners(seqs, counts);
+        PWP_UINT32 base = numSolids_;
+        for (size_t ii = numDone; ii < ranges.size(); ++ii) {
+            ranges[ii].solidBase = base;
+            base += counts[ii] + ranges[ii].numThick;
+        }
+    }
+    if (ok && progressBeginStep(countElements(0, numEntities, false))) {
+        ok = skipRanges(ranges, 0, firstPatch) &&
+            runRanges(pool, job, firstPatch, numPatchRanges, false);
+        progressEndStep();
+    }
+    if (ok && progressBeginStep(countElements(0, numEntities, true))) {
+        ok = skipRanges(ranges, numPatchRanges, firstBlock) &&
+            runRanges(pool, job, firstBlock, ranges.size(), false);
+        progressEndStep();
+    }
+    char msg[128];
+    sprintf(msg, "Parallel traversal: %lu ranges, %lu edges, %lu threads",
+        (unsigned long)ranges.size(), (unsigned long)registry.edgeCount(),
+        (unsigned long)pool.threadCount());
+    host_.sendInfoMsg(msg);
+}
+
+
+bool
+Print3DExporter::fillBatches(PWP_UINT32 ndx, PipelineJob &job)
+{
+    // Fills the batches of patch or block ndx with the solids of the new
+    // edges and thickened elements of up to RangeElems elements, or with
+    // up to RangeElems owned edges. An entity without elements still gets
+    // a batch for its solid.
+    PipelineRing &ring = *job.ring;
+    const bool solid = (Print3DCondSolid == model_->condition(ndx));
+    const PWP_UINT32 numElems = model_->elementCount(ndx);
+    const PWP_UINT32 *edgeVerts = 0;
+    PWP_UINT32 numEdges = 0;
+    if (useOwnedEdges_ && !model_->ownedEdges(ndx, edgeVerts, numEdges)) {
+        return false;
+    }
+    const PWP_UINT32 numItems = useOwnedEdges_ ? numEdges : numElems;
+    PWP_UINT64 done = 0;    // the owned edge progress, in elements
+    PWP_UINT32 first = 0;
+    bool ok = true;
+    do {
+        if (!ring.acquire(job.seq)) {
+            return false;
+        }
+        Batch &batch = (*job.batches)[ring.slot(job.seq)];
+        batch.entity = ndx;
+        batch.slot = entitySlot(ndx);
+        batch.first = (0 == first);
+        batch.numTris = 0;
+        batch.numRings = 0;
+        batch.numRingHits = 0;
+        batch.ops.clear();
+        batch.verts.clear();
+        batch.buf.clear();
+        PWP_UINT32 end = (numItems - first > RangeElems) ?
+            (first + RangeElems) : numItems;
+        batch_ = &batch;
+        if (useOwnedEdges_) {
+            PWGM_VERTDATA vd0;
+            PWGM_VERTDATA vd1;
+            for (PWP_UINT32 ii = first; ok && (ii < end); ++ii) {
+                if (!model_->vertexData(edgeVerts[2 * ii], vd0) ||
+                        !model_->vertexData(edgeVerts[2 * ii + 1], vd1)) {
+                    host_.sendErrorMsg("Bad edge vertex in the grid model");
+                    ok = false;
+                    break;
+                }
+                writeOwnedEdge(vd0, vd1);
+                const PWP_UINT64 target = (PWP_UINT64)(ii + 1) * numElems /
+                    numEdges;
+                for (; ok && (done < target); ++done) {
+                    ok = progressIncrement();
+                }
+            }
+        }
+        else {
+            Print3DElem eData;
+            for (PWP_UINT32 ii = first; ok && (ii < end); ++ii) {
+                if (!model_->elementData(ndx, ii, eData)) {
+                    // the rest of the entity is skipped
+                    end = numItems;
+                    break;
+                }
+                ok = progressIncrement();
+                if (ok) {
+                    writeElemData(eData, solid);
+                }
+            }
+        }
+        batch_ = 0;
+        if (!ok) {
+            return false;
+        }
+        batch.last = (end == numItems);
+        if (batch.last && multiSolid_ && isBinaryEncoding()) {
+            // the writer thread may not read the model
+            batch.name = model_->entityName(ndx);
+        }
+        batch.solidBase = job.numSolids;
+        if (multiSolid_ && (Print3DSolidPerCylinder == settings_.solidScope)) {
+            job.numSolids += (PWP_UINT32)batch.ops.size();
+        }
+        ring.publish(job.seq++);
+        first = end;
+    } while (first < numItems);
+    if (useOwnedEdges_) {
+        for (; ok && (done < numElems); ++done) {
+            ok = progressIncrement();
+        }
+    }
+    return ok;
+}
+
+
+bool
+Print3DExporter::fillBatches(bool blocks, PipelineJob &job)
+{
+    const PWP_UINT32 numEntities = model_->entityCount();
+    bool ok = false;
+    if (progressBeginStep(countElements(0, numEntities, blocks))) {
+        ok = true;
+        for (PWP_UINT32 ndx = 0; ok && (ndx < numEntities); ++ndx) {
+            if ((blocks != model_->isBlock(ndx)) ||
+                    (Print3DCondHidden == model_->condition(ndx))) {
+                continue;
+            }
+            ok = isCheckpointed(ndx) ? restoreEntity(ndx) :
+                fillBatches(ndx, job);
+        }
+        progressEndStep();
+    }
+    return ok && !aborted();
+}
+
+
+void
+Print3DExporter::makeBatchFacets(Batch &batch)
+{
+    capture_ = &batch.buf;
+    curEntity_ = batch.entity;
+    numSolids_ = batch.solidBase;
+    numTris_ = 0;
+    curAttr_ = 0;
+    if (multiSolid_ && isBinaryEncoding() &&
+            (Print3DSolidPerEntity == settings_.solidScope)) {
+        curAttr_ = solidAttr(batch.entity + 1);
+    }
+    const PWGM_VERTDATA *vd = batch.verts.empty() ? 0 : &batch.verts[0];
+    for (size_t ii = 0; ii < batch.ops.size(); vd += batch.ops[ii++]) {
+        switch (batch.ops[ii]) {
+            case 2:
+                writeCylinder(vd[0], vd[1]);
+                break;
+            case 3:
+                writeThickenedPolygon(vd[0], vd[1], vd[2]);
+                break;
+            default:
+                writeThickenedPolygon(vd[0], vd[1], vd[2], vd[3]);
+                break;
+        }
+    }
+    batch.numTris = numTris_;
+    batch.numSolids = numSolids_;
+    batch.numRings = numRings_;
+    batch.numRingHits = numRingHits_;
+    numRings_ = 0;
+    numRingHits_ = 0;
+    capture_ = 0;
+}
+
+
+void
+Print3DExporter::writeBatch(const Batch &batch)
+{
+    // the entity's solid and manifest entry are written around its batches
+    if (batch.first) {
+        curEntity_ = batch.entity;
+        entitySolids_ = numSolids_;
+        beginMultiSolid(Print3DSolidPerEntity);
+    }
+    if (!batch.buf.empty()) {
+        writeBytes(batch.buf.data(), batch.buf.size());
+    }
+    numTris_ += batch.numTris;
+    numRings_ += batch.numRings;
+    numRingHits_ += batch.numRingHits;
+    if (multiSolid_ && (Print3DSolidPerCylinder == settings_.solidScope)) {
+        numSolids_ = batch.numSolids;
+    }
+    if (batch.last) {
+        endMultiSolid(Print3DSolidPerEntity);
+        addManifestEntry(batch.entity, entitySolids_, batch.name.c_str());
+        saveCheckpoint(batch.slot);
+    }
+}
+
+
+void
+Print3DExporter::writePipelined()
+{
+    // This thread reads the elements and keeps the first use of each edge,
+    // as writePatches() and writeBlocks() do, and fills batches with the
+    // solids to make. Geometry threads make the facets of the batches and
+    // a writer thread writes them in order, so the file is the same as
+    // the serial one. The ring holds a fixed number of batches: the
+    // memory does not grow with the grid, and the traversal waits only
+    // when the geometry or the disk falls behind.
+    if (aborted()) {
+        return;
+    }
+    const PWP_UINT32 numThreads = (0 == settings_.numThreads) ?
+        WorkerPool::processorCount() : settings_.numThreads;
+    // this thread and the writer run beside the geometry threads
+    const PWP_UINT32 numWorkers = (numThreads > 2) ? (numThreads - 2) : 1;
+    PipelineRing ring(BatchesPerWorker * numWorkers);
+    std::vector<Batch> batches(ring.slotCount());
+    Workers workers(*this, numWorkers);
+    PipelineJob job;
+    job.exporter = this;
+    job.ring = &ring;
+    job.batches = &batches;
+    job.seq = 0;
+    job.numSolids = numSolids_;
+    job.workers = &workers;
+    // the writer thread owns the output until the pool is done
+    WorkerPool pool(numWorkers + 1);
+    if (!pool.start(pipelineTask, &job, numWorkers + 1)) {
+        ring.abort();
+        pool.wait();
+        host_.sendWarningMsg("Could not start the export pipeline threads");
+        writePatches();
+        writeBlocks();
+        return;
+    }
+    if (fillBatches(false, job) && fillBatches(true, job)) {
+        ring.close(job.seq);
+    }
+    else {
+        ring.abort();
+    }
+    pool.wait();
+    char msg[128];
+    sprintf(msg, "Pipeline: %lu batches, %lu geometry threads, %lu slots",
+        (unsigned long)job.seq, (unsigned long)numWorkers,
+        (unsigned long)ring.slotCount());
+    host_.sendInfoMsg(msg);
+}
+
+
+void
+Print3DExporter::writeGroups(WorkerPool &pool, const EdgeGroups &groups,
+    std::string *index)
+{
+    // The groups are written in parallel, a batch at a time, each into its
+    // own buffer, and the buffers are written in group order so that the
+    // output does not depend on the thread count. index gets a line per
+    // group: its first byte, byte count, first facet and facet count, and
+    // the curve keys of its first and last edges.
+    const PWP_UINT32 numGroups = groups.groupCount();
+    const PWP_UINT32 batch = 4 * pool.threadCount();
+    const bool grouped = hasGroupedSolids(settings_);
+    std::vector<Group> solids(batch);
+    Workers workers(*this, pool.threadCount());
+    GroupJob job;
+    job.exporter = this;
+    job.groups = &groups;
+    job.solids = &solids;
+    job.first = 0;
+    job.workers = &workers;
+    // the binary header is not counted by writeBytes()
+    PWP_UINT64 offset = isBinaryEncoding() ? 84 : numBytes_;
+    if (progressBeginStep(numGroups)) {
+        bool ok = true;
+        for (PWP_UINT32 first = 0; ok && (first < numGroups); first += batch) {
+            const PWP_UINT32 cnt = (numGroups - first < batch) ?
+                (numGroups - first) : batch;
+            job.first = first;
+            pool.run(groupTask, &job, cnt);
+            for (PWP_UINT32 ii = 0; ok && (ii < cnt); ++ii) {
+                const Group &group = solids[ii];
+                const PWP_UINT32 numSolids = numSolids_;
+                if (0 != index) {
+                    char line[128];
+                    sprintf(line, "%llu %lu %lu %lu 0x%016llx 0x%016llx\n",
+                        (unsigned long long)offset,
+                        (unsigned long)group.buf.size(),
+                        (unsigned long)numTris_, (unsigned long)group.numTris,
+                        (unsigned long long)groups.key(
+                            groups.groupBegin(group.ndx)),
+                        (unsigned long long)groups.key(
+                            groups.groupEnd(group.ndx) - 1));
+                    *index += line;
+                }
+                writeBytes(group.buf.data(), group.buf.size());
+                offset += group.buf.size();
+                numTris_ += group.numTris;
+                numRings_ += group.numRings;
+                numRingHits_ += group.numRingHits;
+                numSolids_ = group.numSolids;
+                char name[32];
+                sprintf(name, "%s_%06lu",
+                    grouped ? SolidScopeName[settings_.solidScope] : "chunk",
+                    (unsigned long)(group.ndx + 1));
+                addManifestEntry(group.ndx, numSolids, name);
+                ok = progressIncrement();
+            }
+        }
+        progressEndStep();
+    }
+}
+
+
+void
+Print3DExporter::writeGroupedSolids()
+{
+    // Replace the collected edges by a solid per cluster or component.
+    if (aborted()) {
+        return;
+    }
+    warnSolidCondition("Grouped solid export");
+    EdgeGroups groups;
+    if (Print3DSolidPerCluster == settings_.solidScope) {
+        const PWP_UINT32 trisPerEdge = 4 * numBasePts_ - 4;
+        groups.makeClusters(*graph_,
+            (PWP_UINT32)(settings_.clusterTris / trisPerEdge));
+    }
+    else {
+        groups.makeComponents(*graph_);
+    }
+    WorkerPool pool(settings_.numThreads);
+    writeGroups(pool, groups, 0);
+    char msg[128];
+    sprintf(msg, "Grouped solids: %lu edges in %lu %ss, %lu threads",
+        (unsigned long)graph_->edgeCount(),
+        (unsigned long)groups.groupCount(),
+        SolidScopeName[settings_.solidScope],
+        (unsigned long)pool.threadCount());
+    host_.sendInfoMsg(msg);
+}
+
+
+void
+Print3DExporter::writeOrderedEdges()
+{
+    // Write the collected edges sorted along the curve, in chunks of
+    // nearby cylinders. The chunk index lets a reader seek to the facets
+    // of a range of keys, and so to a region of the grid.
+    if (aborted()) {
+        return;
+    }
+    warnSolidCondition("EdgeOrder");
+    WorkerPool pool(settings_.numThreads);
+    EdgeGroups chunks;
+    chunks.makeCurveChunks(*graph_, settings_.edgeOrder, OrderChunkEdges,
+        pool);
+    std::string index;
+    writeGroups(pool, chunks, &index);
+    if (!settings_.destPath.empty() && !aborted()) {
+        const std::string path = settings_.destPath + ChunkIndexFileExt;
+        FILE *fp = fopen(path.c_str(), "w");
+        bool ok = (0 != fp);
+        if (ok) {
+            const double *origin = chunks.keyOrigin();
+            fprintf(fp, "# Print3D chunk index\n");
+            fprintf(fp, "# curve: %s\n", EdgeOrderName[settings_.edgeOrder]);
+            fprintf(fp, "# bits: %d per axis\n", EdgeGroups::KeyBits);
+            fprintf(fp, "# origin: %.17g %.17g %.17g\n", origin[0],
+                origin[1], origin[2]);
+            fprintf(fp, "# cell: %.17g\n", chunks.keyCell());
+            fprintf(fp, "# first-byte bytes first-facet facets first-key "
+                "last-key\n");
+            ok = (index.size() == fwrite(index.data(), 1, index.size(), fp));
+            ok = (0 == fclose(fp)) && ok;
+        }
+        if (!ok) {
+            host_.sendWarningMsg("Could not write chunk index");
+        }
+    }
+    char msg[128];
+    sprintf(msg, "Edge order %s: %lu edges in %lu chunks, %lu threads",
+        EdgeOrderName[settings_.edgeOrder],
+        (unsigned long)graph_->edgeCount(),
+        (unsigned long)chunks.groupCount(),
+        (unsigned long)pool.threadCount());
+    host_.sendInfoMsg(msg);
+}
+
+
+void
+Print3DExporter::claimTask(void *ctx, PWP_UINT32 task)
+{
+    RangeJob *job = (RangeJob *)ctx;
+    Range &range = (*job->ranges)[job->first + task];
+    Print3DExporter &worker = *job->workers->take();
+    AllocPhase phase(AllocPhase::Traversal);
+    ClaimEdgeOwner claim(*job->workers->registry);
+    worker.edgeVisitor_ = &claim;
+    Print3DElem eData;
+    range.numThick = 0;
+    for (PWP_UINT32 ii = range.first; ii < range.end; ++ii) {
+        if (!worker.model_->elementData(range.entity, ii, eData)) {
+            break;
+        }
+        claim.setSeq(range.seq + (ii - range.first));
+        worker.writeElemData(eData);
+        if (range.solid && ((PWGM_ELEMTYPE_TRI == eData.type) ||
+                (PWGM_ELEMTYPE_QUAD == eData.type)) &&
+                ((0 == worker.clip_) || worker.clip_->meets(eData))) {
+            ++range.numThick;
+        }
+    }
+    worker.edgeVisitor_ = 0;
+    job->workers->release(&worker);
+}
+
+
+void
+Print3DExporter::writeTask(void *ctx, PWP_UINT32 task)
+{
+    RangeJob *job = (RangeJob *)ctx;
+    Range &range = (*job->ranges)[job->first + task];
+    std::string &buf = job->bufs[task];
+    Print3DExporter &worker = *job->workers->take();
+    AllocPhase phase(AllocPhase::Traversal);
+    buf.clear();
+    worker.capture_ = &buf;
+    worker.curEntity_ = range.entity;
+    worker.numSolids_ = range.solidBase;
+    if (worker.multiSolid_ && worker.isBinaryEncoding() &&
+            (Print3DSolidPerEntity == worker.settings_.solidScope)) {
+        worker.curAttr_ = worker.solidAttr(range.entity + 1);
+    }
+    Print3DElem eData;
+    for (PWP_UINT32 ii = range.first; ii < range.end; ++ii) {
+        if (!worker.model_->elementData(range.entity, ii, eData)) {
+            break;
+        }
+        worker.seq_ = range.seq + (ii - range.first);
+        worker.writeElemData(eData, range.solid);
+    }
+    range.numTris = worker.numTris_;
+    range.numSolids = worker.numSolids_;
+    range.numRings = worker.numRings_;
+    range.numRingHits = worker.numRingHits_;
+    worker.capture_ = 0;
+    job->workers->release(&worker);
+}
+
+
+void
+Print3DExporter::pipelineTask(void *ctx, PWP_UINT32 task)
+{
+    // task 0 writes the batches in order, the others make their facets
+    PipelineJob *job = (PipelineJob *)ctx;
+    PipelineRing &ring = *job->ring;
+    std::vector<Batch> &batches = *job->batches;
+    Print3DExporter &exporter = *job->exporter;
+    PWP_UINT64 seq = 0;
+    if (0 == task) {
+        AllocPhase phase(AllocPhase::Io);
+        while (ring.waitDone(seq)) {
+            exporter.writeBatch(batches[ring.slot(seq)]);
+            ring.release(seq++);
+        }
+    }
+    else {
+        Print3DExporter &worker = *job->workers->take();
+        AllocPhase phase(AllocPhase::Geometry);
+        while (ring.take(seq)) {
+            worker.makeBatchFacets(batches[ring.slot(seq)]);
+            ring.complete(seq);
+        }
+        job->workers->release(&worker);
+    }
+}
+
+
+void
+Print3DExporter::groupTask(void *ctx, PWP_UINT32 task)
+{
+    GroupJob *job = (GroupJob *)ctx;
+    Group &group = (*job->solids)[task];
+    const Print3DExporter &exporter = *job->exporter;
+    const EdgeGraph &graph = *exporter.graph_;
+    const EdgeGroups &groups = *job->groups;
+    Print3DExporter &worker = *job->workers->take();
+    AllocPhase phase(AllocPhase::Geometry);
+    // a grouped solid is one solid, a chunk of an ordered export has a
+    // solid per cylinder
+    const bool grouped = hasGroupedSolids(worker.settings_);
+    group.ndx = job->first + task;
+    group.buf.clear();
+    worker.capture_ = &group.buf;
+    worker.numSolids_ = grouped ? group.ndx : groups.groupBegin(group.ndx);
+    if (grouped) {
+        worker.beginMultiSolid(worker.settings_.solidScope);
+    }
+    PWGM_VERTDATA vd[2];
+    const PWP_UINT32 end = groups.groupEnd(group.ndx);
+    for (PWP_UINT32 ii = groups.groupBegin(group.ndx); ii < end; ++ii) {
+        const PWP_UINT32 edge = groups.edge(ii);
+        for (int jj = 0; jj < 2; ++jj) {
+            const PWP_UINT32 vert = graph.edgeVert(edge, jj);
+            const double *xyz = graph.xyz(vert);
+            vd[jj].x = xyz[0];
+            vd[jj].y = xyz[1];
+            vd[jj].z = xyz[2];
+            vd[jj].i = graph.gridIndex(vert);
+        }
+        worker.writeCylinder(vd[0], vd[1]);
+    }
+    if (grouped) {
+        worker.endMultiSolid(worker.settings_.solidScope);
+    }
+    group.numTris = worker.numTris_;
+    group.numSolids = worker.numSolids_;
+    group.numRings = worker.numRings_;
+    group.numRingHits = worker.numRingHits_;
+    worker.capture_ = 0;
+    job->workers->release(&worker);
+}
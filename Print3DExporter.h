@@ -0,0 +1,398 @@
+/****************************************************************************
+ *
+ * class Print3DExporter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _PRINT3DEXPORTER_H_
+#define _PRINT3DEXPORTER_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+#include "pwpPlatform.h"
+
+#include "AllocPhase.h"
+#include "Checkpoint.h"
+#include "Edge.h"
+#include "EdgeGraph.h"
+#include "EdgeRegistry.h"
+#include "EdgeTable.h"
+#include "Print3DModel.h"
+#include "TessCache.h"
+#include "ZipWriter.h"
+
+#include "cml/cml.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+
+#define DefCylDiam      0.9
+#define DefNumBasePts   7
+#define MinNumBasePts   3
+#define MaxNumBasePts   10
+#define NameBufSize     81
+#define DefSdfRes       5
+#define MinSdfRes       2
+#define MaxSdfRes       64
+#define DefSliceThick   0.1
+#define DefFeatureAngle 30.0
+#define DefClusterTris  100000
+#define MaxBndryLayers  100
+#define MaxPartitions   1024
+#define MaxThreads      256
+
+// the solid manifest written next to a binary multi-solid STL export
+#define ManifestFileExt ".solids"
+
+
+//////////////////////////////////////////////////////////////////////////
+// typedef a 3D CML vector with element type double                     //
+//////////////////////////////////////////////////////////////////////////
+typedef cml::vector3d vector3;
+
+//////////////////////////////////////////////////////////////////////////
+// typedef a 4x4 column-major CML matrix with element type double,      //
+// configured for use with column vectors:                              //
+//////////////////////////////////////////////////////////////////////////
+typedef cml::matrix33d_c matrix33;
+
+typedef vector3 CylBase[MaxNumBasePts];
+typedef CylBase Cylinder[2];
+
+class EdgeChains;
+class EdgeFilter;
+class EdgeGroups;
+class ClippedModel;
+class RingCache;
+class WeldedModel;
+
+
+//////////////////////////////////////////////////////////////////////////
+// What a multi-solid export treats as one solid body                    //
+//////////////////////////////////////////////////////////////////////////
+enum Print3DSolidScope {
+    Print3DSolidPerCylinder,    // each inflated edge and thickened element
+    Print3DSolidPerEntity,      // each patch and block
+    Print3DSolidPerCluster,     // the inflated edges in a region of space
+    Print3DSolidPerComponent    // the inflated edges of a connected piece
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// How a binary multi-solid export stores the solid id in the 16-bit     //
+// facet attribute                                                       //
+//////////////////////////////////////////////////////////////////////////
+enum Print3DSolidIds {
+    Print3DSolidIdPlain,    // the id itself, 1..65535
+    Print3DSolidIdVisCAM,   // a color per id, VisCAM/SolidView convention
+    Print3DSolidIdMagics    // a color per id, Materialise Magics convention
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Which grid edges are inflated                                        //
+//////////////////////////////////////////////////////////////////////////
+enum Print3DEdgeMode {
+    Print3DEdgesAll,        // every edge of the visible patches and blocks
+    Print3DEdgesBoundary,   // the edges on the grid surface and in the
+                            // cell layers next to it
+    Print3DEdgesFeature     // the surface edges at sharp corners
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// The order in which an STL export writes the cylinders                //
+//////////////////////////////////////////////////////////////////////////
+enum Print3DEdgeOrder {
+    Print3DOrderTraversal,  // as the patches and blocks are traversed
+    Print3DOrderMorton,     // along a Morton curve through the midpoints
+    Print3DOrderHilbert     // along a Hilbert curve through the midpoints
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// The output file format                                               //
+//////////////////////////////////////////////////////////////////////////
+enum Print3DFormat {
+    Print3DFormatStl,   // a facet per triangle, ASCII or binary
+    Print3DFormat3mf,   // one cylinder mesh instanced per edge
+    Print3DFormatCli    // Common Layer Interface slice outlines, ASCII
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// The export options. CaeUnsPrint3D loads them from the solver          //
+// attributes and the print3d command line driver from its flags.        //
+//////////////////////////////////////////////////////////////////////////
+struct Print3DSettings {
+    Print3DSettings();
+
+    Print3DFormat       format;
+    bool                binary;
+    bool                beamLattice;
+    bool                multiSolid;
+    Print3DSolidScope   solidScope;
+    Print3DSolidIds     solidIds;
+    PWP_UINT            clusterTris;
+    double              diameter;
+    PWP_UINT            numPoints;
+    double              cylTolerance;
+    Print3DEdgeMode     edgeMode;
+    PWP_UINT            boundaryLayers;
+    double              featureAngle;
+    std::string         clipBoxes;
+    std::string         clipHalfSpaces;
+    bool                clipTrim;
+    bool                weldVertices;
+    double              weldTolerance;
+    bool                mergeChains;
+    double              chainTolerance;
+    Print3DEdgeOrder    edgeOrder;
+    bool                tessCache;
+    bool                checkpoint;
+    PWP_UINT            numParts;
+    PWP_UINT            partRank;
+    bool                mergeParts;
+    bool                sdfUnion;
+    PWP_UINT            sdfResolution;
+    bool                hubLattice;
+    PWP_UINT            numThreads;
+    double              sliceThickness;
+    bool                threadSafeModel;
+    std::string         destPath;
+};
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+class Print3DExporter {
+public:
+    Print3DExporter(Print3DModel &model, Print3DHost &host, FILE *fp,
+        const Print3DSettings &settings);
+    ~Print3DExporter();
+
+    static PWP_UINT32   majorSteps(const Print3DSettings &settings);
+    static bool         isUnion(const Print3DSettings &settings);
+    static bool         isParallel(const Print3DSettings &settings);
+    static bool         isPipelined(const Print3DSettings &settings);
+    static bool         hasGroupedSolids(const Print3DSettings &settings);
+    static bool         usesChains(const Print3DSettings &settings);
+    static bool         usesEdgeOrder(const Print3DSettings &settings);
+    static bool         usesClip(const Print3DSettings &settings);
+    static bool         usesCache(const Print3DSettings &settings);
+    static bool         usesCheckpoint(const Print3DSettings &settings);
+
+    bool    run();
+
+    // Adds the edges to graph in the order a serial export writes them.
+    // ends[ndx] is the graph's edge count after entity ndx, so each edge
+    // belongs to the first visible patch or block that uses it.
+    bool    collectEdges(EdgeGraph &graph, std::vector<PWP_UINT32> &ends);
+
+private:
+    struct Range;
+    struct RangeJob;
+    struct Batch;
+    struct PipelineJob;
+    struct Group;
+    struct GroupJob;
+    struct Workers;
+
+    bool    isBinaryEncoding() const {
+                return settings_.binary && isStl(); }
+    bool    isAsciiEncoding() const {
+                return !settings_.binary && isStl(); }
+    bool    isStl() const {
+                return Print3DFormatStl == settings_.format; }
+    bool    is3mf() const {
+                return Print3DFormat3mf == settings_.format; }
+    bool    isCli() const {
+                return Print3DFormatCli == settings_.format; }
+    FILE *  fp() const {
+                return fp_; }
+    bool    progressBeginStep(PWP_UINT32 total) {
+                return host_.progressBeginStep(total); }
+    bool    progressIncrement() {
+                return host_.progressIncrement(); }
+    void    progressEndStep() {
+                host_.progressEndStep(); }
+    bool    aborted() {
+                return host_.aborted(); }
+
+    void    writeBytes(const void *buf, size_t size);
+    void    writeStr(const char *format, ...);
+    void    writeText(const char *format, ...);
+    void    writeTextV(const char *format, va_list args);
+    void    writeFacet(const vector3 &norm, const vector3 &p0,
+                const vector3 &p1, const vector3 &p2);
+    void    writeTriFacet(const vector3 &p0, const vector3 &p1,
+                const vector3 &p2);
+    void    writeQuadFacet(const vector3 &p0, const vector3 &p1,
+                const vector3 &p2, const vector3 &p3);
+    PWP_UINT16  solidAttr(PWP_UINT32 solidNum) const;
+    bool        renumbersParts() const;
+    void    beginMultiSolid(Print3DSolidScope scope = Print3DSolidPerCylinder);
+    void    endMultiSolid(Print3DSolidScope scope = Print3DSolidPerCylinder);
+    void    addManifestEntry(PWP_UINT32 ndx, PWP_UINT32 numSolids);
+    void    addManifestEntry(PWP_UINT32 ndx, PWP_UINT32 numSolids,
+                const char *name);
+    bool    writeManifest(const std::string &path);
+    bool    appendManifest(const std::string &path, FILE *out,
+                PWP_UINT32 &numSolids);
+    void    makeCylinder(const matrix33 &rot, const vector3 &tran0,
+                const vector3 &tran1, Cylinder &cyl);
+    void    writeCylBase(const CylBase &base, bool reverse);
+    void    writeCylSides(const CylBase &cb0, const CylBase &cb1);
+    RingCache * newRingCache();
+    void    writeCylinder(const vector3 &p0, const vector3 &p1);
+    void    writeCylinder(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1);
+    bool    isNewEdge(const Edge &e);
+    void    writeEdge(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1);
+    void    writeSegment(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1);
+    void    writeOwnedEdge(const PWGM_VERTDATA &vd0,
+                const PWGM_VERTDATA &vd1);
+    void    writePolygon(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1,
+                const PWGM_VERTDATA &vd2, const PWGM_VERTDATA &vd3);
+    void    writePolygon(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1,
+                const PWGM_VERTDATA &vd2);
+    void    writeThickenedPolygon(const vector3 &tp0, const vector3 &tp1,
+                const vector3 &tp2);
+    void    writeThickenedPolygon(const PWGM_VERTDATA &vd0,
+                const PWGM_VERTDATA &vd1, const PWGM_VERTDATA &vd2);
+    void    writeThickenedPolygon(const vector3 &qp0, const vector3 &qp1,
+                const vector3 &qp2, const vector3 &qp3);
+    void    writeThickenedPolygon(const PWGM_VERTDATA &vd0,
+                const PWGM_VERTDATA &vd1, const PWGM_VERTDATA &vd2,
+                const PWGM_VERTDATA &vd3);
+    void    writeElemData(const Print3DElem &ed, bool solid = false);
+    void    hashElemData(TessHash &hash, const Print3DElem &ed) const;
+    bool    scanEntity(PWP_UINT32 ndx, EdgeVisitor &visitor,
+                TessHash *hash = 0);
+    bool    scanEntities(PWP_UINT32 first, PWP_UINT32 end,
+                EdgeVisitor &visitor);
+    PWP_UINT32  countElements(PWP_UINT32 first, PWP_UINT32 end,
+                    bool blocks) const;
+    bool    writeCachedEntity(PWP_UINT32 ndx);
+    bool    hasOwnedEdges() const;
+    bool    writeOwnedEdges(PWP_UINT32 ndx);
+    bool    inPartition(PWP_UINT32 entityNdx) const;
+    void    initPartition();
+    void    seedPartitionEdges();
+    bool    mergePartitions();
+    void    write3mfHeader();
+    bool    write3mfFooter();
+    void    begin3mfObject();
+    void    end3mfObject();
+    void    write3mfComponent(const matrix33 &rot, const vector3 &tran,
+                double len);
+    void    warnSolidCondition(const char *mode);
+    void    writeSdfUnion();
+    bool    writeHubLattice();
+    void    writeBeamLattice();
+    void    writeLayerSlices();
+    void    writeCliPolyline(const std::vector<double> &loop);
+    void    writeHeader();
+    bool    writeFooter();
+    void    reportRings();
+    bool    buildEdgeFilter();
+    bool    buildChains();
+    bool    buildClip();
+    bool    buildWeld();
+    bool    writeEntity(PWP_UINT32 ndx);
+    void    writeEntities(bool blocks);
+    bool    hashGrid(TessHash &hash);
+    bool    checkpointKey(PWP_UINT64 &key);
+    PWP_UINT32  entitySlot(PWP_UINT32 ndx) const;
+    bool    isCheckpointed(PWP_UINT32 ndx) const;
+    bool    beginCheckpoint();
+    void    saveCheckpoint(PWP_UINT32 slot);
+    bool    endCheckpoint();
+    bool    restoreEntity(PWP_UINT32 ndx);
+    void    writePatches();
+    void    writeBlocks();
+    void    addRanges(bool blocks, std::vector<Range> &ranges) const;
+    bool    runRanges(WorkerPool &pool, RangeJob &job, size_t first,
+                size_t end, bool claim);
+    bool    skipRanges(const std::vector<Range> &ranges, size_t first,
+                size_t end);
+    void    writeRange(const Range &range, const std::string &buf);
+    void    writeParallel();
+    bool    fillBatches(PWP_UINT32 ndx, PipelineJob &job);
+    bool    fillBatches(bool blocks, PipelineJob &job);
+    void    makeBatchFacets(Batch &batch);
+    void    writeBatch(const Batch &batch);
+    void    writePipelined();
+    void    writeGroups(WorkerPool &pool, const EdgeGroups &groups,
+                std::string *index);
+    void    writeGroupedSolids();
+    void    writeOrderedEdges();
+
+    static void claimTask(void *ctx, PWP_UINT32 task);
+    static void writeTask(void *ctx, PWP_UINT32 task);
+    static void pipelineTask(void *ctx, PWP_UINT32 task);
+    static void groupTask(void *ctx, PWP_UINT32 task);
+
+private:
+    Print3DModel *  model_;     // the grid, or clip_ and weld_ over it
+    Print3DHost &   host_;
+    FILE *          fp_;
+    Print3DSettings settings_;
+    EdgeTable       edges_;
+    sysFILEPOS      numTrisPos_;
+    PWP_UINT32      numTris_;
+    PWP_UINT32      numSolids_;
+    char            curSolidName_[NameBufSize];
+    bool            multiSolid_;
+    PWP_UINT32      curEntity_;
+    PWP_UINT16      curAttr_;
+    std::string     manifest_;
+    ZipWriter *     zip_;
+    PWP_UINT32      numObjects_;
+    bool            objectOpen_;
+    std::string     buildItems_;
+    std::vector<vector3>    meshVerts_;
+    EdgeGraph *     graph_;
+    EdgeRegistry *  registry_;
+    PWP_UINT64      seq_;
+    PWP_UINT32      entitySolids_;
+    CylBase         masterCylBase_;
+    double          radius_;
+    double          zOffset_;
+    PWP_UINT        numBasePts_;
+    double          ringStep_;
+    RingCache *     rings_;
+    PWP_UINT32      numRings_;
+    PWP_UINT32      numRingHits_;
+    ClippedModel *  clip_;
+    WeldedModel *   weld_;
+    EdgeFilter *    edgeFilter_;
+    EdgeChains *    chains_;
+    bool            useCache_;
+    bool            useOwnedEdges_;
+    std::string     cachePath_;
+    TessCache       cache_;
+    std::string *   capture_;
+    Batch *         batch_;
+    EdgeVisitor *   edgeVisitor_;
+    PWP_UINT32      partFirst_;
+    PWP_UINT32      partEnd_;
+    bool            useCheckpoint_;
+    std::string     ckptPath_;
+    Checkpoint      ckpt_;
+    bool            ckptFailed_;
+    FILE *          outFp_;
+    PWP_UINT64      numBytes_;
+    time_t          ckptTime_;
+};
+
+#endif // _PRINT3DEXPORTER_H_
@@ -0,0 +1,92 @@
+/****************************************************************************
+ *
+ * Print3D grid model and host interfaces
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _PRINT3DMODEL_H_
+#define _PRINT3DMODEL_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include <string>
+
+
+//////////////////////////////////////////////////////////////////////////
+// An element with its vertex data already resolved                     //
+//////////////////////////////////////////////////////////////////////////
+struct Print3DElem {
+    PWGM_ENUM_ELEMTYPE  type;
+    PWP_UINT32          vertCnt;
+    PWGM_VERTDATA       vert[8];
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// How an entity's condition affects the export                         //
+//////////////////////////////////////////////////////////////////////////
+enum Print3DCond {
+    Print3DCondMesh,    // inflate the edges
+    Print3DCondHidden,  // skip the entity
+    Print3DCondSolid    // inflate the edges and thicken the 2D elements
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// The grid model consumed by Print3DExporter. Patches and blocks share  //
+// one entity index space with all patches first.                        //
+// CaeUnsPrint3D implements it on top of the Pointwise grid model and    //
+// the print3d command line driver implements it for mesh files.         //
+//////////////////////////////////////////////////////////////////////////
+class Print3DModel {
+public:
+    virtual ~Print3DModel() {}
+
+    virtual PWP_UINT32  entityCount() const = 0;
+    virtual bool        isBlock(PWP_UINT32 ndx) const = 0;
+    virtual Print3DCond condition(PWP_UINT32 ndx) const = 0;
+    virtual std::string entityName(PWP_UINT32 ndx) const = 0;
+    virtual PWP_UINT32  elementCount(PWP_UINT32 ndx) const = 0;
+    virtual bool        elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+                            Print3DElem &elem) const = 0;
+
+    // Optional. A model that already knows the unique edges returns the
+    // ones an entity writes first as vertex index pairs, in the order a
+    // serial export writes them, and looks its vertices up by index. The
+    // exporter then skips the element traversal and the edge lookup.
+    virtual bool        ownedEdges(PWP_UINT32, const PWP_UINT32 *&,
+                            PWP_UINT32 &) const {
+                            return false; }
+    virtual bool        vertexData(PWP_UINT32, PWGM_VERTDATA &) const {
+                            return false; }
+
+    // Optional. A model that knows the bounding box of an entity's
+    // vertices without visiting its elements returns it, so that the
+    // entities outside the clip regions are skipped.
+    virtual bool        bounds(PWP_UINT32, double *, double *) const {
+                            return false; }
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Progress, abort and message services provided by the caller           //
+//////////////////////////////////////////////////////////////////////////
+class Print3DHost {
+public:
+    virtual ~Print3DHost() {}
+
+    virtual bool    progressBeginStep(PWP_UINT32 total) = 0;
+    virtual bool    progressIncrement() = 0;
+    virtual void    progressEndStep() = 0;
+    virtual bool    aborted() = 0;
+    virtual void    sendInfoMsg(const char *msg) = 0;
+    virtual void    sendWarningMsg(const char *msg) = 0;
+    virtual void    sendErrorMsg(const char *msg) = 0;
+};
+
+#endif // _PRINT3DMODEL_H_
@@ -0,0 +1,378 @@
+/****************************************************************************
+ *
+ * class Print3DSweep
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Print3DSweep.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <utility>
+
+
+// Splits a comma-separated list into its trimmed items. Returns false if
+// an item is empty.
+static bool
+splitList(const std::string &list, std::vector<std::string> &items)
+{
+    items.clear();
+    if (std::string::npos == list.find_first_not_of(" \t")) {
+        return true;
+    }
+    std::string::size_type start = 0;
+    while (true) {
+        const std::string::size_type comma = list.find(',', start);
+        const std::string::size_type end = (std::string::npos == comma) ?
+            list.size() : comma;
+        const std::string::size_type first = list.find_first_not_of(" \t",
+            start);
+        const std::string::size_type last = list.find_last_not_of(" \t",
+            end - 1);
+        if ((std::string::npos == first) || (first >= end) ||
+                (std::string::npos == last) || (last < first)) {
+            return false;
+        }
+        items.push_back(list.substr(first, last - first + 1));
+        if (std::string::npos == comma) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return true;
+}
+
+
+static const char *
+formatExt(Print3DFormat format)
+{
+    const char *ret = ".stl";
+    switch (format) {
+        case Print3DFormat3mf:  ret = ".3mf"; break;
+        case Print3DFormatCli:  ret = ".cli"; break;
+        default:                break;
+    }
+    return ret;
+}
+
+
+//***************************************************************************
+// Collects the messages of a variant exported on a worker thread. They are
+// passed on from the sweep's thread once the variant is done. Progress and
+// aborts are handled between the batches of variants.
+class VariantHost : public Print3DHost {
+public:
+    VariantHost() :
+        msgs_()
+    {
+    }
+
+    virtual bool progressBeginStep(PWP_UINT32) {
+        return true;
+    }
+
+    virtual bool progressIncrement() {
+        return true;
+    }
+
+    virtual void progressEndStep() {
+    }
+
+    virtual bool aborted() {
+        return false;
+    }
+
+    virtual void sendInfoMsg(const char *msg) {
+        msgs_.push_back(Msg('I', msg));
+    }
+
+    virtual void sendWarningMsg(const char *msg) {
+        msgs_.push_back(Msg('W', msg));
+    }
+
+    virtual void sendErrorMsg(const char *msg) {
+        msgs_.push_back(Msg('E', msg));
+    }
+
+    void report(Print3DHost &host, const std::string &name) const {
+        for (size_t ii = 0; ii < msgs_.size(); ++ii) {
+            const std::string msg = name + ": " + msgs_[ii].second;
+            switch (msgs_[ii].first) {
+                case 'W':   host.sendWarningMsg(msg.c_str()); break;
+                case 'E':   host.sendErrorMsg(msg.c_str()); break;
+                default:    host.sendInfoMsg(msg.c_str()); break;
+            }
+        }
+    }
+
+private:
+    typedef std::pair<char, std::string> Msg;
+
+    std::vector<Msg>    msgs_;
+};
+
+
+//***************************************************************************
+// The variants of a batch and the snapshot shared by their tasks
+struct Print3DSweep::Job {
+    GridSnapshot *                          snapshot;
+    const std::vector<Print3DSettings> *    variants;
+    FILE *                                  fp;     // the file of variant 0
+    PWP_UINT32                              first;  // the batch's variant 0
+    std::vector<VariantHost> *              hosts;
+    std::vector<char> *                     ok;     // bool per variant
+};
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+Print3DSweep::Print3DSweep(Print3DModel &model, Print3DHost &host,
+        const Print3DSettings &settings) :
+    model_(model),
+    host_(host),
+    settings_(settings),
+    diameters_(),
+    numPoints_(),
+    formats_()
+{
+}
+
+
+Print3DSweep::~Print3DSweep()
+{
+}
+
+
+bool
+Print3DSweep::parseDiameters(const std::string &list,
+    std::vector<double> &vals)
+{
+    std::vector<std::string> items;
+    vals.clear();
+    if (!splitList(list, items)) {
+        return false;
+    }
+    for (size_t ii = 0; ii < items.size(); ++ii) {
+        char *end = 0;
+        const double val = strtod(items[ii].c_str(), &end);
+        if ((0 == end) || ('\0' != *end) || (val <= 0.0)) {
+            return false;
+        }
+        vals.push_back(val);
+    }
+    return true;
+}
+
+
+bool
+Print3DSweep::parseNumPoints(const std::string &list,
+    std::vector<PWP_UINT> &vals)
+{
+    std::vector<std::string> items;
+    vals.clear();
+    if (!splitList(list, items)) {
+        return false;
+    }
+    for (size_t ii = 0; ii < items.size(); ++ii) {
+        char *end = 0;
+        const long val = strtol(items[ii].c_str(), &end, 10);
+        if ((0 == end) || ('\0' != *end) || (val < MinNumBasePts) ||
+                (val > MaxNumBasePts)) {
+            return false;
+        }
+        vals.push_back((PWP_UINT)val);
+    }
+    return true;
+}
+
+
+bool
+Print3DSweep::parseFormats(const std::string &list,
+    std::vector<Print3DFormat> &vals)
+{
+    std::vector<std::string> items;
+    vals.clear();
+    if (!splitList(list, items)) {
+        return false;
+    }
+    for (size_t ii = 0; ii < items.size(); ++ii) {
+        if ("stl" == items[ii]) {
+            vals.push_back(Print3DFormatStl);
+        }
+        else if ("3mf" == items[ii]) {
+            vals.push_back(Print3DFormat3mf);
+        }
+        else if ("cli" == items[ii]) {
+            vals.push_back(Print3DFormatCli);
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+PWP_UINT32
+Print3DSweep::variantCount() const
+{
+    std::vector<Print3DSettings> variants;
+    makeVariants(variants);
+    return (PWP_UINT32)variants.size();
+}
+
+
+std::string
+Print3DSweep::variantPath(const std::string &dest,
+    const Print3DSettings &variant)
+{
+    char tag[64];
+    sprintf(tag, ".d%g.n%lu%s", variant.diameter,
+        (unsigned long)variant.numPoints, formatExt(variant.format));
+    std::string ret(dest);
+    std::string::size_type dot = ret.find_last_of('.');
+    std::string::size_type sep = ret.find_last_of("/\\");
+    if ((std::string::npos != dot) &&
+            ((std::string::npos == sep) || (dot > sep))) {
+        ret.erase(dot);
+    }
+    return ret + tag;
+}
+
+
+bool
+Print3DSweep::run(FILE *fp)
+{
+    if (settings_.tessCache || (settings_.numParts > 1) ||
+            settings_.mergeParts) {
+        host_.sendErrorMsg("A parameter sweep does not support partitions "
+            "or the tessellation cache");
+        return false;
+    }
+    std::vector<Print3DSettings> variants;
+    makeVariants(variants);
+    GridSnapshot snapshot;
+    std::string err;
+    if (!snapshot.load(model_, host_, err)) {
+        if (!host_.aborted()) {
+            host_.sendErrorMsg(err.c_str());
+        }
+        return false;
+    }
+    // the variants run in batches of one per thread so that the progress
+    // and aborts are handled on this thread
+    WorkerPool pool(settings_.numThreads);
+    const PWP_UINT32 numVariants = (PWP_UINT32)variants.size();
+    std::vector<VariantHost> hosts(numVariants);
+    std::vector<char> ok(numVariants, 0);
+    Job job;
+    job.snapshot = &snapshot;
+    job.variants = &variants;
+    job.fp = fp;
+    job.first = 0;
+    job.hosts = &hosts;
+    job.ok = &ok;
+    bool ret = false;
+    if (host_.progressBeginStep(numVariants)) {
+        const PWP_UINT32 batch = pool.threadCount();
+        ret = true;
+        for (PWP_UINT32 first = 0; ret && (first < numVariants);
+                first += batch) {
+            const PWP_UINT32 cnt = (numVariants - first < batch) ?
+                (numVariants - first) : batch;
+            job.first = first;
+            pool.run(exportTask, &job, cnt);
+            for (PWP_UINT32 ii = first; ii < first + cnt; ++ii) {
+                hosts[ii].report(host_, variants[ii].destPath);
+                ret = ret && (0 != ok[ii]) && host_.progressIncrement();
+            }
+        }
+        host_.progressEndStep();
+    }
+    char msg[128];
+    sprintf(msg, "Sweep: %lu variants from one traversal, %lu threads",
+        (unsigned long)numVariants, (unsigned long)pool.threadCount());
+    host_.sendInfoMsg(msg);
+    return ret && !host_.aborted();
+}
+
+
+void
+Print3DSweep::makeVariants(std::vector<Print3DSettings> &variants) const
+{
+    std::vector<Print3DFormat> formats(1, settings_.format);
+    for (size_t ii = 0; ii < formats_.size(); ++ii) {
+        if (std::find(formats.begin(), formats.end(), formats_[ii]) ==
+                formats.end()) {
+            formats.push_back(formats_[ii]);
+        }
+    }
+    std::vector<double> diameters(diameters_);
+    if (diameters.empty()) {
+        diameters.push_back(settings_.diameter);
+    }
+    std::vector<PWP_UINT> numPoints(numPoints_);
+    if (numPoints.empty()) {
+        numPoints.push_back(settings_.numPoints);
+    }
+    variants.clear();
+    for (size_t ff = 0; ff < formats.size(); ++ff) {
+        // the slices and beams do not depend on the cylinder points
+        const size_t numN = ((Print3DFormatCli == formats[ff]) ||
+            ((Print3DFormat3mf == formats[ff]) && settings_.beamLattice)) ?
+            1 : numPoints.size();
+        for (size_t dd = 0; dd < diameters.size(); ++dd) {
+            for (size_t nn = 0; nn < numN; ++nn) {
+                Print3DSettings variant = settings_;
+                variant.format = formats[ff];
+                variant.beamLattice = settings_.beamLattice &&
+                    (Print3DFormat3mf == formats[ff]);
+                variant.diameter = diameters[dd];
+                variant.numPoints = numPoints[nn];
+                // one thread per variant, the snapshot is read only
+                variant.numThreads = 1;
+                variant.threadSafeModel = true;
+                if (!variants.empty()) {
+                    variant.destPath = variantPath(settings_.destPath,
+                        variant);
+                }
+                variants.push_back(variant);
+            }
+        }
+    }
+}
+
+
+void
+Print3DSweep::exportTask(void *ctx, PWP_UINT32 task)
+{
+    Job &job = *(Job *)ctx;
+    const PWP_UINT32 ndx = job.first + task;
+    const Print3DSettings &settings = (*job.variants)[ndx];
+    VariantHost &host = (*job.hosts)[ndx];
+    FILE *fp = (0 == ndx) ? job.fp : fopen(settings.destPath.c_str(), "wb");
+    if (0 == fp) {
+        host.sendErrorMsg("cannot create file");
+        return;
+    }
+    Print3DExporter exporter(*job.snapshot, host, fp, settings);
+    bool ret = exporter.run();
+    if ((0 != ndx) && (0 != fclose(fp))) {
+        ret = false;
+    }
+    if ((0 != ndx) && !ret) {
+        remove(settings.destPath.c_str());
+    }
+    (*job.ok)[ndx] = ret ? 1 : 0;
+}
@@ -0,0 +1,89 @@
+/****************************************************************************
+ *
+ * class Print3DSweep
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _PRINT3DSWEEP_H_
+#define _PRINT3DSWEEP_H_
+
+#include "apiPWP.h"
+
+#include "GridSnapshot.h"
+#include "Print3DExporter.h"
+#include "Print3DModel.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// Exports one grid with several edge diameters, cylinder point counts  //
+// and formats. The grid is traversed and its edges are deduplicated    //
+// once into an in-memory GridSnapshot. Every combination is then       //
+// exported from the snapshot on its own worker thread.                 //
+//                                                                       //
+// The first combination goes to the export file. Each other one goes   //
+// to a file next to it, named by variantPath().                        //
+//////////////////////////////////////////////////////////////////////////
+class Print3DSweep {
+public:
+    Print3DSweep(Print3DModel &model, Print3DHost &host,
+        const Print3DSettings &settings);
+    ~Print3DSweep();
+
+    // Parse comma-separated lists such as "0.6,0.9,1.2", "5,8" or
+    // "stl,3mf". Each returns false on a bad value.
+    static bool parseDiameters(const std::string &list,
+                    std::vector<double> &vals);
+    static bool parseNumPoints(const std::string &list,
+                    std::vector<PWP_UINT> &vals);
+    static bool parseFormats(const std::string &list,
+                    std::vector<Print3DFormat> &vals);
+
+    // An empty list keeps the value in settings. The settings format is
+    // always exported first.
+    void    setDiameters(const std::vector<double> &vals) {
+                diameters_ = vals; }
+    void    setNumPoints(const std::vector<PWP_UINT> &vals) {
+                numPoints_ = vals; }
+    void    setFormats(const std::vector<Print3DFormat> &vals) {
+                formats_ = vals; }
+
+    PWP_UINT32  variantCount() const;
+
+    // the snapshot edge collection, the snapshot and the variants
+    static PWP_UINT32   majorSteps() {
+                            return 3; }
+
+    // Returns the file for variant next to dest. For example, "wing.stl"
+    // becomes "wing.d0.6.n5.3mf" for a 3MF export with diameter 0.6 and
+    // 5 points.
+    static std::string  variantPath(const std::string &dest,
+                            const Print3DSettings &variant);
+
+    // Exports all variants, the first one to fp
+    bool    run(FILE *fp);
+
+private:
+    struct Job;
+
+    void    makeVariants(std::vector<Print3DSettings> &variants) const;
+
+    static void exportTask(void *ctx, PWP_UINT32 task);
+
+private:
+    Print3DModel &              model_;
+    Print3DHost &               host_;
+    Print3DSettings             settings_;
+    std::vector<double>         diameters_;
+    std::vector<PWP_UINT>       numPoints_;
+    std::vector<Print3DFormat>  formats_;
+};
+
+#endif // _PRINT3DSWEEP_H_
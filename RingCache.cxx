@@ -0,0 +1,117 @@
+/****************************************************************************
+ *
+ * class RingCache
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <math.h>
+
+#include "RingCache.h"
+
+// the table slots, a power of 2
+const PWP_UINT32 NumSlotsLog2 = 11;
+
+// A cell index is in [-CellRange, CellRange] and is stored in 21 bits, so
+// the smallest step is 1 / CellRange. The largest step keeps every cell
+// center away from the origin.
+const PWP_INT32 CellRange = 1 << 19;
+const double MinStep = 1.0 / CellRange;
+const double MaxStep = 0.25;
+
+// no cell has every index bit set
+const PWP_UINT64 EmptyKey = ~(PWP_UINT64)0;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+RingCache::RingCache(const CylBase &master, PWP_UINT numPts, double step) :
+    rings_(1 << NumSlotsLog2),
+    master_(),
+    numPts_(numPts),
+    step_(step)
+{
+    for (PWP_UINT ii = 0; ii < numPts_; ++ii) {
+        master_[ii] = master[ii];
+    }
+    for (size_t ii = 0; ii < rings_.size(); ++ii) {
+        rings_[ii].key = EmptyKey;
+    }
+}
+
+
+RingCache::~RingCache()
+{
+}
+
+
+double
+RingCache::stepFor(double radius, double tolerance)
+{
+    // Once normalized, a cell center is within step * sqrt(3) of every
+    // direction in the cell. For directions with z >= 0, the rotation
+    // from +z moves a point of the ring by at most twice the radius times
+    // the change of direction.
+    if (!(radius > 0.0) || !(tolerance > 0.0)) {
+        return 0.0;
+    }
+    const double step = tolerance / (2.0 * sqrt(3.0) * radius);
+    if (step < MinStep) {
+        return 0.0;
+    }
+    return (step > MaxStep) ? MaxStep : step;
+}
+
+
+const RingCache::Ring &
+RingCache::lookup(const vector3 &dir, bool &hit)
+{
+    const PWP_UINT64 k = key(dir);
+    Ring &ring = rings_[(k * 0x9E3779B97F4A7C15ULL) >> (64 - NumSlotsLog2)];
+    hit = (k == ring.key);
+    if (!hit) {
+        fill(ring, k);
+    }
+    return ring;
+}
+
+
+PWP_UINT64
+RingCache::key(const vector3 &dir) const
+{
+    PWP_UINT64 ret = 0;
+    for (int ii = 0; ii < 3; ++ii) {
+        const PWP_INT32 cell = (PWP_INT32)floor(dir[ii] / step_ + 0.5);
+        ret = (ret << 21) | (PWP_UINT64)(cell + CellRange);
+    }
+    return ret;
+}
+
+
+void
+RingCache::fill(Ring &ring, PWP_UINT64 k) const
+{
+    const PWP_UINT64 Mask = (1 << 21) - 1;
+    ring.key = k;
+    ring.axis.set(
+        (double)((PWP_INT32)((k >> 42) & Mask) - CellRange) * step_,
+        (double)((PWP_INT32)((k >> 21) & Mask) - CellRange) * step_,
+        (double)((PWP_INT32)(k & Mask) - CellRange) * step_);
+    ring.axis.normalize();
+    vector3 zaxis(0, 0, 1);
+    cml::matrix_rotation_vec_to_vec(ring.rot, ring.axis, zaxis);
+    for (PWP_UINT ii = 0; ii < numPts_; ++ii) {
+        ring.base[ii] = master_[ii] * ring.rot;
+    }
+    // the sides run from base 1 back to base 0, as in writeCylSides()
+    for (PWP_UINT ii = 0; ii < numPts_; ++ii) {
+        const vector3 &next = ring.base[(ii + 1 < numPts_) ? (ii + 1) : 0];
+        ring.sideNorms[ii] = cml::cross(-ring.axis,
+            next - ring.base[ii]).normalize();
+    }
+}
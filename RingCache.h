@@ -0,0 +1,66 @@
+/****************************************************************************
+ *
+ * class RingCache
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _RINGCACHE_H_
+#define _RINGCACHE_H_
+
+#include "apiPWP.h"
+
+#include "Print3DExporter.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// The cylinder base rings of an exporter, rotated onto quantized edge  //
+// directions. Each unit direction is rounded to the center of a cell   //
+// of a grid with the given step, and the ring is rotated onto the     //
+// center. A ring depends only on its cell, so an export is the same    //
+// whichever edge fills a slot first.                                   //
+//                                                                       //
+// The table is direct mapped: a cell replaces the ring in its slot.    //
+//////////////////////////////////////////////////////////////////////////
+class RingCache {
+public:
+    // the ring of one cell and the normals of its facets
+    struct Ring {
+        PWP_UINT64  key;
+        matrix33    rot;        // rotates the master ring onto axis
+        vector3     axis;       // the cell center, normalized
+        CylBase     base;       // the rotated master ring
+        CylBase     sideNorms;  // the normal of side ii, base[ii] to
+                                // base[ii + 1]
+    };
+
+    // master holds numPts points in the z=0 plane
+    RingCache(const CylBase &master, PWP_UINT numPts, double step);
+    ~RingCache();
+
+    // Returns the cell step that keeps the ring points of a cylinder with
+    // the given radius within tolerance of their exact position, or 0 if
+    // the tolerance is too small to quantize.
+    static double   stepFor(double radius, double tolerance);
+
+    // Returns the ring of the unit vector dir, which must have dir[2] >= 0.
+    // hit is true if the ring was in the table.
+    const Ring &    lookup(const vector3 &dir, bool &hit);
+
+private:
+    PWP_UINT64  key(const vector3 &dir) const;
+    void        fill(Ring &ring, PWP_UINT64 k) const;
+
+private:
+    std::vector<Ring>   rings_;
+    CylBase             master_;
+    PWP_UINT            numPts_;
+    double              step_;
+};
+
+#endif // _RINGCACHE_H_
@@ -0,0 +1,367 @@
+/****************************************************************************
+ *
+ * class SdfMesher
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <math.h>
+
+#include <map>
+
+#include "SdfMesher.h"
+
+// The 6 tetrahedra of a cell. The corners are numbered by their offset
+// bits: x=1, y=2, z=4. All share the diagonal from corner 0 to corner 7.
+static const int CellTets[6][4] = {
+    { 0, 1, 3, 7 },
+    { 0, 1, 5, 7 },
+    { 0, 2, 3, 7 },
+    { 0, 2, 6, 7 },
+    { 0, 4, 5, 7 },
+    { 0, 4, 6, 7 }
+};
+
+// A sample closer than this fraction of the spacing to the surface is
+// moved outside by it. A crossing then never lands within single
+// precision of a lattice point, where the crossings of its other lattice
+// edges would meet it in a zero-area facet. The surface moves far less
+// than the sampling error.
+const double MinSampleOffset = 1.0E-3;
+
+// A facet whose doubled area is below this fraction of the spacing
+// squared is dropped. It has coincident vertices, and its neighbors
+// already meet each other.
+const double MinFacetArea = 1.0E-12;
+
+
+static PWP_INT32
+floorDiv(PWP_INT32 a, PWP_INT32 b)
+{
+    return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+
+static double
+segmentDistance(const double p[3], const double a[3], const double b[3])
+{
+    double ab[3];
+    double ap[3];
+    double abab = 0;
+    double apab = 0;
+    for (int kk = 0; kk < 3; ++kk) {
+        ab[kk] = b[kk] - a[kk];
+        ap[kk] = p[kk] - a[kk];
+        abab += ab[kk] * ab[kk];
+        apab += ap[kk] * ab[kk];
+    }
+    double t = (abab > 0) ? (apab / abab) : 0;
+    if (t < 0) {
+        t = 0;
+    }
+    else if (t > 1) {
+        t = 1;
+    }
+    double dd = 0;
+    for (int kk = 0; kk < 3; ++kk) {
+        const double d = ap[kk] - t * ab[kk];
+        dd += d * d;
+    }
+    return sqrt(dd);
+}
+
+
+static bool
+latticeLess(const PWP_INT32 a[3], const PWP_INT32 b[3])
+{
+    if (a[2] != b[2]) {
+        return a[2] < b[2];
+    }
+    if (a[1] != b[1]) {
+        return a[1] < b[1];
+    }
+    return a[0] < b[0];
+}
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+SdfMesher::SdfMesher(const EdgeGraph &graph, double radius, double spacing) :
+    graph_(graph),
+    radius_(radius),
+    spacing_(spacing),
+    tiles_()
+{
+    origin_[0] = origin_[1] = origin_[2] = 0;
+}
+
+
+SdfMesher::~SdfMesher()
+{
+}
+
+
+PWP_UINT32
+SdfMesher::build()
+{
+    tiles_.clear();
+    double minXyz[3];
+    double maxXyz[3];
+    if (!graph_.bounds(minXyz, maxXyz)) {
+        return 0;
+    }
+    // an edge can affect the samples within radius + spacing of it
+    const double reach = radius_ + spacing_;
+    for (int kk = 0; kk < 3; ++kk) {
+        origin_[kk] = minXyz[kk] - reach - spacing_;
+    }
+    typedef std::map<std::vector<PWP_INT32>, std::vector<PWP_UINT32> > TileMap;
+    TileMap bins;
+    std::vector<PWP_INT32> key(3);
+    const PWP_UINT32 numEdges = graph_.edgeCount();
+    for (PWP_UINT32 ee = 0; ee < numEdges; ++ee) {
+        const double *a = graph_.xyz(graph_.edgeVert(ee, 0));
+        const double *b = graph_.xyz(graph_.edgeVert(ee, 1));
+        PWP_INT32 lo[3];
+        PWP_INT32 hi[3];
+        for (int kk = 0; kk < 3; ++kk) {
+            const double mn = ((a[kk] < b[kk]) ? a[kk] : b[kk]) - reach;
+            const double mx = ((a[kk] > b[kk]) ? a[kk] : b[kk]) + reach;
+            lo[kk] = floorDiv((PWP_INT32)floor((mn - origin_[kk]) / spacing_),
+                TileCells);
+            hi[kk] = floorDiv((PWP_INT32)floor((mx - origin_[kk]) / spacing_),
+                TileCells);
+        }
+        for (key[2] = lo[2]; key[2] <= hi[2]; ++key[2]) {
+            for (key[1] = lo[1]; key[1] <= hi[1]; ++key[1]) {
+                for (key[0] = lo[0]; key[0] <= hi[0]; ++key[0]) {
+                    bins[key].push_back(ee);
+                }
+            }
+        }
+    }
+    tiles_.resize(bins.size());
+    size_t ndx = 0;
+    for (TileMap::iterator it = bins.begin(); it != bins.end(); ++it, ++ndx) {
+        Tile &tile = tiles_[ndx];
+        tile.ijk[0] = it->first[0];
+        tile.ijk[1] = it->first[1];
+        tile.ijk[2] = it->first[2];
+        tile.edges.swap(it->second);
+    }
+    return tileCount();
+}
+
+
+void
+SdfMesher::mesh(WorkerPool &pool, PWP_UINT32 first, PWP_UINT32 count,
+    std::vector< std::vector<double> > &tris)
+{
+    tris.resize(count);
+    MeshJob job;
+    job.mesher = this;
+    job.first = first;
+    job.tris = &tris;
+    pool.run(meshTask, &job, count);
+}
+
+
+void
+SdfMesher::meshTask(void *ctx, PWP_UINT32 task)
+{
+    MeshJob *job = (MeshJob *)ctx;
+    std::vector<double> &tris = (*job->tris)[task];
+    tris.clear();
+    job->mesher->meshTile(job->mesher->tiles_[job->first + task], tris);
+}
+
+
+void
+SdfMesher::latticePoint(const PWP_INT32 g[3], double p[3]) const
+{
+    p[0] = origin_[0] + g[0] * spacing_;
+    p[1] = origin_[1] + g[1] * spacing_;
+    p[2] = origin_[2] + g[2] * spacing_;
+}
+
+
+double
+SdfMesher::distance(const double p[3], const Tile &tile) const
+{
+    // the edges not in the tile are farther than spacing_ from p
+    double ret = spacing_;
+    for (size_t ii = 0; ii < tile.edges.size(); ++ii) {
+        const PWP_UINT32 ee = tile.edges[ii];
+        const double d = segmentDistance(p, graph_.xyz(graph_.edgeVert(ee, 0)),
+            graph_.xyz(graph_.edgeVert(ee, 1))) - radius_;
+        if (d < ret) {
+            ret = d;
+        }
+    }
+    return ret;
+}
+
+
+void
+SdfMesher::meshTile(const Tile &tile, std::vector<double> &tris) const
+{
+    const int N = TileCells + 1;
+    double vals[N][N][N];
+    PWP_INT32 base[3];
+    PWP_INT32 g[3];
+    double p[3];
+    int ii;
+    int jj;
+    int kk;
+    for (int c = 0; c < 3; ++c) {
+        base[c] = tile.ijk[c] * TileCells;
+    }
+    for (kk = 0; kk < N; ++kk) {
+        for (jj = 0; jj < N; ++jj) {
+            for (ii = 0; ii < N; ++ii) {
+                g[0] = base[0] + ii;
+                g[1] = base[1] + jj;
+                g[2] = base[2] + kk;
+                latticePoint(g, p);
+                // a function of the distance alone, so neighboring tiles
+                // still compute identical values
+                double val = distance(p, tile);
+                if (fabs(val) < MinSampleOffset * spacing_) {
+                    val = MinSampleOffset * spacing_;
+                }
+                vals[kk][jj][ii] = val;
+            }
+        }
+    }
+
+    const double minCross = MinFacetArea * spacing_ * spacing_;
+    PWP_INT32 cg[8][3];     // corner lattice indices
+    double cv[8];           // corner values
+    for (kk = 0; kk < TileCells; ++kk) {
+        for (jj = 0; jj < TileCells; ++jj) {
+            for (ii = 0; ii < TileCells; ++ii) {
+                int numIn = 0;
+                for (int c = 0; c < 8; ++c) {
+                    const int di = c & 1;
+                    const int dj = (c >> 1) & 1;
+                    const int dk = (c >> 2) & 1;
+                    cv[c] = vals[kk + dk][jj + dj][ii + di];
+                    cg[c][0] = base[0] + ii + di;
+                    cg[c][1] = base[1] + jj + dj;
+                    cg[c][2] = base[2] + kk + dk;
+                    if (cv[c] < 0) {
+                        ++numIn;
+                    }
+                }
+                if ((0 == numIn) || (8 == numIn)) {
+                    continue;
+                }
+                for (int t = 0; t < 6; ++t) {
+                    const int *tet = CellTets[t];
+                    int in[4];
+                    int out[4];
+                    int nIn = 0;
+                    int nOut = 0;
+                    for (int c = 0; c < 4; ++c) {
+                        if (cv[tet[c]] < 0) {
+                            in[nIn++] = tet[c];
+                        }
+                        else {
+                            out[nOut++] = tet[c];
+                        }
+                    }
+                    if ((0 == nIn) || (0 == nOut)) {
+                        continue;
+                    }
+                    // the crossings, in cyclic order for the quad case
+                    int ends[4][2];
+                    int numVerts = 0;
+                    if (1 == nIn) {
+                        for (int c = 0; c < 3; ++c) {
+                            ends[numVerts][0] = in[0];
+                            ends[numVerts++][1] = out[c];
+                        }
+                    }
+                    else if (3 == nIn) {
+                        for (int c = 0; c < 3; ++c) {
+                            ends[numVerts][0] = in[c];
+                            ends[numVerts++][1] = out[0];
+                        }
+                    }
+                    else {
+                        ends[0][0] = in[0]; ends[0][1] = out[0];
+                        ends[1][0] = in[0]; ends[1][1] = out[1];
+                        ends[2][0] = in[1]; ends[2][1] = out[1];
+                        ends[3][0] = in[1]; ends[3][1] = out[0];
+                        numVerts = 4;
+                    }
+                    double v[4][3];
+                    for (int c = 0; c < numVerts; ++c) {
+                        int a = ends[c][0];
+                        int b = ends[c][1];
+                        if (latticeLess(cg[b], cg[a])) {
+                            const int tmp = a;
+                            a = b;
+                            b = tmp;
+                        }
+                        double pa[3];
+                        double pb[3];
+                        latticePoint(cg[a], pa);
+                        latticePoint(cg[b], pb);
+                        const double s = cv[a] / (cv[a] - cv[b]);
+                        for (int d = 0; d < 3; ++d) {
+                            v[c][d] = pa[d] + s * (pb[d] - pa[d]);
+                        }
+                    }
+                    // the outward direction, from the inside corners to
+                    // the outside corners
+                    double dir[3] = { 0, 0, 0 };
+                    for (int d = 0; d < 3; ++d) {
+                        for (int c = 0; c < nOut; ++c) {
+                            dir[d] += (double)cg[out[c]][d] / nOut;
+                        }
+                        for (int c = 0; c < nIn; ++c) {
+                            dir[d] -= (double)cg[in[c]][d] / nIn;
+                        }
+                    }
+                    for (int f = 0; f + 2 < numVerts; ++f) {
+                        const double *v0 = v[0];
+                        const double *v1 = v[f + 1];
+                        const double *v2 = v[f + 2];
+                        double e1[3];
+                        double e2[3];
+                        for (int d = 0; d < 3; ++d) {
+                            e1[d] = v1[d] - v0[d];
+                            e2[d] = v2[d] - v0[d];
+                        }
+                        const double n[3] = {
+                            e1[1] * e2[2] - e1[2] * e2[1],
+                            e1[2] * e2[0] - e1[0] * e2[2],
+                            e1[0] * e2[1] - e1[1] * e2[0]
+                        };
+                        const double dot = n[0] * dir[0] + n[1] * dir[1] +
+                            n[2] * dir[2];
+                        if ((0 == dot) || (sqrt(n[0] * n[0] + n[1] * n[1] +
+                                n[2] * n[2]) < minCross)) {
+                            // degenerate
+                            continue;
+                        }
+                        if (dot < 0) {
+                            const double *tmp = v1;
+                            v1 = v2;
+                            v2 = tmp;
+                        }
+                        tris.insert(tris.end(), v0, v0 + 3);
+                        tris.insert(tris.end(), v1, v1 + 3);
+                        tris.insert(tris.end(), v2, v2 + 3);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+ *
+ * class SdfMesher
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _SDFMESHER_H_
+#define _SDFMESHER_H_
+
+#include "apiPWP.h"
+
+#include "EdgeGraph.h"
+#include "WorkerPool.h"
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// Extracts the surface of the union of the edge capsules (the inflated  //
+// edges with round ends) from their signed distance field.              //
+//                                                                       //
+// The field is sampled on a lattice with the given spacing. The lattice //
+// is split into tiles of TileCells^3 cells and only tiles near an edge  //
+// exist. Each tile lists the edges that can affect its samples. Values  //
+// are clamped to +spacing, which makes every tile compute identical     //
+// values on the samples it shares with its neighbors. Values near zero  //
+// are moved off the surface so that no facet has coincident vertices.   //
+//                                                                       //
+// Each cell is split into 6 tetrahedra around its main diagonal. The    //
+// split is the same in every cell so the tetrahedra are conforming and  //
+// marching them yields a closed, manifold surface. Edge crossings are   //
+// interpolated from the lower lattice point so that neighboring tiles   //
+// produce bitwise identical vertices.                                   //
+//////////////////////////////////////////////////////////////////////////
+class SdfMesher {
+public:
+    enum { TileCells = 8 };
+
+    SdfMesher(const EdgeGraph &graph, double radius, double spacing);
+    ~SdfMesher();
+
+    // bins the edges into tiles and returns the number of tiles
+    PWP_UINT32  build();
+
+    PWP_UINT32  tileCount() const {
+                    return (PWP_UINT32)tiles_.size(); }
+
+    // Meshes tiles [first, first + count) on the pool. On return, tris[ii]
+    // holds the triangles of tile first + ii as 9 coordinates each, wound
+    // counter-clockwise seen from outside.
+    void    mesh(WorkerPool &pool, PWP_UINT32 first, PWP_UINT32 count,
+                std::vector< std::vector<double> > &tris);
+
+private:
+    struct Tile {
+        PWP_INT32               ijk[3];
+        std::vector<PWP_UINT32> edges;
+    };
+
+    struct MeshJob {
+        SdfMesher *                             mesher;
+        PWP_UINT32                              first;
+        std::vector< std::vector<double> > *    tris;
+    };
+
+    static void meshTask(void *ctx, PWP_UINT32 task);
+
+    void    meshTile(const Tile &tile, std::vector<double> &tris) const;
+    double  distance(const double p[3], const Tile &tile) const;
+    void    latticePoint(const PWP_INT32 g[3], double p[3]) const;
+
+private:
+    const EdgeGraph &   graph_;
+    double              radius_;
+    double              spacing_;
+    double              origin_[3];
+    std::vector<Tile>   tiles_;
+};
+
+#endif // _SDFMESHER_H_
@@ -0,0 +1,185 @@
+/****************************************************************************
+ *
+ * STL partition merge utilities
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "StlMerge.h"
+
+const size_t StlHeaderSize = 80;
+const size_t StlFacetSize = 50; // 12 REAL32 + 1 UINT16
+
+
+std::string
+stlPartPath(const std::string &dest, PWP_UINT32 rank)
+{
+    char tag[32];
+    sprintf(tag, ".part%lu", (unsigned long)rank);
+    std::string ret(dest);
+    std::string::size_type dot = ret.find_last_of('.');
+    std::string::size_type sep = ret.find_last_of("/\\");
+    if ((std::string::npos == dot) ||
+            ((std::string::npos != sep) && (dot < sep))) {
+        // no extension
+        ret += tag;
+    }
+    else {
+        ret.insert(dot, tag);
+    }
+    return ret;
+}
+
+
+static bool
+copyBytes(FILE *in, FILE *out, PWP_UINT64 size)
+{
+    char buf[64 * 1024];
+    while (size > 0) {
+        size_t cnt = (size < sizeof(buf)) ? (size_t)size : sizeof(buf);
+        if ((1 != fread(buf, cnt, 1, in)) || (1 != fwrite(buf, cnt, 1, out))) {
+            return false;
+        }
+        size -= cnt;
+    }
+    return true;
+}
+
+
+static bool
+renumberBinary(FILE *in, FILE *out, PWP_UINT32 cnt,
+    const StlSolidAttr &renumber, PWP_UINT32 &numSolids)
+{
+    // consecutive solids always have different plain ids
+    unsigned char buf[1024 * StlFacetSize];
+    PWP_UINT16 lastId = 0;
+    PWP_UINT16 attr = 0;
+    while (cnt > 0) {
+        const PWP_UINT32 num = (cnt < 1024) ? cnt : 1024;
+        if (1 != fread(buf, num * StlFacetSize, 1, in)) {
+            return false;
+        }
+        for (PWP_UINT32 ii = 0; ii < num; ++ii) {
+            unsigned char *facetAttr = buf + (ii + 1) * StlFacetSize -
+                sizeof(PWP_UINT16);
+            PWP_UINT16 id;
+            memcpy(&id, facetAttr, sizeof(id));
+            if (0 == id) {
+                continue;
+            }
+            if (id != lastId) {
+                lastId = id;
+                attr = renumber.attribute(++numSolids);
+            }
+            memcpy(facetAttr, &attr, sizeof(attr));
+        }
+        if (1 != fwrite(buf, num * StlFacetSize, 1, out)) {
+            return false;
+        }
+        cnt -= num;
+    }
+    return true;
+}
+
+
+static bool
+appendBinary(FILE *in, FILE *out, PWP_UINT32 &numTris,
+    const StlSolidAttr *renumber, PWP_UINT32 &numSolids)
+{
+    char header[StlHeaderSize];
+    PWP_UINT32 cnt = 0;
+    bool ret = (1 == fread(header, sizeof(header), 1, in)) &&
+        (1 == fread(&cnt, sizeof(cnt), 1, in));
+    if (ret && (0 != renumber)) {
+        ret = renumberBinary(in, out, cnt, *renumber, numSolids);
+    }
+    else if (ret) {
+        ret = copyBytes(in, out, (PWP_UINT64)cnt * StlFacetSize);
+    }
+    if (ret) {
+        numTris += cnt;
+    }
+    return ret;
+}
+
+
+static bool
+isSolidLine(const char *line, const char *keyword)
+{
+    while (' ' == *line || '\t' == *line) {
+        ++line;
+    }
+    const size_t len = strlen(keyword);
+    return (0 == strncmp(line, keyword, len)) &&
+        ((' ' == line[len]) || ('\n' == line[len]) || ('\r' == line[len]) ||
+         ('\0' == line[len]));
+}
+
+
+static void
+renumberSolidLine(char *line, size_t size, PWP_UINT32 solidNum)
+{
+    // replaces the number after the last '_' of the solid name
+    char *num = strrchr(line, '_');
+    if (0 == num) {
+        return;
+    }
+    char *end = 0;
+    strtoul(num + 1, &end, 10);
+    char buf[32];
+    sprintf(buf, "_%06lu", (unsigned long)solidNum);
+    const std::string renamed = std::string(line, num) + buf + end;
+    if (renamed.size() < size) {
+        strcpy(line, renamed.c_str());
+    }
+}
+
+
+static bool
+appendAscii(FILE *in, FILE *out, bool stripSolid, bool renumber,
+    PWP_UINT32 &numSolids)
+{
+    char buf[1024];
+    bool lineStart = true;
+    while (0 != fgets(buf, sizeof(buf), in)) {
+        // facet lines never begin with solid or endsolid
+        const bool begin = lineStart && isSolidLine(buf, "solid");
+        const bool end = lineStart && isSolidLine(buf, "endsolid");
+        const bool skip = stripSolid && (begin || end);
+        if (renumber && begin) {
+            renumberSolidLine(buf, sizeof(buf), ++numSolids);
+        }
+        else if (renumber && end) {
+            renumberSolidLine(buf, sizeof(buf), numSolids);
+        }
+        if (!skip && (EOF == fputs(buf, out))) {
+            return false;
+        }
+        // fgets() stops early on long lines
+        lineStart = (0 != strchr(buf, '\n'));
+    }
+    return !ferror(in);
+}
+
+
+bool
+stlAppendPart(const std::string &path, FILE *out, bool binary,
+    bool stripSolid, PWP_UINT32 &numTris, const StlSolidAttr *renumber,
+    PWP_UINT32 &numSolids)
+{
+    FILE *in = fopen(path.c_str(), (binary ? "rb" : "r"));
+    if (0 == in) {
+        return false;
+    }
+    const bool ret = binary ?
+        appendBinary(in, out, numTris, renumber, numSolids) :
+        appendAscii(in, out, stripSolid, (0 != renumber), numSolids);
+    fclose(in);
+    return ret;
+}
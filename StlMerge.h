@@ -0,0 +1,49 @@
+/****************************************************************************
+ *
+ * STL partition merge utilities
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _STLMERGE_H_
+#define _STLMERGE_H_
+
+#include "apiPWP.h"
+
+#include <stdio.h>
+#include <string>
+
+
+//////////////////////////////////////////////////////////////////////////
+// Gives the binary attribute of a renumbered solid                     //
+//////////////////////////////////////////////////////////////////////////
+class StlSolidAttr {
+public:
+    virtual ~StlSolidAttr() {}
+
+    virtual PWP_UINT16 attribute(PWP_UINT32 solidNum) const = 0;
+};
+
+
+// Returns the file name used by partition rank for the final export file
+// dest. For example, "wing.stl" becomes "wing.part3.stl" for rank 3.
+std::string stlPartPath(const std::string &dest, PWP_UINT32 rank);
+
+// Appends the facets of the partial STL file at path to out. The binary
+// header and triangle count are consumed and numTris is incremented by the
+// part's triangle count. For ASCII parts written without multiple solids,
+// set stripSolid to drop the part's enclosing solid/endsolid lines.
+//
+// If renumber is not null, the part numbers its solids from 1: binary
+// facets carry plain ids (0 outside any solid) and ASCII solid names end
+// in "_<number>". The solids are renumbered to follow the numSolids solids
+// of the earlier parts, with the binary attributes given by renumber, and
+// numSolids is incremented by the part's solid count.
+bool stlAppendPart(const std::string &path, FILE *out, bool binary,
+        bool stripSolid, PWP_UINT32 &numTris, const StlSolidAttr *renumber,
+        PWP_UINT32 &numSolids);
+
+#endif // _STLMERGE_H_
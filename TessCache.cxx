@@ -0,0 +1,335 @@
+/****************************************************************************
+ *
+ * class TessCache
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "TessCache.h"
+
+static const char       CacheMagic[8] = { 'P','3','D','C','A','C','H','E' };
+static const PWP_UINT32 CacheVersion = 1;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+TessHash::TessHash() :
+    h_(14695981039346656037ULL)
+{
+}
+
+
+void
+TessHash::add(const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t ii = 0; ii < size; ++ii) {
+        h_ ^= p[ii];
+        h_ *= 1099511628211ULL;
+    }
+}
+
+
+void
+TessHash::add(PWP_UINT32 val)
+{
+    add(&val, sizeof(val));
+}
+
+
+void
+TessHash::add(double val)
+{
+    add(&val, sizeof(val));
+}
+
+
+void
+TessHash::add(const char *str)
+{
+    // include the terminator so that "ab","c" and "a","bc" differ
+    add(str, (str ? strlen(str) + 1 : 0));
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+template<typename T>
+static bool
+readVal(FILE *fp, T &val)
+{
+    return 1 == fread(&val, sizeof(val), 1, fp);
+}
+
+
+template<typename T>
+static bool
+writeVal(FILE *fp, const T &val)
+{
+    return 1 == fwrite(&val, sizeof(val), 1, fp);
+}
+
+
+// Moves forward size bytes. Returns false if the file ends before them.
+static bool
+skip(FILE *fp, PWP_UINT64 size)
+{
+    const PWP_UINT64 MaxStep = 0x40000000;
+    while (size > 0) {
+        const PWP_UINT64 step = (size < MaxStep) ? size : MaxStep;
+        if (0 != fseek(fp, (long)step - 1, SEEK_CUR) || (EOF == fgetc(fp))) {
+            return false;
+        }
+        size -= step;
+    }
+    return true;
+}
+
+
+TessCache::TessCache() :
+    path_(),
+    tmpPath_(),
+    oldFp_(0),
+    fp_(0),
+    entries_(),
+    numNew_(0),
+    countPos_(),
+    endPos_(),
+    headerPos_(),
+    chunk_(0),
+    readFp_(0),
+    ok_(false),
+    hits_(0),
+    misses_(0)
+{
+}
+
+
+TessCache::~TessCache()
+{
+    // an export that did not save keeps the old cache
+    discard();
+}
+
+
+bool
+TessCache::open(const std::string &path)
+{
+    discard();
+    path_ = path;
+    tmpPath_ = path + ".tmp";
+    fp_ = fopen(tmpPath_.c_str(), "w+b");
+    // the count is patched by save()
+    ok_ = (0 != fp_) && (1 == fwrite(CacheMagic, sizeof(CacheMagic), 1, fp_))
+        && writeVal(fp_, CacheVersion) && (0 == pwpFileGetpos(fp_, &countPos_))
+        && writeVal(fp_, numNew_) && (0 == pwpFileGetpos(fp_, &endPos_));
+    oldFp_ = fopen(path.c_str(), "rb");
+    if (0 == oldFp_) {
+        // no cache yet - not an error
+        return true;
+    }
+    if (!index()) {
+        // corrupt or stale format - start over
+        entries_.clear();
+        fclose(oldFp_);
+        oldFp_ = 0;
+        return false;
+    }
+    return true;
+}
+
+
+bool
+TessCache::index()
+{
+    // the positions of the streams, which are skipped
+    char magic[sizeof(CacheMagic)];
+    PWP_UINT32 version;
+    PWP_UINT32 count;
+    if ((1 != fread(magic, sizeof(magic), 1, oldFp_)) ||
+            (0 != memcmp(magic, CacheMagic, sizeof(magic))) ||
+            !readVal(oldFp_, version) || (CacheVersion != version) ||
+            !readVal(oldFp_, count)) {
+        return false;
+    }
+    PWP_UINT64 key;
+    TessEntry entry;
+    entry.isNew = false;
+    entry.used = false;
+    for (PWP_UINT32 ii = 0; ii < count; ++ii) {
+        if (!readVal(oldFp_, key) || !readVal(oldFp_, entry.numTris) ||
+                !readVal(oldFp_, entry.numSolids) ||
+                !readVal(oldFp_, entry.size) ||
+                (0 != pwpFileGetpos(oldFp_, &entry.pos)) ||
+                !skip(oldFp_, entry.size)) {
+            return false;
+        }
+        entries_[key] = entry;
+    }
+    return true;
+}
+
+
+bool
+TessCache::save()
+{
+    // Append the old streams that were used, patch the count and replace
+    // the old cache. rename() does not replace an existing file.
+    if (0 == fp_) {
+        return false;
+    }
+    EntryMap::const_iterator it = entries_.begin();
+    for (; ok_ && (it != entries_.end()); ++it) {
+        if (it->second.used && !it->second.isNew) {
+            ok_ = copy(it->first, it->second);
+        }
+    }
+    ok_ = ok_ && (0 == pwpFileSetpos(fp_, &countPos_)) &&
+        writeVal(fp_, numNew_);
+    ok_ = (0 == fclose(fp_)) && ok_;
+    fp_ = 0;
+    if (0 != oldFp_) {
+        fclose(oldFp_);
+        oldFp_ = 0;
+    }
+    if (ok_) {
+        remove(path_.c_str());
+        ok_ = (0 == rename(tmpPath_.c_str(), path_.c_str()));
+    }
+    if (!ok_) {
+        // never leave a partial cache behind
+        remove(tmpPath_.c_str());
+    }
+    entries_.clear();
+    return ok_;
+}
+
+
+const TessEntry *
+TessCache::find(PWP_UINT64 key)
+{
+    // The entries written by this export are also found, for identical
+    // entities. A stream being appended is not complete yet.
+    EntryMap::iterator it = entries_.find(key);
+    if ((it == entries_.end()) || (&it->second == chunk_) ||
+            (it->second.isNew ? !ok_ : (0 == oldFp_))) {
+        ++misses_;
+        return 0;
+    }
+    it->second.used = true;
+    ++hits_;
+    return &it->second;
+}
+
+
+bool
+TessCache::beginRead(const TessEntry &entry)
+{
+    readFp_ = entry.isNew ? fp_ : oldFp_;
+    return (0 != readFp_) && (0 == pwpFileSetpos(readFp_, &entry.pos));
+}
+
+
+bool
+TessCache::read(void *buf, size_t size)
+{
+    return (0 != readFp_) && (1 == pwpFileRead(buf, size, 1, readFp_));
+}
+
+
+void
+TessCache::beginChunk(PWP_UINT64 key)
+{
+    // The chunk header is patched by endChunk(). A failed write is only
+    // reported by save().
+    TessEntry &entry = entries_[key];
+    entry.numTris = 0;
+    entry.numSolids = 0;
+    entry.size = 0;
+    entry.isNew = true;
+    entry.used = true;
+    chunk_ = &entry;
+    ok_ = ok_ && (0 == pwpFileSetpos(fp_, &endPos_)) &&
+        (0 == pwpFileGetpos(fp_, &headerPos_)) && writeVal(fp_, key) &&
+        writeVal(fp_, entry.numTris) && writeVal(fp_, entry.numSolids) &&
+        writeVal(fp_, entry.size) && (0 == pwpFileGetpos(fp_, &entry.pos));
+}
+
+
+void
+TessCache::append(const void *data, size_t size)
+{
+    chunk_->size += size;
+    ok_ = ok_ && (1 == pwpFileWrite(data, size, 1, fp_));
+}
+
+
+void
+TessCache::endChunk(PWP_UINT32 numTris, PWP_UINT32 numSolids)
+{
+    chunk_->numTris = numTris;
+    chunk_->numSolids = numSolids;
+    ok_ = ok_ && (0 == pwpFileGetpos(fp_, &endPos_)) &&
+        (0 == pwpFileSetpos(fp_, &headerPos_)) &&
+        (0 == fseek(fp_, sizeof(PWP_UINT64), SEEK_CUR)) &&
+        writeVal(fp_, numTris) && writeVal(fp_, numSolids) &&
+        writeVal(fp_, chunk_->size) && (0 == pwpFileSetpos(fp_, &endPos_));
+    if (ok_) {
+        ++numNew_;
+    }
+    chunk_ = 0;
+}
+
+
+bool
+TessCache::copy(PWP_UINT64 key, const TessEntry &entry)
+{
+    // one block at a time from the old cache to the end of the replacement
+    char buf[64 * 1024];
+    PWP_UINT64 left = entry.size;
+    bool ret = (0 == pwpFileSetpos(fp_, &endPos_)) && writeVal(fp_, key) &&
+        writeVal(fp_, entry.numTris) && writeVal(fp_, entry.numSolids) &&
+        writeVal(fp_, entry.size) && (0 == pwpFileSetpos(oldFp_, &entry.pos));
+    while (ret && (left > 0)) {
+        const size_t size = (left < sizeof(buf)) ? (size_t)left : sizeof(buf);
+        ret = (1 == pwpFileRead(buf, size, 1, oldFp_)) &&
+            (1 == pwpFileWrite(buf, size, 1, fp_));
+        left -= size;
+    }
+    if (ret) {
+        ++numNew_;
+        ret = (0 == pwpFileGetpos(fp_, &endPos_));
+    }
+    return ret;
+}
+
+
+void
+TessCache::discard()
+{
+    if (0 != fp_) {
+        fclose(fp_);
+        fp_ = 0;
+        remove(tmpPath_.c_str());
+    }
+    if (0 != oldFp_) {
+        fclose(oldFp_);
+        oldFp_ = 0;
+    }
+    entries_.clear();
+    numNew_ = 0;
+    chunk_ = 0;
+    readFp_ = 0;
+    ok_ = false;
+}
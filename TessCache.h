@@ -0,0 +1,116 @@
+/****************************************************************************
+ *
+ * class TessCache
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _TESSCACHE_H_
+#define _TESSCACHE_H_
+
+#include "apiPWP.h"
+#include "pwpPlatform.h"
+
+#include <stdio.h>
+#include <map>
+#include <string>
+
+
+//////////////////////////////////////////////////////////////////////////
+// 64-bit FNV-1a hash used to key the cached entity tessellations       //
+//////////////////////////////////////////////////////////////////////////
+class TessHash {
+public:
+    TessHash();
+
+    void    add(const void *data, size_t size);
+    void    add(PWP_UINT32 val);
+    void    add(double val);
+    void    add(const char *str);
+
+    PWP_UINT64  value() const {
+                    return h_; }
+
+private:
+    PWP_UINT64  h_;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Where the facet stream of one patch or block is in a cache file      //
+//////////////////////////////////////////////////////////////////////////
+struct TessEntry {
+    PWP_UINT32  numTris;
+    PWP_UINT32  numSolids;
+    PWP_UINT64  size;       // of the facet stream
+    sysFILEPOS  pos;        // of the facet stream
+    bool        isNew;      // in the replacement, else in the old cache
+    bool        used;       // by the current export
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// On-disk cache of entity facet streams keyed by a content hash.       //
+// open() only reads the index of the old cache. The streams that are  //
+// found are read back from it in blocks, and the regenerated streams   //
+// are appended to a replacement file as they are written, so no stream //
+// is held in memory. save() copies the streams found in the old cache  //
+// into the replacement and renames it over the old cache. Only the     //
+// entries used by the current export survive a save().                 //
+//////////////////////////////////////////////////////////////////////////
+class TessCache {
+public:
+    TessCache();
+    ~TessCache();
+
+    // Indexes the cache at path and starts its replacement. Returns false
+    // if the old cache is unreadable, which is then ignored.
+    bool    open(const std::string &path);
+    bool    save();
+
+    const TessEntry *   find(PWP_UINT64 key);
+
+    // Reads the stream of a found entry, in order, size bytes at a time
+    bool    beginRead(const TessEntry &entry);
+    bool    read(void *buf, size_t size);
+
+    // Appends a regenerated stream to the replacement
+    void    beginChunk(PWP_UINT64 key);
+    void    append(const void *data, size_t size);
+    void    endChunk(PWP_UINT32 numTris, PWP_UINT32 numSolids);
+
+    bool        recording() const {
+                    return 0 != chunk_; }
+    PWP_UINT32  hits() const {
+                    return hits_; }
+    PWP_UINT32  misses() const {
+                    return misses_; }
+
+private:
+    typedef std::map<PWP_UINT64, TessEntry> EntryMap;
+
+    bool    index();
+    bool    copy(PWP_UINT64 key, const TessEntry &entry);
+    void    discard();
+
+private:
+    std::string path_;
+    std::string tmpPath_;
+    FILE *      oldFp_;     // the cache being replaced
+    FILE *      fp_;        // the replacement
+    EntryMap    entries_;
+    PWP_UINT32  numNew_;    // entries in the replacement
+    sysFILEPOS  countPos_;
+    sysFILEPOS  endPos_;
+    sysFILEPOS  headerPos_; // of the chunk being appended
+    TessEntry * chunk_;
+    FILE *      readFp_;
+    bool        ok_;        // no write to the replacement failed
+    PWP_UINT32  hits_;
+    PWP_UINT32  misses_;
+};
+
+#endif // _TESSCACHE_H_
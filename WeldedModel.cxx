@@ -0,0 +1,241 @@
+/****************************************************************************
+ *
+ * class WeldedModel
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#include "WeldedModel.h"
+
+// a vertex index not met by build(), and the end of a cell's chain
+const PWP_UINT32 NoSlot = ~(PWP_UINT32)0;
+
+// the cell buckets of the smallest grid
+const PWP_UINT32 MinBuckets = 64;
+
+
+// The cell of a coordinate, or the coordinate itself without a tolerance.
+// Adding 0 turns -0 into 0, which hashes the same as the other zeros.
+static double
+cellOf(double val, double invSize)
+{
+    return ((invSize > 0.0) ? floor(val * invSize) : val) + 0.0;
+}
+
+
+static PWP_UINT32
+cellBucket(const double *cell, PWP_UINT32 mask)
+{
+    PWP_UINT64 h = 0;
+    for (int ii = 0; ii < 3; ++ii) {
+        PWP_UINT64 bits;
+        memcpy(&bits, &cell[ii], sizeof(bits));
+        h = (h ^ bits) * 0x9E3779B97F4A7C15ULL;
+    }
+    return (PWP_UINT32)(h ^ (h >> 32)) & mask;
+}
+
+
+static double
+dist2(const PWGM_VERTDATA &vd0, const PWGM_VERTDATA &vd1)
+{
+    const double dx = vd1.x - vd0.x;
+    const double dy = vd1.y - vd0.y;
+    const double dz = vd1.z - vd0.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+WeldedModel::WeldedModel(Print3DModel &model, Print3DHost &host) :
+    model_(model),
+    host_(host),
+    slots_(),
+    verts_(),
+    welds_(),
+    numWelded_(0)
+{
+}
+
+
+WeldedModel::~WeldedModel()
+{
+}
+
+
+PWP_UINT32
+WeldedModel::stepCount() const
+{
+    PWP_UINT32 numElems = 0;
+    const PWP_UINT32 numEntities = model_.entityCount();
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        if (Print3DCondHidden != model_.condition(ndx)) {
+            numElems += model_.elementCount(ndx);
+        }
+    }
+    return numElems;
+}
+
+
+bool
+WeldedModel::build(double tolerance)
+{
+    if (!collectVertices()) {
+        return false;
+    }
+    weld(tolerance);
+    return true;
+}
+
+
+PWP_UINT32
+WeldedModel::entityCount() const
+{
+    return model_.entityCount();
+}
+
+
+bool
+WeldedModel::isBlock(PWP_UINT32 ndx) const
+{
+    return model_.isBlock(ndx);
+}
+
+
+Print3DCond
+WeldedModel::condition(PWP_UINT32 ndx) const
+{
+    return model_.condition(ndx);
+}
+
+
+std::string
+WeldedModel::entityName(PWP_UINT32 ndx) const
+{
+    return model_.entityName(ndx);
+}
+
+
+PWP_UINT32
+WeldedModel::elementCount(PWP_UINT32 ndx) const
+{
+    return model_.elementCount(ndx);
+}
+
+
+bool
+WeldedModel::elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+    Print3DElem &elem) const
+{
+    if (!model_.elementData(ndx, elemNdx, elem)) {
+        return false;
+    }
+    for (PWP_UINT32 ii = 0; ii < elem.vertCnt; ++ii) {
+        // the vertices of the hidden entities were not welded
+        const PWP_UINT32 vert = elem.vert[ii].i;
+        if ((vert < slots_.size()) && (NoSlot != slots_[vert])) {
+            elem.vert[ii] = verts_[welds_[slots_[vert]]];
+        }
+    }
+    return true;
+}
+
+
+bool
+WeldedModel::collectVertices()
+{
+    // the vertices in the order the elements use them first, so the
+    // welds do not depend on the vertex numbering
+    slots_.clear();
+    verts_.clear();
+    Print3DElem ed;
+    const PWP_UINT32 numEntities = model_.entityCount();
+    for (PWP_UINT32 ndx = 0; ndx < numEntities; ++ndx) {
+        if (Print3DCondHidden == model_.condition(ndx)) {
+            continue;
+        }
+        const PWP_UINT32 numElems = model_.elementCount(ndx);
+        for (PWP_UINT32 ii = 0; ii < numElems; ++ii) {
+            if (!model_.elementData(ndx, ii, ed) ||
+                    !host_.progressIncrement()) {
+                return false;
+            }
+            for (PWP_UINT32 jj = 0; jj < ed.vertCnt; ++jj) {
+                const PWP_UINT32 vert = ed.vert[jj].i;
+                if (vert >= slots_.size()) {
+                    slots_.resize((size_t)vert + 1, NoSlot);
+                }
+                if (NoSlot == slots_[vert]) {
+                    slots_[vert] = (PWP_UINT32)verts_.size();
+                    verts_.push_back(ed.vert[jj]);
+                }
+            }
+        }
+    }
+    return !host_.aborted();
+}
+
+
+void
+WeldedModel::weld(double tolerance)
+{
+    // Only the vertices that are not welded go into the cells, so a vertex
+    // is welded within the tolerance of its weld and runs of close
+    // vertices do not drift. Two vertices within the tolerance are at
+    // most one cell apart on each axis.
+    const PWP_UINT32 numVerts = vertexCount();
+    PWP_UINT32 numBuckets = MinBuckets;
+    while (numBuckets < 2 * (PWP_UINT64)numVerts) {
+        numBuckets *= 2;
+    }
+    const PWP_UINT32 mask = numBuckets - 1;
+    const double invSize = (tolerance > 0.0) ? 1.0 / tolerance : 0.0;
+    const int reach = (tolerance > 0.0) ? 1 : 0;
+    const double tol2 = tolerance * tolerance;
+    std::vector<PWP_UINT32> head(numBuckets, NoSlot);
+    std::vector<PWP_UINT32> next(numVerts, NoSlot);
+    welds_.resize(numVerts);
+    numWelded_ = 0;
+    for (PWP_UINT32 ii = 0; ii < numVerts; ++ii) {
+        const PWGM_VERTDATA &vd = verts_[ii];
+        const double cell[3] = { cellOf(vd.x, invSize),
+            cellOf(vd.y, invSize), cellOf(vd.z, invSize) };
+        PWP_UINT32 weld = ii;
+        double nbr[3];
+        for (int dx = -reach; dx <= reach; ++dx) {
+            nbr[0] = cell[0] + dx;
+            for (int dy = -reach; dy <= reach; ++dy) {
+                nbr[1] = cell[1] + dy;
+                for (int dz = -reach; dz <= reach; ++dz) {
+                    nbr[2] = cell[2] + dz;
+                    PWP_UINT32 jj = head[cellBucket(nbr, mask)];
+                    for (; NoSlot != jj; jj = next[jj]) {
+                        // the first vertex met wins
+                        if ((jj < weld) && (dist2(verts_[jj], vd) <= tol2)) {
+                            weld = jj;
+                        }
+                    }
+                }
+            }
+        }
+        welds_[ii] = weld;
+        if (weld != ii) {
+            ++numWelded_;
+        }
+        else {
+            const PWP_UINT32 bucket = cellBucket(cell, mask);
+            next[ii] = head[bucket];
+            head[bucket] = ii;
+        }
+    }
+}
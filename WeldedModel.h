@@ -0,0 +1,77 @@
+/****************************************************************************
+ *
+ * class WeldedModel
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _WELDEDMODEL_H_
+#define _WELDEDMODEL_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include "Print3DModel.h"
+
+#include <string>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// A Print3DModel that welds the coincident vertices of another one.    //
+// Patches and blocks that meet at separately indexed points would      //
+// write each edge of the interface twice, as overlapping cylinders.    //
+// build() hashes the vertices of the visible entities into cells the   //
+// size of the tolerance and welds each vertex to the first one met     //
+// within the tolerance of it. The elements then use the index and the  //
+// coordinates of that vertex, so the edge tables, the edge filter and  //
+// the chains all see a single edge.                                    //
+//////////////////////////////////////////////////////////////////////////
+class WeldedModel : public Print3DModel {
+public:
+    WeldedModel(Print3DModel &model, Print3DHost &host);
+    virtual ~WeldedModel();
+
+    // the progress increments of build(), one per element
+    PWP_UINT32  stepCount() const;
+
+    // Welds the vertices of the visible patches and blocks. A tolerance of
+    // 0 only welds the vertices with the same coordinates. Returns false
+    // if aborted.
+    bool        build(double tolerance);
+
+    // the number of vertices of the visible patches and blocks
+    PWP_UINT32  vertexCount() const {
+                    return (PWP_UINT32)verts_.size(); }
+
+    // the number of them welded to another vertex
+    PWP_UINT32  weldedCount() const {
+                    return numWelded_; }
+
+    virtual PWP_UINT32  entityCount() const;
+    virtual bool        isBlock(PWP_UINT32 ndx) const;
+    virtual Print3DCond condition(PWP_UINT32 ndx) const;
+    virtual std::string entityName(PWP_UINT32 ndx) const;
+    virtual PWP_UINT32  elementCount(PWP_UINT32 ndx) const;
+
+    // safe to call from several threads if the welded model's is
+    virtual bool        elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+                            Print3DElem &elem) const;
+
+private:
+    bool        collectVertices();
+    void        weld(double tolerance);
+
+private:
+    Print3DModel &              model_;
+    Print3DHost &               host_;
+    std::vector<PWP_UINT32>     slots_;     // verts_ slot of each index
+    std::vector<PWGM_VERTDATA>  verts_;     // in the order first met
+    std::vector<PWP_UINT32>     welds_;     // the verts_ slot of the weld
+    PWP_UINT32                  numWelded_;
+};
+
+#endif // _WELDEDMODEL_H_
@@ -0,0 +1,287 @@
+/****************************************************************************
+ *
+ * class WorkerPool
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#if !defined(_WIN32)
+#   include <unistd.h>
+#endif
+
+#include <vector>
+
+#include "WorkerPool.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+#if defined(_WIN32)
+
+Mutex::Mutex()
+{
+    InitializeCriticalSection(&cs_);
+}
+
+
+Mutex::~Mutex()
+{
+    DeleteCriticalSection(&cs_);
+}
+
+
+void
+Mutex::lock()
+{
+    EnterCriticalSection(&cs_);
+}
+
+
+void
+Mutex::unlock()
+{
+    LeaveCriticalSection(&cs_);
+}
+
+#else
+
+Mutex::Mutex()
+{
+    pthread_mutex_init(&mutex_, 0);
+}
+
+
+Mutex::~Mutex()
+{
+    pthread_mutex_destroy(&mutex_);
+}
+
+
+void
+Mutex::lock()
+{
+    pthread_mutex_lock(&mutex_);
+}
+
+
+void
+Mutex::unlock()
+{
+    pthread_mutex_unlock(&mutex_);
+}
+
+#endif
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+#if defined(_WIN32)
+
+Condition::Condition()
+{
+    InitializeConditionVariable(&cv_);
+}
+
+
+Condition::~Condition()
+{
+}
+
+
+void
+Condition::wait(Mutex &mutex)
+{
+    SleepConditionVariableCS(&cv_, &mutex.cs_, INFINITE);
+}
+
+
+void
+Condition::notifyAll()
+{
+    WakeAllConditionVariable(&cv_);
+}
+
+#else
+
+Condition::Condition()
+{
+    pthread_cond_init(&cond_, 0);
+}
+
+
+Condition::~Condition()
+{
+    pthread_cond_destroy(&cond_);
+}
+
+
+void
+Condition::wait(Mutex &mutex)
+{
+    pthread_cond_wait(&cond_, &mutex.mutex_);
+}
+
+
+void
+Condition::notifyAll()
+{
+    pthread_cond_broadcast(&cond_);
+}
+
+#endif
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+WorkerPool::WorkerPool(PWP_UINT32 numThreads) :
+    numThreads_((0 == numThreads) ? processorCount() : numThreads),
+    mutex_(),
+    func_(0),
+    ctx_(0),
+    next_(0),
+    numTasks_(0),
+    threads_()
+{
+}
+
+
+WorkerPool::~WorkerPool()
+{
+    wait();
+}
+
+
+void
+WorkerPool::run(TaskFunc func, void *ctx, PWP_UINT32 numTasks)
+{
+    func_ = func;
+    ctx_ = ctx;
+    next_ = 0;
+    numTasks_ = numTasks;
+    PWP_UINT32 numExtra = numThreads_ - 1;
+    if (numExtra > numTasks) {
+        numExtra = numTasks;
+    }
+    spawn(numExtra);
+    // if a thread could not be created, the others do its share
+    work();
+    wait();
+}
+
+
+bool
+WorkerPool::start(TaskFunc func, void *ctx, PWP_UINT32 numTasks)
+{
+    func_ = func;
+    ctx_ = ctx;
+    next_ = 0;
+    numTasks_ = numTasks;
+    spawn(numTasks);
+    return threads_.size() == numTasks;
+}
+
+
+void
+WorkerPool::wait()
+{
+#if defined(_WIN32)
+    for (size_t ii = 0; ii < threads_.size(); ++ii) {
+        WaitForSingleObject(threads_[ii], INFINITE);
+        CloseHandle(threads_[ii]);
+    }
+#else
+    for (size_t ii = 0; ii < threads_.size(); ++ii) {
+        pthread_join(threads_[ii], 0);
+    }
+#endif
+    threads_.clear();
+}
+
+
+PWP_UINT32
+WorkerPool::processorCount()
+{
+    PWP_UINT32 ret = 1;
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    ret = (PWP_UINT32)info.dwNumberOfProcessors;
+#else
+    long cnt = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cnt > 0) {
+        ret = (PWP_UINT32)cnt;
+    }
+#endif
+    return (0 == ret) ? 1 : ret;
+}
+
+
+void
+WorkerPool::spawn(PWP_UINT32 numThreads)
+{
+    for (PWP_UINT32 ii = 0; ii < numThreads; ++ii) {
+#if defined(_WIN32)
+        HANDLE h = CreateThread(0, 0, threadMain, this, 0, 0);
+        if (0 == h) {
+            break;
+        }
+        threads_.push_back(h);
+#else
+        pthread_t t;
+        if (0 != pthread_create(&t, 0, threadMain, this)) {
+            break;
+        }
+        threads_.push_back(t);
+#endif
+    }
+}
+
+
+bool
+WorkerPool::nextTask(PWP_UINT32 &task)
+{
+    MutexLock lock(mutex_);
+    if (next_ >= numTasks_) {
+        return false;
+    }
+    task = next_++;
+    return true;
+}
+
+
+void
+WorkerPool::work()
+{
+    PWP_UINT32 task;
+    while (nextTask(task)) {
+        func_(ctx_, task);
+    }
+}
+
+
+#if defined(_WIN32)
+DWORD WINAPI
+WorkerPool::threadMain(LPVOID arg)
+{
+    ((WorkerPool *)arg)->work();
+    return 0;
+}
+#else
+void *
+WorkerPool::threadMain(void *arg)
+{
+    ((WorkerPool *)arg)->work();
+    return 0;
+}
+#endif
@@ -0,0 +1,151 @@
+/****************************************************************************
+ *
+ * class WorkerPool
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _WORKERPOOL_H_
+#define _WORKERPOOL_H_
+
+#include "apiPWP.h"
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#endif
+
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// A non-recursive mutex                                                //
+//////////////////////////////////////////////////////////////////////////
+class Mutex {
+public:
+    Mutex();
+    ~Mutex();
+
+    void    lock();
+    void    unlock();
+
+private:
+    // not copyable
+    Mutex(const Mutex &);
+    Mutex & operator=(const Mutex &);
+
+private:
+    friend class Condition;
+
+#if defined(_WIN32)
+    CRITICAL_SECTION    cs_;
+#else
+    pthread_mutex_t     mutex_;
+#endif
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// A condition variable used with a locked Mutex                        //
+//////////////////////////////////////////////////////////////////////////
+class Condition {
+public:
+    Condition();
+    ~Condition();
+
+    // unlocks mutex, waits for a notifyAll() and locks mutex again
+    void    wait(Mutex &mutex);
+    void    notifyAll();
+
+private:
+    // not copyable
+    Condition(const Condition &);
+    Condition & operator=(const Condition &);
+
+private:
+#if defined(_WIN32)
+    CONDITION_VARIABLE  cv_;
+#else
+    pthread_cond_t      cond_;
+#endif
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Locks a mutex for the lifetime of the lock                           //
+//////////////////////////////////////////////////////////////////////////
+class MutexLock {
+public:
+    MutexLock(Mutex &mutex) :
+        mutex_(mutex)
+    {
+        mutex_.lock();
+    }
+
+    ~MutexLock()
+    {
+        mutex_.unlock();
+    }
+
+private:
+    Mutex & mutex_;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Runs the tasks 0..numTasks-1 on a set of threads. The calling thread  //
+// works too and run() returns when all tasks are done. Tasks are handed //
+// out in increasing order, one at a time.                               //
+//////////////////////////////////////////////////////////////////////////
+class WorkerPool {
+public:
+    typedef void (*TaskFunc)(void *ctx, PWP_UINT32 task);
+
+    // numThreads of 0 uses one thread per processor
+    WorkerPool(PWP_UINT32 numThreads = 0);
+    ~WorkerPool();
+
+    PWP_UINT32  threadCount() const {
+                    return numThreads_; }
+
+    void    run(TaskFunc func, void *ctx, PWP_UINT32 numTasks);
+
+    // Starts a thread per task and returns at once, for tasks that wait
+    // on each other. Returns false if a thread could not be created. The
+    // started threads run the remaining tasks when theirs are done.
+    // wait() returns when all tasks are done.
+    bool    start(TaskFunc func, void *ctx, PWP_UINT32 numTasks);
+    void    wait();
+
+    static PWP_UINT32   processorCount();
+
+private:
+    void    spawn(PWP_UINT32 numThreads);
+    bool    nextTask(PWP_UINT32 &task);
+    void    work();
+
+#if defined(_WIN32)
+    static DWORD WINAPI threadMain(LPVOID arg);
+#else
+    static void *       threadMain(void *arg);
+#endif
+
+private:
+    PWP_UINT32  numThreads_;
+    Mutex       mutex_;
+    TaskFunc    func_;
+    void *      ctx_;
+    PWP_UINT32  next_;
+    PWP_UINT32  numTasks_;
+#if defined(_WIN32)
+    std::vector<HANDLE>     threads_;
+#else
+    std::vector<pthread_t>  threads_;
+#endif
+};
+
+#endif // _WORKERPOOL_H_
@@ -0,0 +1,249 @@
+/****************************************************************************
+ *
+ * class ZipWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include "ZipWriter.h"
+
+static const PWP_UINT32 LocalHeaderSig  = 0x04034b50;
+static const PWP_UINT32 CentralDirSig   = 0x02014b50;
+static const PWP_UINT32 EndOfDirSig     = 0x06054b50;
+static const PWP_UINT16 ZipVersion      = 20;   // 2.0
+static const PWP_UINT16 DosTime         = 0;    // 00:00:00
+static const PWP_UINT16 DosDate         = 0x21; // 1980-01-01
+static const PWP_UINT32 MaxSize         = 0xFFFFFFFFUL;
+
+
+// The CRC-32 table. It is built during static initialization so that
+// packages can be written from several threads.
+class Crc32Table {
+public:
+    Crc32Table() {
+        for (PWP_UINT32 ii = 0; ii < 256; ++ii) {
+            PWP_UINT32 c = ii;
+            for (int kk = 0; kk < 8; ++kk) {
+                c = (c & 1) ? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+            }
+            table_[ii] = c;
+        }
+    }
+
+    PWP_UINT32 operator[](size_t ndx) const {
+        return table_[ndx];
+    }
+
+private:
+    PWP_UINT32  table_[256];
+};
+
+static const Crc32Table CrcTable;
+
+
+static PWP_UINT32
+crc32Update(PWP_UINT32 crc, const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    crc = ~crc;
+    for (size_t ii = 0; ii < size; ++ii) {
+        crc = CrcTable[(crc ^ p[ii]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Little-endian record builder                                         //
+//////////////////////////////////////////////////////////////////////////
+class ZipRecord {
+public:
+    ZipRecord() :
+        bytes_()
+    {
+    }
+
+    void    u16(PWP_UINT32 val) {
+                bytes_ += (char)(val & 0xFF);
+                bytes_ += (char)((val >> 8) & 0xFF); }
+    void    u32(PWP_UINT32 val) {
+                u16(val & 0xFFFF);
+                u16((val >> 16) & 0xFFFF); }
+    void    str(const std::string &val) {
+                bytes_ += val; }
+
+    const char *    data() const {
+                        return bytes_.data(); }
+    size_t          size() const {
+                        return bytes_.size(); }
+
+private:
+    std::string bytes_;
+};
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+ZipWriter::ZipWriter(FILE *fp) :
+    fp_(fp),
+    entries_(),
+    offset_(0),
+    fileSize_(0),
+    crc_(0),
+    inFile_(false),
+    ok_(0 != fp)
+{
+}
+
+
+ZipWriter::~ZipWriter()
+{
+}
+
+
+bool
+ZipWriter::addFile(const char *name, const void *data, size_t size)
+{
+    return beginFile(name) && write(data, size) && endFile();
+}
+
+
+bool
+ZipWriter::beginFile(const char *name)
+{
+    if (!ok_ || inFile_ || (offset_ > MaxSize)) {
+        return false;
+    }
+    Entry entry;
+    entry.name = name;
+    entry.crc = 0;
+    entry.size = 0;
+    entry.offset = (PWP_UINT32)offset_;
+    entries_.push_back(entry);
+    fileSize_ = 0;
+    crc_ = 0;
+    inFile_ = true;
+    // the sizes and CRC are patched by endFile()
+    ok_ = (0 == pwpFileGetpos(fp_, &headerPos_)) && writeLocalHeader(entry);
+    return ok_;
+}
+
+
+bool
+ZipWriter::write(const void *data, size_t size)
+{
+    if (ok_ && inFile_) {
+        crc_ = crc32Update(crc_, data, size);
+        fileSize_ += size;
+        ok_ = writeRaw(data, size);
+    }
+    return ok_;
+}
+
+
+bool
+ZipWriter::endFile()
+{
+    if (!ok_ || !inFile_) {
+        return false;
+    }
+    inFile_ = false;
+    if (fileSize_ > MaxSize) {
+        // would need zip64
+        ok_ = false;
+        return false;
+    }
+    Entry &entry = entries_.back();
+    entry.crc = crc_;
+    entry.size = (PWP_UINT32)fileSize_;
+    sysFILEPOS endPos;
+    const PWP_UINT64 endOffset = offset_;
+    ok_ = (0 == pwpFileGetpos(fp_, &endPos)) &&
+        (0 == pwpFileSetpos(fp_, &headerPos_)) && writeLocalHeader(entry) &&
+        (0 == pwpFileSetpos(fp_, &endPos));
+    // writeLocalHeader() counted the rewritten header again
+    offset_ = endOffset;
+    return ok_;
+}
+
+
+bool
+ZipWriter::finish()
+{
+    if (!ok_ || inFile_) {
+        return false;
+    }
+    const PWP_UINT64 dirOffset = offset_;
+    std::vector<Entry>::const_iterator it;
+    for (it = entries_.begin(); ok_ && (it != entries_.end()); ++it) {
+        ZipRecord rec;
+        rec.u32(CentralDirSig);
+        rec.u16(ZipVersion);    // made by
+        rec.u16(ZipVersion);    // needed to extract
+        rec.u16(0);             // flags
+        rec.u16(0);             // method: stored
+        rec.u16(DosTime);
+        rec.u16(DosDate);
+        rec.u32(it->crc);
+        rec.u32(it->size);      // compressed
+        rec.u32(it->size);      // uncompressed
+        rec.u16((PWP_UINT32)it->name.size());
+        rec.u16(0);             // extra length
+        rec.u16(0);             // comment length
+        rec.u16(0);             // disk number
+        rec.u16(0);             // internal attributes
+        rec.u32(0);             // external attributes
+        rec.u32(it->offset);
+        rec.str(it->name);
+        ok_ = writeRaw(rec.data(), rec.size());
+    }
+    if (ok_ && (offset_ > MaxSize)) {
+        ok_ = false;
+    }
+    if (ok_) {
+        ZipRecord rec;
+        rec.u32(EndOfDirSig);
+        rec.u16(0);             // disk number
+        rec.u16(0);             // disk with directory
+        rec.u16((PWP_UINT32)entries_.size());
+        rec.u16((PWP_UINT32)entries_.size());
+        rec.u32((PWP_UINT32)(offset_ - dirOffset));
+        rec.u32((PWP_UINT32)dirOffset);
+        rec.u16(0);             // comment length
+        ok_ = writeRaw(rec.data(), rec.size());
+    }
+    return ok_;
+}
+
+
+bool
+ZipWriter::writeRaw(const void *data, size_t size)
+{
+    offset_ += size;
+    return (0 == size) || (1 == pwpFileWrite(data, size, 1, fp_));
+}
+
+
+bool
+ZipWriter::writeLocalHeader(const Entry &entry)
+{
+    ZipRecord rec;
+    rec.u32(LocalHeaderSig);
+    rec.u16(ZipVersion);        // needed to extract
+    rec.u16(0);                 // flags
+    rec.u16(0);                 // method: stored
+    rec.u16(DosTime);
+    rec.u16(DosDate);
+    rec.u32(entry.crc);
+    rec.u32(entry.size);        // compressed
+    rec.u32(entry.size);        // uncompressed
+    rec.u16((PWP_UINT32)entry.name.size());
+    rec.u16(0);                 // extra length
+    rec.str(entry.name);
+    return writeRaw(rec.data(), rec.size());
+}
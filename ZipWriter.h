@@ -0,0 +1,61 @@
+/****************************************************************************
+ *
+ * class ZipWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _ZIPWRITER_H_
+#define _ZIPWRITER_H_
+
+#include "apiPWP.h"
+#include "pwpPlatform.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// Writes a zip archive of stored (uncompressed) files to an open file. //
+// A file's data can be streamed between beginFile() and endFile(). The //
+// local header is patched with the final size and CRC by endFile().   //
+// Files are limited to 4GB (no zip64).                                 //
+//////////////////////////////////////////////////////////////////////////
+class ZipWriter {
+public:
+    ZipWriter(FILE *fp);
+    ~ZipWriter();
+
+    bool    addFile(const char *name, const void *data, size_t size);
+    bool    beginFile(const char *name);
+    bool    write(const void *data, size_t size);
+    bool    endFile();
+    bool    finish();
+
+private:
+    struct Entry {
+        std::string name;
+        PWP_UINT32  crc;
+        PWP_UINT32  size;
+        PWP_UINT32  offset;
+    };
+
+    bool    writeRaw(const void *data, size_t size);
+    bool    writeLocalHeader(const Entry &entry);
+
+private:
+    FILE *              fp_;
+    std::vector<Entry>  entries_;
+    PWP_UINT64          offset_;
+    PWP_UINT64          fileSize_;
+    PWP_UINT32          crc_;
+    sysFILEPOS          headerPos_;
+    bool                inFile_;
+    bool                ok_;
+};
+
+#endif // _ZIPWRITER_H_
@@ -0,0 +1,164 @@
+/****************************************************************************
+ *
+ * class AllocCounter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#endif
+
+#include "AllocCounter.h"
+
+#include <new>
+
+#if __cplusplus >= 201103L
+#   define ALLOC_THROWS
+#   define ALLOC_NOTHROW    noexcept
+#else
+#   define ALLOC_THROWS     throw(std::bad_alloc)
+#   define ALLOC_NOTHROW    throw()
+#endif
+
+// incremented by any thread, so that a count never misses an allocation
+static volatile long Counts[AllocPhase::NumPhases];
+
+
+static void *
+allocate(size_t size)
+{
+#if defined(_WIN32)
+    InterlockedIncrement(&Counts[AllocPhase::current()]);
+#else
+    __sync_fetch_and_add(&Counts[AllocPhase::current()], 1);
+#endif
+    if (0 == size) {
+        size = 1;
+    }
+    void *ret;
+    while (0 == (ret = malloc(size))) {
+        // the handler frees memory, throws or ends the program
+        std::new_handler handler = std::set_new_handler(0);
+        std::set_new_handler(handler);
+        if (0 == handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+    return ret;
+}
+
+
+static void *
+allocateNoThrow(size_t size)
+{
+    try {
+        return allocate(size);
+    }
+    catch (...) {
+        return 0;
+    }
+}
+
+
+void *
+operator new(size_t size) ALLOC_THROWS
+{
+    return allocate(size);
+}
+
+
+void *
+operator new[](size_t size) ALLOC_THROWS
+{
+    return allocate(size);
+}
+
+
+void *
+operator new(size_t size, const std::nothrow_t &) ALLOC_NOTHROW
+{
+    return allocateNoThrow(size);
+}
+
+
+void *
+operator new[](size_t size, const std::nothrow_t &) ALLOC_NOTHROW
+{
+    return allocateNoThrow(size);
+}
+
+
+void
+operator delete(void *ptr) ALLOC_NOTHROW
+{
+    free(ptr);
+}
+
+
+void
+operator delete[](void *ptr) ALLOC_NOTHROW
+{
+    free(ptr);
+}
+
+
+#if __cplusplus >= 201402L
+void
+operator delete(void *ptr, size_t) ALLOC_NOTHROW
+{
+    free(ptr);
+}
+
+
+void
+operator delete[](void *ptr, size_t) ALLOC_NOTHROW
+{
+    free(ptr);
+}
+#endif
+
+
+void
+operator delete(void *ptr, const std::nothrow_t &) ALLOC_NOTHROW
+{
+    free(ptr);
+}
+
+
+void
+operator delete[](void *ptr, const std::nothrow_t &) ALLOC_NOTHROW
+{
+    free(ptr);
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+void
+AllocCounter::reset()
+{
+    for (int ii = 0; ii < AllocPhase::NumPhases; ++ii) {
+#if defined(_WIN32)
+        InterlockedExchange(&Counts[ii], 0);
+#else
+        __sync_lock_test_and_set(&Counts[ii], 0);
+#endif
+    }
+}
+
+
+unsigned long
+AllocCounter::count(AllocPhase::Phase phase)
+{
+    return (unsigned long)Counts[phase];
+}
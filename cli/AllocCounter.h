@@ -0,0 +1,31 @@
+/****************************************************************************
+ *
+ * class AllocCounter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _ALLOCCOUNTER_H_
+#define _ALLOCCOUNTER_H_
+
+#include "AllocPhase.h"
+
+
+//////////////////////////////////////////////////////////////////////////
+// The heap allocations of each export phase. Linking AllocCounter.cxx  //
+// replaces the global operator new, which charges every allocation to  //
+// the AllocPhase of the thread that makes it.                          //
+//////////////////////////////////////////////////////////////////////////
+class AllocCounter {
+public:
+    // zeroes the counts
+    static void             reset();
+
+    // the allocations in phase since the last reset()
+    static unsigned long    count(AllocPhase::Phase phase);
+};
+
+#endif // _ALLOCCOUNTER_H_
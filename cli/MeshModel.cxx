@@ -0,0 +1,274 @@
+/****************************************************************************
+ *
+ * class MeshModel
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "MeshModel.h"
+
+
+static std::string
+fileExt(const std::string &path)
+{
+    std::string ret;
+    std::string::size_type dot = path.find_last_of('.');
+    std::string::size_type sep = path.find_last_of("/\\");
+    if ((std::string::npos != dot) &&
+            ((std::string::npos == sep) || (dot > sep))) {
+        ret = path.substr(dot + 1);
+        for (size_t ii = 0; ii < ret.size(); ++ii) {
+            ret[ii] = (char)tolower(ret[ii]);
+        }
+    }
+    return ret;
+}
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+MeshModel::MeshModel() :
+    xyz_(),
+    entities_()
+{
+}
+
+
+MeshModel::~MeshModel()
+{
+}
+
+
+bool
+MeshModel::read(const std::string &path, std::string &err)
+{
+    const std::string ext = fileExt(path);
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (0 == fp) {
+        err = "cannot open file";
+        return false;
+    }
+    bool ret = false;
+    if ("vtk" == ext) {
+        ret = readVtk(fp, err);
+    }
+    else if ("vtu" == ext) {
+        ret = readVtu(fp, err);
+    }
+    else if ("msh" == ext) {
+        ret = readGmsh(fp, err);
+    }
+    else if ("p3dm" == ext) {
+        ret = readDump(fp, err);
+    }
+    else {
+        err = "unsupported file extension '" + ext + "'";
+    }
+    fclose(fp);
+    if (ret) {
+        finish();
+    }
+    return ret;
+}
+
+
+PWP_UINT32
+MeshModel::setCondition(const std::string &name, Print3DCond cond)
+{
+    PWP_UINT32 ret = 0;
+    for (size_t ii = 0; ii < entities_.size(); ++ii) {
+        if (name == entities_[ii].name) {
+            entities_[ii].cond = cond;
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+
+PWP_UINT32
+MeshModel::entityCount() const
+{
+    return (PWP_UINT32)entities_.size();
+}
+
+
+bool
+MeshModel::isBlock(PWP_UINT32 ndx) const
+{
+    return entities_[ndx].block;
+}
+
+
+Print3DCond
+MeshModel::condition(PWP_UINT32 ndx) const
+{
+    return entities_[ndx].cond;
+}
+
+
+std::string
+MeshModel::entityName(PWP_UINT32 ndx) const
+{
+    return entities_[ndx].name;
+}
+
+
+PWP_UINT32
+MeshModel::elementCount(PWP_UINT32 ndx) const
+{
+    return (PWP_UINT32)entities_[ndx].types.size();
+}
+
+
+bool
+MeshModel::elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+    Print3DElem &elem) const
+{
+    const Entity &ent = entities_[ndx];
+    if (elemNdx >= ent.types.size()) {
+        return false;
+    }
+    elem.type = (PWGM_ENUM_ELEMTYPE)ent.types[elemNdx];
+    elem.vertCnt = vertCount(elem.type);
+    const PWP_UINT32 *verts = &ent.conn[ent.offsets[elemNdx]];
+    for (PWP_UINT32 ii = 0; ii < elem.vertCnt; ++ii) {
+        const PWP_UINT32 vNdx = verts[ii];
+        elem.vert[ii].x = xyz_[3 * vNdx];
+        elem.vert[ii].y = xyz_[3 * vNdx + 1];
+        elem.vert[ii].z = xyz_[3 * vNdx + 2];
+        elem.vert[ii].i = vNdx;
+    }
+    return true;
+}
+
+
+bool
+MeshModel::bounds(PWP_UINT32 ndx, double *minXyz, double *maxXyz) const
+{
+    const Entity &ent = entities_[ndx];
+    for (int ii = 0; ii < 3; ++ii) {
+        minXyz[ii] = ent.minXyz[ii];
+        maxXyz[ii] = ent.maxXyz[ii];
+    }
+    return true;
+}
+
+
+void
+MeshModel::reserveVertices(PWP_UINT32 cnt)
+{
+    xyz_.reserve(3 * (size_t)cnt);
+}
+
+
+void
+MeshModel::addVertex(double x, double y, double z)
+{
+    xyz_.push_back(x);
+    xyz_.push_back(y);
+    xyz_.push_back(z);
+}
+
+
+PWP_UINT32
+MeshModel::addEntity(const std::string &name, bool block)
+{
+    entities_.push_back(Entity());
+    Entity &ent = entities_.back();
+    ent.name = name;
+    ent.block = block;
+    ent.cond = Print3DCondMesh;
+    return (PWP_UINT32)(entities_.size() - 1);
+}
+
+
+bool
+MeshModel::addElement(PWP_UINT32 entity, PWGM_ENUM_ELEMTYPE type,
+    const PWP_UINT32 *verts)
+{
+    const PWP_UINT32 cnt = vertCount(type);
+    const PWP_UINT32 numVerts = vertexCount();
+    for (PWP_UINT32 ii = 0; ii < cnt; ++ii) {
+        if (verts[ii] >= numVerts) {
+            return false;
+        }
+    }
+    Entity &ent = entities_[entity];
+    ent.types.push_back((unsigned char)type);
+    ent.offsets.push_back(ent.conn.size());
+    ent.conn.insert(ent.conn.end(), verts, verts + cnt);
+    return true;
+}
+
+
+void
+MeshModel::finish()
+{
+    // drop the empty entities and put the patches before the blocks as
+    // required by Print3DModel
+    std::vector<Entity> patches;
+    std::vector<Entity> blocks;
+    for (size_t ii = 0; ii < entities_.size(); ++ii) {
+        if (entities_[ii].types.empty()) {
+            continue;
+        }
+        std::vector<Entity> &dest = entities_[ii].block ? blocks : patches;
+        dest.push_back(Entity());
+        std::swap(dest.back(), entities_[ii]);
+    }
+    entities_.swap(patches);
+    for (size_t ii = 0; ii < blocks.size(); ++ii) {
+        entities_.push_back(Entity());
+        std::swap(entities_.back(), blocks[ii]);
+    }
+    // the bounding box of each entity's vertices
+    for (size_t ii = 0; ii < entities_.size(); ++ii) {
+        Entity &ent = entities_[ii];
+        const double *xyz = &xyz_[3 * (size_t)ent.conn[0]];
+        for (int jj = 0; jj < 3; ++jj) {
+            ent.minXyz[jj] = ent.maxXyz[jj] = xyz[jj];
+        }
+        for (size_t kk = 1; kk < ent.conn.size(); ++kk) {
+            xyz = &xyz_[3 * (size_t)ent.conn[kk]];
+            for (int jj = 0; jj < 3; ++jj) {
+                if (xyz[jj] < ent.minXyz[jj]) {
+                    ent.minXyz[jj] = xyz[jj];
+                }
+                else if (xyz[jj] > ent.maxXyz[jj]) {
+                    ent.maxXyz[jj] = xyz[jj];
+                }
+            }
+        }
+    }
+}
+
+
+PWP_UINT32
+MeshModel::vertCount(PWGM_ENUM_ELEMTYPE type)
+{
+    PWP_UINT32 ret = 0;
+    switch (type) {
+        case PWGM_ELEMTYPE_POINT:   ret = 1; break;
+        case PWGM_ELEMTYPE_BAR:     ret = 2; break;
+        case PWGM_ELEMTYPE_TRI:     ret = 3; break;
+        case PWGM_ELEMTYPE_QUAD:    ret = 4; break;
+        case PWGM_ELEMTYPE_TET:     ret = 4; break;
+        case PWGM_ELEMTYPE_PYRAMID: ret = 5; break;
+        case PWGM_ELEMTYPE_WEDGE:   ret = 6; break;
+        case PWGM_ELEMTYPE_HEX:     ret = 8; break;
+        default:                    ret = 0; break;
+    }
+    return ret;
+}
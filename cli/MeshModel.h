@@ -0,0 +1,89 @@
+/****************************************************************************
+ *
+ * class MeshModel
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _MESHMODEL_H_
+#define _MESHMODEL_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include "Print3DModel.h"
+
+#include <string>
+#include <vector>
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+//////////////////////////////////////////////////////////////////////////
+// An in-memory unstructured mesh read from a mesh file. The elements of //
+// each entity are stored as a type array plus compact connectivity.     //
+//////////////////////////////////////////////////////////////////////////
+class MeshModel : public Print3DModel {
+public:
+    MeshModel();
+    virtual ~MeshModel();
+
+    // Reads a VTK legacy (.vtk), VTK XML (.vtu), Gmsh (.msh) or Print3D
+    // binary dump (.p3dm) file. Returns false and sets err on failure.
+    bool    read(const std::string &path, std::string &err);
+
+    // Applies a condition to the entities with the given name
+    PWP_UINT32  setCondition(const std::string &name, Print3DCond cond);
+
+    PWP_UINT32  vertexCount() const {
+                    return (PWP_UINT32)(xyz_.size() / 3); }
+
+    // Print3DModel implementation
+    virtual PWP_UINT32  entityCount() const;
+    virtual bool        isBlock(PWP_UINT32 ndx) const;
+    virtual Print3DCond condition(PWP_UINT32 ndx) const;
+    virtual std::string entityName(PWP_UINT32 ndx) const;
+    virtual PWP_UINT32  elementCount(PWP_UINT32 ndx) const;
+    virtual bool        elementData(PWP_UINT32 ndx, PWP_UINT32 elemNdx,
+                            Print3DElem &elem) const;
+    virtual bool        bounds(PWP_UINT32 ndx, double *minXyz,
+                            double *maxXyz) const;
+
+    // used by the file readers
+    void        reserveVertices(PWP_UINT32 cnt);
+    void        addVertex(double x, double y, double z);
+    PWP_UINT32  addEntity(const std::string &name, bool block);
+    bool        addElement(PWP_UINT32 entity, PWGM_ENUM_ELEMTYPE type,
+                    const PWP_UINT32 *verts);
+    void        finish();
+
+    static PWP_UINT32   vertCount(PWGM_ENUM_ELEMTYPE type);
+
+private:
+    struct Entity {
+        std::string                 name;
+        bool                        block;
+        Print3DCond                 cond;
+        std::vector<unsigned char>  types;
+        std::vector<size_t>         offsets;
+        std::vector<PWP_UINT32>     conn;
+        double                      minXyz[3];  // set by finish()
+        double                      maxXyz[3];
+    };
+
+    bool    readVtk(FILE *fp, std::string &err);
+    bool    readVtu(FILE *fp, std::string &err);
+    bool    readGmsh(FILE *fp, std::string &err);
+    bool    readDump(FILE *fp, std::string &err);
+
+private:
+    std::vector<double> xyz_;
+    std::vector<Entity> entities_;
+};
+
+#endif // _MESHMODEL_H_
@@ -0,0 +1,1292 @@
+/****************************************************************************
+ *
+ * MeshModel file readers
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+
+#include "MeshModel.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+static bool
+isLittleEndian()
+{
+    const PWP_UINT32 one = 1;
+    return 1 == *(const unsigned char *)&one;
+}
+
+
+static void
+swapBytes(void *data, size_t size)
+{
+    unsigned char *p = (unsigned char *)data;
+    for (size_t ii = 0; ii < size / 2; ++ii) {
+        unsigned char tmp = p[ii];
+        p[ii] = p[size - 1 - ii];
+        p[size - 1 - ii] = tmp;
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Buffered reader for the mixed text/binary mesh formats               //
+//////////////////////////////////////////////////////////////////////////
+class MeshReader {
+public:
+    MeshReader(FILE *fp) :
+        fp_(fp),
+        pos_(0),
+        end_(0),
+        lastDelim_(0)
+    {
+    }
+
+    bool getChar(int &c) {
+        if ((pos_ == end_) && !fill()) {
+            return false;
+        }
+        c = (unsigned char)buf_[pos_++];
+        return true;
+    }
+
+    // next whitespace delimited token
+    bool token(std::string &tok) {
+        tok.clear();
+        int c;
+        do {
+            if (!getChar(c)) {
+                return false;
+            }
+        } while (isspace(c));
+        do {
+            tok += (char)c;
+            if (!getChar(c)) {
+                // end of file ends the line too
+                c = '\n';
+            }
+        } while (!isspace(c));
+        lastDelim_ = c;
+        return true;
+    }
+
+    // skip the remainder of the line of the last token
+    bool endLine() {
+        int c = lastDelim_;
+        while ('\n' != c) {
+            if (!getChar(c)) {
+                return false;
+            }
+        }
+        lastDelim_ = 0;
+        return true;
+    }
+
+    // rest of the current line without the line terminator
+    bool line(std::string &ln) {
+        ln.clear();
+        lastDelim_ = '\n';
+        int c;
+        bool ret = false;
+        while (getChar(c)) {
+            ret = true;
+            if ('\n' == c) {
+                break;
+            }
+            if ('\r' != c) {
+                ln += (char)c;
+            }
+        }
+        return ret;
+    }
+
+    bool raw(void *data, size_t size) {
+        char *dest = (char *)data;
+        while (size > 0) {
+            if ((pos_ == end_) && !fill()) {
+                return false;
+            }
+            size_t cnt = end_ - pos_;
+            if (cnt > size) {
+                cnt = size;
+            }
+            memcpy(dest, buf_ + pos_, cnt);
+            pos_ += cnt;
+            dest += cnt;
+            size -= cnt;
+        }
+        return true;
+    }
+
+    bool real(double &val) {
+        std::string tok;
+        char *end = 0;
+        return token(tok) && ((val = strtod(tok.c_str(), &end)), true) &&
+            ('\0' == *end);
+    }
+
+    bool integer(PWP_INT64 &val) {
+        std::string tok;
+        char *end = 0;
+        return token(tok) &&
+            ((val = (PWP_INT64)strtoll(tok.c_str(), &end, 10)), true) &&
+            ('\0' == *end);
+    }
+
+    bool uint32(PWP_UINT32 &val) {
+        PWP_INT64 tmp = 0;
+        if (!integer(tmp) || (tmp < 0) || (tmp > 0xFFFFFFFFLL)) {
+            return false;
+        }
+        val = (PWP_UINT32)tmp;
+        return true;
+    }
+
+    // skip to the line following the one starting with keyword
+    bool seek(const char *keyword) {
+        std::string ln;
+        while (line(ln)) {
+            if (0 == ln.compare(0, strlen(keyword), keyword)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    bool fill() {
+        pos_ = 0;
+        end_ = fread(buf_, 1, sizeof(buf_), fp_);
+        return end_ > 0;
+    }
+
+private:
+    FILE *  fp_;
+    char    buf_[64 * 1024];
+    size_t  pos_;
+    size_t  end_;
+    int     lastDelim_;
+};
+
+
+//***************************************************************************
+// Value types of the VTK and Gmsh data arrays
+//***************************************************************************
+
+enum ValType {
+    ValNone,
+    ValInt8,
+    ValUInt8,
+    ValInt16,
+    ValUInt16,
+    ValInt32,
+    ValUInt32,
+    ValInt64,
+    ValUInt64,
+    ValFloat32,
+    ValFloat64
+};
+
+
+static size_t
+valSize(ValType type)
+{
+    size_t ret = 0;
+    switch (type) {
+        case ValInt8:
+        case ValUInt8:      ret = 1; break;
+        case ValInt16:
+        case ValUInt16:     ret = 2; break;
+        case ValInt32:
+        case ValUInt32:
+        case ValFloat32:    ret = 4; break;
+        case ValInt64:
+        case ValUInt64:
+        case ValFloat64:    ret = 8; break;
+        default:            ret = 0; break;
+    }
+    return ret;
+}
+
+
+static ValType
+vtkLegacyType(std::string name)
+{
+    for (size_t ii = 0; ii < name.size(); ++ii) {
+        name[ii] = (char)tolower(name[ii]);
+    }
+    ValType ret = ValNone;
+    if ("float" == name) { ret = ValFloat32; }
+    else if ("double" == name) { ret = ValFloat64; }
+    else if ("char" == name) { ret = ValInt8; }
+    else if ("unsigned_char" == name) { ret = ValUInt8; }
+    else if ("short" == name) { ret = ValInt16; }
+    else if ("unsigned_short" == name) { ret = ValUInt16; }
+    else if ("int" == name) { ret = ValInt32; }
+    else if ("unsigned_int" == name) { ret = ValUInt32; }
+    else if ("long" == name) { ret = ValInt64; }
+    else if ("unsigned_long" == name) { ret = ValUInt64; }
+    else if ("vtktypeint64" == name) { ret = ValInt64; }
+    else if ("vtktypeuint64" == name) { ret = ValUInt64; }
+    else if ("vtkidtype" == name) { ret = ValInt32; }
+    return ret;
+}
+
+
+static ValType
+vtkXmlType(const std::string &name)
+{
+    ValType ret = ValNone;
+    if ("Float32" == name) { ret = ValFloat32; }
+    else if ("Float64" == name) { ret = ValFloat64; }
+    else if ("Int8" == name) { ret = ValInt8; }
+    else if ("UInt8" == name) { ret = ValUInt8; }
+    else if ("Int16" == name) { ret = ValInt16; }
+    else if ("UInt16" == name) { ret = ValUInt16; }
+    else if ("Int32" == name) { ret = ValInt32; }
+    else if ("UInt32" == name) { ret = ValUInt32; }
+    else if ("Int64" == name) { ret = ValInt64; }
+    else if ("UInt64" == name) { ret = ValUInt64; }
+    return ret;
+}
+
+
+// converts one native byte order value
+template<typename T>
+static T
+getValue(const unsigned char *p, ValType type)
+{
+    T ret = 0;
+    switch (type) {
+        case ValInt8:    { signed char v; memcpy(&v, p, 1); ret = (T)v; break; }
+        case ValUInt8:   { ret = (T)*p; break; }
+        case ValInt16:   { short v; memcpy(&v, p, 2); ret = (T)v; break; }
+        case ValUInt16:  { unsigned short v; memcpy(&v, p, 2); ret = (T)v; break; }
+        case ValInt32:   { PWP_INT32 v; memcpy(&v, p, 4); ret = (T)v; break; }
+        case ValUInt32:  { PWP_UINT32 v; memcpy(&v, p, 4); ret = (T)v; break; }
+        case ValInt64:   { PWP_INT64 v; memcpy(&v, p, 8); ret = (T)v; break; }
+        case ValUInt64:  { PWP_UINT64 v; memcpy(&v, p, 8); ret = (T)v; break; }
+        case ValFloat32: { float v; memcpy(&v, p, 4); ret = (T)v; break; }
+        case ValFloat64: { double v; memcpy(&v, p, 8); ret = (T)v; break; }
+        default: break;
+    }
+    return ret;
+}
+
+
+// converts count packed values, swapping their byte order first if needed
+template<typename T>
+static void
+getValues(unsigned char *data, ValType type, bool swap, size_t count,
+    T *vals)
+{
+    const size_t size = valSize(type);
+    for (size_t ii = 0; ii < count; ++ii, data += size) {
+        if (swap) {
+            swapBytes(data, size);
+        }
+        vals[ii] = getValue<T>(data, type);
+    }
+}
+
+
+template<typename T>
+static bool
+readValues(MeshReader &rdr, bool binary, bool swap, ValType type,
+    size_t count, std::vector<T> &vals)
+{
+    vals.resize(count);
+    if (ValNone == type) {
+        return false;
+    }
+    if (!binary) {
+        double val;
+        for (size_t ii = 0; ii < count; ++ii) {
+            if (!rdr.real(val)) {
+                return false;
+            }
+            vals[ii] = (T)val;
+        }
+        return true;
+    }
+    const size_t size = valSize(type);
+    std::vector<unsigned char> buf(64 * 1024);
+    const size_t chunk = buf.size() / size;
+    for (size_t ii = 0; ii < count; ii += chunk) {
+        const size_t cnt = (count - ii < chunk) ? (count - ii) : chunk;
+        if (!rdr.raw(&buf[0], cnt * size)) {
+            return false;
+        }
+        getValues(&buf[0], type, swap, cnt, &vals[ii]);
+    }
+    return true;
+}
+
+
+
+//***************************************************************************
+// VTK legacy and XML unstructured grids
+//***************************************************************************
+
+// maps a VTK cell type to a Pointwise element type and vertex order
+static bool
+vtkCellType(PWP_INT64 vtkType, PWGM_ENUM_ELEMTYPE &type, const int *&order)
+{
+    static const int Identity[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    static const int Pixel[4] = { 0, 1, 3, 2 };
+    static const int Voxel[8] = { 0, 1, 3, 2, 4, 5, 7, 6 };
+    bool ret = true;
+    order = Identity;
+    switch (vtkType) {
+        case 1:  type = PWGM_ELEMTYPE_POINT; break;
+        case 3:  // VTK_LINE
+        case 21: type = PWGM_ELEMTYPE_BAR; break;
+        case 5:  // VTK_TRIANGLE
+        case 22: type = PWGM_ELEMTYPE_TRI; break;
+        case 8:  type = PWGM_ELEMTYPE_QUAD; order = Pixel; break;
+        case 9:  // VTK_QUAD
+        case 23: type = PWGM_ELEMTYPE_QUAD; break;
+        case 10: // VTK_TETRA
+        case 24: type = PWGM_ELEMTYPE_TET; break;
+        case 11: type = PWGM_ELEMTYPE_HEX; order = Voxel; break;
+        case 12: // VTK_HEXAHEDRON
+        case 25: type = PWGM_ELEMTYPE_HEX; break;
+        case 13: // VTK_WEDGE
+        case 26: type = PWGM_ELEMTYPE_WEDGE; break;
+        case 14: // VTK_PYRAMID
+        case 27: type = PWGM_ELEMTYPE_PYRAMID; break;
+        default: ret = false; break;
+    }
+    // the quadratic types list their corner vertices first
+    return ret;
+}
+
+
+static bool
+isVolume(PWGM_ENUM_ELEMTYPE type)
+{
+    return (PWGM_ELEMTYPE_TET == type) || (PWGM_ELEMTYPE_HEX == type) ||
+        (PWGM_ELEMTYPE_WEDGE == type) || (PWGM_ELEMTYPE_PYRAMID == type);
+}
+
+
+// Adds the VTK cells given as offsets into conn. Surface cells go to the
+// "patch" entity and volume cells to the "block" entity.
+static bool
+addVtkCells(MeshModel &model, const std::vector<PWP_INT64> &offsets,
+    const std::vector<PWP_INT64> &conn, const std::vector<PWP_INT64> &types,
+    std::string &err)
+{
+    if (offsets.size() != types.size() + 1) {
+        err = "inconsistent cell counts";
+        return false;
+    }
+    const PWP_UINT32 patch = model.addEntity("patch", false);
+    const PWP_UINT32 block = model.addEntity("block", true);
+    PWP_UINT32 skipped = 0;
+    PWGM_ENUM_ELEMTYPE type;
+    const int *order;
+    PWP_UINT32 verts[8];
+    for (size_t ii = 0; ii < types.size(); ++ii) {
+        const PWP_INT64 beg = offsets[ii];
+        const PWP_INT64 cnt = offsets[ii + 1] - beg;
+        if (!vtkCellType(types[ii], type, order) ||
+                (cnt < (PWP_INT64)MeshModel::vertCount(type))) {
+            ++skipped;
+            continue;
+        }
+        if ((beg < 0) || (offsets[ii + 1] > (PWP_INT64)conn.size())) {
+            err = "cell connectivity out of range";
+            return false;
+        }
+        for (PWP_UINT32 jj = 0; jj < MeshModel::vertCount(type); ++jj) {
+            verts[jj] = (PWP_UINT32)conn[(size_t)beg + order[jj]];
+        }
+        if (!model.addElement(isVolume(type) ? block : patch, type, verts)) {
+            err = "cell vertex index out of range";
+            return false;
+        }
+    }
+    if (skipped > 0) {
+        char msg[128];
+        sprintf(msg, "%lu cells of unsupported type skipped",
+            (unsigned long)skipped);
+        err = msg;
+    }
+    return true;
+}
+
+
+bool
+MeshModel::readVtk(FILE *fp, std::string &err)
+{
+    MeshReader rdr(fp);
+    std::string ln;
+    if (!rdr.line(ln) || (0 != ln.compare(0, 5, "# vtk"))) {
+        err = "not a VTK legacy file";
+        return false;
+    }
+    double version = 0;
+    std::string::size_type pos = ln.find("Version");
+    if (std::string::npos != pos) {
+        version = atof(ln.c_str() + pos + 7);
+    }
+    std::string tok;
+    std::string type;
+    if (!rdr.line(ln) || !rdr.token(tok)) {
+        err = "truncated VTK header";
+        return false;
+    }
+    const bool binary = ("BINARY" == tok);
+    const bool swap = binary && isLittleEndian();
+    if (!rdr.token(tok) || ("DATASET" != tok) || !rdr.token(tok) ||
+            ("UNSTRUCTURED_GRID" != tok)) {
+        err = "only DATASET UNSTRUCTURED_GRID is supported";
+        return false;
+    }
+    std::vector<double> pts;
+    std::vector<PWP_INT64> offsets;
+    std::vector<PWP_INT64> conn;
+    std::vector<PWP_INT64> types;
+    PWP_UINT32 a = 0;
+    PWP_UINT32 b = 0;
+    bool ok = true;
+    while (ok && rdr.token(tok)) {
+        if ("POINTS" == tok) {
+            ok = rdr.uint32(a) && rdr.token(type) && rdr.endLine() &&
+                readValues(rdr, binary, swap, vtkLegacyType(type),
+                    3 * (size_t)a, pts);
+        }
+        else if (("CELLS" == tok) && (version < 5.0)) {
+            // n cells as: count id0 id1 ...
+            std::vector<PWP_INT64> cells;
+            ok = rdr.uint32(a) && rdr.uint32(b) && rdr.endLine() &&
+                readValues(rdr, binary, swap, ValInt32, b, cells);
+            size_t cur = 0;
+            offsets.clear();
+            conn.clear();
+            conn.reserve(b - a);
+            for (PWP_UINT32 ii = 0; ok && (ii < a); ++ii) {
+                offsets.push_back((PWP_INT64)conn.size());
+                ok = (cur < cells.size()) &&
+                    (cur + 1 + (size_t)cells[cur] <= cells.size());
+                if (ok) {
+                    conn.insert(conn.end(), cells.begin() + cur + 1,
+                        cells.begin() + cur + 1 + (size_t)cells[cur]);
+                    cur += 1 + (size_t)cells[cur];
+                }
+            }
+            offsets.push_back((PWP_INT64)conn.size());
+        }
+        else if ("CELLS" == tok) {
+            // version 5 cells as OFFSETS and CONNECTIVITY arrays
+            ok = rdr.uint32(a) && rdr.uint32(b) && rdr.token(tok) &&
+                ("OFFSETS" == tok) && rdr.token(type) && rdr.endLine() &&
+                readValues(rdr, binary, swap, vtkLegacyType(type), a,
+                    offsets) &&
+                rdr.token(tok) && ("CONNECTIVITY" == tok) &&
+                rdr.token(type) && rdr.endLine() &&
+                readValues(rdr, binary, swap, vtkLegacyType(type), b, conn);
+        }
+        else if ("CELL_TYPES" == tok) {
+            ok = rdr.uint32(a) && rdr.endLine() &&
+                readValues(rdr, binary, swap, ValInt32, a, types);
+        }
+        else if ("FIELD" == tok) {
+            // skip the field data arrays
+            PWP_UINT32 numArrays;
+            PWP_UINT32 numComps;
+            PWP_UINT32 numTuples;
+            std::vector<double> vals;
+            ok = rdr.token(tok) && rdr.uint32(numArrays);
+            for (PWP_UINT32 ii = 0; ok && (ii < numArrays); ++ii) {
+                ok = rdr.token(tok) && rdr.uint32(numComps) &&
+                    rdr.uint32(numTuples) && rdr.token(type) &&
+                    rdr.endLine() &&
+                    readValues(rdr, binary, swap, vtkLegacyType(type),
+                        (size_t)numComps * numTuples, vals);
+            }
+        }
+        else {
+            // POINT_DATA, CELL_DATA, ... are not needed
+            break;
+        }
+    }
+    if (!ok || pts.empty() || types.empty()) {
+        err = "bad or incomplete VTK unstructured grid";
+        return false;
+    }
+    reserveVertices((PWP_UINT32)(pts.size() / 3));
+    for (size_t ii = 0; ii + 2 < pts.size(); ii += 3) {
+        addVertex(pts[ii], pts[ii + 1], pts[ii + 2]);
+    }
+    return addVtkCells(*this, offsets, conn, types, err);
+}
+
+
+static bool
+xmlAttr(const std::string &tag, const char *name, std::string &val)
+{
+    // tag is the text of a start tag, e.g. <DataArray type="Int32" ...>
+    const std::string key = std::string(" ") + name + "=\"";
+    std::string::size_type pos = tag.find(key);
+    if (std::string::npos == pos) {
+        return false;
+    }
+    pos += key.size();
+    std::string::size_type end = tag.find('"', pos);
+    if (std::string::npos == end) {
+        return false;
+    }
+    val = tag.substr(pos, end - pos);
+    return true;
+}
+
+
+static bool
+xmlFindTag(const std::string &doc, const char *name, size_t &pos,
+    std::string &tag)
+{
+    // finds the next <name ...> start tag at or after pos and leaves pos
+    // just past its closing '>'
+    const std::string open = std::string("<") + name;
+    while (std::string::npos != (pos = doc.find(open, pos))) {
+        const char c = doc[pos + open.size()];
+        if (isspace(c) || ('>' == c) || ('/' == c)) {
+            std::string::size_type end = doc.find('>', pos);
+            if (std::string::npos == end) {
+                return false;
+            }
+            tag = doc.substr(pos, end + 1 - pos);
+            pos = end + 1;
+            return true;
+        }
+        pos += open.size();
+    }
+    return false;
+}
+
+
+static bool
+base64Decode(const char *src, size_t len, std::vector<unsigned char> &out)
+{
+    out.clear();
+    out.reserve(len / 4 * 3);
+    PWP_UINT32 acc = 0;
+    int bits = 0;
+    for (size_t ii = 0; ii < len; ++ii) {
+        const char c = src[ii];
+        int val;
+        if ((c >= 'A') && (c <= 'Z')) { val = c - 'A'; }
+        else if ((c >= 'a') && (c <= 'z')) { val = c - 'a' + 26; }
+        else if ((c >= '0') && (c <= '9')) { val = c - '0' + 52; }
+        else if ('+' == c) { val = 62; }
+        else if ('/' == c) { val = 63; }
+        else if ('=' == c) {
+            // padding ends this block
+            acc = 0;
+            bits = 0;
+            continue;
+        }
+        else if (isspace(c)) { continue; }
+        else { return false; }
+        acc = (acc << 6) | (PWP_UINT32)val;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back((unsigned char)((acc >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// The parts of a .vtu file needed to decode its data arrays            //
+//////////////////////////////////////////////////////////////////////////
+struct VtuDoc {
+    std::string doc;
+    bool        swap;
+    size_t      headerSize;
+    size_t      appendPos;
+    bool        appendRaw;
+};
+
+
+// Decodes a base64 header+data pair. VTK encodes the header and data
+// either as one stream or as two separately padded streams.
+static bool
+decodeVtuBase64(const VtuDoc &vtu, const char *src, size_t len,
+    std::vector<unsigned char> &data)
+{
+    const size_t encHdr = ((vtu.headerSize + 2) / 3) * 4;
+    std::vector<unsigned char> hdr;
+    if ((len < encHdr) || !base64Decode(src, encHdr, hdr)) {
+        return false;
+    }
+    PWP_UINT64 nbytes = (8 == vtu.headerSize) ?
+        getValue<PWP_UINT64>(&hdr[0], ValUInt64) :
+        getValue<PWP_UINT64>(&hdr[0], ValUInt32);
+    bool ret = false;
+    if ('=' == src[encHdr - 1]) {
+        // separate streams
+        ret = base64Decode(src + encHdr, len - encHdr, data);
+    }
+    else if (base64Decode(src, len, data) && (data.size() >= vtu.headerSize)) {
+        data.erase(data.begin(), data.begin() + vtu.headerSize);
+        ret = true;
+    }
+    if (vtu.swap) {
+        swapBytes(&nbytes, vtu.headerSize);
+    }
+    if (ret && (data.size() > nbytes)) {
+        data.resize((size_t)nbytes);
+    }
+    return ret;
+}
+
+
+template<typename T>
+static bool
+readVtuArray(const VtuDoc &vtu, const std::string &tag, size_t contentPos,
+    size_t count, std::vector<T> &vals)
+{
+    std::string format;
+    std::string typeName;
+    if (!xmlAttr(tag, "format", format) || !xmlAttr(tag, "type", typeName)) {
+        return false;
+    }
+    const ValType type = vtkXmlType(typeName);
+    const size_t size = valSize(type);
+    if (ValNone == type) {
+        return false;
+    }
+    vals.resize(count);
+    if (0 == count) {
+        return true;
+    }
+    std::vector<unsigned char> data;
+    if ("ascii" == format) {
+        const char *p = vtu.doc.c_str() + contentPos;
+        char *end;
+        for (size_t ii = 0; ii < count; ++ii, p = end) {
+            vals[ii] = (T)strtod(p, &end);
+            if (end == p) {
+                return false;
+            }
+        }
+        return true;
+    }
+    else if ("binary" == format) {
+        const std::string::size_type end = vtu.doc.find('<', contentPos);
+        if ((std::string::npos == end) ||
+                !decodeVtuBase64(vtu, vtu.doc.c_str() + contentPos,
+                    end - contentPos, data)) {
+            return false;
+        }
+    }
+    else if (("appended" == format) && (0 != vtu.appendPos)) {
+        std::string offsetStr;
+        if (!xmlAttr(tag, "offset", offsetStr)) {
+            return false;
+        }
+        const size_t pos = vtu.appendPos + (size_t)atof(offsetStr.c_str());
+        if (pos + vtu.headerSize > vtu.doc.size()) {
+            return false;
+        }
+        if (vtu.appendRaw) {
+            const unsigned char *p =
+                (const unsigned char *)vtu.doc.data() + pos;
+            data.assign(p + vtu.headerSize,
+                p + vtu.headerSize + ((pos + vtu.headerSize + count * size <=
+                    vtu.doc.size()) ? count * size : 0));
+        }
+        else {
+            std::string::size_type end = vtu.doc.find_first_not_of(
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+                "0123456789+/=", pos);
+            if (std::string::npos == end) {
+                end = vtu.doc.size();
+            }
+            if (!decodeVtuBase64(vtu, vtu.doc.c_str() + pos, end - pos,
+                    data)) {
+                return false;
+            }
+        }
+    }
+    else {
+        return false;
+    }
+    if (data.size() < count * size) {
+        return false;
+    }
+    getValues(&data[0], type, vtu.swap, count, &vals[0]);
+    return true;
+}
+
+
+bool
+MeshModel::readVtu(FILE *fp, std::string &err)
+{
+    VtuDoc vtu;
+    char buf[64 * 1024];
+    size_t cnt;
+    while (0 < (cnt = fread(buf, 1, sizeof(buf), fp))) {
+        vtu.doc.append(buf, cnt);
+    }
+    size_t pos = 0;
+    std::string tag;
+    std::string val;
+    if (!xmlFindTag(vtu.doc, "VTKFile", pos, tag) ||
+            !xmlAttr(tag, "type", val) || ("UnstructuredGrid" != val)) {
+        err = "not a VTK XML unstructured grid";
+        return false;
+    }
+    if (xmlAttr(tag, "compressor", val) && !val.empty()) {
+        err = "compressed .vtu files are not supported";
+        return false;
+    }
+    vtu.swap = xmlAttr(tag, "byte_order", val) &&
+        (("BigEndian" == val) == isLittleEndian());
+    vtu.headerSize = (xmlAttr(tag, "header_type", val) && ("UInt64" == val)) ?
+        8 : 4;
+    vtu.appendPos = 0;
+    vtu.appendRaw = true;
+    size_t appPos = pos;
+    if (xmlFindTag(vtu.doc, "AppendedData", appPos, tag)) {
+        vtu.appendRaw = !xmlAttr(tag, "encoding", val) || ("raw" == val);
+        std::string::size_type mark = vtu.doc.find('_', appPos);
+        vtu.appendPos = (std::string::npos == mark) ? 0 : mark + 1;
+    }
+
+    std::string numPts;
+    std::string numCells;
+    if (!xmlFindTag(vtu.doc, "Piece", pos, tag) ||
+            !xmlAttr(tag, "NumberOfPoints", numPts) ||
+            !xmlAttr(tag, "NumberOfCells", numCells)) {
+        err = "missing Piece";
+        return false;
+    }
+    const size_t np = (size_t)atof(numPts.c_str());
+    const size_t nc = (size_t)atof(numCells.c_str());
+    std::vector<double> pts;
+    size_t sectPos = pos;
+    if (!xmlFindTag(vtu.doc, "Points", sectPos, tag) ||
+            !xmlFindTag(vtu.doc, "DataArray", sectPos, tag) ||
+            !readVtuArray(vtu, tag, sectPos, 3 * np, pts)) {
+        err = "bad Points array";
+        return false;
+    }
+    std::vector<PWP_INT64> conn;
+    std::vector<PWP_INT64> offsets;
+    std::vector<PWP_INT64> types;
+    sectPos = pos;
+    if (!xmlFindTag(vtu.doc, "Cells", sectPos, tag)) {
+        err = "missing Cells";
+        return false;
+    }
+    const size_t cellsEnd = vtu.doc.find("</Cells>", sectPos);
+    bool ok = true;
+    while (ok && xmlFindTag(vtu.doc, "DataArray", sectPos, tag) &&
+            (sectPos < cellsEnd)) {
+        xmlAttr(tag, "Name", val);
+        if ("offsets" == val) {
+            ok = readVtuArray(vtu, tag, sectPos, nc, offsets);
+        }
+        else if ("types" == val) {
+            ok = readVtuArray(vtu, tag, sectPos, nc, types);
+        }
+    }
+    // VTK XML offsets give the end of each cell. The connectivity size is
+    // not known until the offsets are read.
+    offsets.insert(offsets.begin(), 0);
+    if (ok && (nc > 0)) {
+        sectPos = vtu.doc.find("<Cells", pos);
+        while (xmlFindTag(vtu.doc, "DataArray", sectPos, tag) &&
+                (sectPos < cellsEnd)) {
+            if (xmlAttr(tag, "Name", val) && ("connectivity" == val)) {
+                ok = readVtuArray(vtu, tag, sectPos, (size_t)offsets.back(),
+                    conn);
+                break;
+            }
+        }
+    }
+    if (!ok || (types.size() != nc) || (offsets.size() != nc + 1) ||
+            (conn.size() != (size_t)offsets.back())) {
+        err = "bad Cells arrays";
+        return false;
+    }
+    reserveVertices((PWP_UINT32)np);
+    for (size_t ii = 0; ii + 2 < pts.size(); ii += 3) {
+        addVertex(pts[ii], pts[ii + 1], pts[ii + 2]);
+    }
+    return addVtkCells(*this, offsets, conn, types, err);
+}
+
+
+
+//***************************************************************************
+// Gmsh 2.2 (ASCII and binary) and 4.1 (ASCII)
+//***************************************************************************
+
+// maps a Gmsh element type to a Pointwise element type. The higher order
+// types list their corner nodes first. numNodes is the node count of the
+// Gmsh element.
+static bool
+gmshElemType(int gmshType, PWGM_ENUM_ELEMTYPE &type, PWP_UINT32 &numNodes)
+{
+    bool ret = true;
+    switch (gmshType) {
+        case 1:  type = PWGM_ELEMTYPE_BAR;     numNodes = 2;  break;
+        case 2:  type = PWGM_ELEMTYPE_TRI;     numNodes = 3;  break;
+        case 3:  type = PWGM_ELEMTYPE_QUAD;    numNodes = 4;  break;
+        case 4:  type = PWGM_ELEMTYPE_TET;     numNodes = 4;  break;
+        case 5:  type = PWGM_ELEMTYPE_HEX;     numNodes = 8;  break;
+        case 6:  type = PWGM_ELEMTYPE_WEDGE;   numNodes = 6;  break;
+        case 7:  type = PWGM_ELEMTYPE_PYRAMID; numNodes = 5;  break;
+        case 8:  type = PWGM_ELEMTYPE_BAR;     numNodes = 3;  break;
+        case 9:  type = PWGM_ELEMTYPE_TRI;     numNodes = 6;  break;
+        case 10: type = PWGM_ELEMTYPE_QUAD;    numNodes = 9;  break;
+        case 11: type = PWGM_ELEMTYPE_TET;     numNodes = 10; break;
+        case 12: type = PWGM_ELEMTYPE_HEX;     numNodes = 27; break;
+        case 13: type = PWGM_ELEMTYPE_WEDGE;   numNodes = 18; break;
+        case 14: type = PWGM_ELEMTYPE_PYRAMID; numNodes = 14; break;
+        case 15: type = PWGM_ELEMTYPE_POINT;   numNodes = 1;  break;
+        case 16: type = PWGM_ELEMTYPE_QUAD;    numNodes = 8;  break;
+        case 17: type = PWGM_ELEMTYPE_HEX;     numNodes = 20; break;
+        case 18: type = PWGM_ELEMTYPE_WEDGE;   numNodes = 15; break;
+        case 19: type = PWGM_ELEMTYPE_PYRAMID; numNodes = 13; break;
+        default: ret = false; break;
+    }
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Maps Gmsh node tags to vertex indices and groups the elements into   //
+// one entity per physical group (or geometric entity if untagged).     //
+//////////////////////////////////////////////////////////////////////////
+class GmshBuilder {
+public:
+    GmshBuilder(MeshModel &model) :
+        model_(model),
+        nodes_(),
+        names_(),
+        entities_()
+    {
+    }
+
+    void addNode(PWP_INT64 tag, double x, double y, double z) {
+        nodes_[tag] = model_.vertexCount();
+        model_.addVertex(x, y, z);
+    }
+
+    void addName(int dim, int tag, const std::string &name) {
+        names_[Key(dim, tag)] = name;
+    }
+
+    bool addElement(int dim, int tag, PWGM_ENUM_ELEMTYPE type,
+            const PWP_INT64 *nodeTags) {
+        PWP_UINT32 verts[8];
+        const PWP_UINT32 cnt = MeshModel::vertCount(type);
+        for (PWP_UINT32 ii = 0; ii < cnt; ++ii) {
+            NodeMap::const_iterator it = nodes_.find(nodeTags[ii]);
+            if (nodes_.end() == it) {
+                return false;
+            }
+            verts[ii] = it->second;
+        }
+        return model_.addElement(entity(dim, tag, type), type, verts);
+    }
+
+private:
+    typedef std::map<PWP_INT64, PWP_UINT32>     NodeMap;
+    typedef std::pair<int, int>                 Key;
+    typedef std::map<Key, std::string>          NameMap;
+    typedef std::map<std::pair<Key, bool>, PWP_UINT32>  EntityMap;
+
+    PWP_UINT32 entity(int dim, int tag, PWGM_ENUM_ELEMTYPE type) {
+        const bool block = isVolume(type);
+        const std::pair<Key, bool> key(Key(dim, tag), block);
+        EntityMap::const_iterator it = entities_.find(key);
+        if (entities_.end() != it) {
+            return it->second;
+        }
+        std::string name;
+        NameMap::const_iterator nit = names_.find(key.first);
+        if (names_.end() != nit) {
+            name = nit->second;
+        }
+        else {
+            char buf[64];
+            sprintf(buf, "%s%d", (block ? "volume" : "surface"), tag);
+            name = buf;
+        }
+        return entities_[key] = model_.addEntity(name, block);
+    }
+
+private:
+    MeshModel & model_;
+    NodeMap     nodes_;
+    NameMap     names_;
+    EntityMap   entities_;
+};
+
+
+static bool
+readGmshNames(MeshReader &rdr, GmshBuilder &builder)
+{
+    PWP_UINT32 cnt = 0;
+    PWP_INT64 dim = 0;
+    PWP_INT64 tag = 0;
+    std::string name;
+    bool ret = rdr.uint32(cnt);
+    for (PWP_UINT32 ii = 0; ret && (ii < cnt); ++ii) {
+        ret = rdr.integer(dim) && rdr.integer(tag) && rdr.line(name);
+        // strip the quotes
+        std::string::size_type beg = name.find('"');
+        std::string::size_type end = name.rfind('"');
+        if (ret && (std::string::npos != beg) && (end > beg)) {
+            name = name.substr(beg + 1, end - beg - 1);
+        }
+        if (ret) {
+            builder.addName((int)dim, (int)tag, name);
+        }
+    }
+    return ret;
+}
+
+
+static bool
+readGmsh2(MeshReader &rdr, bool binary, bool swap, GmshBuilder &builder)
+{
+    std::string tok;
+    PWP_UINT32 cnt;
+    PWGM_ENUM_ELEMTYPE type;
+    PWP_UINT32 numNodes;
+    PWP_INT64 nodes[27];
+    bool ret = true;
+    while (ret && rdr.token(tok)) {
+        if ("$PhysicalNames" == tok) {
+            ret = readGmshNames(rdr, builder);
+        }
+        else if ("$Nodes" == tok) {
+            ret = rdr.uint32(cnt) && rdr.endLine();
+            PWP_INT64 tag = 0;
+            double xyz[3] = { 0.0, 0.0, 0.0 };
+            for (PWP_UINT32 ii = 0; ret && (ii < cnt); ++ii) {
+                if (binary) {
+                    PWP_INT32 tag32 = 0;
+                    ret = rdr.raw(&tag32, 4) && rdr.raw(xyz, sizeof(xyz));
+                    if (swap) {
+                        swapBytes(&tag32, 4);
+                        swapBytes(&xyz[0], 8);
+                        swapBytes(&xyz[1], 8);
+                        swapBytes(&xyz[2], 8);
+                    }
+                    tag = tag32;
+                }
+                else {
+                    ret = rdr.integer(tag) && rdr.real(xyz[0]) &&
+                        rdr.real(xyz[1]) && rdr.real(xyz[2]);
+                }
+                if (ret) {
+                    builder.addNode(tag, xyz[0], xyz[1], xyz[2]);
+                }
+            }
+        }
+        else if ("$Elements" == tok) {
+            ret = rdr.uint32(cnt) && rdr.endLine();
+            PWP_UINT32 ii = 0;
+            while (ret && (ii < cnt)) {
+                // binary elements come in blocks of one type:
+                //   type numElems numTags { num tags... nodes... }
+                // ASCII elements are one per line:
+                //   num type numTags tags... nodes...
+                PWP_INT32 hdr[3] = { 0, 1, 0 };
+                PWP_INT64 val = 0;
+                if (binary) {
+                    ret = rdr.raw(hdr, sizeof(hdr));
+                    if (swap) {
+                        swapBytes(&hdr[0], 4);
+                        swapBytes(&hdr[1], 4);
+                        swapBytes(&hdr[2], 4);
+                    }
+                }
+                else {
+                    ret = rdr.integer(val) && rdr.integer(val) &&
+                        ((hdr[0] = (PWP_INT32)val), rdr.integer(val)) &&
+                        ((hdr[2] = (PWP_INT32)val), true);
+                }
+                const bool known = gmshElemType(hdr[0], type, numNodes);
+                if (ret && !known && binary) {
+                    // cannot skip a block of unknown size
+                    ret = false;
+                }
+                for (PWP_INT32 jj = 0; ret && (jj < hdr[1]); ++jj, ++ii) {
+                    PWP_INT32 ints[64];
+                    const PWP_INT32 numInts = 1 + hdr[2] + (PWP_INT32)numNodes;
+                    PWP_INT64 tags[2] = { 0, 0 };
+                    if (binary) {
+                        ret = (numInts <= 64) && rdr.raw(ints, 4 * numInts);
+                        for (PWP_INT32 kk = 0; ret && (kk < numInts); ++kk) {
+                            if (swap) {
+                                swapBytes(&ints[kk], 4);
+                            }
+                        }
+                        for (PWP_INT32 kk = 0; ret && kk < hdr[2]; ++kk) {
+                            if (kk < 2) {
+                                tags[kk] = ints[1 + kk];
+                            }
+                        }
+                        for (PWP_UINT32 kk = 0; ret && (kk < numNodes); ++kk) {
+                            nodes[kk] = ints[1 + hdr[2] + kk];
+                        }
+                    }
+                    else {
+                        for (PWP_INT32 kk = 0; ret && (kk < hdr[2]); ++kk) {
+                            ret = rdr.integer(val);
+                            if (kk < 2) {
+                                tags[kk] = val;
+                            }
+                        }
+                        if (!known) {
+                            ret = ret && rdr.endLine();
+                            continue;
+                        }
+                        for (PWP_UINT32 kk = 0; ret && (kk < numNodes); ++kk) {
+                            ret = rdr.integer(nodes[kk]);
+                        }
+                    }
+                    // group by physical tag, else by elementary tag
+                    const int tag = (int)((0 != tags[0]) ? tags[0] : tags[1]);
+                    const int dim = isVolume(type) ? 3 : 2;
+                    ret = ret && builder.addElement(dim, tag, type, nodes);
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+
+static bool
+readGmsh4(MeshReader &rdr, GmshBuilder &builder)
+{
+    std::string tok;
+    std::map<std::pair<int, int>, int> physical;
+    PWGM_ENUM_ELEMTYPE type;
+    PWP_UINT32 numNodes;
+    PWP_INT64 nodes[27];
+    PWP_INT64 val = 0;
+    bool ret = true;
+    while (ret && rdr.token(tok)) {
+        if ("$PhysicalNames" == tok) {
+            ret = readGmshNames(rdr, builder);
+        }
+        else if ("$Entities" == tok) {
+            // remember the first physical tag of each curve/surface/volume
+            PWP_INT64 counts[4] = { 0, 0, 0, 0 };
+            ret = rdr.integer(counts[0]) && rdr.integer(counts[1]) &&
+                rdr.integer(counts[2]) && rdr.integer(counts[3]);
+            for (int dim = 0; ret && (dim < 4); ++dim) {
+                for (PWP_INT64 ii = 0; ret && (ii < counts[dim]); ++ii) {
+                    PWP_INT64 tag = 0;
+                    PWP_INT64 numPhys = 0;
+                    double bbox;
+                    ret = rdr.integer(tag);
+                    for (int kk = 0; ret && (kk < ((0 == dim) ? 3 : 6)); ++kk) {
+                        ret = rdr.real(bbox);
+                    }
+                    ret = ret && rdr.integer(numPhys);
+                    for (PWP_INT64 kk = 0; ret && (kk < numPhys); ++kk) {
+                        ret = rdr.integer(val);
+                        if (0 == kk) {
+                            physical[std::make_pair(dim, (int)tag)] = (int)val;
+                        }
+                    }
+                    // skip the bounding entities
+                    ret = ret && rdr.endLine();
+                }
+            }
+        }
+        else if ("$Nodes" == tok) {
+            PWP_INT64 numBlocks = 0;
+            PWP_INT64 numNodesTot = 0;
+            ret = rdr.integer(numBlocks) && rdr.integer(numNodesTot) &&
+                rdr.integer(val) && rdr.integer(val);
+            for (PWP_INT64 bb = 0; ret && (bb < numBlocks); ++bb) {
+                PWP_INT64 dim = 0;
+                PWP_INT64 parametric = 0;
+                PWP_INT64 cnt = 0;
+                ret = rdr.integer(dim) && rdr.integer(val) &&
+                    rdr.integer(parametric) && rdr.integer(cnt) &&
+                    (0 == parametric);
+                std::vector<PWP_INT64> tags((size_t)(ret ? cnt : 0));
+                for (size_t ii = 0; ret && (ii < tags.size()); ++ii) {
+                    ret = rdr.integer(tags[ii]);
+                }
+                double xyz[3] = { 0.0, 0.0, 0.0 };
+                for (size_t ii = 0; ret && (ii < tags.size()); ++ii) {
+                    ret = rdr.real(xyz[0]) && rdr.real(xyz[1]) &&
+                        rdr.real(xyz[2]);
+                    if (ret) {
+                        builder.addNode(tags[ii], xyz[0], xyz[1], xyz[2]);
+                    }
+                }
+            }
+        }
+        else if ("$Elements" == tok) {
+            PWP_INT64 numBlocks = 0;
+            ret = rdr.integer(numBlocks) && rdr.integer(val) &&
+                rdr.integer(val) && rdr.integer(val);
+            for (PWP_INT64 bb = 0; ret && (bb < numBlocks); ++bb) {
+                PWP_INT64 dim = 0;
+                PWP_INT64 tag = 0;
+                PWP_INT64 gmshType = 0;
+                PWP_INT64 cnt = 0;
+                ret = rdr.integer(dim) && rdr.integer(tag) &&
+                    rdr.integer(gmshType) && rdr.integer(cnt) &&
+                    gmshElemType((int)gmshType, type, numNodes);
+                std::map<std::pair<int, int>, int>::const_iterator it =
+                    physical.find(std::make_pair((int)dim, (int)tag));
+                const int group = (physical.end() == it) ? (int)tag :
+                    it->second;
+                for (PWP_INT64 ii = 0; ret && (ii < cnt); ++ii) {
+                    ret = rdr.integer(val);
+                    for (PWP_UINT32 kk = 0; ret && (kk < numNodes); ++kk) {
+                        ret = rdr.integer(nodes[kk]);
+                    }
+                    ret = ret && builder.addElement(isVolume(type) ? 3 : 2,
+                        group, type, nodes);
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+
+bool
+MeshModel::readGmsh(FILE *fp, std::string &err)
+{
+    MeshReader rdr(fp);
+    std::string tok;
+    double version = 0;
+    PWP_INT64 fileType = 0;
+    PWP_INT64 dataSize = 0;
+    if (!rdr.token(tok) || ("$MeshFormat" != tok) || !rdr.real(version) ||
+            !rdr.integer(fileType) || !rdr.integer(dataSize) ||
+            !rdr.endLine()) {
+        err = "not a Gmsh file";
+        return false;
+    }
+    bool swap = false;
+    if (1 == fileType) {
+        PWP_INT32 one;
+        if (!rdr.raw(&one, sizeof(one))) {
+            err = "truncated Gmsh header";
+            return false;
+        }
+        swap = (1 != one);
+    }
+    GmshBuilder builder(*this);
+    bool ret = false;
+    if ((version >= 2.0) && (version < 3.0)) {
+        ret = ((0 == fileType) || (8 == dataSize)) &&
+            readGmsh2(rdr, (1 == fileType), swap, builder);
+    }
+    else if ((version >= 4.0) && (version < 5.0) && (0 == fileType)) {
+        ret = readGmsh4(rdr, builder);
+    }
+    else {
+        err = "unsupported Gmsh version (use 2.2 or 4.1 ASCII)";
+        return false;
+    }
+    if (!ret) {
+        err = "bad or unsupported Gmsh data";
+    }
+    return ret;
+}
+
+
+
+//***************************************************************************
+// Print3D binary dump (.p3dm), native byte order:
+//   char       magic[8] = "P3DMESH1"
+//   UINT32     numVerts
+//   REAL64     xyz[numVerts][3]
+//   UINT32     numEntities
+//   foreach entity
+//     UINT8    isBlock
+//     UINT8    condition (0=mesh, 1=hidden, 2=solid)
+//     UINT16   nameLen
+//     char     name[nameLen]
+//     UINT32   numElems
+//     UINT8    type[numElems]          PWGM_ENUM_ELEMTYPE values
+//     UINT32   verts[]                 vertex indices of each element
+//   end
+//***************************************************************************
+
+bool
+MeshModel::readDump(FILE *fp, std::string &err)
+{
+    MeshReader rdr(fp);
+    char magic[8];
+    PWP_UINT32 numVerts;
+    if (!rdr.raw(magic, sizeof(magic)) ||
+            (0 != memcmp(magic, "P3DMESH1", sizeof(magic))) ||
+            !rdr.raw(&numVerts, sizeof(numVerts))) {
+        err = "not a Print3D mesh dump";
+        return false;
+    }
+    xyz_.resize(3 * (size_t)numVerts);
+    PWP_UINT32 numEntities = 0;
+    bool ret = ((0 == numVerts) ||
+            rdr.raw(&xyz_[0], xyz_.size() * sizeof(double))) &&
+        rdr.raw(&numEntities, sizeof(numEntities));
+    for (PWP_UINT32 ii = 0; ret && (ii < numEntities); ++ii) {
+        PWP_UINT8 flags[2];
+        PWP_UINT16 nameLen;
+        PWP_UINT32 numElems;
+        std::string name;
+        ret = rdr.raw(flags, sizeof(flags)) &&
+            rdr.raw(&nameLen, sizeof(nameLen)) && (flags[1] <= 2);
+        if (ret) {
+            name.resize(nameLen);
+            ret = ((0 == nameLen) || rdr.raw(&name[0], nameLen)) &&
+                rdr.raw(&numElems, sizeof(numElems));
+        }
+        if (ret) {
+            const PWP_UINT32 ent = addEntity(name, (0 != flags[0]));
+            entities_[ent].cond = (Print3DCond)flags[1];
+            std::vector<PWP_UINT8> types(numElems);
+            ret = (0 == numElems) || rdr.raw(&types[0], numElems);
+            PWP_UINT32 verts[8];
+            for (PWP_UINT32 jj = 0; ret && (jj < numElems); ++jj) {
+                const PWGM_ENUM_ELEMTYPE type = (PWGM_ENUM_ELEMTYPE)types[jj];
+                const PWP_UINT32 cnt = vertCount(type);
+                ret = (cnt > 0) &&
+                    rdr.raw(verts, cnt * sizeof(PWP_UINT32)) &&
+                    addElement(ent, type, verts);
+            }
+        }
+    }
+    if (!ret) {
+        err = "bad Print3D mesh dump";
+    }
+    return ret;
+}
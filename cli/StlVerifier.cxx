@@ -0,0 +1,668 @@
+/****************************************************************************
+ *
+ * class StlVerifier
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "StlVerifier.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <map>
+
+const PWP_UINT64 StlHeaderSize = 84;    // 80 byte header + UINT32 count
+const PWP_UINT64 StlFacetSize = 50;     // 12 REAL32 + 1 UINT16
+
+// the smallest chunk of an ASCII file checked by one task
+const PWP_UINT64 MinChunkBytes = 64 * 1024;
+
+// A facet has no area if twice its area is below this fraction of its
+// longest edge squared. Its normal may be off by this much in length and
+// must have at least this cosine with the winding normal.
+const double DegenerateTol = 1.0E-10;
+const double NormalLenTol = 1.0E-3;
+const double NormalCosTol = 0.9;
+
+
+static bool
+isFiniteVal(double val)
+{
+    return (val == val) && (val - val == 0.0);
+}
+
+
+// counts the facet with normal n and vertices v into stats
+static void
+checkFacet(const float n[3], const float v[3][3], StlSolidStats &stats)
+{
+    ++stats.numFacets;
+    for (int ii = 0; ii < 3; ++ii) {
+        if (!isFiniteVal(n[ii]) || !isFiniteVal(v[0][ii]) ||
+                !isFiniteVal(v[1][ii]) || !isFiniteVal(v[2][ii])) {
+            ++stats.numNonFinite;
+            return;
+        }
+    }
+    double e0[3];
+    double e1[3];
+    double e2[3];
+    for (int ii = 0; ii < 3; ++ii) {
+        e0[ii] = (double)v[1][ii] - v[0][ii];
+        e1[ii] = (double)v[2][ii] - v[1][ii];
+        e2[ii] = (double)v[0][ii] - v[2][ii];
+    }
+    const double c[3] = {
+        e0[1] * e1[2] - e0[2] * e1[1],
+        e0[2] * e1[0] - e0[0] * e1[2],
+        e0[0] * e1[1] - e0[1] * e1[0]
+    };
+    const double len0 = e0[0] * e0[0] + e0[1] * e0[1] + e0[2] * e0[2];
+    const double len1 = e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2];
+    const double len2 = e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2];
+    const double maxLen = std::max(len0, std::max(len1, len2));
+    const double cLen = sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+    if (cLen <= DegenerateTol * maxLen) {
+        ++stats.numDegenerate;
+        return;
+    }
+    stats.area += 0.5 * cLen;
+    const double nLen = sqrt((double)n[0] * n[0] + (double)n[1] * n[1] +
+        (double)n[2] * n[2]);
+    const double cosAngle = (n[0] * c[0] + n[1] * c[1] + n[2] * c[2]) /
+        (nLen * cLen);
+    if ((fabs(nLen - 1.0) > NormalLenTol) || !(cosAngle >= NormalCosTol)) {
+        ++stats.numBadNormals;
+    }
+}
+
+
+// the bits of the facet's coordinates, with -0 and 0 the same
+static void
+vertexBits(const float v[3][3], PWP_UINT32 bits[3][3])
+{
+    for (int ii = 0; ii < 3; ++ii) {
+        for (int jj = 0; jj < 3; ++jj) {
+            const float val = (0.0f == v[ii][jj]) ? 0.0f : v[ii][jj];
+            memcpy(&bits[ii][jj], &val, sizeof(val));
+        }
+    }
+}
+
+
+// Returns a hash of the facet's vertices that does not depend on which
+// vertex comes first. The winding is kept.
+static PWP_UINT64
+hashFacet(const float v[3][3])
+{
+    PWP_UINT32 bits[3][3];
+    vertexBits(v, bits);
+    int first = 0;
+    for (int ii = 1; ii < 3; ++ii) {
+        if (std::lexicographical_compare(bits[ii], bits[ii] + 3,
+                bits[first], bits[first] + 3)) {
+            first = ii;
+        }
+    }
+    // FNV-1a over the vertex words
+    PWP_UINT64 ret = 14695981039346656037ULL;
+    for (int ii = 0; ii < 3; ++ii) {
+        const PWP_UINT32 *vert = bits[(first + ii) % 3];
+        for (int jj = 0; jj < 3; ++jj) {
+            ret ^= vert[jj];
+            ret *= 1099511628211ULL;
+        }
+    }
+    return ret;
+}
+
+
+// Appends a hash of each edge of the facet. The lowest bit is the
+// direction of the edge and the others identify its two vertices, so an
+// edge and its reverse differ only in that bit. An edge from a vertex to
+// itself is skipped.
+static void
+hashEdges(const float v[3][3], std::vector<PWP_UINT64> &hashes)
+{
+    PWP_UINT32 bits[3][3];
+    vertexBits(v, bits);
+    for (int ii = 0; ii < 3; ++ii) {
+        const PWP_UINT32 *a = bits[ii];
+        const PWP_UINT32 *b = bits[(ii + 1) % 3];
+        if (std::equal(a, a + 3, b)) {
+            continue;
+        }
+        const bool reverse = std::lexicographical_compare(b, b + 3, a, a + 3);
+        const PWP_UINT32 *lo = reverse ? b : a;
+        const PWP_UINT32 *hi = reverse ? a : b;
+        // FNV-1a over the vertex words
+        PWP_UINT64 ret = 14695981039346656037ULL;
+        for (int jj = 0; jj < 3; ++jj) {
+            ret ^= lo[jj];
+            ret *= 1099511628211ULL;
+        }
+        for (int jj = 0; jj < 3; ++jj) {
+            ret ^= hi[jj];
+            ret *= 1099511628211ULL;
+        }
+        hashes.push_back((ret & ~(PWP_UINT64)1) | (reverse ? 1 : 0));
+    }
+}
+
+
+// Copies the line at pos, without its end of line, into buf. Returns the
+// start of the next line.
+static PWP_UINT64
+readLine(const unsigned char *data, PWP_UINT64 pos, PWP_UINT64 end, char *buf,
+    size_t bufSize)
+{
+    const unsigned char *nl = (const unsigned char *)memchr(data + pos, '\n',
+        (size_t)(end - pos));
+    const PWP_UINT64 lineEnd = (0 == nl) ? end : (PWP_UINT64)(nl - data);
+    size_t len = (size_t)(lineEnd - pos);
+    if (len > bufSize - 1) {
+        len = bufSize - 1;
+    }
+    memcpy(buf, data + pos, len);
+    while ((len > 0) && ('\r' == buf[len - 1])) {
+        --len;
+    }
+    buf[len] = '\0';
+    return (0 == nl) ? end : lineEnd + 1;
+}
+
+
+// Returns the text after keyword if line starts with it, or 0
+static const char *
+afterKeyword(const char *line, const char *keyword)
+{
+    while ((' ' == *line) || ('\t' == *line)) {
+        ++line;
+    }
+    const size_t len = strlen(keyword);
+    if ((0 != strncmp(line, keyword, len)) || ((' ' != line[len]) &&
+            ('\t' != line[len]) && ('\0' != line[len]))) {
+        return 0;
+    }
+    line += len;
+    while ((' ' == *line) || ('\t' == *line)) {
+        ++line;
+    }
+    return line;
+}
+
+
+// reads up to three numbers, returns the number read
+static int
+readXyz(const char *str, float xyz[3])
+{
+    int ret = 0;
+    for (; ret < 3; ++ret) {
+        char *end = 0;
+        const double val = strtod(str, &end);
+        if (end == str) {
+            break;
+        }
+        xyz[ret] = (float)val;
+        str = end;
+    }
+    return ret;
+}
+
+
+
+//***************************************************************************
+// The facets [begin, end) of a binary file or the bytes [begin, end) of an
+// ASCII file, checked by one task. An ASCII chunk does not know the solid
+// that is open at its start, so solids[0] counts its facets until the
+// chunk's first solid line.
+struct StlVerifier::Chunk {
+    PWP_UINT64                  begin;
+    PWP_UINT64                  end;
+    std::vector<StlSolidStats>  solids;
+    bool                        switched;   // a solid line was seen
+    std::string                 open;       // the solid open at end
+    std::vector<PWP_UINT64>     hashes;
+};
+
+
+//***************************************************************************
+// The chunks shared by the tasks
+struct StlVerifier::Job {
+    const StlVerifier *     verifier;
+    std::vector<Chunk> *    chunks;
+    ScanMode                mode;
+};
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+StlSolidStats::StlSolidStats() :
+    name(),
+    numFacets(0),
+    numDegenerate(0),
+    numNonFinite(0),
+    numBadNormals(0),
+    numMalformed(0),
+    area(0.0)
+{
+}
+
+
+void
+StlSolidStats::add(const StlSolidStats &other)
+{
+    numFacets += other.numFacets;
+    numDegenerate += other.numDegenerate;
+    numNonFinite += other.numNonFinite;
+    numBadNormals += other.numBadNormals;
+    numMalformed += other.numMalformed;
+    area += other.area;
+}
+
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+StlVerifier::StlVerifier(PWP_UINT32 numThreads) :
+    numThreads_(numThreads),
+    file_(),
+    binary_(false),
+    headerCount_(0),
+    fileCount_(0)
+{
+}
+
+
+StlVerifier::~StlVerifier()
+{
+}
+
+
+bool
+StlVerifier::open(const std::string &path, std::string &err)
+{
+    close();
+    if (!file_.open(path)) {
+        err = "cannot map " + path;
+        return false;
+    }
+    // A file is binary if its size matches the facet count in its header.
+    // Otherwise it is ASCII if it starts with "solid".
+    const unsigned char *data = file_.data();
+    const PWP_UINT64 size = file_.size();
+    PWP_UINT32 count = 0;
+    if (size >= StlHeaderSize) {
+        memcpy(&count, data + 80, sizeof(count));
+    }
+    PWP_UINT64 pos = 0;
+    while ((pos < size) && ((' ' == data[pos]) || ('\t' == data[pos]))) {
+        ++pos;
+    }
+    const bool ascii = (pos + 5 <= size) &&
+        (0 == memcmp(data + pos, "solid", 5));
+    binary_ = (size >= StlHeaderSize) &&
+        ((size == StlHeaderSize + StlFacetSize * count) || !ascii);
+    if (!binary_ && !ascii) {
+        err = path + " is not an STL file";
+        close();
+        return false;
+    }
+    if (binary_) {
+        headerCount_ = count;
+        fileCount_ = (size - StlHeaderSize) / StlFacetSize;
+    }
+    return true;
+}
+
+
+void
+StlVerifier::close()
+{
+    file_.close();
+    binary_ = false;
+    headerCount_ = 0;
+    fileCount_ = 0;
+}
+
+
+void
+StlVerifier::check(std::vector<StlSolidStats> &solids, StlSolidStats &totals)
+{
+    std::vector<Chunk> chunks;
+    runChunks(chunks, ScanCheck);
+    // merge the chunk solids by name, in the order they are first seen
+    solids.clear();
+    totals = StlSolidStats();
+    std::map<std::string, size_t> index;
+    std::string open;
+    for (size_t ii = 0; ii < chunks.size(); ++ii) {
+        Chunk &chunk = chunks[ii];
+        if (!binary_ && !chunk.solids.empty()) {
+            chunk.solids[0].name = open;
+        }
+        for (size_t jj = 0; jj < chunk.solids.size(); ++jj) {
+            const StlSolidStats &stats = chunk.solids[jj];
+            totals.add(stats);
+            if (stats.name.empty() && (0 == stats.numFacets) &&
+                    (0 == stats.numMalformed)) {
+                // no solid and nothing in it
+                continue;
+            }
+            std::map<std::string, size_t>::iterator it =
+                index.find(stats.name);
+            if (index.end() == it) {
+                it = index.insert(std::make_pair(stats.name,
+                    solids.size())).first;
+                solids.push_back(StlSolidStats());
+                solids.back().name = stats.name;
+            }
+            solids[it->second].add(stats);
+        }
+        if (chunk.switched) {
+            open = chunk.open;
+        }
+    }
+}
+
+
+void
+StlVerifier::facetHashes(std::vector<PWP_UINT64> &hashes)
+{
+    std::vector<Chunk> chunks;
+    runChunks(chunks, ScanFacets);
+    collectHashes(chunks, hashes);
+}
+
+
+PWP_UINT64
+StlVerifier::openEdgeCount()
+{
+    // In each run of equal hashes but for the direction bit, the edges
+    // one way are matched one to one with those the other way.
+    std::vector<Chunk> chunks;
+    std::vector<PWP_UINT64> hashes;
+    runChunks(chunks, ScanEdges);
+    collectHashes(chunks, hashes);
+    PWP_UINT64 ret = 0;
+    size_t ii = 0;
+    while (ii < hashes.size()) {
+        const PWP_UINT64 edge = hashes[ii] >> 1;
+        PWP_UINT64 numFwd = 0;
+        PWP_UINT64 numRev = 0;
+        for (; (ii < hashes.size()) && ((hashes[ii] >> 1) == edge); ++ii) {
+            if (0 != (hashes[ii] & 1)) {
+                ++numRev;
+            }
+            else {
+                ++numFwd;
+            }
+        }
+        ret += (numFwd > numRev) ? (numFwd - numRev) : (numRev - numFwd);
+    }
+    return ret;
+}
+
+
+void
+StlVerifier::collectHashes(std::vector<Chunk> &chunks,
+    std::vector<PWP_UINT64> &hashes)
+{
+    size_t count = 0;
+    for (size_t ii = 0; ii < chunks.size(); ++ii) {
+        count += chunks[ii].hashes.size();
+    }
+    hashes.clear();
+    hashes.reserve(count);
+    for (size_t ii = 0; ii < chunks.size(); ++ii) {
+        hashes.insert(hashes.end(), chunks[ii].hashes.begin(),
+            chunks[ii].hashes.end());
+        std::vector<PWP_UINT64>().swap(chunks[ii].hashes);
+    }
+    std::sort(hashes.begin(), hashes.end());
+}
+
+
+void
+StlVerifier::diff(const std::vector<PWP_UINT64> &a,
+    const std::vector<PWP_UINT64> &b, PWP_UINT64 &onlyA, PWP_UINT64 &onlyB)
+{
+    // a and b are sorted, equal hashes are matched one to one
+    onlyA = 0;
+    onlyB = 0;
+    size_t ia = 0;
+    size_t ib = 0;
+    while ((ia < a.size()) && (ib < b.size())) {
+        if (a[ia] < b[ib]) {
+            ++onlyA;
+            ++ia;
+        }
+        else if (b[ib] < a[ia]) {
+            ++onlyB;
+            ++ib;
+        }
+        else {
+            ++ia;
+            ++ib;
+        }
+    }
+    onlyA += a.size() - ia;
+    onlyB += b.size() - ib;
+}
+
+
+void
+StlVerifier::makeChunks(std::vector<Chunk> &chunks) const
+{
+    // Each thread gets several chunks so that an uneven chunk does not
+    // hold up the others. An ASCII chunk starts on a facet or solid line.
+    const PWP_UINT32 numThreads = (0 == numThreads_) ?
+        WorkerPool::processorCount() : numThreads_;
+    const PWP_UINT64 total = binary_ ? fileCount_ : file_.size();
+    PWP_UINT64 numChunks = 4 * (PWP_UINT64)numThreads;
+    if (!binary_ && (total / MinChunkBytes < numChunks)) {
+        numChunks = total / MinChunkBytes;
+    }
+    if (numChunks < 1) {
+        numChunks = 1;
+    }
+    chunks.clear();
+    chunks.resize((size_t)numChunks);
+    const unsigned char *data = file_.data();
+    char line[256];
+    PWP_UINT64 prev = 0;
+    for (size_t ii = 0; ii < chunks.size(); ++ii) {
+        PWP_UINT64 begin = total * ii / numChunks;
+        if (!binary_ && (0 != begin)) {
+            // skip the partial line, then to a line that starts a facet
+            // or a solid
+            const unsigned char *nl = (const unsigned char *)memchr(
+                data + begin - 1, '\n', (size_t)(total - begin + 1));
+            begin = (0 == nl) ? total : (PWP_UINT64)(nl - data) + 1;
+            while (begin < total) {
+                const PWP_UINT64 next = readLine(data, begin, total, line,
+                    sizeof(line));
+                if ((0 != afterKeyword(line, "facet")) ||
+                        (0 != afterKeyword(line, "solid")) ||
+                        (0 != afterKeyword(line, "endsolid"))) {
+                    break;
+                }
+                begin = next;
+            }
+        }
+        chunks[ii].begin = std::max(begin, prev);
+        chunks[ii].switched = false;
+        prev = chunks[ii].begin;
+        if (ii > 0) {
+            chunks[ii - 1].end = prev;
+        }
+    }
+    chunks.back().end = total;
+}
+
+
+void
+StlVerifier::scanFacet(Chunk &chunk, ScanMode mode, const float n[3],
+    const float v[3][3], StlSolidStats *stats)
+{
+    // the stats are only counted by a check
+    switch (mode) {
+        case ScanCheck:
+            checkFacet(n, v, *stats);
+            break;
+        case ScanFacets:
+            chunk.hashes.push_back(hashFacet(v));
+            break;
+        case ScanEdges:
+            hashEdges(v, chunk.hashes);
+            break;
+    }
+}
+
+
+void
+StlVerifier::scanBinary(Chunk &chunk, ScanMode mode) const
+{
+    // the solids are named by their facet attribute
+    std::map<PWP_UINT16, size_t> index;
+    PWP_UINT16 lastAttr = 0;
+    size_t last = 0;
+    const unsigned char *facet = file_.data() + StlHeaderSize +
+        chunk.begin * StlFacetSize;
+    float n[3];
+    float v[3][3];
+    PWP_UINT16 attr;
+    for (PWP_UINT64 ii = chunk.begin; ii < chunk.end; ++ii) {
+        memcpy(n, facet, sizeof(n));
+        memcpy(v, facet + sizeof(n), sizeof(v));
+        memcpy(&attr, facet + sizeof(n) + sizeof(v), sizeof(attr));
+        facet += StlFacetSize;
+        if (ScanCheck != mode) {
+            scanFacet(chunk, mode, n, v, 0);
+            continue;
+        }
+        if (chunk.solids.empty() || (attr != lastAttr)) {
+            std::map<PWP_UINT16, size_t>::iterator it = index.find(attr);
+            if (index.end() == it) {
+                char name[32];
+                sprintf(name, "id %u", (unsigned)attr);
+                it = index.insert(std::make_pair(attr,
+                    chunk.solids.size())).first;
+                chunk.solids.push_back(StlSolidStats());
+                chunk.solids.back().name = name;
+            }
+            lastAttr = attr;
+            last = it->second;
+        }
+        scanFacet(chunk, mode, n, v, &chunk.solids[last]);
+    }
+}
+
+
+void
+StlVerifier::scanAscii(Chunk &chunk, ScanMode mode) const
+{
+    const unsigned char *data = file_.data();
+    chunk.solids.push_back(StlSolidStats());
+    size_t cur = 0;
+    bool inSolid = true;    // the solid before the chunk, if any
+    bool inFacet = false;
+    int numVerts = 0;
+    float n[3] = { 0.0f, 0.0f, 0.0f };
+    float v[3][3];
+    char line[256];
+    const char *rest;
+    PWP_UINT64 pos = chunk.begin;
+    while (pos < chunk.end) {
+        pos = readLine(data, pos, chunk.end, line, sizeof(line));
+        if (0 != (rest = afterKeyword(line, "facet"))) {
+            if (!inSolid) {
+                // facets outside of any solid
+                chunk.solids.push_back(StlSolidStats());
+                cur = chunk.solids.size() - 1;
+                inSolid = true;
+            }
+            if (inFacet) {
+                // no endfacet
+                ++chunk.solids[cur].numMalformed;
+            }
+            const char *xyz = afterKeyword(rest, "normal");
+            if ((0 == xyz) || (3 != readXyz(xyz, n))) {
+                n[0] = n[1] = n[2] = 0.0f;
+            }
+            inFacet = true;
+            numVerts = 0;
+        }
+        else if (0 != (rest = afterKeyword(line, "vertex"))) {
+            if (inFacet && (numVerts < 3) &&
+                    (3 == readXyz(rest, v[numVerts]))) {
+                ++numVerts;
+            }
+            else {
+                numVerts = 4;
+            }
+        }
+        else if (0 != afterKeyword(line, "endfacet")) {
+            if (!inFacet || (3 != numVerts)) {
+                ++chunk.solids[cur].numMalformed;
+            }
+            else {
+                scanFacet(chunk, mode, n, v, &chunk.solids[cur]);
+            }
+            inFacet = false;
+        }
+        else if (0 != (rest = afterKeyword(line, "solid"))) {
+            chunk.solids.push_back(StlSolidStats());
+            chunk.solids.back().name = rest;
+            cur = chunk.solids.size() - 1;
+            inSolid = true;
+            chunk.switched = true;
+            chunk.open = rest;
+        }
+        else if (0 != afterKeyword(line, "endsolid")) {
+            inSolid = false;
+            chunk.switched = true;
+            chunk.open.clear();
+        }
+    }
+}
+
+
+void
+StlVerifier::runChunks(std::vector<Chunk> &chunks, ScanMode mode)
+{
+    makeChunks(chunks);
+    Job job;
+    job.verifier = this;
+    job.chunks = &chunks;
+    job.mode = mode;
+    WorkerPool pool(numThreads_);
+    pool.run(scanTask, &job, (PWP_UINT32)chunks.size());
+}
+
+
+void
+StlVerifier::scanTask(void *ctx, PWP_UINT32 task)
+{
+    Job *job = (Job *)ctx;
+    Chunk &chunk = (*job->chunks)[task];
+    if (job->verifier->isBinary()) {
+        job->verifier->scanBinary(chunk, job->mode);
+    }
+    else {
+        job->verifier->scanAscii(chunk, job->mode);
+    }
+}
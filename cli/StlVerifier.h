@@ -0,0 +1,123 @@
+/****************************************************************************
+ *
+ * class StlVerifier
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _STLVERIFIER_H_
+#define _STLVERIFIER_H_
+
+#include "apiPWP.h"
+
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+// The facet counts of one solid of an STL file                         //
+//////////////////////////////////////////////////////////////////////////
+struct StlSolidStats {
+    StlSolidStats();
+
+    void    add(const StlSolidStats &other);
+    bool    hasDefects() const {
+                return (0 != numDegenerate) || (0 != numNonFinite) ||
+                    (0 != numBadNormals) || (0 != numMalformed); }
+
+    std::string name;
+    PWP_UINT64  numFacets;
+    PWP_UINT64  numDegenerate;  // no area
+    PWP_UINT64  numNonFinite;   // a NaN or infinite value
+    PWP_UINT64  numBadNormals;  // not a unit vector along the winding
+    PWP_UINT64  numMalformed;   // an ASCII facet without three vertices
+    double      area;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Checks an ASCII or binary STL file written by Print3DExporter without //
+// reading it into memory. The file is mapped and its facets are split  //
+// into chunks that are checked on worker threads.                      //
+//                                                                       //
+// ASCII solids are identified by name, binary ones by the solid id in  //
+// the facet attribute.                                                 //
+//////////////////////////////////////////////////////////////////////////
+class StlVerifier {
+public:
+    // numThreads 0 uses one thread per processor
+    StlVerifier(PWP_UINT32 numThreads);
+    ~StlVerifier();
+
+    // Maps the STL at path. Returns false and sets err on failure.
+    bool    open(const std::string &path, std::string &err);
+    void    close();
+
+    bool        isBinary() const {
+                    return binary_; }
+
+    // the facet count in a binary header and the whole facets after it
+    PWP_UINT64  headerCount() const {
+                    return headerCount_; }
+    PWP_UINT64  fileCount() const {
+                    return fileCount_; }
+
+    // Checks every facet. The solids are in file order.
+    void    check(std::vector<StlSolidStats> &solids, StlSolidStats &totals);
+
+    // Returns a sorted hash of each facet. The hash ignores the normal and
+    // the solid, and does not depend on which vertex comes first.
+    void    facetHashes(std::vector<PWP_UINT64> &hashes);
+
+    // Returns the number of facet edges that are not matched by an edge of
+    // another facet running the other way. A closed surface whose facets
+    // are all wound the same way has none. Vertices match if their REAL32
+    // coordinates are equal.
+    PWP_UINT64  openEdgeCount();
+
+    // Counts the facets of a that are not in b and the facets of b that
+    // are not in a, regardless of their order
+    static void diff(const std::vector<PWP_UINT64> &a,
+                    const std::vector<PWP_UINT64> &b, PWP_UINT64 &onlyA,
+                    PWP_UINT64 &onlyB);
+
+private:
+    struct Chunk;
+    struct Job;
+
+    // what a scan collects
+    enum ScanMode {
+        ScanCheck,      // the solid stats
+        ScanFacets,     // the facet hashes
+        ScanEdges       // the edge hashes
+    };
+
+    void    makeChunks(std::vector<Chunk> &chunks) const;
+    static void scanFacet(Chunk &chunk, ScanMode mode, const float n[3],
+                    const float v[3][3], StlSolidStats *stats);
+    void    scanBinary(Chunk &chunk, ScanMode mode) const;
+    void    scanAscii(Chunk &chunk, ScanMode mode) const;
+    void    runChunks(std::vector<Chunk> &chunks, ScanMode mode);
+    static void collectHashes(std::vector<Chunk> &chunks,
+                    std::vector<PWP_UINT64> &hashes);
+
+    static void scanTask(void *ctx, PWP_UINT32 task);
+
+    // not copyable
+    StlVerifier(const StlVerifier &);
+    StlVerifier & operator=(const StlVerifier &);
+
+private:
+    PWP_UINT32  numThreads_;
+    MappedFile  file_;
+    bool        binary_;
+    PWP_UINT64  headerCount_;
+    PWP_UINT64  fileCount_;
+};
+
+#endif // _STLVERIFIER_H_
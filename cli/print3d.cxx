@@ -0,0 +1,977 @@
+/****************************************************************************
+ *
+ * print3d - headless Print3D exporter
+ *
+ * Reads unstructured mesh files and exports each one to STL as inflated
+ * grid edges using the same exporter as the Pointwise plugin.
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2014 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#   include <sys/types.h>
+#   include <sys/wait.h>
+#   include <unistd.h>
+#endif
+
+#include "AllocCounter.h"
+#include "GridSnapshot.h"
+#include "Print3DExporter.h"
+#include "Print3DSweep.h"
+#include "MeshModel.h"
+#include "StlMerge.h"
+#include "StlVerifier.h"
+
+#include <string>
+#include <vector>
+
+
+static volatile sig_atomic_t Interrupted = 0;
+
+
+static void
+onInterrupt(int)
+{
+    Interrupted = 1;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Reports exporter messages on stderr and honors Ctrl-C as an abort    //
+//////////////////////////////////////////////////////////////////////////
+class CliHost : public Print3DHost {
+public:
+    CliHost(const std::string &name, bool quiet) :
+        name_(name),
+        quiet_(quiet)
+    {
+    }
+
+    virtual bool progressBeginStep(PWP_UINT32) {
+        return !aborted();
+    }
+
+    virtual bool progressIncrement() {
+        return !aborted();
+    }
+
+    virtual void progressEndStep() {
+    }
+
+    virtual bool aborted() {
+        return 0 != Interrupted;
+    }
+
+    virtual void sendInfoMsg(const char *msg) {
+        if (!quiet_) {
+            fprintf(stderr, "%s: %s\n", name_.c_str(), msg);
+        }
+    }
+
+    virtual void sendWarningMsg(const char *msg) {
+        fprintf(stderr, "%s: warning: %s\n", name_.c_str(), msg);
+    }
+
+    virtual void sendErrorMsg(const char *msg) {
+        fprintf(stderr, "%s: error: %s\n", name_.c_str(), msg);
+    }
+
+private:
+    std::string name_;
+    bool        quiet_;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// The command line options                                             //
+//////////////////////////////////////////////////////////////////////////
+struct Options {
+    Options() :
+        settings(),
+        output(),
+        outDir(),
+        hidden(),
+        solid(),
+        jobs(1),
+        partitions(1),
+        quiet(false),
+        snapshot(false),
+        verify(false),
+        closed(false),
+        diff(false),
+        diameters(),
+        numPoints(),
+        formats(),
+        inputs()
+    {
+    }
+
+    Print3DSettings             settings;
+    std::string                 output;
+    std::string                 outDir;
+    std::vector<std::string>    hidden;
+    std::vector<std::string>    solid;
+    int                         jobs;
+    PWP_UINT32                  partitions;
+    bool                        quiet;
+    bool                        snapshot;
+    bool                        verify;
+    bool                        closed;
+    bool                        diff;
+    std::vector<double>         diameters;
+    std::vector<PWP_UINT>       numPoints;
+    std::vector<Print3DFormat>  formats;
+    std::vector<std::string>    inputs;
+};
+
+
+static void
+usage(FILE *fp)
+{
+    fprintf(fp,
+        "usage: print3d [options] mesh-file...\n"
+        "       print3d [--threads N] --verify [--closed] stl-file...\n"
+        "       print3d [--threads N] --diff stl-file stl-file\n"
+        "\n"
+        "Exports each mesh file (.vtk, .vtu, .msh, .p3dm) or grid snapshot\n"
+        "(.p3ds) to STL as inflated grid edges.\n"
+        "\n"
+        "  -o FILE               output file (single input only)\n"
+        "  -d DIR                output directory (default: next to input)\n"
+        "  --diameter D[,D...]   edge cylinder diameter (default %g)\n"
+        "  --points N[,N...]     cylinder base points, %d..%d (default %d)\n"
+        "  --cyl-tolerance T     reuse the cylinder of a nearby edge direction\n"
+        "                        if no point moves more than T (default 0,\n"
+        "                        exact cylinders)\n"
+        "  --edges M             inflate all edges (default), the boundary\n"
+        "                        edges or the feature edges\n"
+        "  --boundary-layers K   --edges boundary also keeps the cell layers\n"
+        "                        within K of the boundary, 0..%d (default 0)\n"
+        "  --feature-angle A     --edges feature keeps the edges whose faces\n"
+        "                        meet at more than A degrees (default %g)\n"
+        "  --clip-box X0,Y0,Z0,X1,Y1,Z1\n"
+        "                        only export the edges that meet this box;\n"
+        "                        repeat for several regions\n"
+        "  --clip-half-space A,B,C,D\n"
+        "                        only export the edges that meet the\n"
+        "                        half-space A*x + B*y + C*z <= D\n"
+        "  --clip-trim           cut the edges that cross the clip regions\n"
+        "                        at the region boundaries\n"
+        "  --weld                merge coincident vertices of different\n"
+        "                        indices, such as block interface points\n"
+        "  --weld-tolerance T    --weld merges vertices within T (default 0,\n"
+        "                        the same coordinates)\n"
+        "  --merge-chains        one cylinder per run of collinear edges\n"
+        "  --chain-tolerance T   --merge-chains keeps the joined vertices\n"
+        "                        within T of the cylinder axis (default 0)\n"
+        "  --edge-order O        write the STL cylinders in traversal order\n"
+        "                        (default) or along a morton or hilbert\n"
+        "                        curve, with a chunk index (.chunks)\n"
+        "  --formats F[,F...]    also export these formats: stl, 3mf, cli\n"
+        "  --multi-solid         export separate solids (default)\n"
+        "  --no-multi-solid      a single solid\n"
+        "  --solid-scope S       cylinder (default), entity, cluster (nearby\n"
+        "                        edges) or component (connected edges)\n"
+        "  --cluster-tris N      largest cluster solid, in triangles\n"
+        "                        (default %d)\n"
+        "  --solid-ids F         binary solid id format: plain (default),\n"
+        "                        viscam or magics\n"
+        "  --ascii               ASCII STL (default)\n"
+        "  --binary              binary STL\n"
+        "  --3mf                 3MF with one instanced cylinder mesh\n"
+        "                        (default if -o ends with .3mf)\n"
+        "  --beam-lattice        3MF with a beam per edge instead of cylinders\n"
+        "  --cli                 layer outlines in Common Layer Interface\n"
+        "                        format (default if -o ends with .cli)\n"
+        "  --slice-thickness T   --cli layer thickness (default %g)\n"
+        "  --tess-cache          reuse unchanged entities from a cache file\n"
+        "  --checkpoint          save the progress after each patch or block;\n"
+        "                        an interrupted export resumes from it\n"
+        "  --sdf                 export the surface of the union of the edges\n"
+        "  --sdf-resolution N    --sdf samples per diameter, %d..%d (default %d)\n"
+        "  --hub-lattice         export struts joined at convex hubs as one\n"
+        "                        closed surface\n"
+        "  --threads N           worker threads, 0..%d (default 0: one per\n"
+        "                        processor)\n"
+        "  --snapshot            write a grid snapshot (.p3ds) instead of\n"
+        "                        exporting\n"
+        "  --verify              check STL files instead of exporting: the\n"
+        "                        binary facet count, the normals and the\n"
+        "                        degenerate or NaN facets, per solid\n"
+        "  --closed              --verify also checks that every facet edge\n"
+        "                        meets a facet edge running the other way\n"
+        "  --diff                compare the facets of two STL files in any\n"
+        "                        order\n"
+        "  --hidden NAME         skip the entities named NAME\n"
+        "  --solid NAME          export the entities named NAME as solids\n"
+        "\n"
+        "Several diameters, point counts or formats export every combination\n"
+        "from one traversal of the mesh. The first one goes to the output\n"
+        "file and the others to files named like mesh.d0.6.n5.stl.\n"
+        "  -j N                  export N files in parallel\n"
+        "  --partitions N        export each STL in N partitions by N\n"
+        "                        processes, then merge them\n"
+        "  -q                    suppress info messages\n",
+        DefCylDiam, MinNumBasePts, MaxNumBasePts, DefNumBasePts,
+        MaxBndryLayers, DefFeatureAngle, DefClusterTris, DefSliceThick,
+        MinSdfRes, MaxSdfRes, DefSdfRes, MaxThreads);
+}
+
+
+static bool
+parseArgs(int argc, char *argv[], Options &opts)
+{
+    for (int ii = 1; ii < argc; ++ii) {
+        const std::string arg = argv[ii];
+        const char *val = (ii + 1 < argc) ? argv[ii + 1] : 0;
+        bool usesVal = false;
+        if ("-h" == arg || "--help" == arg) {
+            usage(stdout);
+            exit(0);
+        }
+        else if ("-o" == arg && val) {
+            opts.output = val;
+            usesVal = true;
+        }
+        else if ("-d" == arg && val) {
+            opts.outDir = val;
+            usesVal = true;
+        }
+        else if ("--diameter" == arg && val) {
+            if (!Print3DSweep::parseDiameters(val, opts.diameters) ||
+                    opts.diameters.empty()) {
+                fprintf(stderr, "print3d: diameter must be positive\n");
+                return false;
+            }
+            opts.settings.diameter = opts.diameters[0];
+            usesVal = true;
+        }
+        else if ("--points" == arg && val) {
+            if (!Print3DSweep::parseNumPoints(val, opts.numPoints) ||
+                    opts.numPoints.empty()) {
+                fprintf(stderr, "print3d: points must be %d..%d\n",
+                    MinNumBasePts, MaxNumBasePts);
+                return false;
+            }
+            opts.settings.numPoints = opts.numPoints[0];
+            usesVal = true;
+        }
+        else if ("--formats" == arg && val) {
+            if (!Print3DSweep::parseFormats(val, opts.formats)) {
+                fprintf(stderr, "print3d: bad format list '%s'\n", val);
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--cyl-tolerance" == arg && val) {
+            opts.settings.cylTolerance = atof(val);
+            if (opts.settings.cylTolerance < 0.0) {
+                fprintf(stderr, "print3d: cylinder tolerance must not be "
+                    "negative\n");
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--edges" == arg && val) {
+            if (0 == strcmp(val, "all")) {
+                opts.settings.edgeMode = Print3DEdgesAll;
+            }
+            else if (0 == strcmp(val, "boundary")) {
+                opts.settings.edgeMode = Print3DEdgesBoundary;
+            }
+            else if (0 == strcmp(val, "feature")) {
+                opts.settings.edgeMode = Print3DEdgesFeature;
+            }
+            else {
+                fprintf(stderr, "print3d: bad edge mode '%s'\n", val);
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--edge-order" == arg && val) {
+            if (0 == strcmp(val, "traversal")) {
+                opts.settings.edgeOrder = Print3DOrderTraversal;
+            }
+            else if (0 == strcmp(val, "morton")) {
+                opts.settings.edgeOrder = Print3DOrderMorton;
+            }
+            else if (0 == strcmp(val, "hilbert")) {
+                opts.settings.edgeOrder = Print3DOrderHilbert;
+            }
+            else {
+                fprintf(stderr, "print3d: bad edge order '%s'\n", val);
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--boundary-layers" == arg && val) {
+            const int n = atoi(val);
+            if ((n < 0) || (n > MaxBndryLayers)) {
+                fprintf(stderr, "print3d: boundary layers must be 0..%d\n",
+                    MaxBndryLayers);
+                return false;
+            }
+            opts.settings.boundaryLayers = (PWP_UINT)n;
+            usesVal = true;
+        }
+        else if ("--feature-angle" == arg && val) {
+            opts.settings.featureAngle = atof(val);
+            if ((opts.settings.featureAngle < 0.0) ||
+                    (opts.settings.featureAngle > 90.0)) {
+                fprintf(stderr, "print3d: feature angle must be 0..90\n");
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--clip-box" == arg && val) {
+            std::string &list = opts.settings.clipBoxes;
+            list += (list.empty() ? "" : ";") + std::string(val);
+            usesVal = true;
+        }
+        else if ("--clip-half-space" == arg && val) {
+            std::string &list = opts.settings.clipHalfSpaces;
+            list += (list.empty() ? "" : ";") + std::string(val);
+            usesVal = true;
+        }
+        else if ("--clip-trim" == arg) {
+            opts.settings.clipTrim = true;
+        }
+        else if ("--weld" == arg) {
+            opts.settings.weldVertices = true;
+        }
+        else if ("--weld-tolerance" == arg && val) {
+            opts.settings.weldTolerance = atof(val);
+            if (opts.settings.weldTolerance < 0.0) {
+                fprintf(stderr, "print3d: weld tolerance must not be "
+                    "negative\n");
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--merge-chains" == arg) {
+            opts.settings.mergeChains = true;
+        }
+        else if ("--chain-tolerance" == arg && val) {
+            opts.settings.chainTolerance = atof(val);
+            if (opts.settings.chainTolerance < 0.0) {
+                fprintf(stderr, "print3d: chain tolerance must not be "
+                    "negative\n");
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--multi-solid" == arg) {
+            opts.settings.multiSolid = true;
+        }
+        else if ("--no-multi-solid" == arg) {
+            opts.settings.multiSolid = false;
+        }
+        else if ("--solid-scope" == arg && val) {
+            if (0 == strcmp(val, "cylinder")) {
+                opts.settings.solidScope = Print3DSolidPerCylinder;
+            }
+            else if (0 == strcmp(val, "entity")) {
+                opts.settings.solidScope = Print3DSolidPerEntity;
+            }
+            else if (0 == strcmp(val, "cluster")) {
+                opts.settings.solidScope = Print3DSolidPerCluster;
+            }
+            else if (0 == strcmp(val, "component")) {
+                opts.settings.solidScope = Print3DSolidPerComponent;
+            }
+            else {
+                fprintf(stderr, "print3d: bad solid scope '%s'\n", val);
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--cluster-tris" == arg && val) {
+            const int n = atoi(val);
+            if (n < 1) {
+                fprintf(stderr, "print3d: cluster triangles must be "
+                    "positive\n");
+                return false;
+            }
+            opts.settings.clusterTris = (PWP_UINT)n;
+            usesVal = true;
+        }
+        else if ("--solid-ids" == arg && val) {
+            if (0 == strcmp(val, "plain")) {
+                opts.settings.solidIds = Print3DSolidIdPlain;
+            }
+            else if (0 == strcmp(val, "viscam")) {
+                opts.settings.solidIds = Print3DSolidIdVisCAM;
+            }
+            else if (0 == strcmp(val, "magics")) {
+                opts.settings.solidIds = Print3DSolidIdMagics;
+            }
+            else {
+                fprintf(stderr, "print3d: bad solid id format '%s'\n", val);
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--ascii" == arg) {
+            opts.settings.binary = false;
+        }
+        else if ("--binary" == arg) {
+            opts.settings.binary = true;
+        }
+        else if ("--3mf" == arg) {
+            opts.settings.format = Print3DFormat3mf;
+        }
+        else if ("--beam-lattice" == arg) {
+            opts.settings.format = Print3DFormat3mf;
+            opts.settings.beamLattice = true;
+        }
+        else if ("--cli" == arg) {
+            opts.settings.format = Print3DFormatCli;
+        }
+        else if ("--slice-thickness" == arg && val) {
+            opts.settings.sliceThickness = atof(val);
+            if (opts.settings.sliceThickness <= 0.0) {
+                fprintf(stderr, "print3d: slice thickness must be positive\n");
+                return false;
+            }
+            usesVal = true;
+        }
+        else if ("--sdf" == arg) {
+            opts.settings.sdfUnion = true;
+        }
+        else if ("--sdf-resolution" == arg && val) {
+            const int n = atoi(val);
+            if ((n < MinSdfRes) || (n > MaxSdfRes)) {
+                fprintf(stderr, "print3d: sdf resolution must be %d..%d\n",
+                    MinSdfRes, MaxSdfRes);
+                return false;
+            }
+            opts.settings.sdfResolution = (PWP_UINT)n;
+            usesVal = true;
+        }
+        else if ("--hub-lattice" == arg) {
+            opts.settings.hubLattice = true;
+        }
+        else if ("--threads" == arg && val) {
+            const int n = atoi(val);
+            if ((n < 0) || (n > MaxThreads)) {
+                fprintf(stderr, "print3d: threads must be 0..%d\n",
+                    MaxThreads);
+                return false;
+            }
+            opts.settings.numThreads = (PWP_UINT)n;
+            usesVal = true;
+        }
+        else if ("--tess-cache" == arg) {
+            opts.settings.tessCache = true;
+        }
+        else if ("--checkpoint" == arg) {
+            opts.settings.checkpoint = true;
+        }
+        else if ("--snapshot" == arg) {
+            opts.snapshot = true;
+        }
+        else if ("--verify" == arg) {
+            opts.verify = true;
+        }
+        else if ("--closed" == arg) {
+            opts.closed = true;
+        }
+        else if ("--diff" == arg) {
+            opts.diff = true;
+        }
+        else if ("--hidden" == arg && val) {
+            opts.hidden.push_back(val);
+            usesVal = true;
+        }
+        else if ("--solid" == arg && val) {
+            opts.solid.push_back(val);
+            usesVal = true;
+        }
+        else if ("-j" == arg && val) {
+            opts.jobs = atoi(val);
+            if (opts.jobs < 1) {
+                opts.jobs = 1;
+            }
+            usesVal = true;
+        }
+        else if ("--partitions" == arg && val) {
+            const int n = atoi(val);
+            if ((n < 1) || (n > MaxPartitions)) {
+                fprintf(stderr, "print3d: partitions must be 1..%d\n",
+                    MaxPartitions);
+                return false;
+            }
+            opts.partitions = (PWP_UINT32)n;
+            usesVal = true;
+        }
+        else if ("-q" == arg) {
+            opts.quiet = true;
+        }
+        else if (!arg.empty() && ('-' == arg[0])) {
+            fprintf(stderr, "print3d: bad option '%s'\n", arg.c_str());
+            return false;
+        }
+        else {
+            opts.inputs.push_back(arg);
+        }
+        if (usesVal) {
+            ++ii;
+        }
+    }
+    if (opts.inputs.empty()) {
+        usage(stderr);
+        return false;
+    }
+    if (opts.diff && (2 != opts.inputs.size())) {
+        fprintf(stderr, "print3d: --diff requires two STL files\n");
+        return false;
+    }
+    if (!opts.output.empty() && (opts.inputs.size() > 1)) {
+        fprintf(stderr, "print3d: -o requires a single input file\n");
+        return false;
+    }
+    const std::string::size_type len = opts.output.size();
+    if ((len > 4) && (0 == opts.output.compare(len - 4, 4, ".3mf"))) {
+        opts.settings.format = Print3DFormat3mf;
+    }
+    else if ((len > 4) && (0 == opts.output.compare(len - 4, 4, ".cli"))) {
+        opts.settings.format = Print3DFormatCli;
+    }
+    return true;
+}
+
+
+static std::string
+outputPath(const Options &opts, const std::string &input)
+{
+    if (!opts.output.empty()) {
+        return opts.output;
+    }
+    std::string base = input;
+    const std::string::size_type dot = base.rfind('.');
+    const std::string::size_type sep = base.find_last_of("/\\");
+    if ((std::string::npos != dot) &&
+            ((std::string::npos == sep) || (dot > sep))) {
+        base.erase(dot);
+    }
+    if (!opts.outDir.empty()) {
+        if (std::string::npos != sep) {
+            base.erase(0, sep + 1);
+        }
+        base = opts.outDir + "/" + base;
+    }
+    const char *ext = ".stl";
+    switch (opts.settings.format) {
+        case Print3DFormat3mf:  ext = ".3mf"; break;
+        case Print3DFormatCli:  ext = ".cli"; break;
+        default:                break;
+    }
+    if (opts.snapshot) {
+        ext = SnapshotFileExt;
+    }
+    return base + ext;
+}
+
+
+static bool
+isSnapshot(const std::string &path)
+{
+    const std::string::size_type len = path.size();
+    const std::string::size_type extLen = sizeof(SnapshotFileExt) - 1;
+    return (len > extLen) &&
+        (0 == path.compare(len - extLen, extLen, SnapshotFileExt));
+}
+
+
+// applies the --hidden and --solid conditions
+template<class Model>
+static void
+applyConditions(const Options &opts, Model &model)
+{
+    for (size_t ii = 0; ii < opts.hidden.size(); ++ii) {
+        model.setCondition(opts.hidden[ii], Print3DCondHidden);
+    }
+    for (size_t ii = 0; ii < opts.solid.size(); ++ii) {
+        model.setCondition(opts.solid[ii], Print3DCondSolid);
+    }
+}
+
+
+// checks one STL file, returns true if it has no defects
+static bool
+verifyFile(const Options &opts, const std::string &input)
+{
+    CliHost host(input, opts.quiet);
+    StlVerifier verifier(opts.settings.numThreads);
+    std::string err;
+    if (!verifier.open(input, err)) {
+        host.sendErrorMsg(err.c_str());
+        return false;
+    }
+    std::vector<StlSolidStats> solids;
+    StlSolidStats totals;
+    verifier.check(solids, totals);
+    // one line per solid on stdout:
+    // file solid facets degenerate non-finite bad-normals malformed area
+    for (size_t ii = 0; ii < solids.size(); ++ii) {
+        const StlSolidStats &stats = solids[ii];
+        printf("%s\t%s\t%lu\t%lu\t%lu\t%lu\t%lu\t%.8g\n", input.c_str(),
+            stats.name.empty() ? "-" : stats.name.c_str(),
+            (unsigned long)stats.numFacets, (unsigned long)stats.numDegenerate,
+            (unsigned long)stats.numNonFinite,
+            (unsigned long)stats.numBadNormals,
+            (unsigned long)stats.numMalformed, stats.area);
+    }
+    bool ret = true;
+    char msg[256];
+    if (verifier.isBinary() &&
+            (verifier.headerCount() != verifier.fileCount())) {
+        sprintf(msg, "the header counts %lu facets, the file holds %lu",
+            (unsigned long)verifier.headerCount(),
+            (unsigned long)verifier.fileCount());
+        host.sendErrorMsg(msg);
+        ret = false;
+    }
+    if (totals.hasDefects()) {
+        sprintf(msg, "%lu degenerate, %lu non-finite, %lu bad normal and "
+            "%lu malformed facets", (unsigned long)totals.numDegenerate,
+            (unsigned long)totals.numNonFinite,
+            (unsigned long)totals.numBadNormals,
+            (unsigned long)totals.numMalformed);
+        host.sendErrorMsg(msg);
+        ret = false;
+    }
+    if (opts.closed) {
+        const PWP_UINT64 numOpen = verifier.openEdgeCount();
+        if (0 != numOpen) {
+            sprintf(msg, "%lu open facet edges, the surface is not closed",
+                (unsigned long)numOpen);
+            host.sendErrorMsg(msg);
+            ret = false;
+        }
+    }
+    sprintf(msg, "%s STL, %lu facets in %lu solids, area %.8g",
+        verifier.isBinary() ? "binary" : "ASCII",
+        (unsigned long)totals.numFacets, (unsigned long)solids.size(),
+        totals.area);
+    host.sendInfoMsg(msg);
+    return ret;
+}
+
+
+// compares the facets of the two input files, returns true if they match
+static bool
+diffFiles(const Options &opts)
+{
+    const std::string &pathA = opts.inputs[0];
+    const std::string &pathB = opts.inputs[1];
+    CliHost host(pathA, opts.quiet);
+    std::vector<PWP_UINT64> hashesA;
+    std::vector<PWP_UINT64> hashesB;
+    std::string err;
+    StlVerifier verifier(opts.settings.numThreads);
+    if (!verifier.open(pathA, err)) {
+        host.sendErrorMsg(err.c_str());
+        return false;
+    }
+    verifier.facetHashes(hashesA);
+    const bool binaryA = verifier.isBinary();
+    if (!verifier.open(pathB, err)) {
+        host.sendErrorMsg(err.c_str());
+        return false;
+    }
+    verifier.facetHashes(hashesB);
+    if (binaryA != verifier.isBinary()) {
+        // the vertices are compared as REAL32, ASCII rounds them first
+        host.sendWarningMsg("ASCII and binary vertices differ in their last "
+            "digits, compare exports of the same encoding");
+    }
+    PWP_UINT64 onlyA = 0;
+    PWP_UINT64 onlyB = 0;
+    StlVerifier::diff(hashesA, hashesB, onlyA, onlyB);
+    char msg[1024];
+    sprintf(msg, "%lu facets, %.400s %lu facets, %lu only in the first and "
+        "%lu only in the second", (unsigned long)hashesA.size(),
+        pathB.c_str(), (unsigned long)hashesB.size(), (unsigned long)onlyA,
+        (unsigned long)onlyB);
+    if ((0 == onlyA) && (0 == onlyB)) {
+        host.sendInfoMsg(msg);
+        return true;
+    }
+    host.sendErrorMsg(msg);
+    return false;
+}
+
+
+// writes the export of model to settings.destPath, returns true on success
+static bool
+writeExport(const Options &opts, Print3DModel &model, CliHost &host,
+    const Print3DSettings &settings, PWP_UINT32 numVerts)
+{
+    FILE *fp = fopen(settings.destPath.c_str(), "wb");
+    if (0 == fp) {
+        host.sendErrorMsg(("cannot create " + settings.destPath).c_str());
+        return false;
+    }
+    Print3DSweep sweep(model, host, settings);
+    sweep.setDiameters(opts.diameters);
+    sweep.setNumPoints(opts.numPoints);
+    sweep.setFormats(opts.formats);
+    bool ret = false;
+    AllocCounter::reset();
+    if (sweep.variantCount() > 1) {
+        ret = sweep.run(fp) && !host.aborted();
+    }
+    else {
+        Print3DExporter exporter(model, host, fp, settings);
+        ret = exporter.run() && !host.aborted();
+    }
+    if (0 != fclose(fp)) {
+        ret = false;
+    }
+    if (ret) {
+        char msg[512];
+        sprintf(msg, "wrote %.400s (%lu entities, %lu vertices)",
+            settings.destPath.c_str(), (unsigned long)model.entityCount(),
+            (unsigned long)numVerts);
+        host.sendInfoMsg(msg);
+        // the regression check compares these between mesh sizes
+        std::string allocs = "Allocations:";
+        for (int ii = 0; ii < AllocPhase::NumPhases; ++ii) {
+            const AllocPhase::Phase phase = (AllocPhase::Phase)ii;
+            sprintf(msg, "%s %lu %s", (0 == ii) ? "" : ",",
+                AllocCounter::count(phase), AllocPhase::name(phase));
+            allocs += msg;
+        }
+        host.sendInfoMsg(allocs.c_str());
+    }
+    else {
+        remove(settings.destPath.c_str());
+    }
+    return ret;
+}
+
+
+// exports model in opts.partitions partitions, each in its own process,
+// then merges the partition files into settings.destPath. Returns true on
+// success.
+static bool
+exportPartitions(const Options &opts, Print3DModel &model, CliHost &host,
+    const Print3DSettings &settings, PWP_UINT32 numVerts)
+{
+    if ((opts.diameters.size() > 1) || (opts.numPoints.size() > 1) ||
+            !opts.formats.empty()) {
+        host.sendErrorMsg("partitions require a single diameter, point "
+            "count and format");
+        return false;
+    }
+    Print3DSettings part = settings;
+    part.numParts = opts.partitions;
+    bool ret = true;
+#if defined(_WIN32)
+    for (PWP_UINT32 rank = 0; ret && (rank < opts.partitions); ++rank) {
+        part.partRank = rank;
+        part.destPath = stlPartPath(settings.destPath, rank);
+        ret = writeExport(opts, model, host, part, numVerts);
+    }
+#else
+    // the children share the parsed model
+    PWP_UINT32 running = 0;
+    fflush(0);
+    for (PWP_UINT32 rank = 0; rank < opts.partitions; ++rank) {
+        part.partRank = rank;
+        part.destPath = stlPartPath(settings.destPath, rank);
+        const pid_t pid = fork();
+        if (0 == pid) {
+            _exit(writeExport(opts, model, host, part, numVerts) ? 0 : 1);
+        }
+        else if (pid < 0) {
+            // could not fork, do it here
+            if (!writeExport(opts, model, host, part, numVerts)) {
+                ret = false;
+            }
+        }
+        else {
+            ++running;
+        }
+    }
+    while (running > 0) {
+        int status = 0;
+        const pid_t pid = wait(&status);
+        if (pid > 0) {
+            --running;
+            if (!WIFEXITED(status) || (0 != WEXITSTATUS(status))) {
+                ret = false;
+            }
+        }
+        else if (!Interrupted) {
+            break;
+        }
+    }
+#endif
+    if (ret && !host.aborted()) {
+        Print3DSettings merge = settings;
+        merge.numParts = opts.partitions;
+        merge.mergeParts = true;
+        ret = writeExport(opts, model, host, merge, numVerts);
+    }
+    for (PWP_UINT32 rank = 0; rank < opts.partitions; ++rank) {
+        const std::string path = stlPartPath(settings.destPath, rank);
+        remove(path.c_str());
+        remove((path + ManifestFileExt).c_str());
+    }
+    return ret;
+}
+
+
+// exports one mesh file, returns true on success
+static bool
+exportFile(const Options &opts, const std::string &input)
+{
+    if (opts.verify) {
+        return verifyFile(opts, input);
+    }
+    CliHost host(input, opts.quiet);
+    MeshModel mesh;
+    GridSnapshot snapshot;
+    Print3DModel *model = 0;
+    PWP_UINT32 numVerts = 0;
+    std::string err;
+    if (isSnapshot(input)) {
+        // mapped, nothing to parse
+        if (!snapshot.open(input, err)) {
+            host.sendErrorMsg(err.c_str());
+            return false;
+        }
+        applyConditions(opts, snapshot);
+        numVerts = snapshot.vertexCount();
+        model = &snapshot;
+    }
+    else {
+        if (!mesh.read(input, err)) {
+            host.sendErrorMsg(err.c_str());
+            return false;
+        }
+        if (!err.empty()) {
+            host.sendWarningMsg(err.c_str());
+        }
+        applyConditions(opts, mesh);
+        numVerts = mesh.vertexCount();
+        model = &mesh;
+    }
+
+    Print3DSettings settings = opts.settings;
+    settings.destPath = outputPath(opts, input);
+    if (opts.snapshot) {
+        bool ret = (settings.destPath != input) &&
+            GridSnapshot::write(*model, host, settings.destPath);
+        if (ret) {
+            host.sendInfoMsg(("wrote " + settings.destPath).c_str());
+        }
+        else if (!host.aborted()) {
+            host.sendErrorMsg(("cannot write " + settings.destPath).c_str());
+        }
+        return ret;
+    }
+    // the model is read only, the elements can be traversed in parallel
+    settings.threadSafeModel = true;
+    if (opts.partitions > 1) {
+        return exportPartitions(opts, *model, host, settings, numVerts);
+    }
+    return writeExport(opts, *model, host, settings, numVerts);
+}
+
+
+// exports the files using up to opts.jobs child processes, returns the
+// number of failures
+static int
+exportAll(const Options &opts)
+{
+    int failed = 0;
+#if defined(_WIN32)
+    for (size_t ii = 0; ii < opts.inputs.size() && !Interrupted; ++ii) {
+        if (!exportFile(opts, opts.inputs[ii])) {
+            ++failed;
+        }
+    }
+#else
+    if (opts.jobs <= 1) {
+        for (size_t ii = 0; ii < opts.inputs.size() && !Interrupted; ++ii) {
+            if (!exportFile(opts, opts.inputs[ii])) {
+                ++failed;
+            }
+        }
+        return failed;
+    }
+    // each file is exported in its own process so that a large mesh only
+    // holds its memory while it is being exported
+    size_t next = 0;
+    int running = 0;
+    while ((next < opts.inputs.size() && !Interrupted) || (running > 0)) {
+        while ((running < opts.jobs) && (next < opts.inputs.size()) &&
+                !Interrupted) {
+            fflush(0);
+            const pid_t pid = fork();
+            if (0 == pid) {
+                _exit(exportFile(opts, opts.inputs[next]) ? 0 : 1);
+            }
+            else if (pid < 0) {
+                // could not fork, do it here
+                if (!exportFile(opts, opts.inputs[next])) {
+                    ++failed;
+                }
+            }
+            else {
+                ++running;
+            }
+            ++next;
+        }
+        if (running > 0) {
+            int status = 0;
+            const pid_t pid = wait(&status);
+            if (pid > 0) {
+                --running;
+                if (!WIFEXITED(status) || (0 != WEXITSTATUS(status))) {
+                    ++failed;
+                }
+            }
+            else if (Interrupted) {
+                // the children see the same signal and will exit
+                continue;
+            }
+            else {
+                break;
+            }
+        }
+    }
+#endif
+    return failed;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    Options opts;
+    if (!parseArgs(argc, argv, opts)) {
+        return 2;
+    }
+    if (opts.diff) {
+        return diffFiles(opts) ? 0 : 1;
+    }
+    signal(SIGINT, onInterrupt);
+    const int failed = exportAll(opts);
+    if (Interrupted) {
+        fprintf(stderr, "print3d: interrupted\n");
+        return 130;
+    }
+    return (0 == failed) ? 0 : 1;
+}
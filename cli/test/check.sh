@@ -0,0 +1,352 @@
+#!/bin/sh
+#############################################################################
+#
+# check.sh - print3d regression check
+#
+# Exports the meshes in this directory and compares the results with the
+# reference exports in ref/. Every STL is also checked with --verify
+# --closed, so a defect or an open surface fails the check.
+#
+#   sh check.sh [print3d]
+#
+# The cylinder exports are checked against each other: the thread counts,
+# the tessellation cache, the checkpoint, the grid snapshot and the
+# merged partitions must give the same file, and the edge orders and
+# solid scopes the same facets. The plain cylinder export of each mesh,
+# the hub lattice, the beam lattice and the layer slices are compared
+# with references. The cylinder of an edge is rotated into place by the
+# Configurable Math Library, whose rounding may differ between versions,
+# so another CML version may need new cylinder references.
+#
+# Run "sh check.sh print3d update" after an intended change of a
+# reference export to write the new references.
+#
+#############################################################################
+
+P3D=${1:-./print3d}
+UPDATE=${2:-}
+DIR=`dirname "$0"`
+OUT=${TMPDIR:-/tmp}/print3d-check.$$
+FAILS=0
+
+case "$P3D" in
+    */*) P3D=`cd \`dirname "$P3D"\` && pwd`/`basename "$P3D"` ;;
+esac
+
+rm -rf "$OUT"
+mkdir -p "$OUT" || exit 1
+trap 'rm -rf "$OUT"' 0
+trap 'exit 130' 1 2 15
+
+
+fail()
+{
+    echo "FAIL: $*"
+    FAILS=`expr $FAILS + 1`
+}
+
+
+# export FILE MESH OPTION... : export MESH to FILE in the output directory
+export3d()
+{
+    file=$1
+    mesh=$2
+    shift 2
+    "$P3D" -q "$@" -o "$OUT/$file" "$DIR/$mesh" ||
+        fail "print3d $* $mesh"
+}
+
+
+# verify FILE : the STL has no defects and is closed
+verify()
+{
+    if ! log=`"$P3D" --verify --closed "$OUT/$1" 2>&1`; then
+        echo "$log" | grep -v '	id '
+        fail "$1 is not a valid closed STL"
+    fi
+}
+
+
+# reference FILE : the export is the same as the reference
+reference()
+{
+    if [ "update" = "$UPDATE" ]; then
+        cp "$OUT/$1" "$DIR/ref/$1"
+    elif ! cmp -s "$OUT/$1" "$DIR/ref/$1"; then
+        fail "$1 differs from ref/$1"
+    fi
+}
+
+
+# same FILE FILE : the exports are byte-identical
+same()
+{
+    cmp -s "$OUT/$1" "$OUT/$2" || fail "$1 and $2 differ"
+}
+
+
+# grid FILE N : writes an N by N grid of unit quads to the output directory
+grid()
+{
+    awk -v n=$2 'BEGIN {
+        print "# vtk DataFile Version 2.0"
+        print "grid"
+        print "ASCII"
+        print "DATASET UNSTRUCTURED_GRID"
+        print "POINTS", (n + 1) * (n + 1), "double"
+        for (j = 0; j <= n; ++j)
+            for (i = 0; i <= n; ++i)
+                print i, j, 0
+        print "CELLS", n * n, 5 * n * n
+        for (j = 0; j < n; ++j)
+            for (i = 0; i < n; ++i) {
+                v = j * (n + 1) + i
+                print 4, v, v + 1, v + n + 2, v + n + 1
+            }
+        print "CELL_TYPES", n * n
+        for (c = 0; c < n * n; ++c)
+            print 9
+    }' > "$OUT/$1"
+}
+
+
+# cube FILE N : writes an N by N by N block of unit hexes to the output
+# directory
+cube()
+{
+    awk -v n=$2 'BEGIN {
+        m = n + 1
+        print "# vtk DataFile Version 2.0"
+        print "cube"
+        print "ASCII"
+        print "DATASET UNSTRUCTURED_GRID"
+        print "POINTS", m * m * m, "double"
+        for (k = 0; k <= n; ++k)
+            for (j = 0; j <= n; ++j)
+                for (i = 0; i <= n; ++i)
+                    print i, j, k
+        print "CELLS", n * n * n, 9 * n * n * n
+        for (k = 0; k < n; ++k)
+            for (j = 0; j < n; ++j)
+                for (i = 0; i < n; ++i) {
+                    v = (k * m + j) * m + i
+                    print 8, v, v + 1, v + m + 1, v + m,
+                        v + m * m, v + m * m + 1, v + m * m + m + 1,
+                        v + m * m + m
+                }
+        print "CELL_TYPES", n * n * n
+        for (c = 0; c < n * n * n; ++c)
+            print 12
+    }' > "$OUT/$1"
+}
+
+
+# kept MESH COUNT OPTION... : the export of MESH in the output directory
+# keeps COUNT edges
+kept()
+{
+    mesh=$1
+    count=$2
+    shift 2
+    n=`"$P3D" "$@" -o "$OUT/kept.stl" "$OUT/$mesh" 2>&1 |
+        sed -n 's/.*Edge mode [a-z]*: \([0-9]*\) edges kept.*/\1/p'`
+    [ "$count" = "$n" ] ||
+        fail "print3d $* keeps ${n:-no} edges of $mesh, not $count"
+}
+
+
+# allocs MESH OPTION... : the allocation counts of the export of MESH in
+# the output directory, in phase order
+allocs()
+{
+    mesh=$1
+    shift
+    "$P3D" "$@" -o "$OUT/allocs.out" "$OUT/$mesh" 2>&1 |
+        sed -n 's/.*Allocations: //p' | tr -cs '0-9' ' ' | sed 's/ $//'
+}
+
+
+# growth OPTION... : the export of a grid with four times the edges makes
+# no more traversal, geometry or I/O allocations, and its tables are
+# doubled at most once more
+growth()
+{
+    small=`allocs small.vtk "$@"`
+    large=`allocs large.vtk "$@"`
+    if [ -z "$small" ] || [ -z "$large" ]; then
+        fail "print3d $* reports no allocations"
+    elif ! echo $small $large | awk '{ exit !($6 <= 2 * $1 &&
+            $7 <= $2 && $8 <= 2 * $3 && $9 <= $4 && $10 <= $5) }'; then
+        fail "print3d $* allocations grow with the edges:" \
+            "setup traversal dedup geometry I/O $small -> $large"
+    fi
+}
+
+
+# facets FILE FILE : the exports have the same facets in any order
+facets()
+{
+    if ! log=`"$P3D" --diff "$OUT/$1" "$OUT/$2" 2>&1`; then
+        echo "$log"
+        fail "$1 and $2 have different facets"
+    fi
+}
+
+
+for mesh in quads.vtk hexes.msh; do
+    name=`echo $mesh | sed 's/\..*//'`
+    export3d $name.stl $mesh --binary --threads 1
+    verify $name.stl
+    reference $name.stl
+    export3d $name.t4.stl $mesh --binary --threads 4
+    same $name.stl $name.t4.stl
+    export3d $name.ascii.stl $mesh --ascii
+    verify $name.ascii.stl
+    # the merged partitions are the same as a single process export
+    export3d $name.parts.stl $mesh --binary --partitions 3
+    same $name.stl $name.parts.stl
+    export3d $name.ascii.parts.stl $mesh --ascii --partitions 3
+    same $name.ascii.stl $name.ascii.parts.stl
+    export3d $name.entity.stl $mesh --binary --solid-scope entity
+    verify $name.entity.stl
+    facets $name.stl $name.entity.stl
+    export3d $name.hilbert.stl $mesh --binary --edge-order hilbert
+    facets $name.stl $name.hilbert.stl
+    # the second export splices its entities from the cache
+    export3d $name.cache.stl $mesh --binary --tess-cache
+    export3d $name.cache.stl $mesh --binary --tess-cache
+    same $name.stl $name.cache.stl
+    export3d $name.ckpt.stl $mesh --binary --checkpoint
+    same $name.stl $name.ckpt.stl
+    # the grid snapshot of the mesh exports the same file
+    export3d $name.p3ds $mesh --snapshot
+    "$P3D" -q --binary --threads 1 -o "$OUT/$name.snap.stl" \
+        "$OUT/$name.p3ds" || fail "print3d $name.p3ds"
+    same $name.stl $name.snap.stl
+    export3d $name.3mf $mesh --3mf --threads 1
+    export3d $name.t4.3mf $mesh --3mf --threads 4
+    same $name.3mf $name.t4.3mf
+done
+
+# Only the first cylinder in each edge direction of hexes.msh misses the
+# direction cache, so 70 of the 75 reuse a ring. The axis directions are
+# rounded to themselves.
+hits=`"$P3D" --binary --threads 1 --cyl-tolerance 0.001 \
+    -o "$OUT/hexes.cyl.stl" "$DIR/hexes.msh" 2>&1 |
+    sed -n 's/.*Direction cache: \([0-9]* of [0-9]*\) .*/\1/p'`
+[ "70 of 75" = "$hits" ] ||
+    fail "print3d --cyl-tolerance reuses ${hits:-no} rings of hexes.msh"
+verify hexes.cyl.stl
+facets hexes.stl hexes.cyl.stl
+
+export3d quads.hub.stl quads.vtk --binary --hub-lattice --diameter 0.3
+verify quads.hub.stl
+reference quads.hub.stl
+# the struts are narrowed to fit between hubs wider than their edges
+if "$P3D" -q --binary --hub-lattice --diameter 2 -o "$OUT/quads.hub2.stl" \
+        "$DIR/quads.vtk" 2>&1 | grep 'not a valid solid'; then
+    fail "quads.hub2.stl has invalid struts or hubs"
+fi
+verify quads.hub2.stl
+# the edge between the coincident vertices of collapsed.vtk is skipped
+if ! "$P3D" -q --binary --hub-lattice --diameter 0.1 \
+        -o "$OUT/collapsed.hub.stl" "$DIR/collapsed.vtk" 2>&1 |
+        grep -q 'skipped 1 edges of no length'; then
+    fail "collapsed.hub.stl does not skip the edge of no length"
+fi
+verify collapsed.hub.stl
+# The quads of split.vtk have their own copies of the shared vertices,
+# which --weld merges, so the shared edge is written once.
+merged=`"$P3D" --binary --points 4 --weld -o "$OUT/split.weld.stl" \
+    "$DIR/split.vtk" 2>&1 | sed -n 's/.*Weld: //p'`
+[ "2 of 8 vertices merged" = "$merged" ] ||
+    fail "print3d --weld merges ${merged:-no vertices} of split.vtk"
+export3d split.stl split.vtk --binary --points 4
+for file in split.stl:96 split.weld.stl:84; do
+    if ! "$P3D" --verify "$OUT/${file%:*}" 2>&1 |
+            grep -q "binary STL, ${file#*:} facets"; then
+        fail "${file%:*} does not have ${file#*:} facets"
+    fi
+done
+# once welded, the bottom and top edges of the quads are two chains
+chains=`"$P3D" --binary --weld --merge-chains -o "$OUT/split.chains.stl" \
+    "$DIR/split.vtk" 2>&1 | sed -n 's/.*Chains: //p'`
+[ "4 of 7 edges merged into 2 cylinders" = "$chains" ] ||
+    fail "print3d --merge-chains merges ${chains:-no edges} of split.vtk"
+verify split.chains.stl
+# the distance field union is one closed surface, welded or not
+export3d split.sdf.stl split.vtk --binary --sdf --diameter 0.1 \
+    --sdf-resolution 8
+verify split.sdf.stl
+export3d split.sdf.weld.stl split.vtk --binary --sdf --diameter 0.1 \
+    --sdf-resolution 8 --weld
+verify split.sdf.weld.stl
+export3d hexes.beams.3mf hexes.msh --beam-lattice
+reference hexes.beams.3mf
+# the layer outlines are closed and do not depend on the thread count
+if "$P3D" -q --cli --diameter 0.3 --slice-thickness 0.05 --threads 1 \
+        -o "$OUT/quads.cli" "$DIR/quads.vtk" 2>&1 | grep 'not be closed'; then
+    fail "quads.cli has open outlines"
+fi
+reference quads.cli
+export3d quads.t4.cli quads.vtk --cli --diameter 0.3 --slice-thickness 0.05 \
+    --threads 4
+same quads.cli quads.t4.cli
+
+# Each variant of a sweep is the same as its own export. The first one is
+# written to the output file, the others next to it.
+export3d sweep.stl hexes.msh --binary --threads 1 --diameter 0.1,0.2 \
+    --points 4,6 --formats stl,3mf
+for d in 0.1 0.2; do
+    for n in 4 6; do
+        for ext in stl 3mf; do
+            export3d $d.$n.$ext hexes.msh --binary --threads 1 \
+                --diameter $d --points $n `[ 3mf = $ext ] && echo --3mf`
+            if [ $d.$n.$ext = 0.1.4.stl ]; then
+                same sweep.stl $d.$n.$ext
+            else
+                same sweep.d$d.n$n.$ext $d.$n.$ext
+            fi
+        done
+    done
+done
+
+# the thread count is one the plugin also accepts
+for n in -1 257; do
+    if "$P3D" -q --threads $n -o "$OUT/threads.stl" "$DIR/quads.vtk" \
+            2>/dev/null; then
+        fail "print3d --threads $n is accepted"
+    fi
+done
+
+# a box around the last of the three blocks of hexes.msh culls the others
+culled=`"$P3D" --binary --clip-box 4,0,0,5,3,3 -o "$OUT/hexes.clip.stl" \
+    "$DIR/hexes.msh" 2>&1 | sed -n 's/.*Clip: 1 regions, //p'`
+[ "2 of 3 entities culled" = "$culled" ] ||
+    fail "print3d --clip-box culls ${culled:-no entities} of hexes.msh"
+verify hexes.clip.stl
+
+# The 54 edges of a block of 2 by 2 by 2 hexes are 48 on its boundary,
+# of which the 24 on the sides of the cube are feature edges. The first
+# layer of cells adds the 6 interior edges.
+cube cube.vtk 2
+kept cube.vtk 48 --edges boundary
+kept cube.vtk 24 --edges feature
+kept cube.vtk 54 --edges boundary --boundary-layers 1
+
+# Each phase's allocations are per export, per thread or per entity. The
+# small grid has enough ranges to fill a batch of --threads 2.
+grid small.vtk 96
+grid large.vtk 192
+growth --binary --threads 1 --points 3
+growth --ascii --threads 1 --points 3
+growth --binary --threads 2 --points 3
+growth --binary --threads 2 --points 3 --merge-chains
+growth --3mf --threads 1 --points 3
+
+if [ 0 -ne $FAILS ]; then
+    echo "$FAILS print3d checks failed"
+    exit 1
+fi
+echo "print3d checks passed"
+exit 0
@@ -27,7 +27,9 @@ CAEP_VCINFO CaeUnsPrint3DVCInfo[] = {
 };
 /*------------------------------------*/
 const char *CaeUnsPrint3DFileExt[] = {
-    "stl"
+    "stl",
+    "3mf",
+    "cli"
 };
 
 #endif /* _RTCAEPSUPPORTDATA_H_ */